@@ -14,9 +14,15 @@
  * limitations under the License.
  */
 
+#include <atomic>
+#include <map>
+#include <set>
+
 #include "gtest/gtest.h"
 #include "gtest/internal/gtest-param-util.h"
 #include "testing/toydb_engine_test_base.h"
+#include "vm/runner.h"
+#include "vm/sql_compiler.h"
 
 using namespace llvm;       // NOLINT (build/namespaces)
 using namespace llvm::orc;  // NOLINT (build/namespaces)
@@ -48,6 +54,155 @@ TEST_P(EngineTest, TestBatchEngine) {
         LOG(INFO) << "Skip mode " << sql_case.mode();
     }
 }
+static Status RunBatchCase(const SqlCase& sql_case, const EngineOptions& options, std::vector<Row>* outputs,
+                           Schema* schema) {
+    ToydbBatchEngineTestRunner runner(sql_case, options);
+    CHECK_TRUE(runner.InitEngineCatalog(), common::kTestEngineError, "Engine Test Init Catalog Error");
+    CHECK_STATUS(runner.Compile());
+    CHECK_STATUS(runner.PrepareData());
+    CHECK_STATUS(runner.Compute(outputs));
+    *schema = runner.GetSession()->GetSchema();
+    return Status::OK();
+}
+
+// window aggregates keep their states between rows by default, the outputs
+// should be the same as rescanning every window
+TEST_P(EngineTest, TestIncrementalWindowAggBatchEngine) {
+    ParamType sql_case = GetParam();
+    LOG(INFO) << "ID: " << sql_case.id() << ", DESC: " << sql_case.desc();
+    if (!sql_case.expect().success_ || !boost::icontains(sql_case.sql_str(), " over ") ||
+        boost::contains(sql_case.mode(), "batch-unsupport") ||
+        boost::contains(sql_case.mode(), "rtidb-unsupport") ||
+        boost::contains(sql_case.mode(), "performance-sensitive-unsupport") ||
+        boost::contains(sql_case.mode(), "rtidb-batch-unsupport")) {
+        LOG(INFO) << "Skip mode " << sql_case.mode();
+        return;
+    }
+    std::vector<Row> incremental_rows;
+    std::vector<Row> rescan_rows;
+    Schema schema;
+    EngineOptions incremental_options;
+    incremental_options.SetEnableIncrementalWindowAgg(true);
+    EngineOptions rescan_options;
+    rescan_options.SetEnableIncrementalWindowAgg(false);
+    Status incremental_status = RunBatchCase(sql_case, incremental_options, &incremental_rows, &schema);
+    Status rescan_status = RunBatchCase(sql_case, rescan_options, &rescan_rows, &schema);
+    ASSERT_TRUE(incremental_status.isOK()) << incremental_status;
+    ASSERT_TRUE(rescan_status.isOK()) << rescan_status;
+    ASSERT_NO_FATAL_FAILURE(CheckRows(schema, incremental_rows, rescan_rows));
+}
+
+class ParallelWindowAggTest : public ::testing::TestWithParam<SqlCase> {};
+
+// every key of the window is run by one of the workers, the outputs should
+// be the same as the serial run and in the same order
+TEST_P(ParallelWindowAggTest, CompareWithSerialRun) {
+    SqlCase sql_case = GetParam();
+    LOG(INFO) << "ID: " << sql_case.id() << ", DESC: " << sql_case.desc();
+    std::vector<Row> serial_rows;
+    std::vector<Row> parallel_rows;
+    Schema schema;
+    EngineOptions serial_options;
+    EngineOptions parallel_options;
+    parallel_options.SetWindowAggParallelism(4);
+    Status serial_status = RunBatchCase(sql_case, serial_options, &serial_rows, &schema);
+    ASSERT_TRUE(serial_status.isOK()) << serial_status;
+    ASSERT_FALSE(serial_rows.empty());
+    Status parallel_status = RunBatchCase(sql_case, parallel_options, &parallel_rows, &schema);
+    ASSERT_TRUE(parallel_status.isOK()) << parallel_status;
+    ASSERT_NO_FATAL_FAILURE(CheckRows(schema, parallel_rows, serial_rows));
+}
+INSTANTIATE_TEST_SUITE_P(EngineParallelWindowQuery, ParallelWindowAggTest,
+                         testing::ValuesIn(sqlcase::InitCases("/cases/query/parallel_window_query.yaml")));
+// count the runs of the wrapped runner, the counter takes over the cache of
+// the wrapped runner so that the cache hits are not counted
+class CountRunsRunner : public Runner {
+ public:
+    explicit CountRunsRunner(Runner* runner)
+        : Runner(runner->id_, runner->type_, runner->output_schemas()), run_cnt_(0) {
+        AddProducer(runner);
+        EnableCache();
+        runner->DisableCache();
+    }
+    std::shared_ptr<DataHandler> Run(RunnerContext& ctx,  // NOLINT
+                                     const std::vector<std::shared_ptr<DataHandler>>& inputs) override {
+        run_cnt_++;
+        return inputs[0];
+    }
+    size_t run_cnt() const { return run_cnt_.load(); }
+
+ private:
+    std::atomic<size_t> run_cnt_;
+};
+static void CollectRunners(Runner* runner, std::set<Runner*>* runners) {
+    if (nullptr == runner || !runners->insert(runner).second) {
+        return;
+    }
+    for (auto producer : runner->GetProducers()) {
+        CollectRunners(producer, runners);
+    }
+}
+// find a cached runner reached from several producers of a runner which
+// runs its producers in parallel
+static Runner* FindSharedCachedRunner(Runner* root) {
+    std::set<Runner*> runners;
+    CollectRunners(root, &runners);
+    for (auto runner : runners) {
+        if (runner->producer_parallelism() <= 1) {
+            continue;
+        }
+        std::map<Runner*, size_t> branch_cnts;
+        for (auto producer : runner->GetProducers()) {
+            std::set<Runner*> branch;
+            CollectRunners(producer, &branch);
+            for (auto branch_runner : branch) {
+                if (branch_runner->need_cache() && ++branch_cnts[branch_runner] > 1) {
+                    return branch_runner;
+                }
+            }
+        }
+    }
+    return nullptr;
+}
+
+class ParallelBranchTest : public ::testing::TestWithParam<SqlCase> {};
+
+// the branches run in parallel share a cached runner, which should run once
+// for every request
+TEST_P(ParallelBranchTest, RunSharedProducerOnce) {
+    SqlCase sql_case = GetParam();
+    LOG(INFO) << "ID: " << sql_case.id() << ", DESC: " << sql_case.desc();
+    EngineOptions options;
+    options.SetBranchParallelism(4);
+    ToydbRequestEngineTestRunner runner(sql_case, options);
+    ASSERT_TRUE(runner.InitEngineCatalog());
+    Status status = runner.Compile();
+    ASSERT_TRUE(status.isOK()) << status;
+    auto compile_info = std::dynamic_pointer_cast<SqlCompileInfo>(runner.GetSession()->GetCompileInfo());
+    Runner* root = compile_info->GetMainTask();
+    Runner* shared = FindSharedCachedRunner(root);
+    ASSERT_TRUE(shared != nullptr) << "No cached runner is shared by the parallel branches";
+
+    CountRunsRunner counter(shared);
+    std::set<Runner*> runners;
+    CollectRunners(root, &runners);
+    for (auto consumer : runners) {
+        for (size_t idx = 0; idx < consumer->GetProducers().size(); idx++) {
+            if (consumer->GetProducers()[idx] == shared) {
+                consumer->SetProducer(idx, &counter);
+            }
+        }
+    }
+    status = runner.PrepareData();
+    ASSERT_TRUE(status.isOK()) << status;
+    std::vector<Row> output_rows;
+    status = runner.Compute(&output_rows);
+    ASSERT_TRUE(status.isOK()) << status;
+    ASSERT_EQ(output_rows.size(), counter.run_cnt());
+    ASSERT_NO_FATAL_FAILURE(DoEngineCheckExpect(sql_case, runner.GetSession(), output_rows));
+}
+INSTANTIATE_TEST_SUITE_P(EngineParallelBranchQuery, ParallelBranchTest,
+                         testing::ValuesIn(sqlcase::InitCases("/cases/query/parallel_branch_query.yaml")));
 TEST_P(EngineTest, TestBatchRequestEngineForLastRow) {
     ParamType sql_case = GetParam();
     EngineOptions options;
@@ -20,6 +20,7 @@
 #include <memory.h>
 #include <stddef.h>
 #include <string.h>
+#include <atomic>
 #include <memory>
 #include <string>
 #include "base/raw_buffer.h"
@@ -150,19 +151,23 @@ class RefCountedSlice : public Slice {
     RefCountedSlice &operator=(const RefCountedSlice &);
     RefCountedSlice &operator=(RefCountedSlice &&);
 
+    // whether the buffer is owned and freed with the last reference
+    inline bool IsManaged() const { return ref_cnt_ != nullptr; }
+
  private:
     RefCountedSlice(int8_t *data, size_t size, bool managed)
         : Slice(reinterpret_cast<const char *>(data), size),
-          ref_cnt_(managed ? new int(1) : nullptr) {}
+          ref_cnt_(managed ? new std::atomic<int32_t>(1) : nullptr) {}
 
     RefCountedSlice(const char *data, size_t size, bool managed)
-        : Slice(data, size), ref_cnt_(managed ? new int(1) : nullptr) {}
+        : Slice(data, size), ref_cnt_(managed ? new std::atomic<int32_t>(1) : nullptr) {}
 
     void Release();
 
     void Update(const RefCountedSlice &slice);
 
-    int32_t *ref_cnt_;
+    // the slice may be released by the thread sending it
+    std::atomic<int32_t> *ref_cnt_;
 };
 
 }  // namespace base
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HYBRIDSE_INCLUDE_CODEC_AGGR_CODEC_H_
+#define HYBRIDSE_INCLUDE_CODEC_AGGR_CODEC_H_
+
+#include <stdint.h>
+#include <string>
+
+namespace hybridse {
+namespace codec {
+
+// aggregate functions which can be maintained in pre-aggr tables
+enum AggrFuncType {
+    kAggrSum = 0,
+    kAggrMin,
+    kAggrMax,
+    kAggrCount,
+    kAggrAvg,
+};
+
+bool GetAggrFuncType(const std::string& name, AggrFuncType* type);
+
+// column positions of pre-aggr table schema, see
+// SQLClusterRouter::CreatePreAggrTable
+enum AggrColumnPos : uint32_t {
+    kAggrKeyPos = 0,
+    kAggrTsStartPos,
+    kAggrTsEndPos,
+    kAggrNumRowsPos,
+    kAggrValPos,
+    kAggrBinlogOffsetPos,
+};
+
+// parse bucket_size of pre-aggr meta info, a bucket of pure digits is
+// counted by rows, otherwise it is a time duration with unit s/m/h/d and
+// the size is returned in milliseconds
+bool ParseAggrBucketSize(const std::string& bucket_size, bool* is_row_bucket,
+                         int64_t* size);
+
+// partial aggregate value of one bucket, saved in `agg_val` column of
+// pre-aggr table. the encoded value is always 16 bytes: the count of non-null
+// inputs followed by the int64 or double accumulator. avg keeps its sum in
+// double whatever the input type is
+class AggrValue {
+ public:
+    AggrValue() : AggrValue(kAggrSum, false) {}
+    AggrValue(AggrFuncType type, bool is_double)
+        : type_(type),
+          is_double_(is_double || type == kAggrAvg),
+          cnt_(0),
+          i64_(0),
+          f64_(0) {}
+
+    void Update(int64_t val);
+    void Update(double val);
+    void Merge(const AggrValue& other);
+
+    void Encode(std::string* buf) const;
+    bool Decode(const char* buf, uint32_t size);
+
+    inline void Reset() {
+        cnt_ = 0;
+        i64_ = 0;
+        f64_ = 0;
+    }
+    inline AggrFuncType GetType() const { return type_; }
+    inline bool IsDouble() const { return is_double_; }
+    inline bool IsNull() const { return type_ != kAggrCount && cnt_ == 0; }
+    inline int64_t GetCount() const { return cnt_; }
+    inline int64_t GetInt64() const { return i64_; }
+    inline double GetDouble() const { return f64_; }
+
+    static constexpr uint32_t ENCODE_SIZE = 16;
+
+ private:
+    AggrFuncType type_;
+    bool is_double_;
+    int64_t cnt_;
+    int64_t i64_;
+    double f64_;
+};
+
+}  // namespace codec
+}  // namespace hybridse
+
+#endif  // HYBRIDSE_INCLUDE_CODEC_AGGR_CODEC_H_
@@ -78,6 +78,35 @@ class WindowIterator {
     /// Return the key of current segment of
     /// dataset if Valid() is `true`
     virtual const Row GetKey() = 0;
+    /// Return the count of rows of current segment
+    /// if Valid() return `true`. Subclasses with segment metadata should
+    /// override it, the default implementation iterates the segment.
+    virtual uint64_t GetValueCount() {
+        auto iter = GetValue();
+        uint64_t cnt = 0;
+        if (!iter) {
+            return cnt;
+        }
+        iter->SeekToFirst();
+        while (iter->Valid()) {
+            cnt++;
+            iter->Next();
+        }
+        return cnt;
+    }
+    /// Return the row at position `pos` of current
+    /// segment, or an empty row if `pos` is out of range.
+    virtual Row GetValueAt(uint64_t pos) {
+        auto iter = GetValue();
+        if (!iter) {
+            return Row();
+        }
+        iter->SeekToFirst();
+        while (pos-- > 0 && iter->Valid()) {
+            iter->Next();
+        }
+        return iter->Valid() ? iter->GetValue() : Row();
+    }
 };
 }  // namespace codec
 }  // namespace hybridse
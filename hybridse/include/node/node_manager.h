@@ -361,7 +361,8 @@ class NodeManager {
     UdafDefNode *MakeUdafDefNode(const std::string &name,
                                  const std::vector<const TypeNode *> &arg_types,
                                  ExprNode *init, FnDefNode *update_func,
-                                 FnDefNode *merge_func, FnDefNode *output_func);
+                                 FnDefNode *merge_func, FnDefNode *output_func,
+                                 FnDefNode *retract_func = nullptr);
     LambdaNode *MakeLambdaNode(const std::vector<ExprIdNode *> &args,
                                ExprNode *body);
 
@@ -2498,14 +2498,16 @@ class LambdaNode : public FnDefNode {
 class UdafDefNode : public FnDefNode {
  public:
     UdafDefNode(const std::string &name, const std::vector<const TypeNode *> &arg_types, ExprNode *init_expr,
-                FnDefNode *update_func, FnDefNode *merge_func, FnDefNode *output_func)
+                FnDefNode *update_func, FnDefNode *merge_func, FnDefNode *output_func,
+                FnDefNode *retract_func = nullptr)
         : FnDefNode(kUdafDef),
           name_(name),
           arg_types_(arg_types),
           init_expr_(init_expr),
           update_(update_func),
           merge_(merge_func),
-          output_(output_func) {}
+          output_(output_func),
+          retract_(retract_func) {}
 
     const std::string GetName() const override { return name_; }
 
@@ -2516,8 +2518,11 @@ class UdafDefNode : public FnDefNode {
     FnDefNode *update_func() const { return update_; }
     FnDefNode *merge_func() const { return merge_; }
     FnDefNode *output_func() const { return output_; }
+    // inverse of update, remove an element from the state
+    FnDefNode *retract_func() const { return retract_; }
 
     bool AllowMerge() const { return merge_ != nullptr; }
+    bool AllowRetract() const { return retract_ != nullptr; }
 
     base::Status Validate(const std::vector<const TypeNode *> &arg_types) const override;
 
@@ -2567,6 +2572,7 @@ class UdafDefNode : public FnDefNode {
     FnDefNode *update_;
     FnDefNode *merge_;
     FnDefNode *output_;
+    FnDefNode *retract_;
 };
 
 class PartitionMetaNode : public SqlNode {
@@ -235,6 +235,10 @@ class ResultSet {
     virtual bool IsNULL(int index) = 0;
 
     virtual int32_t Size() = 0;
+
+    // the error which stops Next before all of the rows are read, the rows
+    // read are incomplete if it is not ok
+    virtual void GetStatus(Status* status) { *status = Status(); }
 };
 
 }  // namespace sdk
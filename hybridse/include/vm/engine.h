@@ -17,6 +17,9 @@
 #ifndef HYBRIDSE_INCLUDE_VM_ENGINE_H_
 #define HYBRIDSE_INCLUDE_VM_ENGINE_H_
 
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <functional>
 #include <map>
 #include <memory>
 #include <mutex>  //NOLINT
@@ -110,6 +113,42 @@ class EngineOptions {
         return enable_window_column_pruning_;
     }
 
+    /// Set `true` to keep the states of sliding window sum/avg/count/min/max
+    /// between rows in batch mode instead of rescanning the window, default
+    /// `true`. Only aggregations on integer columns whose udafs register a
+    /// retract function are maintained incrementally.
+    inline EngineOptions* SetEnableIncrementalWindowAgg(bool flag) {
+        enable_incremental_window_agg_ = flag;
+        return this;
+    }
+    /// Return if the engine keeps the sliding window aggregation states.
+    inline bool IsEnableIncrementalWindowAgg() const {
+        return enable_incremental_window_agg_;
+    }
+
+    /// Set the number of threads used to run window aggregation on partition
+    /// keys in batch mode, default `1` which means run serially.
+    inline EngineOptions* SetWindowAggParallelism(uint32_t parallelism) {
+        window_agg_parallelism_ = parallelism;
+        return this;
+    }
+    /// Return the number of threads used by batch window aggregation.
+    inline uint32_t GetWindowAggParallelism() const {
+        return window_agg_parallelism_;
+    }
+
+    /// Set the number of threads used to run the independent inputs of a
+    /// runner concurrently, e.g. the windows and last joins of a deployment
+    /// in request mode, default `1` which means run serially.
+    inline EngineOptions* SetBranchParallelism(uint32_t parallelism) {
+        branch_parallelism_ = parallelism;
+        return this;
+    }
+    /// Return the number of threads used to run the independent inputs.
+    inline uint32_t GetBranchParallelism() const {
+        return branch_parallelism_;
+    }
+
     /// Set the maximum number of cache entries, default is `50`.
     inline void SetMaxSqlCacheSize(uint32_t size) {
         max_sql_cache_size_ = size;
@@ -117,6 +156,16 @@ class EngineOptions {
     /// Return the maximum number of entries we can hold for compiling cache.
     inline uint32_t GetMaxSqlCacheSize() const { return max_sql_cache_size_; }
 
+    /// Set `true` to lift the literals of WHERE clause into parameters for batch mode query, default `false`.
+    ///
+    /// If set `true`, the queries which differ only in the literals share one compiling result.
+    inline EngineOptions* SetEnableSqlNormalize(bool flag) {
+        enable_sql_normalize_ = flag;
+        return this;
+    }
+    /// Return if the engine lifts the literals into parameters.
+    inline bool IsEnableSqlNormalize() const { return enable_sql_normalize_; }
+
     /// Set `true` to enable spark unsafe row format, default `false`.
     EngineOptions* SetEnableSparkUnsaferowFormat(bool flag);
     /// Return if the engine can support can support spark unsafe row format.
@@ -136,7 +185,11 @@ class EngineOptions {
     bool enable_expr_optimize_;
     bool enable_batch_window_parallelization_;
     bool enable_window_column_pruning_;
+    bool enable_incremental_window_agg_;
+    uint32_t window_agg_parallelism_;
+    uint32_t branch_parallelism_;
     uint32_t max_sql_cache_size_;
+    bool enable_sql_normalize_;
     bool enable_spark_unsaferow_format_;
     JitOptions jit_options_;
 };
@@ -203,12 +256,25 @@ class BatchRunSession : public RunSession {
     /// Query results will be returned as std::vector<Row> in output
     int32_t Run(std::vector<Row>& output,  // NOLINT
                 uint64_t limit = 0);
+
+    /// \brief Query sql with parameter row in batch mode.
+    /// Query results will be passed to output one by one, and the query
+    /// stops once output returns false. Only the rows of a root table
+    /// project are produced lazily, the other plans, e.g. window aggregation,
+    /// still materialize their whole result before it is passed to output
+    int32_t Run(const Row& parameter_row, const std::function<bool(const Row&)>& output);
     /// Bing the run session with specific parameter schema
     void SetParameterSchema(const codec::Schema& schema) { parameter_schema_ = schema; }
     /// Return query parameter schema.
     virtual const Schema& GetParameterSchema() const { return parameter_schema_; }
+    /// Return the parameter row of the literals lifted by the engine, it is used
+    /// when the query runs with an empty parameter row
+    const Row& GetLiftedParameterRow() const { return lifted_parameter_row_; }
+
  private:
     codec::Schema parameter_schema_;
+    Row lifted_parameter_row_;
+    friend Engine;
 };
 
 /// \brief MockRequestRunSession is a kind of mock RuSession design for request query
@@ -327,10 +393,21 @@ struct ExplainOutput {
 };
 
 
+/// \brief The statistics of engine compiling cache.
+struct EngineCacheStats {
+    uint64_t hit_cnt = 0;              ///< The number of queries served by the cache
+    uint64_t miss_cnt = 0;             ///< The number of queries compiled
+    uint64_t dedup_cnt = 0;            ///< The number of queries waiting for the same compiling in progress
+    uint64_t normalized_cnt = 0;       ///< The number of queries compiled or served with lifted literals
+    uint64_t compile_time_us = 0;      ///< The total time of compiling in microseconds
+    uint64_t max_compile_time_us = 0;  ///< The maximum time of compiling in microseconds
+};
+
 /// \brief An engine is responsible to compile SQL on the specific Catalog.
 ///
 /// An engine can be used to `compile sql and explain the compiling result.
-/// It maintains a LRU cache for compiling result.
+/// It maintains a LRU cache for compiling result. The concurrent queries
+/// missing the cache with the same SQL are compiled only once.
 ///
 /// **Example**
 /// ```
@@ -404,6 +481,9 @@ class Engine {
     /// \brief Get engine's options
     EngineOptions GetEngineOptions();
 
+    /// \brief Get the statistics of engine's compiling result cache
+    EngineCacheStats GetCacheStats() const;
+
  private:
     bool GetDependentTables(const node::PlanNode* node, const std::string& default_db,
                             std::set<std::pair<std::string, std::string>>* db_tables, base::Status& status);  // NOLINT
@@ -418,6 +498,17 @@ class Engine {
                            std::shared_ptr<CompileInfo> info,
                            base::Status& status);  // NOLINT
 
+    // get the compiling result from the cache, or compile it once for all of
+    // the concurrent callers with the same key
+    bool GetCompileInfo(const std::string& sql, const std::string& db,
+                        RunSession& session,    // NOLINT
+                        base::Status& status);  // NOLINT
+    std::shared_ptr<CompileInfo> Compile(const std::string& sql, const std::string& db,
+                                         RunSession& session,    // NOLINT
+                                         base::Status& status);  // NOLINT
+    // the sql with the session config which decides the compiling result
+    std::string GetInflightKey(const std::string& sql, const std::string& db, RunSession& session);  // NOLINT
+
     bool Explain(const std::string& sql, const std::string& db,
                  EngineMode engine_mode, const codec::Schema& parameter_schema,
                  const std::set<size_t>& common_column_indices,
@@ -426,6 +517,23 @@ class Engine {
     EngineOptions options_;
     base::SpinMutex mu_;
     EngineLRUCache lru_cache_;
+
+    // a compiling in progress, the callers with the same key wait for it
+    struct InflightCompile {
+        std::condition_variable cv;
+        bool done = false;
+        std::shared_ptr<CompileInfo> info;
+        base::Status status;
+    };
+    std::mutex inflight_mu_;
+    std::map<std::string, std::shared_ptr<InflightCompile>> inflight_;
+
+    std::atomic<uint64_t> hit_cnt_;
+    std::atomic<uint64_t> miss_cnt_;
+    std::atomic<uint64_t> dedup_cnt_;
+    std::atomic<uint64_t> normalized_cnt_;
+    std::atomic<uint64_t> compile_time_us_;
+    std::atomic<uint64_t> max_compile_time_us_;
 };
 
 /// \brief Local tablet is responsible to run a task locally.
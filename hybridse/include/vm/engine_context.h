@@ -99,11 +99,22 @@ class JitOptions {
     bool IsEnablePerf() const { return enable_perf_; }
     void SetEnablePerf(bool flag) { enable_perf_ = flag; }
 
+    // the dir to keep the compiled objects across restarts, empty means disabled
+    const std::string& GetObjectCacheDir() const { return object_cache_dir_; }
+    void SetObjectCacheDir(const std::string& dir) { object_cache_dir_ = dir; }
+
+    // the max bytes of the objects kept in the dir, the least recently used
+    // ones are removed beyond it
+    uint64_t GetObjectCacheMaxBytes() const { return object_cache_max_bytes_; }
+    void SetObjectCacheMaxBytes(uint64_t max_bytes) { object_cache_max_bytes_ = max_bytes; }
+
  private:
     bool enable_mcjit_ = false;
     bool enable_vtune_ = false;
     bool enable_gdb_ = false;
     bool enable_perf_ = false;
+    std::string object_cache_dir_;
+    uint64_t object_cache_max_bytes_ = 1024 * 1024 * 1024;
 };
 }  // namespace vm
 }  // namespace hybridse
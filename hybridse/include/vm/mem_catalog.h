@@ -239,6 +239,72 @@ class MemTimeTableHandler : public TableHandler {
     OrderType order_type_;
 };
 
+/**
+ * Monotonic deque over int64 values keeping the min (or max) of a sliding
+ * window. Rows are numbered by their position in the window, evicting the
+ * oldest row pops it from the front if it is still the extremum.
+ */
+class MinMaxWindowDeque {
+ public:
+    explicit MinMaxWindowDeque(bool is_min)
+        : is_min_(is_min), head_seq_(0), tail_seq_(0), items_() {}
+
+    // buffer the newest row of window
+    void PushBack(int64_t value, bool is_null);
+    // buffer a row older than all buffered ones, used when rebuilding the
+    // deque from the newest row to the oldest one
+    void PushFront(int64_t value, bool is_null);
+    // evict the oldest row of window
+    void EvictOldest();
+    // return the current min/max, or `default_value` if no valid row
+    int64_t Front(int64_t default_value) const {
+        return items_.empty() ? default_value : items_.front().second;
+    }
+    void Clear() {
+        head_seq_ = 0;
+        tail_seq_ = 0;
+        items_.clear();
+    }
+
+ private:
+    // `l` should be kept rather than `r` if `l` is newer
+    inline bool Prefer(int64_t l, int64_t r) const {
+        return is_min_ ? l < r : l > r;
+    }
+    const bool is_min_;
+    // sequence of the oldest row and the next row
+    int64_t head_seq_;
+    int64_t tail_seq_;
+    std::deque<std::pair<int64_t, int64_t>> items_;
+};
+
+/**
+ * Running aggregate state that a generated window function keeps in a
+ * window between two calls. It is brought up to date either by applying
+ * the rows added and evicted since the last call, or by a full rescan.
+ */
+class WindowAggState {
+ public:
+    enum SyncMode {
+        kRescan = 0,
+        kApplyDelta = 1,
+        kUpToDate = 2,
+    };
+    explicit WindowAggState(size_t bytes)
+        : buf_(bytes, 0), deques_(), epoch_(0), mode_(kRescan) {}
+
+    int8_t* buf() { return buf_.data(); }
+    SyncMode mode() const { return mode_; }
+    MinMaxWindowDeque* GetDeque(size_t idx, bool is_min);
+
+ private:
+    friend class Window;
+    std::vector<int8_t> buf_;
+    std::vector<std::unique_ptr<MinMaxWindowDeque>> deques_;
+    uint64_t epoch_;
+    SyncMode mode_;
+};
+
 class Window : public MemTimeTableHandler {
  public:
     enum WindowFrameType {
@@ -262,7 +328,7 @@ class Window : public MemTimeTableHandler {
         return new vm::MemTimeTableIterator(&table_, schema_);
     }
     virtual bool BufferData(uint64_t key, const Row& row) = 0;
-    virtual void PopBackData() { PopBackRow(); }
+    virtual void PopBackData() { EvictBackRow(); }
     virtual void PopFrontData() = 0;
 
     virtual const uint64_t GetCount() { return table_.size(); }
@@ -286,9 +352,37 @@ class Window : public MemTimeTableHandler {
         exclude_current_time_ = flag;
     }
 
+    // rows added to and evicted from the window since the aggregate states
+    // were synced last time, in the order they happened
+    const MemTimeTable& appended_rows() const { return appended_rows_; }
+    const MemTimeTable& retracted_rows() const { return retracted_rows_; }
+
+    /**
+     * Find or create the aggregate state of `key` and decide how the caller
+     * should bring it up to date. `fifo_only` means the state can only
+     * retract the oldest rows, so evicting the newest row needs a rescan.
+     */
+    WindowAggState* SyncAggState(uint64_t key, size_t bytes, bool fifo_only);
+
  protected:
+    // window content changes go through these to keep track of the delta
+    void AppendFrontRow(uint64_t key, const Row& row);
+    void EvictBackRow();
+    void EvictFrontRow();
+
     bool exclude_current_time_;
     bool instance_not_in_window_;
+
+ private:
+    bool TrackDelta();
+
+    MemTimeTable appended_rows_;
+    MemTimeTable retracted_rows_;
+    bool front_retracted_ = false;
+    bool delta_overflow_ = false;
+    bool delta_consumed_ = false;
+    uint64_t epoch_ = 0;
+    std::map<uint64_t, std::unique_ptr<WindowAggState>> agg_states_;
 };
 class WindowRange {
  public:
@@ -370,14 +464,14 @@ class HistoryWindow : public Window {
     ~HistoryWindow() {}
     virtual void PopFrontData() {
         if (current_history_buffer_.empty()) {
-            PopFrontRow();
+            EvictFrontRow();
         } else {
             current_history_buffer_.pop_front();
         }
     }
     virtual void PopEffectiveData() {
         if (!table_.empty()) {
-            PopFrontRow();
+            EvictFrontRow();
         }
     }
     bool BufferData(uint64_t key, const Row& row) {
@@ -427,11 +521,11 @@ class HistoryWindow : public Window {
 
     bool BufferEffectiveWindow(uint64_t key, const Row& row,
                                uint64_t start_ts) {
-        AddFrontRow(key, row);
+        AppendFrontRow(key, row);
         auto cur_size = table_.size();
         while (window_range_.max_size_ > 0 &&
                cur_size > window_range_.max_size_) {
-            PopBackRow();
+            EvictBackRow();
             --cur_size;
         }
 
@@ -445,7 +539,7 @@ class HistoryWindow : public Window {
             }
             if (kFrameRows == window_range_.frame_type_ ||
                 pair.first < start_ts) {
-                PopBackRow();
+                EvictBackRow();
                 --cur_size;
 
             } else {
@@ -489,7 +583,7 @@ class CurrentHistoryWindow : public HistoryWindow {
                                     max_size)) {}
     ~CurrentHistoryWindow() {}
 
-    virtual void PopFrontData() { PopFrontRow(); }
+    virtual void PopFrontData() { EvictFrontRow(); }
     bool BufferData(uint64_t key, const Row& row) {
         if (!table_.empty() && GetFrontRow().first > key) {
             DLOG(WARNING) << "Fail BufferData: buffer key less than latest key";
@@ -772,6 +866,19 @@ size_t RowIterGetCurSliceSize(int8_t* iter, size_t idx);
 void RowIterDelete(int8_t* iter);
 int8_t* RowGetSlice(int8_t* row_ptr, size_t idx);
 size_t RowGetSliceSize(int8_t* row_ptr, size_t idx);
+
+// incremental window aggregation interfaces for llvm
+int8_t* WindowAggStateSync(int8_t* input, uint64_t key, size_t bytes,
+                           int8_t fifo_only);
+int32_t WindowAggStateMode(int8_t* state);
+int8_t* WindowAggStateBuf(int8_t* state);
+void GetWindowAggDeltaIter(int8_t* input, int8_t* state, int8_t retracted,
+                           int8_t* iter_addr);
+int8_t* WindowAggStateDeque(int8_t* state, size_t idx, int8_t is_min);
+void WindowAggDequePushBack(int8_t* deque, int64_t value, int8_t is_null);
+void WindowAggDequePushFront(int8_t* deque, int64_t value, int8_t is_null);
+void WindowAggDequeEvict(int8_t* deque);
+int64_t WindowAggDequeFront(int8_t* deque, int64_t default_value);
 }  // namespace vm
 }  // namespace hybridse
 #endif  // HYBRIDSE_INCLUDE_VM_MEM_CATALOG_H_
@@ -23,6 +23,7 @@
 #include <utility>
 #include <vector>
 
+#include "codec/aggr_codec.h"
 #include "node/plan_node.h"
 #include "passes/expression/expr_pass.h"
 #include "vm/catalog.h"
@@ -52,6 +53,7 @@ enum PhysicalOpType {
     kPhysicalOpIndexSeek,
     kPhysicalOpRequestUnion,
     kPhysicalOpPostRequestUnion,
+    kPhysicalOpRequestAggUnion,
     kPhysicalOpRequestJoin,
     kPhysicalOpRequestGroup,
     kPhysicalOpRequestGroupAndSort,
@@ -1470,6 +1472,77 @@ class PhysicalRequestUnionNode : public PhysicalBinaryNode {
     RequestWindowUnionList window_unions_;
 };
 
+/**
+ * One aggregation over request window which can be answered by pre-aggr
+ * table. `col_idx` is the position of aggregated column in request schema,
+ * -1 for `count(*)`.
+ */
+struct RequestAggSpec {
+    codec::AggrFuncType func_type;
+    int32_t col_idx;
+    std::shared_ptr<TableHandler> aggr_table;
+};
+
+/**
+ * Aggregate request window with the whole buckets of pre-aggr tables and the
+ * raw rows of base table out of those buckets. It replaces the request union
+ * and the aggregation project over it, and outputs the aggregation row with
+ * the same schema and column ids as the replaced project.
+ */
+class PhysicalRequestAggUnionNode : public PhysicalBinaryNode {
+ public:
+    PhysicalRequestAggUnionNode(PhysicalOpNode *left, PhysicalOpNode *right,
+                                const RequestWindowOp &window,
+                                const node::ExprListNode *aggr_keys,
+                                int64_t bucket_size,
+                                const std::vector<RequestAggSpec> &aggr_specs,
+                                const SchemaSource *output_source)
+        : PhysicalBinaryNode(left, right, kPhysicalOpRequestAggUnion, true),
+          window_(window),
+          aggr_key_(aggr_keys),
+          bucket_size_(bucket_size),
+          aggr_specs_(aggr_specs),
+          output_schema_(*output_source->GetSchema()) {
+        output_type_ = kSchemaTypeRow;
+        for (size_t i = 0; i < output_source->size(); ++i) {
+            output_column_ids_.push_back(output_source->GetColumnID(i));
+        }
+
+        fn_infos_.push_back(&window_.partition_.fn_info());
+        fn_infos_.push_back(&window_.sort_.fn_info());
+        fn_infos_.push_back(&window_.range_.fn_info());
+        fn_infos_.push_back(&window_.index_key_.fn_info());
+        fn_infos_.push_back(&aggr_key_.fn_info());
+    }
+    virtual ~PhysicalRequestAggUnionNode() {}
+    base::Status InitSchema(PhysicalPlanContext *) override;
+    virtual void Print(std::ostream &output, const std::string &tab) const;
+
+    base::Status WithNewChildren(node::NodeManager *nm,
+                                 const std::vector<PhysicalOpNode *> &children,
+                                 PhysicalOpNode **out) override;
+
+    static PhysicalRequestAggUnionNode *CastFrom(PhysicalOpNode *node);
+
+    const RequestWindowOp &window() const { return window_; }
+    const Key &aggr_key() const { return aggr_key_; }
+    const int64_t bucket_size() const { return bucket_size_; }
+    const std::vector<RequestAggSpec> &aggr_specs() const {
+        return aggr_specs_;
+    }
+
+    RequestWindowOp window_;
+    // key of pre-aggr tables, which is the partition keys in the order of
+    // base table index
+    Key aggr_key_;
+
+ private:
+    const int64_t bucket_size_;
+    const std::vector<RequestAggSpec> aggr_specs_;
+    const codec::Schema output_schema_;
+    std::vector<size_t> output_column_ids_;
+};
+
 class PhysicalSortNode : public PhysicalUnaryNode {
  public:
     PhysicalSortNode(PhysicalOpNode *node, const node::OrderByNode *order)
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef HYBRIDSE_INCLUDE_VM_WORKER_POOL_H_
+#define HYBRIDSE_INCLUDE_VM_WORKER_POOL_H_
+
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+namespace hybridse {
+namespace vm {
+
+/**
+ * Workers shared by the runners which split their work among workers, so a
+ * run does not spawn threads of its own.
+ */
+class WorkerPool {
+ public:
+    virtual ~WorkerPool() {}
+
+    /**
+     * Get the process wide pool, a `ThreadWorkerPool` with a thread per
+     * hardware thread unless another one is set by `SetInstance`.
+     */
+    static WorkerPool* GetInstance();
+
+    /**
+     * Replace the process wide pool, e.g. by one running the workers as
+     * coroutines so the caller yields instead of blocking its thread while
+     * it waits. `pool` should outlive every run of the engines.
+     */
+    static void SetInstance(WorkerPool* pool);
+
+    /**
+     * Run `worker` on the caller and on up to `worker_num - 1` workers of
+     * the pool, return when all of them have returned. `worker` should take
+     * the work from a shared cursor until there is none left.
+     */
+    virtual void Run(size_t worker_num,
+                     const std::function<void()>& worker) = 0;
+};
+
+/**
+ * Worker pool of threads, the caller waits on a condition variable.
+ */
+class ThreadWorkerPool : public WorkerPool {
+ public:
+    explicit ThreadWorkerPool(size_t thread_num);
+    ~ThreadWorkerPool();
+    ThreadWorkerPool(const ThreadWorkerPool&) = delete;
+    ThreadWorkerPool& operator=(const ThreadWorkerPool&) = delete;
+
+    /**
+     * The caller never waits for a pool thread to pick the job up: the
+     * threads that get to it after the caller's `worker` has returned skip
+     * it. So runners nested in a worker may use the pool as well.
+     */
+    void Run(size_t worker_num, const std::function<void()>& worker) override;
+
+ private:
+    struct Job {
+        const std::function<void()>* worker = nullptr;
+        std::mutex mu;
+        std::condition_variable cv;
+        size_t running = 0;
+        bool finished = false;
+    };
+
+    void ThreadProc();
+
+    std::mutex mu_;
+    std::condition_variable cv_;
+    std::deque<std::shared_ptr<Job>> jobs_;
+    bool stop_;
+    std::vector<std::thread> threads_;
+};
+
+}  // namespace vm
+}  // namespace hybridse
+#endif  // HYBRIDSE_INCLUDE_VM_WORKER_POOL_H_
@@ -0,0 +1,147 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <unistd.h>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "benchmark/benchmark.h"
+#include "udf/default_udf_library.h"
+#include "vm/engine.h"
+#include "vm/jit_wrapper.h"
+#include "vm/simple_catalog.h"
+#include "vm/sql_compiler.h"
+
+namespace hybridse {
+namespace bm {
+using vm::HybridSeJitWrapper;
+using vm::JitSymbolTable;
+
+static std::shared_ptr<vm::SimpleCatalog> GetJitBmCatalog() {
+    hybridse::type::Database db;
+    db.set_name("db");
+    ::hybridse::type::TableDef* table = db.add_tables();
+    table->set_name("t1");
+    table->set_catalog("db");
+    {
+        ::hybridse::type::ColumnDef* column = table->add_columns();
+        column->set_type(::hybridse::type::kDouble);
+        column->set_name("col_1");
+    }
+    {
+        ::hybridse::type::ColumnDef* column = table->add_columns();
+        column->set_type(::hybridse::type::kInt64);
+        column->set_name("col_2");
+    }
+    {
+        ::hybridse::type::ColumnDef* column = table->add_columns();
+        column->set_type(::hybridse::type::kVarchar);
+        column->set_name("col_3");
+    }
+    auto catalog = std::make_shared<vm::SimpleCatalog>();
+    catalog->AddDatabase(db);
+    return catalog;
+}
+
+static uint64_t GetResidentBytes() {
+    std::ifstream statm("/proc/self/statm");
+    uint64_t size = 0;
+    uint64_t resident = 0;
+    statm >> size >> resident;
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+// compile the query once, return false if it fails
+static bool GetJitBmIr(std::string* ir, std::string* fn_name) {
+    vm::EngineOptions options;
+    options.SetKeepIr(true);
+    base::Status status;
+    vm::BatchRunSession session;
+    vm::Engine engine(GetJitBmCatalog(), options);
+    if (!engine.Get("select col_1 + 1.0 as c1, substr(col_3, 1, 2) as c3, col_2 * 2 as c2 from t1;", "db",
+                    session, status)) {
+        return false;
+    }
+    auto& sql_context = std::dynamic_pointer_cast<vm::SqlCompileInfo>(session.GetCompileInfo())->get_sql_context();
+    *ir = sql_context.ir;
+    *fn_name = sql_context.physical_plan->GetFnInfos()[0]->fn_name();
+    return !ir->empty();
+}
+
+// create state.range(0) jits and keep them as the compiling cache does, report
+// the resident memory each one holds
+static void CreateJits(benchmark::State* state, bool shared_symbols) {
+    std::string ir;
+    std::string fn_name;
+    if (!GetJitBmIr(&ir, &fn_name)) {
+        state->SkipWithError("fail to compile sql");
+        return;
+    }
+    uint64_t jit_cnt = 0;
+    uint64_t rss = 0;
+    for (auto _ : *state) {
+        std::vector<std::unique_ptr<HybridSeJitWrapper>> jits;
+        uint64_t start_rss = GetResidentBytes();
+        for (int64_t i = 0; i < state->range(0); i++) {
+            std::unique_ptr<HybridSeJitWrapper> jit(HybridSeJitWrapper::Create());
+            if (!jit->Init()) {
+                state->SkipWithError("fail to init jit");
+                return;
+            }
+            if (shared_symbols) {
+                jit->LinkSymbolTable(JitSymbolTable::GetInstance());
+            } else {
+                vm::InitBuiltinJitSymbols(jit.get());
+                udf::DefaultUdfLibrary::get()->InitJITSymbols(jit.get());
+            }
+            base::RawBuffer ir_buf(const_cast<char*>(ir.data()), ir.size());
+            if (!jit->AddModuleFromBuffer(ir_buf) || jit->FindFunction(fn_name) == nullptr) {
+                state->SkipWithError("fail to add module");
+                return;
+            }
+            jits.push_back(std::move(jit));
+        }
+        uint64_t end_rss = GetResidentBytes();
+        rss += end_rss > start_rss ? end_rss - start_rss : 0;
+        jit_cnt += jits.size();
+        state->PauseTiming();
+        jits.clear();
+        state->ResumeTiming();
+    }
+    state->counters["rss_per_jit"] = jit_cnt > 0 ? static_cast<double>(rss) / jit_cnt : 0;
+    state->counters["symbols"] = JitSymbolTable::GetInstance()->size();
+}
+
+static void BM_CreateJitEagerSymbols(benchmark::State& state) {  // NOLINT
+    CreateJits(&state, false);
+}
+
+static void BM_CreateJitSharedSymbols(benchmark::State& state) {  // NOLINT
+    CreateJits(&state, true);
+}
+
+BENCHMARK(BM_CreateJitEagerSymbols)->Args({10})->Args({200});
+BENCHMARK(BM_CreateJitSharedSymbols)->Args({10})->Args({200});
+}  // namespace bm
+}  // namespace hybridse
+
+int main(int argc, char** argv) {
+    ::hybridse::vm::Engine::InitializeGlobalLLVM();
+    ::benchmark::Initialize(&argc, argv);
+    ::benchmark::RunSpecifiedBenchmarks();
+    return 0;
+}
@@ -0,0 +1,188 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "codec/aggr_codec.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "boost/algorithm/string.hpp"
+
+namespace hybridse {
+namespace codec {
+
+bool GetAggrFuncType(const std::string& name, AggrFuncType* type) {
+    std::string func = boost::to_lower_copy(name);
+    if (func == "sum") {
+        *type = kAggrSum;
+    } else if (func == "min") {
+        *type = kAggrMin;
+    } else if (func == "max") {
+        *type = kAggrMax;
+    } else if (func == "count") {
+        *type = kAggrCount;
+    } else if (func == "avg") {
+        *type = kAggrAvg;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool ParseAggrBucketSize(const std::string& bucket_size, bool* is_row_bucket,
+                         int64_t* size) {
+    if (bucket_size.empty()) {
+        return false;
+    }
+    size_t pos = 0;
+    while (pos < bucket_size.size() && isdigit(bucket_size[pos])) {
+        pos++;
+    }
+    if (pos == 0 || pos + 1 < bucket_size.size()) {
+        return false;
+    }
+    int64_t num = std::stoll(bucket_size.substr(0, pos));
+    if (num <= 0) {
+        return false;
+    }
+    if (pos == bucket_size.size()) {
+        *is_row_bucket = true;
+        *size = num;
+        return true;
+    }
+    int64_t unit = 0;
+    switch (tolower(bucket_size[pos])) {
+        case 's':
+            unit = 1000;
+            break;
+        case 'm':
+            unit = 60 * 1000;
+            break;
+        case 'h':
+            unit = 60 * 60 * 1000;
+            break;
+        case 'd':
+            unit = 24 * 60 * 60 * 1000;
+            break;
+        default:
+            return false;
+    }
+    *is_row_bucket = false;
+    *size = num * unit;
+    return true;
+}
+
+void AggrValue::Update(int64_t val) {
+    if (is_double_) {
+        Update(static_cast<double>(val));
+        return;
+    }
+    switch (type_) {
+        case kAggrSum:
+            i64_ += val;
+            break;
+        case kAggrMin:
+            i64_ = cnt_ == 0 ? val : std::min(i64_, val);
+            break;
+        case kAggrMax:
+            i64_ = cnt_ == 0 ? val : std::max(i64_, val);
+            break;
+        default:
+            break;
+    }
+    cnt_++;
+}
+
+void AggrValue::Update(double val) {
+    if (!is_double_) {
+        Update(static_cast<int64_t>(val));
+        return;
+    }
+    switch (type_) {
+        case kAggrSum:
+        case kAggrAvg:
+            f64_ += val;
+            break;
+        case kAggrMin:
+            f64_ = cnt_ == 0 ? val : std::min(f64_, val);
+            break;
+        case kAggrMax:
+            f64_ = cnt_ == 0 ? val : std::max(f64_, val);
+            break;
+        default:
+            break;
+    }
+    cnt_++;
+}
+
+void AggrValue::Merge(const AggrValue& other) {
+    if (other.cnt_ == 0) {
+        return;
+    }
+    if (cnt_ == 0) {
+        cnt_ = other.cnt_;
+        i64_ = other.i64_;
+        f64_ = other.f64_;
+        return;
+    }
+    switch (type_) {
+        case kAggrSum:
+        case kAggrAvg:
+            i64_ += other.i64_;
+            f64_ += other.f64_;
+            break;
+        case kAggrMin:
+            i64_ = std::min(i64_, other.i64_);
+            f64_ = std::min(f64_, other.f64_);
+            break;
+        case kAggrMax:
+            i64_ = std::max(i64_, other.i64_);
+            f64_ = std::max(f64_, other.f64_);
+            break;
+        default:
+            break;
+    }
+    cnt_ += other.cnt_;
+}
+
+void AggrValue::Encode(std::string* buf) const {
+    buf->resize(ENCODE_SIZE);
+    char* ptr = &(*buf)[0];
+    memcpy(ptr, &cnt_, sizeof(int64_t));
+    if (is_double_) {
+        memcpy(ptr + sizeof(int64_t), &f64_, sizeof(double));
+    } else {
+        memcpy(ptr + sizeof(int64_t), &i64_, sizeof(int64_t));
+    }
+}
+
+bool AggrValue::Decode(const char* buf, uint32_t size) {
+    Reset();
+    if (buf == nullptr || size != ENCODE_SIZE) {
+        return false;
+    }
+    memcpy(&cnt_, buf, sizeof(int64_t));
+    if (is_double_) {
+        memcpy(&f64_, buf + sizeof(int64_t), sizeof(double));
+    } else {
+        memcpy(&i64_, buf + sizeof(int64_t), sizeof(int64_t));
+    }
+    return true;
+}
+
+}  // namespace codec
+}  // namespace hybridse
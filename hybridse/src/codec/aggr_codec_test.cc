@@ -0,0 +1,119 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "codec/aggr_codec.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace hybridse {
+namespace codec {
+
+class AggrCodecTest : public ::testing::Test {};
+
+TEST_F(AggrCodecTest, ParseBucketSize) {
+    bool is_row = false;
+    int64_t size = 0;
+    ASSERT_TRUE(ParseAggrBucketSize("100", &is_row, &size));
+    ASSERT_TRUE(is_row);
+    ASSERT_EQ(100, size);
+    ASSERT_TRUE(ParseAggrBucketSize("1d", &is_row, &size));
+    ASSERT_FALSE(is_row);
+    ASSERT_EQ(86400000, size);
+    ASSERT_TRUE(ParseAggrBucketSize("30s", &is_row, &size));
+    ASSERT_EQ(30000, size);
+    ASSERT_TRUE(ParseAggrBucketSize("2H", &is_row, &size));
+    ASSERT_EQ(7200000, size);
+    ASSERT_FALSE(ParseAggrBucketSize("", &is_row, &size));
+    ASSERT_FALSE(ParseAggrBucketSize("d", &is_row, &size));
+    ASSERT_FALSE(ParseAggrBucketSize("1w", &is_row, &size));
+    ASSERT_FALSE(ParseAggrBucketSize("1dd", &is_row, &size));
+    ASSERT_FALSE(ParseAggrBucketSize("0", &is_row, &size));
+}
+
+TEST_F(AggrCodecTest, UpdateAndMerge) {
+    AggrFuncType type;
+    ASSERT_TRUE(GetAggrFuncType("SUM", &type));
+    ASSERT_EQ(kAggrSum, type);
+    ASSERT_FALSE(GetAggrFuncType("distinct_count", &type));
+
+    AggrValue sum(kAggrSum, false);
+    ASSERT_TRUE(sum.IsNull());
+    sum.Update(static_cast<int64_t>(3));
+    sum.Update(static_cast<int64_t>(4));
+    AggrValue sum2(kAggrSum, false);
+    sum2.Update(static_cast<int64_t>(5));
+    sum.Merge(sum2);
+    ASSERT_EQ(12, sum.GetInt64());
+    ASSERT_EQ(3, sum.GetCount());
+
+    AggrValue min(kAggrMin, true);
+    min.Update(2.5);
+    AggrValue min2(kAggrMin, true);
+    min2.Update(-1.5);
+    min.Merge(min2);
+    ASSERT_DOUBLE_EQ(-1.5, min.GetDouble());
+
+    AggrValue max(kAggrMax, false);
+    max.Merge(AggrValue(kAggrMax, false));
+    ASSERT_TRUE(max.IsNull());
+    max.Update(static_cast<int64_t>(-7));
+    ASSERT_EQ(-7, max.GetInt64());
+
+    // avg accumulates in double even for integral inputs
+    AggrValue avg(kAggrAvg, false);
+    ASSERT_TRUE(avg.IsDouble());
+    avg.Update(static_cast<int64_t>(1));
+    avg.Update(static_cast<int64_t>(2));
+    ASSERT_DOUBLE_EQ(3.0, avg.GetDouble());
+    ASSERT_EQ(2, avg.GetCount());
+
+    AggrValue count(kAggrCount, false);
+    ASSERT_FALSE(count.IsNull());
+    ASSERT_EQ(0, count.GetCount());
+}
+
+TEST_F(AggrCodecTest, EncodeAndDecode) {
+    AggrValue avg(kAggrAvg, false);
+    avg.Update(1.5);
+    avg.Update(static_cast<int64_t>(2));
+    std::string buf;
+    avg.Encode(&buf);
+    ASSERT_EQ(AggrValue::ENCODE_SIZE, buf.size());
+
+    AggrValue decoded(kAggrAvg, false);
+    ASSERT_TRUE(decoded.Decode(buf.data(), buf.size()));
+    ASSERT_EQ(2, decoded.GetCount());
+    ASSERT_DOUBLE_EQ(3.5, decoded.GetDouble());
+
+    AggrValue sum(kAggrSum, false);
+    sum.Update(static_cast<int64_t>(1) << 40);
+    sum.Encode(&buf);
+    AggrValue sum_decoded(kAggrSum, false);
+    ASSERT_TRUE(sum_decoded.Decode(buf.data(), buf.size()));
+    ASSERT_EQ(static_cast<int64_t>(1) << 40, sum_decoded.GetInt64());
+    ASSERT_FALSE(sum_decoded.Decode(buf.data(), 8));
+    ASSERT_TRUE(sum_decoded.IsNull());
+}
+
+}  // namespace codec
+}  // namespace hybridse
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
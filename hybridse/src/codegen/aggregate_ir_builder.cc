@@ -26,14 +26,20 @@
 #include "codegen/variable_ir_builder.h"
 #include "gflags/gflags.h"
 #include "glog/logging.h"
+#include "vm/mem_catalog.h"
+
 namespace hybridse {
 namespace codegen {
 
 AggregateIRBuilder::AggregateIRBuilder(const vm::SchemasContext* sc,
                                        ::llvm::Module* module,
                                        const node::FrameNode* frame_node,
-                                       uint32_t id)
-    : schema_context_(sc), module_(module), frame_node_(frame_node), id_(id) {
+                                       uint32_t id, bool incremental)
+    : schema_context_(sc),
+      module_(module),
+      frame_node_(frame_node),
+      id_(id),
+      incremental_(incremental) {
     available_agg_func_set_.insert("sum");
     available_agg_func_set_.insert("avg");
     available_agg_func_set_.insert("count");
@@ -52,6 +58,10 @@ bool AggregateIRBuilder::CollectAggColumn(const hybridse::node::ExprNode* expr,
         case node::kExprCall: {
             auto call = dynamic_cast<const node::CallExprNode*>(expr);
             std::string agg_func_name = "";
+            // sum/avg/count are kept incrementally only when the udaf
+            // registers a retract function, external functions may be any
+            // function sharing the name
+            bool retractable = false;
             switch (call->GetFnDef()->GetType()) {
                 case node::kExternalFnDef: {
                     agg_func_name =
@@ -61,9 +71,13 @@ bool AggregateIRBuilder::CollectAggColumn(const hybridse::node::ExprNode* expr,
                     break;
                 }
                 case node::kUdafDef: {
-                    agg_func_name =
-                        dynamic_cast<const node::UdafDefNode*>(call->GetFnDef())
-                            ->GetName();
+                    auto udaf =
+                        dynamic_cast<const node::UdafDefNode*>(call->GetFnDef());
+                    agg_func_name = udaf->GetName();
+                    // min/max are maintained by monotonic deques instead
+                    retractable = udaf->AllowRetract() ||
+                                  agg_func_name == "min" ||
+                                  agg_func_name == "max";
                     break;
                 }
                 default:
@@ -125,6 +139,15 @@ bool AggregateIRBuilder::CollectAggColumn(const hybridse::node::ExprNode* expr,
                     AggColumnInfo(col, node_type, schema_idx, col_idx, offset);
             }
             agg_col_infos_[col_key].AddAgg(agg_func_name, output_idx);
+
+            // sliding states are kept across calls only when every agg can
+            // be inverted exactly
+            bool exact_type = node_type == node::kInt16 ||
+                              node_type == node::kInt32 ||
+                              node_type == node::kInt64;
+            if (!exact_type || !retractable) {
+                incremental_ = false;
+            }
             return true;
         }
         default:
@@ -136,8 +159,10 @@ bool AggregateIRBuilder::CollectAggColumn(const hybridse::node::ExprNode* expr,
 class StatisticalAggGenerator {
  public:
     StatisticalAggGenerator(node::DataType col_type,
-                            const std::vector<std::string>& col_keys)
+                            const std::vector<std::string>& col_keys,
+                            bool incremental)
         : col_type_(col_type),
+          incremental_(incremental),
           col_num_(col_keys.size()),
           col_keys_(col_keys),
           sum_idxs_(col_num_),
@@ -167,6 +192,13 @@ class StatisticalAggGenerator {
 
     ::llvm::Value* GenAvgInitState(::llvm::IRBuilder<>* builder) {
         ::llvm::LLVMContext& llvm_ctx = builder->getContext();
+        if (incremental_) {
+            ::llvm::Type* int64_ty = ::llvm::Type::getInt64Ty(llvm_ctx);
+            ::llvm::Value* accum = CreateAllocaAtHead(builder, int64_ty, "avg");
+            builder->CreateStore(::llvm::ConstantInt::get(int64_ty, 0, true),
+                                 accum);
+            return accum;
+        }
         ::llvm::Type* llvm_ty =
             AggregateIRBuilder::GetOutputLlvmType(llvm_ctx, "avg", col_type_);
         ::llvm::Value* accum = CreateAllocaAtHead(builder, llvm_ty, "avg");
@@ -285,12 +317,17 @@ class StatisticalAggGenerator {
     void GenAvgUpdate(size_t i, ::llvm::Value* input, ::llvm::Value* is_null,
                       ::llvm::IRBuilder<>* builder) {
         ::llvm::Value* accum = builder->CreateLoad(avg_states_[i]);
-        if (input->getType()->isIntegerTy()) {
-            input = builder->CreateSIToFP(input, accum->getType());
+        ::llvm::Value* sum;
+        if (accum->getType()->isIntegerTy()) {
+            sum = builder->CreateAdd(
+                accum, builder->CreateSExt(input, accum->getType()));
+        } else if (input->getType()->isIntegerTy()) {
+            sum = builder->CreateFAdd(
+                accum, builder->CreateSIToFP(input, accum->getType()));
         } else {
-            input = builder->CreateFPCast(input, accum->getType());
+            sum = builder->CreateFAdd(
+                accum, builder->CreateFPCast(input, accum->getType()));
         }
-        ::llvm::Value* sum = builder->CreateFAdd(accum, input);
         sum = builder->CreateSelect(is_null, accum, sum);
         builder->CreateStore(sum, avg_states_[i]);
     }
@@ -363,6 +400,203 @@ class StatisticalAggGenerator {
         }
     }
 
+    void GenSumRetract(size_t i, ::llvm::Value* input, ::llvm::Value* is_null,
+                       ::llvm::IRBuilder<>* builder) {
+        ::llvm::Value* accum = builder->CreateLoad(sum_states_[i]);
+        ::llvm::Value* sub;
+        if (input->getType()->isIntegerTy()) {
+            sub = builder->CreateSub(accum, input);
+        } else {
+            sub = builder->CreateFSub(accum, input);
+        }
+        sub = builder->CreateSelect(is_null, accum, sub);
+        builder->CreateStore(sub, sum_states_[i]);
+    }
+
+    void GenAvgRetract(size_t i, ::llvm::Value* input, ::llvm::Value* is_null,
+                       ::llvm::IRBuilder<>* builder) {
+        ::llvm::Value* accum = builder->CreateLoad(avg_states_[i]);
+        ::llvm::Value* sum = builder->CreateSub(
+            accum, builder->CreateSExt(input, accum->getType()));
+        sum = builder->CreateSelect(is_null, accum, sum);
+        builder->CreateStore(sum, avg_states_[i]);
+    }
+
+    void GenCountRetract(::llvm::IRBuilder<>* builder, ::llvm::Value* is_null) {
+        ::llvm::Value* cnt = builder->CreateLoad(count_state_);
+        ::llvm::Value* new_cnt = builder->CreateSub(
+            cnt, ::llvm::ConstantInt::get(cnt->getType(), 1, true));
+        new_cnt = builder->CreateSelect(is_null, cnt, new_cnt);
+        builder->CreateStore(new_cnt, count_state_);
+    }
+
+    // inverse of GenUpdate, min and max are maintained by deques instead
+    void GenRetract(::llvm::IRBuilder<>* builder,
+                    const std::vector<::llvm::Value*>& inputs,
+                    const std::vector<::llvm::Value*>& is_null) {
+        bool count_retracted = false;
+        for (size_t i = 0; i < col_num_; ++i) {
+            if (!sum_idxs_[i].empty() ||
+                (!avg_idxs_[i].empty() && avg_states_[i] == nullptr)) {
+                GenSumRetract(i, inputs[i], is_null[i], builder);
+            }
+            if (!avg_idxs_[i].empty() && avg_states_[i] != nullptr) {
+                GenAvgRetract(i, inputs[i], is_null[i], builder);
+            }
+            if ((!avg_idxs_[i].empty() || !count_idxs_[i].empty() ||
+                 !min_idxs_[i].empty() || !max_idxs_[i].empty()) &&
+                !count_retracted) {
+                GenCountRetract(builder, is_null[i]);
+                count_retracted = true;
+            }
+        }
+    }
+
+    bool HasMinMax() const {
+        for (size_t i = 0; i < col_num_; ++i) {
+            if (!min_idxs_[i].empty() || !max_idxs_[i].empty()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // assign every sum/avg/count state a 8 bytes slot of the window state
+    // buffer, return the offset after the last slot
+    size_t AssignStateSlots(size_t offset) {
+        state_slots_.clear();
+        for (size_t i = 0; i < col_num_; ++i) {
+            if (sum_states_[i] != nullptr) {
+                state_slots_.emplace_back(sum_states_[i], offset);
+                offset += 8;
+            }
+            if (avg_states_[i] != nullptr) {
+                state_slots_.emplace_back(avg_states_[i], offset);
+                offset += 8;
+            }
+        }
+        if (count_state_ != nullptr) {
+            state_slots_.emplace_back(count_state_, offset);
+            offset += 8;
+        }
+        return offset;
+    }
+
+    void GenLoadStates(::llvm::IRBuilder<>* builder, ::llvm::Value* buf) {
+        for (auto& slot : state_slots_) {
+            ::llvm::Value* addr = GetStateSlotAddr(builder, buf, slot);
+            builder->CreateStore(builder->CreateLoad(addr), slot.first);
+        }
+    }
+
+    void GenSaveStates(::llvm::IRBuilder<>* builder, ::llvm::Value* buf) {
+        for (auto& slot : state_slots_) {
+            ::llvm::Value* addr = GetStateSlotAddr(builder, buf, slot);
+            builder->CreateStore(builder->CreateLoad(slot.first), addr);
+        }
+    }
+
+    // fetch deques of min/max from window state, deque index starts from
+    // `*idx` and is advanced by the number of deques used
+    void GenGetDeques(::llvm::IRBuilder<>* builder, ::llvm::Value* state,
+                      size_t* idx) {
+        ::llvm::Type* ptr_ty = builder->getInt8PtrTy();
+        auto get_deque_func =
+            builder->GetInsertBlock()->getModule()->getOrInsertFunction(
+                "hybridse_storage_window_agg_state_deque",
+                ::llvm::FunctionType::get(
+                    ptr_ty, {ptr_ty, builder->getInt64Ty(), builder->getInt8Ty()},
+                    false));
+        min_deques_.assign(col_num_, nullptr);
+        max_deques_.assign(col_num_, nullptr);
+        for (size_t i = 0; i < col_num_; ++i) {
+            if (!min_idxs_[i].empty()) {
+                min_deques_[i] = builder->CreateCall(
+                    get_deque_func, {state, builder->getInt64((*idx)++),
+                                     builder->getInt8(1)});
+            }
+            if (!max_idxs_[i].empty()) {
+                max_deques_[i] = builder->CreateCall(
+                    get_deque_func, {state, builder->getInt64((*idx)++),
+                                     builder->getInt8(0)});
+            }
+        }
+    }
+
+    // push row into deques, `front` is true when rows are visited from the
+    // newest one to the oldest one
+    void GenDequePush(::llvm::IRBuilder<>* builder,
+                      const std::vector<::llvm::Value*>& inputs,
+                      const std::vector<::llvm::Value*>& is_null, bool front) {
+        ::llvm::Type* ptr_ty = builder->getInt8PtrTy();
+        auto push_func =
+            builder->GetInsertBlock()->getModule()->getOrInsertFunction(
+                front ? "hybridse_storage_window_agg_deque_push_front"
+                      : "hybridse_storage_window_agg_deque_push_back",
+                ::llvm::FunctionType::get(
+                    builder->getVoidTy(),
+                    {ptr_ty, builder->getInt64Ty(), builder->getInt8Ty()},
+                    false));
+        for (size_t i = 0; i < col_num_; ++i) {
+            if (min_deques_[i] == nullptr && max_deques_[i] == nullptr) {
+                continue;
+            }
+            ::llvm::Value* value =
+                builder->CreateSExt(inputs[i], builder->getInt64Ty());
+            ::llvm::Value* null_flag =
+                builder->CreateZExt(is_null[i], builder->getInt8Ty());
+            for (auto deque : {min_deques_[i], max_deques_[i]}) {
+                if (deque != nullptr) {
+                    builder->CreateCall(push_func, {deque, value, null_flag});
+                }
+            }
+        }
+    }
+
+    void GenDequeEvict(::llvm::IRBuilder<>* builder) {
+        ::llvm::Type* ptr_ty = builder->getInt8PtrTy();
+        auto evict_func =
+            builder->GetInsertBlock()->getModule()->getOrInsertFunction(
+                "hybridse_storage_window_agg_deque_evict",
+                ::llvm::FunctionType::get(builder->getVoidTy(), {ptr_ty},
+                                          false));
+        for (size_t i = 0; i < col_num_; ++i) {
+            for (auto deque : {min_deques_[i], max_deques_[i]}) {
+                if (deque != nullptr) {
+                    builder->CreateCall(evict_func, {deque});
+                }
+            }
+        }
+    }
+
+    // load min/max from deques, the initial state is kept for empty window
+    void GenLoadMinMax(::llvm::IRBuilder<>* builder) {
+        ::llvm::Type* ptr_ty = builder->getInt8PtrTy();
+        auto front_func =
+            builder->GetInsertBlock()->getModule()->getOrInsertFunction(
+                "hybridse_storage_window_agg_deque_front",
+                ::llvm::FunctionType::get(builder->getInt64Ty(),
+                                          {ptr_ty, builder->getInt64Ty()},
+                                          false));
+        for (size_t i = 0; i < col_num_; ++i) {
+            std::vector<std::pair<::llvm::Value*, ::llvm::Value*>> pairs = {
+                {min_deques_[i], min_states_[i]},
+                {max_deques_[i], max_states_[i]}};
+            for (auto& pair : pairs) {
+                if (pair.first == nullptr) {
+                    continue;
+                }
+                ::llvm::Value* init = builder->CreateLoad(pair.second);
+                ::llvm::Value* front = builder->CreateCall(
+                    front_func,
+                    {pair.first,
+                     builder->CreateSExt(init, builder->getInt64Ty())});
+                builder->CreateStore(
+                    builder->CreateTrunc(front, init->getType()), pair.second);
+            }
+        }
+    }
+
     void GenOutputs(::llvm::IRBuilder<>* builder,
                     std::vector<std::pair<size_t, NativeValue>>* outputs) {
         for (size_t i = 0; i < col_num_; ++i) {
@@ -386,6 +620,9 @@ class StatisticalAggGenerator {
                 } else {
                     sum = builder->CreateLoad(avg_states_[i]);
                 }
+                if (sum->getType()->isIntegerTy()) {
+                    sum = builder->CreateSIToFP(sum, avg_ty);
+                }
                 ::llvm::Value* avg = builder->CreateFDiv(
                     sum, builder->CreateSIToFP(cnt, avg_ty));
                 for (int idx : avg_idxs_[i]) {
@@ -443,7 +680,20 @@ class StatisticalAggGenerator {
     const std::vector<std::string>& GetColKeys() const { return col_keys_; }
 
  private:
+    ::llvm::Value* GetStateSlotAddr(
+        ::llvm::IRBuilder<>* builder, ::llvm::Value* buf,
+        const std::pair<::llvm::Value*, size_t>& slot) {
+        ::llvm::Type* state_ty =
+            reinterpret_cast<::llvm::PointerType*>(slot.first->getType())
+                ->getElementType();
+        ::llvm::Value* addr = builder->CreateInBoundsGEP(
+            builder->getInt8Ty(), buf, builder->getInt64(slot.second));
+        return builder->CreatePointerCast(addr, state_ty->getPointerTo());
+    }
+
     node::DataType col_type_;
+    // states are retracted, avg of integers keeps an exact int64 sum
+    bool incremental_;
     size_t col_num_;
     std::vector<std::string> col_keys_;
 
@@ -459,6 +709,11 @@ class StatisticalAggGenerator {
     std::vector<::llvm::Value*> min_states_;
     std::vector<::llvm::Value*> max_states_;
     ::llvm::Value* count_state_;
+
+    // sliding window states, see AggregateIRBuilder::BuildIncrementalAgg
+    std::vector<std::pair<::llvm::Value*, size_t>> state_slots_;
+    std::vector<::llvm::Value*> min_deques_;
+    std::vector<::llvm::Value*> max_deques_;
 };
 
 llvm::Type* AggregateIRBuilder::GetOutputLlvmType(
@@ -513,7 +768,7 @@ size_t GetTypeByteSize(node::DataType dtype) {
 
 base::Status ScheduleAggGenerators(
     std::unordered_map<std::string, AggColumnInfo>& agg_col_infos,  // NOLINT
-    std::vector<StatisticalAggGenerator>* res) {
+    bool incremental, std::vector<StatisticalAggGenerator>* res) {
     // collect and sort used input columns
     std::vector<std::string> col_keys;
     for (auto& pair : agg_col_infos) {
@@ -552,7 +807,8 @@ base::Status ScheduleAggGenerators(
 
         if (finish_seq) {
             // create generator from contiguous seq
-            StatisticalAggGenerator agg_gen(cur_col_type, agg_gen_col_seq);
+            StatisticalAggGenerator agg_gen(cur_col_type, agg_gen_col_seq,
+                                            incremental);
             for (size_t i = 0; i < agg_gen_col_seq.size(); ++i) {
                 auto& geninfo = agg_col_infos[agg_gen_col_seq[i]];
                 geninfo.Show();
@@ -624,15 +880,15 @@ base::Status AggregateIRBuilder::BuildMulti(const std::string& base_funcname,
 
     ::llvm::BasicBlock* head_block =
         ::llvm::BasicBlock::Create(llvm_ctx, "head", fn);
-    ::llvm::BasicBlock* enter_block =
-        ::llvm::BasicBlock::Create(llvm_ctx, "enter_iter", fn);
-    ::llvm::BasicBlock* body_block =
-        ::llvm::BasicBlock::Create(llvm_ctx, "iter_body", fn);
+    ::llvm::BasicBlock* scan_block =
+        ::llvm::BasicBlock::Create(llvm_ctx, "scan", fn);
+    ::llvm::BasicBlock* scan_iter_block =
+        ::llvm::BasicBlock::Create(llvm_ctx, "scan_iter", fn);
     ::llvm::BasicBlock* exit_block =
         ::llvm::BasicBlock::Create(llvm_ctx, "exit_iter", fn);
 
     std::vector<StatisticalAggGenerator> generators;
-    CHECK_STATUS(ScheduleAggGenerators(agg_col_infos_, &generators), common::kCodegenUdafError,
+    CHECK_STATUS(ScheduleAggGenerators(agg_col_infos_, incremental_, &generators), common::kCodegenUdafError,
                  "Schedule agg ops failed")
 
     // gen head
@@ -649,19 +905,179 @@ base::Status AggregateIRBuilder::BuildMulti(const std::string& base_funcname,
     ::llvm::Value* iter_ptr = CreateAllocaAtHead(
         &builder, ::llvm::Type::getInt8Ty(llvm_ctx), "row_iter",
         ::llvm::ConstantInt::get(int64_ty, iter_bytes, true));
+
+    if (incremental_) {
+        size_t state_bytes = 0;
+        bool fifo_only = false;
+        for (auto& agg_generator : generators) {
+            state_bytes = agg_generator.AssignStateSlots(state_bytes);
+            fifo_only = fifo_only || agg_generator.HasMinMax();
+        }
+        // states of different agg functions on the same window are told
+        // apart by the function name
+        uint64_t state_key = std::hash<std::string>()(fn_name);
+        auto sync_func = module_->getOrInsertFunction(
+            "hybridse_storage_window_agg_state_sync",
+            ::llvm::FunctionType::get(
+                ptr_ty, {ptr_ty, int64_ty, int64_ty, builder.getInt8Ty()},
+                false));
+        ::llvm::Value* state = builder.CreateCall(
+            sync_func, {input_arg, builder.getInt64(state_key),
+                        builder.getInt64(state_bytes),
+                        builder.getInt8(fifo_only)});
+        ::llvm::BasicBlock* sync_block =
+            ::llvm::BasicBlock::Create(llvm_ctx, "sync_state", fn);
+        // the input is not a sliding window, fallback to scan
+        builder.CreateCondBr(builder.CreateIsNull(state), scan_block,
+                             sync_block);
+        CHECK_STATUS(BuildIncrementalAgg(input_arg, state, iter_ptr,
+                                         &generators, sync_block, exit_block));
+    } else {
+        builder.CreateBr(scan_block);
+    }
+
+    // gen full scan
+    builder.SetInsertPoint(scan_block);
     auto get_iter_func = module_->getOrInsertFunction(
         "hybridse_storage_get_row_iter", void_ty, ptr_ty, ptr_ty);
     builder.CreateCall(get_iter_func, {input_arg, iter_ptr});
-    builder.CreateBr(enter_block);
+    builder.CreateBr(scan_iter_block);
+    CHECK_STATUS(BuildAggLoop(kAggScan, iter_ptr, &generators, scan_iter_block,
+                              exit_block));
+
+    // store results to output row
+    builder.SetInsertPoint(exit_block);
+    std::map<uint32_t, NativeValue> dummy_map;
+    BufNativeEncoderIRBuilder output_encoder(&dummy_map, &output_schema,
+                                             exit_block);
+    for (auto& agg_generator : generators) {
+        std::vector<std::pair<size_t, NativeValue>> outputs;
+        agg_generator.GenOutputs(&builder, &outputs);
+        for (auto pair : outputs) {
+            output_encoder.BuildEncodePrimaryField(output_arg, pair.first,
+                                                   pair.second);
+        }
+    }
+    builder.CreateRetVoid();
+    return base::Status::OK();
+}
+
+base::Status AggregateIRBuilder::BuildIncrementalAgg(
+    ::llvm::Value* input, ::llvm::Value* state, ::llvm::Value* iter_ptr,
+    std::vector<StatisticalAggGenerator>* generators,
+    ::llvm::BasicBlock* sync_block, ::llvm::BasicBlock* exit_block) {
+    ::llvm::LLVMContext& llvm_ctx = module_->getContext();
+    ::llvm::IRBuilder<> builder(llvm_ctx);
+    ::llvm::Function* fn = sync_block->getParent();
+    auto void_ty = llvm::Type::getVoidTy(llvm_ctx);
+    auto int8_ty = llvm::Type::getInt8Ty(llvm_ctx);
+    auto int32_ty = llvm::Type::getInt32Ty(llvm_ctx);
+    auto ptr_ty = int8_ty->getPointerTo();
+
+    ::llvm::BasicBlock* rebuild_block =
+        ::llvm::BasicBlock::Create(llvm_ctx, "rebuild", fn);
+    ::llvm::BasicBlock* rebuild_iter_block =
+        ::llvm::BasicBlock::Create(llvm_ctx, "rebuild_iter", fn);
+    ::llvm::BasicBlock* retract_block =
+        ::llvm::BasicBlock::Create(llvm_ctx, "retract", fn);
+    ::llvm::BasicBlock* retract_iter_block =
+        ::llvm::BasicBlock::Create(llvm_ctx, "retract_iter", fn);
+    ::llvm::BasicBlock* append_block =
+        ::llvm::BasicBlock::Create(llvm_ctx, "append", fn);
+    ::llvm::BasicBlock* append_iter_block =
+        ::llvm::BasicBlock::Create(llvm_ctx, "append_iter", fn);
+    ::llvm::BasicBlock* delta_end_block =
+        ::llvm::BasicBlock::Create(llvm_ctx, "delta_end", fn);
+    ::llvm::BasicBlock* save_block =
+        ::llvm::BasicBlock::Create(llvm_ctx, "save_state", fn);
+
+    // gen state sync
+    builder.SetInsertPoint(sync_block);
+    auto mode_func = module_->getOrInsertFunction(
+        "hybridse_storage_window_agg_state_mode",
+        ::llvm::FunctionType::get(int32_ty, {ptr_ty}, false));
+    auto buf_func = module_->getOrInsertFunction(
+        "hybridse_storage_window_agg_state_buf",
+        ::llvm::FunctionType::get(ptr_ty, {ptr_ty}, false));
+    ::llvm::Value* mode = builder.CreateCall(mode_func, {state});
+    ::llvm::Value* buf = builder.CreateCall(buf_func, {state});
+    size_t deque_idx = 0;
+    for (auto& agg_generator : *generators) {
+        agg_generator.GenGetDeques(&builder, state, &deque_idx);
+    }
+    ::llvm::Value* need_rescan = builder.CreateICmpEQ(
+        mode, builder.getInt32(vm::WindowAggState::kRescan));
+    builder.CreateCondBr(need_rescan, rebuild_block, retract_block);
+
+    // gen rebuild, states are computed from scratch
+    builder.SetInsertPoint(rebuild_block);
+    auto get_iter_func = module_->getOrInsertFunction(
+        "hybridse_storage_get_row_iter", void_ty, ptr_ty, ptr_ty);
+    builder.CreateCall(get_iter_func, {input, iter_ptr});
+    builder.CreateBr(rebuild_iter_block);
+    CHECK_STATUS(BuildAggLoop(kAggRebuild, iter_ptr, generators,
+                              rebuild_iter_block, save_block));
+
+    // gen delta, states of last call are updated by evicted and added rows
+    auto get_delta_iter_func = module_->getOrInsertFunction(
+        "hybridse_storage_get_window_agg_delta_iter",
+        ::llvm::FunctionType::get(void_ty, {ptr_ty, ptr_ty, int8_ty, ptr_ty},
+                                  false));
+    builder.SetInsertPoint(retract_block);
+    for (auto& agg_generator : *generators) {
+        agg_generator.GenLoadStates(&builder, buf);
+    }
+    builder.CreateCall(get_delta_iter_func,
+                       {input, state, builder.getInt8(1), iter_ptr});
+    builder.CreateBr(retract_iter_block);
+    CHECK_STATUS(BuildAggLoop(kAggRetract, iter_ptr, generators,
+                              retract_iter_block, append_block));
+
+    builder.SetInsertPoint(append_block);
+    builder.CreateCall(get_delta_iter_func,
+                       {input, state, builder.getInt8(0), iter_ptr});
+    builder.CreateBr(append_iter_block);
+    CHECK_STATUS(BuildAggLoop(kAggAppend, iter_ptr, generators,
+                              append_iter_block, delta_end_block));
+
+    builder.SetInsertPoint(delta_end_block);
+    for (auto& agg_generator : *generators) {
+        agg_generator.GenLoadMinMax(&builder);
+    }
+    builder.CreateBr(save_block);
+
+    builder.SetInsertPoint(save_block);
+    for (auto& agg_generator : *generators) {
+        agg_generator.GenSaveStates(&builder, buf);
+    }
+    builder.CreateBr(exit_block);
+    return base::Status::OK();
+}
+
+base::Status AggregateIRBuilder::BuildAggLoop(
+    AggLoopKind kind, ::llvm::Value* iter_ptr,
+    std::vector<StatisticalAggGenerator>* generators,
+    ::llvm::BasicBlock* loop_block, ::llvm::BasicBlock* exit_block) {
+    ::llvm::LLVMContext& llvm_ctx = module_->getContext();
+    ::llvm::IRBuilder<> builder(llvm_ctx);
+    ::llvm::Function* fn = loop_block->getParent();
+    auto void_ty = llvm::Type::getVoidTy(llvm_ctx);
+    auto int64_ty = llvm::Type::getInt64Ty(llvm_ctx);
+    auto ptr_ty = llvm::Type::getInt8Ty(llvm_ctx)->getPointerTo();
+
+    ::llvm::BasicBlock* body_block =
+        ::llvm::BasicBlock::Create(llvm_ctx, "iter_body", fn);
+    ::llvm::BasicBlock* end_block =
+        ::llvm::BasicBlock::Create(llvm_ctx, "end_iter", fn);
 
     // gen iter begin
-    builder.SetInsertPoint(enter_block);
+    builder.SetInsertPoint(loop_block);
     auto bool_ty = llvm::Type::getInt1Ty(llvm_ctx);
     auto has_next_func = module_->getOrInsertFunction(
         "hybridse_storage_row_iter_has_next",
         ::llvm::FunctionType::get(bool_ty, {ptr_ty}, false));
     ::llvm::Value* has_next = builder.CreateCall(has_next_func, iter_ptr);
-    builder.CreateCondBr(has_next, body_block, exit_block);
+    builder.CreateCondBr(has_next, body_block, end_block);
 
     // gen iter body
     builder.SetInsertPoint(body_block);
@@ -723,7 +1139,7 @@ base::Status AggregateIRBuilder::BuildMulti(const std::string& base_funcname,
     }
 
     // compute accumulation
-    for (auto& agg_generator : generators) {
+    for (auto& agg_generator : *generators) {
         std::vector<::llvm::Value*> fields;
         std::vector<::llvm::Value*> fields_is_null;
         for (auto& key : agg_generator.GetColKeys()) {
@@ -733,34 +1149,40 @@ base::Status AggregateIRBuilder::BuildMulti(const std::string& base_funcname,
             fields.push_back(field_value.GetValue(&builder));
             fields_is_null.push_back(field_value.GetIsNull(&builder));
         }
-        agg_generator.GenUpdate(&builder, fields, fields_is_null);
+        switch (kind) {
+            case kAggScan:
+                agg_generator.GenUpdate(&builder, fields, fields_is_null);
+                break;
+            case kAggRebuild:
+                // window rows are visited from the newest to the oldest
+                agg_generator.GenUpdate(&builder, fields, fields_is_null);
+                agg_generator.GenDequePush(&builder, fields, fields_is_null,
+                                           true);
+                break;
+            case kAggAppend:
+                agg_generator.GenUpdate(&builder, fields, fields_is_null);
+                agg_generator.GenDequePush(&builder, fields, fields_is_null,
+                                           false);
+                break;
+            case kAggRetract:
+                agg_generator.GenRetract(&builder, fields, fields_is_null);
+                agg_generator.GenDequeEvict(&builder);
+                break;
+        }
     }
     auto next_func = module_->getOrInsertFunction(
         "hybridse_storage_row_iter_next",
         ::llvm::FunctionType::get(void_ty, {ptr_ty}, false));
     builder.CreateCall(next_func, {iter_ptr});
-    builder.CreateBr(enter_block);
+    builder.CreateBr(loop_block);
 
     // gen iter end
-    builder.SetInsertPoint(exit_block);
+    builder.SetInsertPoint(end_block);
     auto delete_iter_func = module_->getOrInsertFunction(
         "hybridse_storage_row_iter_delete",
         ::llvm::FunctionType::get(void_ty, {ptr_ty}, false));
     builder.CreateCall(delete_iter_func, {iter_ptr});
-
-    // store results to output row
-    std::map<uint32_t, NativeValue> dummy_map;
-    BufNativeEncoderIRBuilder output_encoder(&dummy_map, &output_schema,
-                                             exit_block);
-    for (auto& agg_generator : generators) {
-        std::vector<std::pair<size_t, NativeValue>> outputs;
-        agg_generator.GenOutputs(&builder, &outputs);
-        for (auto pair : outputs) {
-            output_encoder.BuildEncodePrimaryField(output_arg, pair.first,
-                                                   pair.second);
-        }
-    }
-    builder.CreateRetVoid();
+    builder.CreateBr(exit_block);
     return base::Status::OK();
 }
 
@@ -77,10 +77,13 @@ struct AggColumnInfo {
     }
 };
 
+class StatisticalAggGenerator;
+
 class AggregateIRBuilder {
  public:
     AggregateIRBuilder(const vm::SchemasContext*, ::llvm::Module* module,
-                       const node::FrameNode* frame_node, uint32_t id);
+                       const node::FrameNode* frame_node, uint32_t id,
+                       bool incremental = false);
 
     // TODO(someone): remove temporary implementations for row-wise agg
     static bool EnableColumnAggOpt();
@@ -103,13 +106,38 @@ class AggregateIRBuilder {
 
     bool empty() const { return agg_col_infos_.empty(); }
 
+    // whether the window states are maintained incrementally between calls
+    bool incremental() const { return incremental_; }
+
  private:
+    enum AggLoopKind {
+        // aggregate every row of window
+        kAggScan,
+        // aggregate every row and rebuild the min/max deques
+        kAggRebuild,
+        // aggregate rows added since the last call
+        kAggAppend,
+        // retract rows evicted since the last call
+        kAggRetract,
+    };
+
+    base::Status BuildAggLoop(AggLoopKind kind, ::llvm::Value* iter_ptr,
+                              std::vector<StatisticalAggGenerator>* generators,
+                              ::llvm::BasicBlock* loop_block,
+                              ::llvm::BasicBlock* exit_block);
+
+    base::Status BuildIncrementalAgg(
+        ::llvm::Value* input, ::llvm::Value* state, ::llvm::Value* iter_ptr,
+        std::vector<StatisticalAggGenerator>* generators,
+        ::llvm::BasicBlock* sync_block, ::llvm::BasicBlock* exit_block);
+
     const vm::SchemasContext* schema_context_;
     ::llvm::Module* module_;
     const node::FrameNode* frame_node_;
     uint32_t id_;
     std::set<std::string> available_agg_func_set_;
     std::unordered_map<std::string, AggColumnInfo> agg_col_infos_;
+    bool incremental_;
 };
 
 }  // namespace codegen
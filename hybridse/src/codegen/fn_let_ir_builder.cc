@@ -28,7 +28,9 @@ using ::hybridse::common::kCodegenError;
 namespace hybridse {
 namespace codegen {
 
-RowFnLetIRBuilder::RowFnLetIRBuilder(CodeGenContext* ctx) : ctx_(ctx) {}
+RowFnLetIRBuilder::RowFnLetIRBuilder(CodeGenContext* ctx,
+                                     bool enable_incremental_window_agg)
+    : ctx_(ctx), enable_incremental_window_agg_(enable_incremental_window_agg) {}
 RowFnLetIRBuilder::~RowFnLetIRBuilder() {}
 
 Status RowFnLetIRBuilder::Build(
@@ -112,7 +114,8 @@ Status RowFnLetIRBuilder::Build(
         if (agg_iter == window_agg_builder.end()) {
             window_agg_builder.insert(std::make_pair(
                 frame_str, AggregateIRBuilder(ctx_->schemas_context(), module,
-                                              frame, agg_builder_id++)));
+                                              frame, agg_builder_id++,
+                                              enable_incremental_window_agg_)));
             agg_iter = window_agg_builder.find(frame_str);
         }
         if (agg_iter->second.CollectAggColumn(expr, i, &col_agg_type)) {
@@ -36,7 +36,8 @@ using hybridse::base::Status;
 
 class RowFnLetIRBuilder {
  public:
-    explicit RowFnLetIRBuilder(CodeGenContext* ctx);
+    explicit RowFnLetIRBuilder(CodeGenContext* ctx,
+                               bool enable_incremental_window_agg = false);
 
     ~RowFnLetIRBuilder();
 
@@ -69,6 +70,7 @@ class RowFnLetIRBuilder {
 
  private:
     CodeGenContext* ctx_;
+    bool enable_incremental_window_agg_;
 };
 
 }  // namespace codegen
@@ -1005,7 +1005,7 @@ UdfByCodeGenDefNode* UdfByCodeGenDefNode::DeepCopy(NodeManager* nm) const {
 
 UdafDefNode* UdafDefNode::ShadowCopy(NodeManager* nm) const {
     return nm->MakeUdafDefNode(name_, arg_types_, init_expr_, update_, merge_,
-                               output_);
+                               output_, retract_);
 }
 
 UdafDefNode* UdafDefNode::DeepCopy(NodeManager* nm) const {
@@ -1013,8 +1013,9 @@ UdafDefNode* UdafDefNode::DeepCopy(NodeManager* nm) const {
     FnDefNode* new_update = update_ ? update_->DeepCopy(nm) : nullptr;
     FnDefNode* new_merge = merge_ ? merge_->DeepCopy(nm) : nullptr;
     FnDefNode* new_output = output_ ? output_->DeepCopy(nm) : nullptr;
+    FnDefNode* new_retract = retract_ ? retract_->DeepCopy(nm) : nullptr;
     return nm->MakeUdafDefNode(name_, arg_types_, new_init, new_update,
-                               new_merge, new_output);
+                               new_merge, new_output, new_retract);
 }
 
 // Default expr deep copy: shadow copy self and deep copy children
@@ -1038,8 +1038,9 @@ node::UdfByCodeGenDefNode *NodeManager::MakeUdfByCodeGenDefNode(const std::strin
 
 node::UdafDefNode *NodeManager::MakeUdafDefNode(const std::string &name, const std::vector<const TypeNode *> &arg_types,
                                                 ExprNode *init, FnDefNode *update_func, FnDefNode *merge_func,
-                                                FnDefNode *output_func) {
-    return RegisterNode(new node::UdafDefNode(name, arg_types, init, update_func, merge_func, output_func));
+                                                FnDefNode *output_func, FnDefNode *retract_func) {
+    return RegisterNode(
+        new node::UdafDefNode(name, arg_types, init, update_func, merge_func, output_func, retract_func));
 }
 
 LambdaNode *NodeManager::MakeLambdaNode(const std::vector<ExprIdNode *> &args, ExprNode *body) {
@@ -2209,6 +2209,15 @@ Status UdafDefNode::Validate(const std::vector<const TypeNode *> &arg_types) con
                    output_func()->GetArgType(0)->GetName());
         CHECK_TRUE(output_func()->GetReturnType() != nullptr, kTypeError);
     }
+    // retract check
+    if (retract_func() != nullptr) {
+        CHECK_TRUE(retract_func()->GetArgSize() == update_func()->GetArgSize(), kTypeError, "Retract should take ",
+                   update_func()->GetArgSize(), ", get ", retract_func()->GetArgSize());
+        CHECK_TRUE(retract_func()->GetReturnType() != nullptr, kTypeError);
+        CHECK_TRUE(retract_func()->GetReturnType()->Equals(GetStateType()), kTypeError,
+                   "Retract's return type should be ", GetStateType()->GetName(), ", but get ",
+                   retract_func()->GetReturnType()->GetName());
+    }
     // actual args check
     CHECK_TRUE(arg_types.size() == arg_types_.size(), kTypeError, GetName(), " expect ", arg_types_.size(),
                " inputs, but get ", arg_types.size());
@@ -2224,7 +2233,8 @@ Status UdafDefNode::Validate(const std::vector<const TypeNode *> &arg_types) con
 bool UdafDefNode::Equals(const SqlNode *node) const {
     auto other = dynamic_cast<const UdafDefNode *>(node);
     return other != nullptr && init_expr_->Equals(other->init_expr()) && update_->Equals(other->update_) &&
-           FnDefEquals(merge_, other->merge_) && FnDefEquals(output_, other->output_);
+           FnDefEquals(merge_, other->merge_) && FnDefEquals(output_, other->output_) &&
+           FnDefEquals(retract_, other->retract_);
 }
 
 void UdafDefNode::Print(std::ostream &output, const std::string &org_tab) const {
@@ -2248,6 +2258,10 @@ void UdafDefNode::Print(std::ostream &output, const std::string &org_tab) const
     output << "\n";
     PrintSqlNode(output, tab, merge_, "merge", false);
     output << "\n";
+    if (retract_ != nullptr) {
+        PrintSqlNode(output, tab, retract_, "retract", false);
+        output << "\n";
+    }
     PrintSqlNode(output, tab, output_, "output", true);
 }
 
@@ -183,18 +183,18 @@ Status ExprInplaceTransformUp::VisitUdaf(
     }
 
     // update
+    std::vector<ExprAttrNode> update_args;
+    update_args.push_back(ExprAttrNode(udaf->GetStateType(), false));
+    for (auto& arg : arg_attrs) {
+        const node::TypeNode* dtype = arg.type();
+        if (dtype != nullptr && dtype->generics_.size() == 1) {
+            // list<T>
+            dtype = dtype->generics_[0];
+        }
+        update_args.push_back(ExprAttrNode(dtype, false));
+    }
     node::FnDefNode* update = udaf->update_func();
     if (update != nullptr) {
-        std::vector<ExprAttrNode> update_args;
-        update_args.push_back(ExprAttrNode(udaf->GetStateType(), false));
-        for (auto& arg : arg_attrs) {
-            const node::TypeNode* dtype = arg.type();
-            if (dtype != nullptr && dtype->generics_.size() == 1) {
-                // list<T>
-                dtype = dtype->generics_[0];
-            }
-            update_args.push_back(ExprAttrNode(dtype, false));
-        }
         CHECK_STATUS(VisitFnDef(udaf->update_func(), update_args, &update));
         if (update != udaf->update_func()) {
             changed = true;
@@ -224,10 +224,19 @@ Status ExprInplaceTransformUp::VisitUdaf(
         }
     }
 
+    // retract, same signature as update
+    node::FnDefNode* retract = udaf->retract_func();
+    if (retract != nullptr) {
+        CHECK_STATUS(VisitFnDef(udaf->retract_func(), update_args, &retract));
+        if (retract != udaf->retract_func()) {
+            changed = true;
+        }
+    }
+
     if (changed) {
         *out = ctx_->node_manager()->MakeUdafDefNode(
             udaf->GetName(), udaf->GetArgTypeList(), init, update, merge,
-            output_fn);
+            output_fn, retract);
     } else {
         *out = udaf;
     }
@@ -152,6 +152,23 @@ bool GroupAndSortOptimized::Transform(PhysicalOpNode* in,
             }
             return true;
         }
+        case PhysicalOpType::kPhysicalOpRequestAggUnion: {
+            PhysicalRequestAggUnionNode* union_op =
+                dynamic_cast<PhysicalRequestAggUnionNode*>(in);
+            PhysicalOpNode* new_producer;
+            // output schema of agg union is the aggregation result, resolve
+            // window keys with the request schema
+            if (KeysAndOrderFilterOptimized(
+                    union_op->GetProducer(0)->schemas_ctx(),
+                    union_op->GetProducer(1), &union_op->window_.partition_,
+                    &union_op->window_.index_key_, &union_op->window_.sort_,
+                    &new_producer)) {
+                if (!ResetProducer(plan_ctx_, union_op, 1, new_producer)) {
+                    return false;
+                }
+            }
+            return true;
+        }
         case PhysicalOpType::kPhysicalOpRequestJoin: {
             PhysicalRequestJoinNode* join_op =
                 dynamic_cast<PhysicalRequestJoinNode*>(in);
@@ -18,6 +18,7 @@
 
 #include <string>
 #include <tuple>
+#include <type_traits>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -97,8 +98,8 @@ struct BuildGetSecondUdf {
 template <typename T>
 struct SumUdafDef {
     void operator()(UdafRegistryHelper& helper) {  // NOLINT
-        helper.templates<T, T, T>()
-            .const_init(T(0))
+        auto impl = helper.templates<T, T, T>();
+        impl.const_init(T(0))
             .update([](UdfResolveContext* ctx, ExprNode* cur_sum,
                        ExprNode* input) {
                 auto nm = ctx->node_manager();
@@ -108,6 +109,17 @@ struct SumUdafDef {
                 return nm->MakeCondExpr(is_null, cur_sum, new_sum);
             })
             .output("identity");
+        // floating point sum can not be retracted exactly
+        if constexpr (std::is_integral_v<T>) {
+            impl.retract([](UdfResolveContext* ctx, ExprNode* cur_sum,
+                            ExprNode* input) {
+                auto nm = ctx->node_manager();
+                auto is_null = nm->MakeUnaryExprNode(input, node::kFnOpIsNull);
+                auto new_sum =
+                    nm->MakeBinaryExprNode(cur_sum, input, node::kFnOpMinus);
+                return nm->MakeCondExpr(is_null, cur_sum, new_sum);
+            });
+        }
     }
 };
 
@@ -219,6 +231,14 @@ struct CountUdafDef {
                     cur_cnt, nm->MakeConstNode(1), node::kFnOpAdd);
                 return nm->MakeCondExpr(is_null, cur_cnt, new_cnt);
             })
+            .retract([](UdfResolveContext* ctx, ExprNode* cur_cnt,
+                        ExprNode* input) {
+                auto nm = ctx->node_manager();
+                auto is_null = nm->MakeUnaryExprNode(input, node::kFnOpIsNull);
+                auto new_cnt = nm->MakeBinaryExprNode(
+                    cur_cnt, nm->MakeConstNode(1), node::kFnOpMinus);
+                return nm->MakeCondExpr(is_null, cur_cnt, new_cnt);
+            })
             .output("identity");
     }
 };
@@ -226,8 +246,8 @@ struct CountUdafDef {
 template <typename T>
 struct AvgUdafDef {
     void operator()(UdafRegistryHelper& helper) {  // NOLINT
-        helper.templates<double, Tuple<int64_t, double>, T>()
-            .const_init(MakeTuple(static_cast<int64_t>(0), 0.0))
+        auto impl = helper.templates<double, Tuple<int64_t, double>, T>();
+        impl.const_init(MakeTuple(static_cast<int64_t>(0), 0.0))
             .update(
                 [](UdfResolveContext* ctx, ExprNode* state, ExprNode* input) {
                     auto nm = ctx->node_manager();
@@ -250,6 +270,24 @@ struct AvgUdafDef {
                     nm->MakeBinaryExprNode(sum, cnt, node::kFnOpFDiv);
                 return avg;
             });
+        // exact while the double sum of integers stays below 2^53, the
+        // incremental window codegen keeps an int64 sum instead
+        if constexpr (std::is_integral_v<T>) {
+            impl.retract([](UdfResolveContext* ctx, ExprNode* state,
+                            ExprNode* input) {
+                auto nm = ctx->node_manager();
+                ExprNode* cnt = nm->MakeGetFieldExpr(state, 0);
+                ExprNode* sum = nm->MakeGetFieldExpr(state, 1);
+                ExprNode* is_null =
+                    nm->MakeUnaryExprNode(input, node::kFnOpIsNull);
+                cnt = nm->MakeBinaryExprNode(cnt, nm->MakeConstNode(1),
+                                             node::kFnOpMinus);
+                sum = nm->MakeBinaryExprNode(sum, input, node::kFnOpMinus);
+                auto new_state =
+                    nm->MakeFuncNode("make_tuple", {cnt, sum}, nullptr);
+                return nm->MakeCondExpr(is_null, state, new_state);
+            });
+        }
     }
 };
 
@@ -169,8 +169,15 @@ Status UdafRegistry::ResolveFunction(UdfResolveContext* ctx,
             udaf_gen_.output_gen->ResolveFunction(&output_ctx, &output_func),
             "Resolve output function of ", name(), " failed");
     }
+    // gen retract, it takes the same arguments as update
+    node::FnDefNode* retract_func = nullptr;
+    if (udaf_gen_.retract_gen != nullptr) {
+        CHECK_STATUS(
+            udaf_gen_.retract_gen->ResolveFunction(&update_ctx, &retract_func),
+            "Resolve retract function of ", name(), " failed");
+    }
     *result = nm->MakeUdafDefNode(name(), list_types, init_expr, update_func,
-                                  merge_func, output_func);
+                                  merge_func, output_func, retract_func);
     return Status::OK();
 }
 
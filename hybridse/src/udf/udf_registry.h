@@ -1451,6 +1451,8 @@ struct UdafDefGen {
     std::shared_ptr<UdfRegistry> update_gen = nullptr;
     std::shared_ptr<UdfRegistry> merge_gen = nullptr;
     std::shared_ptr<UdfRegistry> output_gen = nullptr;
+    // optional inverse of update, enables incremental sliding window
+    std::shared_ptr<UdfRegistry> retract_gen = nullptr;
     node::TypeNode* state_type = nullptr;
     bool state_nullable = false;
 };
@@ -1687,6 +1689,89 @@ class UdafRegistryHelperImpl : UdfRegistryHelper<UdafRegistry> {
         return update(fname, fn_ptr.ptr, fn_ptr.return_by_arg);
     }
 
+    /**
+     * Specify the inverse of update, which removes an input from the state:
+     * retract(update(state, x), x) == state. Sliding windows apply it on
+     * rows leaving the frame instead of aggregating the whole frame again.
+     */
+    UdafRegistryHelperImpl& retract(const std::string& fname) {
+        auto registry = library()->Find(fname, update_tys_);
+        if (registry != nullptr) {
+            udaf_gen_.retract_gen = registry;
+        } else {
+            LOG(WARNING) << "Fail to find udaf retract registry " << fname;
+        }
+        return *this;
+    }
+
+    UdafRegistryHelperImpl& retract(
+        const std::function<
+            Status(UdfResolveContext* ctx, const ExprAttrNode*,
+                   typename std::pair<IN, const ExprAttrNode*>::second_type...,
+                   ExprAttrNode*)>& infer,
+        const std::function<
+            Status(codegen::CodeGenContext*, codegen::NativeValue,
+                   typename std::pair<IN, codegen::NativeValue>::second_type...,
+                   codegen::NativeValue*)>& gen) {
+        auto llvm_gen = std::make_shared<LlvmUdfGen<ST, IN...>>(gen, infer);
+
+        std::vector<size_t> null_indices;
+        std::vector<int> arg_nullable = {IsNullableTrait<IN>::value...};
+        for (size_t i = 0; i < arg_nullable.size(); ++i) {
+            if (arg_nullable[i] > 0) {
+                null_indices.push_back(1 + i);
+            }
+        }
+        auto registry = std::make_shared<LlvmUdfRegistry>(
+            name() + "@retract", llvm_gen, 1 + sizeof...(IN), null_indices);
+        udaf_gen_.retract_gen = registry;
+        return *this;
+    }
+
+    UdafRegistryHelperImpl& retract(
+        const std::function<node::ExprNode*(
+            UdfResolveContext*, node::ExprNode*,
+            typename std::pair<IN, node::ExprNode*>::second_type...)>& gen) {
+        auto expr_gen = std::make_shared<ExprUdfGen<ST, IN...>>(gen);
+        auto registry =
+            std::make_shared<ExprUdfRegistry>(name() + "@retract", expr_gen);
+        udaf_gen_.retract_gen = registry;
+        return *this;
+    }
+
+    UdafRegistryHelperImpl& retract(const std::string& fname, void* fn_ptr,
+                                    bool return_by_arg = false) {
+        auto fn = dynamic_cast<node::ExternalFnDefNode*>(
+            library()->node_manager()->MakeExternalFnDefNode(
+                fname, fn_ptr, state_ty_, state_nullable_, update_tys_,
+                update_nullable_, -1, return_by_arg));
+        auto registry = std::make_shared<ExternalFuncRegistry>(fname, fn);
+        udaf_gen_.retract_gen = registry;
+        library()->AddExternalFunction(fname, fn_ptr);
+        return *this;
+    }
+
+    UdafRegistryHelperImpl& retract(
+        const std::string& fname,
+        const typename TypeAnnotatedFuncPtr<ST, IN...>::type& fn_ptr) {
+        node::TypeNode* ret_type = nullptr;
+        fn_ptr.get_ret_type_func(library()->node_manager(), &ret_type);
+        if (ret_type == nullptr) {
+            LOG(WARNING) << "Fail to get return type of function ptr";
+            return *this;
+        } else if (!ret_type->Equals(state_ty_) ||
+                   (fn_ptr.return_nullable && !state_nullable_)) {
+            LOG(WARNING)
+                << "Illegal return type of external retract typed function '"
+                << fname << "': expected "
+                << (state_nullable_ ? "nullable " : "") << state_ty_->GetName()
+                << " but get " << (fn_ptr.return_nullable ? "nullable " : "")
+                << ret_type->GetName();
+            return *this;
+        }
+        return retract(fname, fn_ptr.ptr, fn_ptr.return_by_arg);
+    }
+
     UdafRegistryHelperImpl& merge(const std::string& fname) {
         auto registry = library()->Find(fname, {state_ty_, state_ty_});
         if (registry != nullptr) {
@@ -15,6 +15,7 @@
  */
 
 #include "vm/engine.h"
+#include <chrono>  // NOLINT
 #include <string>
 #include <utility>
 #include <vector>
@@ -30,6 +31,7 @@
 #include "vm/local_tablet_handler.h"
 #include "vm/mem_catalog.h"
 #include "vm/sql_compiler.h"
+#include "vm/sql_normalizer.h"
 
 DECLARE_bool(logtostderr);
 DECLARE_string(log_dir);
@@ -49,7 +51,11 @@ EngineOptions::EngineOptions()
       enable_expr_optimize_(true),
       enable_batch_window_parallelization_(false),
       enable_window_column_pruning_(false),
+      enable_incremental_window_agg_(true),
+      window_agg_parallelism_(1),
+      branch_parallelism_(1),
       max_sql_cache_size_(50),
+      enable_sql_normalize_(false),
       enable_spark_unsaferow_format_(false) {
     // TODO(chendihao): Pass the parameter to avoid global gflag
     FLAGS_enable_spark_unsaferow_format = enable_spark_unsaferow_format_;
@@ -61,9 +67,20 @@ EngineOptions* EngineOptions::SetEnableSparkUnsaferowFormat(bool flag) {
     return this;
 }
 
-Engine::Engine(const std::shared_ptr<Catalog>& catalog) : cl_(catalog), options_(), mu_(), lru_cache_() {}
+Engine::Engine(const std::shared_ptr<Catalog>& catalog) : Engine(catalog, EngineOptions()) {}
 Engine::Engine(const std::shared_ptr<Catalog>& catalog, const EngineOptions& options)
-    : cl_(catalog), options_(options), mu_(), lru_cache_() {}
+    : cl_(catalog),
+      options_(options),
+      mu_(),
+      lru_cache_(),
+      inflight_mu_(),
+      inflight_(),
+      hit_cnt_(0),
+      miss_cnt_(0),
+      dedup_cnt_(0),
+      normalized_cnt_(0),
+      compile_time_us_(0),
+      max_compile_time_us_(0) {}
 Engine::~Engine() {}
 void Engine::InitializeGlobalLLVM() {
     if (LLVM_IS_INITIALIZED) return;
@@ -208,8 +225,36 @@ bool Engine::IsCompatibleCache(RunSession& session,  // NOLINT
 
 bool Engine::Get(const std::string& sql, const std::string& db, RunSession& session,
                  base::Status& status) {  // NOLINT (runtime/references)
+    if (options_.IsEnableSqlNormalize() && session.engine_mode() == kBatchMode) {
+        auto batch_sess = dynamic_cast<BatchRunSession*>(&session);
+        if (!batch_sess->lifted_parameter_row_.empty()) {
+            // the session is reused, the parameters are lifted by the last query
+            batch_sess->SetParameterSchema(codec::Schema());
+            batch_sess->lifted_parameter_row_ = Row();
+        }
+        NormalizedSql normalized;
+        if (batch_sess->GetParameterSchema().empty() && NormalizeSql(sql, &normalized)) {
+            batch_sess->SetParameterSchema(normalized.parameter_types);
+            base::Status normalized_status;
+            if (GetCompileInfo(normalized.sql, db, session, normalized_status)) {
+                batch_sess->lifted_parameter_row_ = normalized.parameter_row;
+                normalized_cnt_.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+            // some literals can not be parameters, e.g. the ones a function
+            // requires to be constant, compile the sql as it is
+            DLOG(INFO) << "fail to compile normalized sql, " << normalized_status << "\n" << normalized.sql;
+            batch_sess->SetParameterSchema(codec::Schema());
+        }
+    }
+    return GetCompileInfo(sql, db, session, status);
+}
+
+bool Engine::GetCompileInfo(const std::string& sql, const std::string& db, RunSession& session,
+                            base::Status& status) {  // NOLINT (runtime/references)
     std::shared_ptr<CompileInfo> cached_info = GetCacheLocked(db, sql, session.engine_mode());
     if (cached_info && IsCompatibleCache(session, cached_info, status)) {
+        hit_cnt_.fetch_add(1, std::memory_order_relaxed);
         session.SetCompileInfo(cached_info);
         return true;
     }
@@ -218,6 +263,82 @@ bool Engine::Get(const std::string& sql, const std::string& db, RunSession& sess
         LOG(WARNING) << status;
         status = base::Status::OK();
     }
+
+    std::string key = GetInflightKey(sql, db, session);
+    std::shared_ptr<InflightCompile> inflight;
+    {
+        std::unique_lock<std::mutex> lock(inflight_mu_);
+        auto iter = inflight_.find(key);
+        if (iter != inflight_.end()) {
+            // the same sql is being compiled, take its result
+            inflight = iter->second;
+            dedup_cnt_.fetch_add(1, std::memory_order_relaxed);
+            inflight->cv.wait(lock, [&inflight] { return inflight->done; });
+            status = inflight->status;
+            if (!inflight->info) {
+                return false;
+            }
+            session.SetCompileInfo(inflight->info);
+            return true;
+        }
+        inflight = std::make_shared<InflightCompile>();
+        inflight_.emplace(key, inflight);
+    }
+
+    // the last compiling of the key may finish after the cache is missed
+    std::shared_ptr<CompileInfo> info = GetCacheLocked(db, sql, session.engine_mode());
+    base::Status cache_status;
+    if (info && IsCompatibleCache(session, info, cache_status)) {
+        hit_cnt_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        miss_cnt_.fetch_add(1, std::memory_order_relaxed);
+        auto start = std::chrono::steady_clock::now();
+        info = Compile(sql, db, session, status);
+        uint64_t time_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                               std::chrono::steady_clock::now() - start).count();
+        compile_time_us_.fetch_add(time_us, std::memory_order_relaxed);
+        uint64_t max_time_us = max_compile_time_us_.load(std::memory_order_relaxed);
+        while (time_us > max_time_us &&
+               !max_compile_time_us_.compare_exchange_weak(max_time_us, time_us, std::memory_order_relaxed)) {
+        }
+        if (info) {
+            SetCacheLocked(db, sql, session.engine_mode(), info);
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(inflight_mu_);
+        inflight->done = true;
+        inflight->info = info;
+        inflight->status = status;
+        inflight_.erase(key);
+    }
+    inflight->cv.notify_all();
+    if (!info) {
+        return false;
+    }
+    session.SetCompileInfo(info);
+    return true;
+}
+
+std::string Engine::GetInflightKey(const std::string& sql, const std::string& db,
+                                   RunSession& session) {  // NOLINT (runtime/references)
+    std::string key = EngineModeName(session.engine_mode()) + "|" + db + "|";
+    if (session.engine_mode() == kBatchMode) {
+        auto& parameter_schema = dynamic_cast<BatchRunSession*>(&session)->GetParameterSchema();
+        for (int i = 0; i < parameter_schema.size(); i++) {
+            key.append(std::to_string(parameter_schema.Get(i).type())).append(",");
+        }
+    } else if (session.engine_mode() == kBatchRequestMode) {
+        for (size_t idx : dynamic_cast<BatchRequestRunSession*>(&session)->common_column_indices()) {
+            key.append(std::to_string(idx)).append(",");
+        }
+    }
+    key.append("|").append(sql);
+    return key;
+}
+
+std::shared_ptr<CompileInfo> Engine::Compile(const std::string& sql, const std::string& db, RunSession& session,
+                                             base::Status& status) {  // NOLINT (runtime/references)
     DLOG(INFO) << "Compile Engine ...";
     status = base::Status::OK();
     std::shared_ptr<SqlCompileInfo> info = std::make_shared<SqlCompileInfo>();
@@ -230,6 +351,9 @@ bool Engine::Get(const std::string& sql, const std::string& db, RunSession& sess
     sql_context.enable_batch_window_parallelization = options_.IsEnableBatchWindowParallelization();
     sql_context.enable_window_column_pruning = options_.IsEnableWindowColumnPruning();
     sql_context.enable_expr_optimize = options_.IsEnableExprOptimize();
+    sql_context.enable_incremental_window_agg = options_.IsEnableIncrementalWindowAgg();
+    sql_context.window_agg_parallelism = options_.GetWindowAggParallelism();
+    sql_context.branch_parallelism = options_.GetBranchParallelism();
     sql_context.jit_options = options_.jit_options();
     if (session.engine_mode() == kBatchMode) {
         sql_context.parameter_types = dynamic_cast<BatchRunSession*>(&session)->GetParameterSchema();
@@ -242,18 +366,16 @@ bool Engine::Get(const std::string& sql, const std::string& db, RunSession& sess
                          options_.IsPlanOnly());
     bool ok = compiler.Compile(info->get_sql_context(), status);
     if (!ok || 0 != status.code) {
-        return false;
+        return nullptr;
     }
     if (!options_.IsCompileOnly()) {
         ok = compiler.BuildClusterJob(info->get_sql_context(), status);
         if (!ok || 0 != status.code) {
             LOG(WARNING) << "fail to build cluster job: " << status.msg;
-            return false;
+            return nullptr;
         }
     }
 
-    SetCacheLocked(db, sql, session.engine_mode(), info);
-    session.SetCompileInfo(info);
     if (session.is_debug_) {
         std::ostringstream plan_oss;
         if (nullptr != sql_context.physical_plan) {
@@ -264,7 +386,7 @@ bool Engine::Get(const std::string& sql, const std::string& db, RunSession& sess
         sql_context.cluster_job.Print(runner_oss, "");
         LOG(INFO) << "cluster job:\n" << runner_oss.str() << std::endl;
     }
-    return true;
+    return info;
 }
 
 bool Engine::Explain(const std::string& sql, const std::string& db, EngineMode engine_mode,
@@ -368,6 +490,17 @@ EngineOptions Engine::GetEngineOptions() {
     return options_;
 }
 
+EngineCacheStats Engine::GetCacheStats() const {
+    EngineCacheStats stats;
+    stats.hit_cnt = hit_cnt_.load(std::memory_order_relaxed);
+    stats.miss_cnt = miss_cnt_.load(std::memory_order_relaxed);
+    stats.dedup_cnt = dedup_cnt_.load(std::memory_order_relaxed);
+    stats.normalized_cnt = normalized_cnt_.load(std::memory_order_relaxed);
+    stats.compile_time_us = compile_time_us_.load(std::memory_order_relaxed);
+    stats.max_compile_time_us = max_compile_time_us_.load(std::memory_order_relaxed);
+    return stats;
+}
+
 std::shared_ptr<CompileInfo> Engine::GetCacheLocked(const std::string& db, const std::string& sql,
                                                     EngineMode engine_mode) {
     std::lock_guard<base::SpinMutex> lock(mu_);
@@ -482,28 +615,46 @@ int32_t BatchRunSession::Run(std::vector<Row>& rows, uint64_t limit) {
     return Run(Row(), rows, limit);
 }
 int32_t BatchRunSession::Run(const Row& parameter_row, std::vector<Row>& rows, uint64_t limit) {
+    return Run(parameter_row, [&rows](const Row& row) {
+        rows.push_back(row);
+        return true;
+    });
+}
+
+int32_t BatchRunSession::Run(const Row& parameter_row, const std::function<bool(const Row&)>& output) {
     auto& sql_ctx = std::dynamic_pointer_cast<SqlCompileInfo>(compile_info_)->get_sql_context();
-    RunnerContext ctx(&sql_ctx.cluster_job, parameter_row, is_debug_);
-    auto output = sql_ctx.cluster_job.GetTask(0).GetRoot()->RunWithCache(ctx);
-    if (!output) {
+    RunnerContext ctx(&sql_ctx.cluster_job, parameter_row.empty() ? lifted_parameter_row_ : parameter_row, is_debug_);
+    auto root = sql_ctx.cluster_job.GetTask(0).GetRoot();
+    // the rows of a root table project are projected as output pulls them,
+    // the other roots still build their whole output before it is passed on
+    if (root->type_ == kRunnerTableProject && !root->need_cache() && !is_debug_) {
+        if (!dynamic_cast<TableProjectRunner*>(root)->RunStream(ctx, output)) {
+            DLOG(INFO) << "Run batch plan output is empty";
+        }
+        return 0;
+    }
+    auto handler = root->RunWithCache(ctx);
+    if (!handler) {
         DLOG(INFO) << "Run batch plan output is empty";
         return 0;
     }
-    switch (output->GetHanlderType()) {
+    switch (handler->GetHanlderType()) {
         case kTableHandler: {
-            auto iter = std::dynamic_pointer_cast<TableHandler>(output)->GetIterator();
+            auto iter = std::dynamic_pointer_cast<TableHandler>(handler)->GetIterator();
             if (!iter) {
                 return 0;
             }
             iter->SeekToFirst();
             while (iter->Valid()) {
-                rows.push_back(iter->GetValue());
+                if (!output(iter->GetValue())) {
+                    break;
+                }
                 iter->Next();
             }
             return 0;
         }
         case kRowHandler: {
-            rows.push_back(std::dynamic_pointer_cast<RowHandler>(output)->GetValue());
+            output(std::dynamic_pointer_cast<RowHandler>(handler)->GetValue());
             return 0;
         }
         case kPartitionHandler: {
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <thread>  // NOLINT
 #include "case/case_data_mock.h"
 #include "gtest/gtest.h"
 #include "gtest/internal/gtest-param-util.h"
@@ -156,6 +157,91 @@ TEST_F(EngineCompileTest, EngineWithParameterizedLRUCacheTest) {
 }
 
 
+TEST_F(EngineCompileTest, EngineSingleFlightCompileTest) {
+    auto catalog = BuildSimpleCatalog();
+    hybridse::type::Database db;
+    db.set_name("simple_db");
+    hybridse::type::TableDef table_def;
+    sqlcase::CaseSchemaMock::BuildTableDef(table_def);
+    table_def.set_name("t1");
+    AddTable(db, table_def);
+    catalog->AddDatabase(db);
+
+    EngineOptions options;
+    options.SetCompileOnly(true);
+    Engine engine(catalog, options);
+
+    std::string sql = "select col1, col2 + 1 as c2, col5 from t1;";
+    std::vector<BatchRunSession> sessions(8);
+    std::vector<std::thread> threads;
+    std::atomic<int> failed(0);
+    for (auto& session : sessions) {
+        threads.emplace_back([&engine, &sql, &session, &failed] {
+            base::Status get_status;
+            if (!engine.Get(sql, "simple_db", session, get_status)) {
+                failed++;
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    ASSERT_EQ(0, failed.load());
+    for (auto& session : sessions) {
+        ASSERT_EQ(sessions[0].GetCompileInfo().get(), session.GetCompileInfo().get());
+    }
+    auto stats = engine.GetCacheStats();
+    ASSERT_EQ(1u, stats.miss_cnt);
+    ASSERT_EQ(sessions.size(), stats.hit_cnt + stats.miss_cnt + stats.dedup_cnt);
+}
+
+TEST_F(EngineCompileTest, EngineSqlNormalizeTest) {
+    auto catalog = BuildSimpleCatalog();
+    hybridse::type::Database db;
+    db.set_name("simple_db");
+    hybridse::type::TableDef table_def;
+    sqlcase::CaseSchemaMock::BuildTableDef(table_def);
+    table_def.set_name("t1");
+    AddTable(db, table_def);
+    catalog->AddDatabase(db);
+
+    EngineOptions options;
+    options.SetCompileOnly(true);
+    options.SetEnableSqlNormalize(true);
+    Engine engine(catalog, options);
+
+    base::Status get_status;
+    BatchRunSession bsession1;
+    ASSERT_TRUE(engine.Get("select col1, col2 from t1 where col1 > 10 and col0 = 'a';", "simple_db", bsession1,
+                           get_status)) << get_status;
+    ASSERT_EQ(2, bsession1.GetParameterSchema().size());
+    ASSERT_FALSE(bsession1.GetLiftedParameterRow().empty());
+    BatchRunSession bsession2;
+    ASSERT_TRUE(engine.Get("select col1, col2 from t1 where col1 > 20 and col0 = 'b';", "simple_db", bsession2,
+                           get_status)) << get_status;
+    ASSERT_EQ(bsession1.GetCompileInfo().get(), bsession2.GetCompileInfo().get());
+
+    // the session with parameters is not normalized
+    BatchRunSession bsession3;
+    codec::Schema parameter_schema;
+    parameter_schema.Add()->set_type(type::kInt32);
+    bsession3.SetParameterSchema(parameter_schema);
+    ASSERT_TRUE(engine.Get("select col1, col2 from t1 where col1 > ? and col0 = 'c';", "simple_db", bsession3,
+                           get_status)) << get_status;
+    ASSERT_TRUE(bsession3.GetLiftedParameterRow().empty());
+    ASSERT_NE(bsession1.GetCompileInfo().get(), bsession3.GetCompileInfo().get());
+
+    // the reused session drops the lifted parameters of the last query
+    ASSERT_TRUE(engine.Get("select col1, col2 from t1;", "simple_db", bsession1, get_status)) << get_status;
+    ASSERT_EQ(0, bsession1.GetParameterSchema().size());
+    ASSERT_TRUE(bsession1.GetLiftedParameterRow().empty());
+
+    auto stats = engine.GetCacheStats();
+    ASSERT_EQ(2u, stats.normalized_cnt);
+    ASSERT_EQ(1u, stats.hit_cnt);
+    ASSERT_EQ(3u, stats.miss_cnt);
+}
+
 TEST_F(EngineCompileTest, EngineEmptyDefaultDBLRUCacheTest) {
     // Build Simple Catalog
     auto catalog = BuildSimpleCatalog();
@@ -294,6 +380,33 @@ TEST_F(EngineCompileTest, EngineCompileOnlyTest) {
     }
 }
 
+TEST_F(EngineCompileTest, EngineBatchRunOutputTest) {
+    auto catalog = BuildSimpleCatalog();
+    hybridse::type::Database db;
+    db.set_name("simple_db");
+    hybridse::type::TableDef table_def;
+    std::vector<Row> rows;
+    CaseDataMock::BuildOnePkTableData(table_def, rows, 100);
+    table_def.set_name("t1");
+    AddTable(db, table_def);
+    catalog->AddDatabase(db);
+    ASSERT_TRUE(catalog->InsertRows("simple_db", "t1", rows));
+
+    EngineOptions options;
+    Engine engine(catalog, options);
+    base::Status get_status;
+    BatchRunSession session;
+    ASSERT_TRUE(engine.Get("select col1, col5 + 1 as c5 from t1;", "simple_db", session, get_status));
+    std::vector<Row> outputs;
+    ASSERT_EQ(0, session.Run(outputs));
+    ASSERT_EQ(100u, outputs.size());
+    // the rows of the root project are passed one by one and the run stops
+    // once output returns false
+    size_t cnt = 0;
+    ASSERT_EQ(0, session.Run(Row(), [&cnt](const Row& row) { return ++cnt < 10; }));
+    ASSERT_EQ(10u, cnt);
+}
+
 TEST_F(EngineCompileTest, EngineGetDependentTableTest) {
     {
         std::vector<std::pair<std::string, std::set<std::pair<std::string, std::string>>>> pairs;
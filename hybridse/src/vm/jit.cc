@@ -15,6 +15,7 @@
  */
 
 #include "vm/jit.h"
+#include <map>
 #include <string>
 #include <utility>
 extern "C" {
@@ -36,6 +37,7 @@ extern "C" {
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Verifier.h"
+#include "llvm/Support/Host.h"
 #include "llvm/Transforms/InstCombine/InstCombine.h"
 #include "llvm/Transforms/Scalar.h"
 #include "llvm/Transforms/Scalar/GVN.h"
@@ -131,6 +133,55 @@ void HybridSeJit::Init() {
     jd.setGenerator(gen.get());
 }
 
+bool HybridSeJit::LinkSymbolTable(const JitSymbolTable* table) {
+    char prefix = getDataLayout().getGlobalPrefix();
+    auto gen = llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(prefix);
+    auto err = gen.takeError();
+    if (err) {
+        LOG(WARNING) << "Create process sym failed";
+        ::llvm::errs() << err;
+        return false;
+    }
+    auto process_gen = std::move(gen.get());
+    getMainJITDylib().setGenerator(
+        [table, prefix, process_gen](::llvm::orc::JITDylib& jd, const ::llvm::orc::SymbolNameSet& names) mutable
+        -> ::llvm::Expected<::llvm::orc::SymbolNameSet> {
+            ::llvm::orc::SymbolMap symbols;
+            ::llvm::orc::SymbolNameSet rest;
+            for (auto& name : names) {
+                ::llvm::StringRef fn_name = *name;
+                if (prefix != '\0' && fn_name.front() == prefix) {
+                    fn_name = fn_name.drop_front();
+                }
+                void* addr = table->Find(fn_name.str());
+                if (addr == nullptr) {
+                    rest.insert(name);
+                    continue;
+                }
+                symbols[name] =
+                    ::llvm::JITEvaluatedSymbol(::llvm::pointerToJITTargetAddress(addr), ::llvm::JITSymbolFlags());
+            }
+            ::llvm::orc::SymbolNameSet added;
+            if (!symbols.empty()) {
+                for (auto& pair : symbols) {
+                    added.insert(pair.first);
+                }
+                if (auto err = jd.define(::llvm::orc::absoluteSymbols(std::move(symbols)))) {
+                    return std::move(err);
+                }
+            }
+            if (!rest.empty()) {
+                auto found = process_gen(jd, rest);
+                if (!found) {
+                    return found.takeError();
+                }
+                added.insert(found->begin(), found->end());
+            }
+            return added;
+        });
+    return true;
+}
+
 bool HybridSeJit::AddSymbol(::llvm::orc::JITDylib& jd,
                             ::llvm::orc::MangleAndInterner& mi,
                             const std::string& fn_name, void* fn_ptr) {
@@ -148,10 +199,29 @@ bool HybridSeJit::AddSymbol(::llvm::orc::JITDylib& jd,
     }
 }
 
+HybridSeLlvmJitWrapper::HybridSeLlvmJitWrapper(const JitOptions& jit_options) {
+    if (!jit_options.GetObjectCacheDir().empty()) {
+        object_cache_ = JitObjectCache::Get(jit_options.GetObjectCacheDir(), jit_options.GetObjectCacheMaxBytes());
+    }
+}
+
 bool HybridSeLlvmJitWrapper::Init() {
     DLOG(INFO) << "Start to initialize hybridse jit";
-    auto jit = ::llvm::Expected<std::unique_ptr<HybridSeJit>>(
-        HybridSeJitBuilder().create());
+    HybridSeJitBuilder builder;
+    if (object_cache_) {
+        auto object_cache = object_cache_.get();
+        builder.setCompileFunctionCreator(
+            [object_cache](::llvm::orc::JITTargetMachineBuilder jtmb)
+                -> ::llvm::Expected<::llvm::orc::IRCompileLayer::CompileFunction> {
+                auto tm = jtmb.createTargetMachine();
+                if (!tm) {
+                    return tm.takeError();
+                }
+                return ::llvm::orc::IRCompileLayer::CompileFunction(
+                    ::llvm::orc::TMOwningSimpleCompiler(std::move(*tm), object_cache));
+            });
+    }
+    auto jit = ::llvm::Expected<std::unique_ptr<HybridSeJit>>(builder.create());
     {
         ::llvm::Error e = jit.takeError();
         if (e) {
@@ -169,7 +239,29 @@ bool HybridSeLlvmJitWrapper::Init() {
     return true;
 }
 
+// the target the jit emits objects for, which is the host
+static std::string GetHostTarget() {
+    std::string target = ::llvm::sys::getProcessTriple() + "-" + ::llvm::sys::getHostCPUName().str();
+    ::llvm::StringMap<bool> features;
+    if (::llvm::sys::getHostCPUFeatures(features)) {
+        std::map<std::string, bool> sorted_features;
+        for (auto& feature : features) {
+            sorted_features.emplace(feature.first().str(), feature.second);
+        }
+        for (auto& feature : sorted_features) {
+            target.append(feature.second ? ",+" : ",-").append(feature.first);
+        }
+    }
+    return target;
+}
+
 bool HybridSeLlvmJitWrapper::OptModule(::llvm::Module* module) {
+    static const std::string host_target = GetHostTarget();
+    if (object_cache_ && object_cache_->PrepareModule(module, host_target)) {
+        // the object is loaded from the cache instead of compiled
+        DLOG(INFO) << "skip opt of cached module " << module->getModuleIdentifier();
+        return true;
+    }
     return jit_->OptModule(module);
 }
 
@@ -205,6 +297,10 @@ bool HybridSeLlvmJitWrapper::AddExternalFunction(const std::string& name,
                                                 name, addr);
 }
 
+bool HybridSeLlvmJitWrapper::LinkSymbolTable(const JitSymbolTable* table) {
+    return jit_->LinkSymbolTable(table);
+}
+
 #ifdef LLVM_EXT_ENABLE
 bool HybridSeMcJitWrapper::Init() { return true; }
 
@@ -22,6 +22,7 @@
 #include <string>
 #include "llvm/ExecutionEngine/GenericValue.h"
 #include "llvm/ExecutionEngine/Orc/LLJIT.h"
+#include "vm/jit_object_cache.h"
 #include "vm/jit_wrapper.h"
 
 #ifdef LLVM_EXT_ENABLE
@@ -64,6 +65,10 @@ class HybridSeJit : public ::llvm::orc::LLJIT {
     static bool AddSymbol(::llvm::orc::JITDylib& jd,           // NOLINT
                           ::llvm::orc::MangleAndInterner& mi,  // NOLINT
                           const std::string& fn_name, void* fn_ptr);
+
+    // resolve the symbols of main module from the table first, then from the
+    // process
+    bool LinkSymbolTable(const JitSymbolTable* table);
     ~HybridSeJit();
 
  protected:
@@ -88,6 +93,7 @@ std::string LlvmToString(const T& value) {
 class HybridSeLlvmJitWrapper : public HybridSeJitWrapper {
  public:
     HybridSeLlvmJitWrapper() {}
+    explicit HybridSeLlvmJitWrapper(const JitOptions& jit_options);
     ~HybridSeLlvmJitWrapper() {}
 
     bool Init() override;
@@ -99,10 +105,14 @@ class HybridSeLlvmJitWrapper : public HybridSeJitWrapper {
 
     bool AddExternalFunction(const std::string& name, void* addr) override;
 
+    bool LinkSymbolTable(const JitSymbolTable* table) override;
+
     hybridse::vm::RawPtrHandle FindFunction(
         const std::string& funcname) override;
 
  private:
+    // outlives jit_ which compiles with it
+    std::shared_ptr<JitObjectCache> object_cache_;
     std::unique_ptr<HybridSeJit> jit_;
     std::unique_ptr<::llvm::orc::MangleAndInterner> mi_;
 };
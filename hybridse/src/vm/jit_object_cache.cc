@@ -0,0 +1,201 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vm/jit_object_cache.h"
+#include <algorithm>
+#include <vector>
+#include "glog/logging.h"
+#include "hybridse_version.h"  // NOLINT
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/SHA1.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace hybridse {
+namespace vm {
+
+static const char KEY_PREFIX[] = "hybridse_obj_";
+
+std::shared_ptr<JitObjectCache> JitObjectCache::Get(const std::string& dir, uint64_t max_bytes) {
+    static std::mutex mu;
+    static std::map<std::string, std::shared_ptr<JitObjectCache>> caches;
+    std::lock_guard<std::mutex> lock(mu);
+    auto iter = caches.find(dir);
+    if (iter != caches.end()) {
+        return iter->second;
+    }
+    std::error_code ec = ::llvm::sys::fs::create_directories(dir);
+    if (ec) {
+        LOG(WARNING) << "fail to create jit object cache dir " << dir << ": " << ec.message();
+        return nullptr;
+    }
+    auto cache = std::make_shared<JitObjectCache>(dir, max_bytes);
+    caches.emplace(dir, cache);
+    return cache;
+}
+
+JitObjectCache::JitObjectCache(const std::string& dir, uint64_t max_bytes)
+    : dir_(dir), max_bytes_(max_bytes), hit_cnt_(0), miss_cnt_(0), bytes_(0) {
+    LoadObjects();
+}
+
+void JitObjectCache::LoadObjects() {
+    std::vector<std::pair<::llvm::sys::TimePoint<>, std::pair<std::string, uint64_t>>> objects;
+    std::error_code ec;
+    for (::llvm::sys::fs::directory_iterator iter(dir_, ec), end; iter != end && !ec; iter.increment(ec)) {
+        ::llvm::StringRef name = ::llvm::sys::path::filename(iter->path());
+        if (!name.startswith(KEY_PREFIX) || !name.endswith(".o")) {
+            continue;
+        }
+        auto status = iter->status();
+        if (!status) {
+            continue;
+        }
+        objects.push_back({status->getLastModificationTime(), {iter->path(), status->getSize()}});
+    }
+    if (ec) {
+        LOG(WARNING) << "fail to list jit object cache dir " << dir_ << ": " << ec.message();
+    }
+    std::sort(objects.begin(), objects.end(),
+              [](const auto& l, const auto& r) { return l.first < r.first; });
+    std::lock_guard<std::mutex> lock(mu_);
+    for (auto& object : objects) {
+        object_index_[object.second.first] = objects_.insert(objects_.end(), object.second);
+        bytes_ += object.second.second;
+    }
+    EvictObjects();
+}
+
+void JitObjectCache::AddObject(const std::string& path, uint64_t size) {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto iter = object_index_.find(path);
+    if (iter != object_index_.end()) {
+        bytes_ -= iter->second->second;
+        objects_.erase(iter->second);
+    }
+    object_index_[path] = objects_.insert(objects_.end(), {path, size});
+    bytes_ += size;
+    EvictObjects();
+}
+
+void JitObjectCache::TouchObject(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto iter = object_index_.find(path);
+    if (iter != object_index_.end()) {
+        objects_.splice(objects_.end(), objects_, iter->second);
+    }
+}
+
+void JitObjectCache::EvictObjects() {
+    // other processes sharing the dir may have removed the object already
+    while (bytes_ > max_bytes_ && !objects_.empty()) {
+        auto& object = objects_.front();
+        std::error_code ec = ::llvm::sys::fs::remove(object.first);
+        if (ec) {
+            LOG(WARNING) << "fail to remove jit object " << object.first << ": " << ec.message();
+        } else {
+            DLOG(INFO) << "evict jit object " << object.first;
+        }
+        bytes_ -= object.second;
+        object_index_.erase(object.first);
+        objects_.pop_front();
+    }
+}
+
+uint64_t JitObjectCache::GetBytes() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return bytes_;
+}
+
+bool JitObjectCache::PrepareModule(::llvm::Module* module, const std::string& target) {
+    std::string ir;
+    ::llvm::raw_string_ostream ss(ir);
+    ss << *module;
+    ss.flush();
+    ::llvm::SHA1 hasher;
+    hasher.update(LLVM_VERSION_STRING);
+    hasher.update(target);
+    hasher.update(std::to_string(HYBRIDSE_VERSION_MAJOR) + "." + std::to_string(HYBRIDSE_VERSION_MINOR) + "." +
+                  std::to_string(HYBRIDSE_VERSION_BUG));
+    hasher.update(ir);
+    module->setModuleIdentifier(KEY_PREFIX + ::llvm::toHex(hasher.final(), true));
+    return ::llvm::sys::fs::exists(GetObjectPath(module));
+}
+
+std::string JitObjectCache::GetObjectPath(const ::llvm::Module* module) const {
+    const std::string& key = module->getModuleIdentifier();
+    if (key.compare(0, sizeof(KEY_PREFIX) - 1, KEY_PREFIX) != 0) {
+        return "";
+    }
+    return dir_ + "/" + key + ".o";
+}
+
+void JitObjectCache::notifyObjectCompiled(const ::llvm::Module* module, ::llvm::MemoryBufferRef obj) {
+    std::string path = GetObjectPath(module);
+    if (path.empty()) {
+        return;
+    }
+    // write a temporary file then rename it, so a reader never sees a partial
+    // object even if several processes share the dir
+    int fd = -1;
+    ::llvm::SmallString<128> tmp_path;
+    std::error_code ec = ::llvm::sys::fs::createUniqueFile(path + ".%%%%%%.tmp", fd, tmp_path);
+    if (ec) {
+        LOG(WARNING) << "fail to create jit object file for " << path << ": " << ec.message();
+        return;
+    }
+    {
+        ::llvm::raw_fd_ostream os(fd, true);
+        os << obj.getBuffer();
+        os.close();
+        if (os.has_error()) {
+            LOG(WARNING) << "fail to write jit object file " << tmp_path.str().str();
+            os.clear_error();
+            ::llvm::sys::fs::remove(tmp_path);
+            return;
+        }
+    }
+    ec = ::llvm::sys::fs::rename(tmp_path, path);
+    if (ec) {
+        LOG(WARNING) << "fail to rename jit object file to " << path << ": " << ec.message();
+        ::llvm::sys::fs::remove(tmp_path);
+        return;
+    }
+    DLOG(INFO) << "cache jit object " << path;
+    AddObject(path, obj.getBufferSize());
+}
+
+std::unique_ptr<::llvm::MemoryBuffer> JitObjectCache::getObject(const ::llvm::Module* module) {
+    std::string path = GetObjectPath(module);
+    if (path.empty()) {
+        return nullptr;
+    }
+    auto buf = ::llvm::MemoryBuffer::getFile(path, -1, false);
+    if (!buf) {
+        miss_cnt_.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    hit_cnt_.fetch_add(1, std::memory_order_relaxed);
+    TouchObject(path);
+    DLOG(INFO) << "load jit object " << path;
+    return std::move(buf.get());
+}
+
+}  // namespace vm
+}  // namespace hybridse
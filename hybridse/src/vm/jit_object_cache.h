@@ -0,0 +1,94 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HYBRIDSE_SRC_VM_JIT_OBJECT_CACHE_H_
+#define HYBRIDSE_SRC_VM_JIT_OBJECT_CACHE_H_
+
+#include <atomic>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <utility>
+#include "llvm/ExecutionEngine/ObjectCache.h"
+#include "llvm/IR/Module.h"
+
+namespace hybridse {
+namespace vm {
+
+/// \brief JitObjectCache keeps the objects emitted by the jit in a directory,
+/// so that a module compiled before, e.g. by the last run of the process, is
+/// loaded instead of optimized and compiled again.
+///
+/// An object is keyed by the hash of the module ir before optimization with
+/// the llvm version, the target and the library version. A change of the
+/// schemas or the udfs a sql depends on changes the ir, so a stale object is
+/// never loaded. The key is set as the module identifier by `PrepareModule`.
+///
+/// The objects in the directory are kept under `max_bytes`, the least recently
+/// used ones are removed first. The objects left by the last run are ordered
+/// by their modification time.
+class JitObjectCache : public ::llvm::ObjectCache {
+ public:
+    /// Return the cache of the directory shared by the process, or null if
+    /// the directory can not be created. The `max_bytes` of the first call
+    /// for the directory is used.
+    static std::shared_ptr<JitObjectCache> Get(const std::string& dir, uint64_t max_bytes);
+
+    JitObjectCache(const std::string& dir, uint64_t max_bytes);
+    ~JitObjectCache() override {}
+
+    /// Set the key of the module as its identifier, return `true` if the
+    /// object of the module is cached, then the module needs no optimization.
+    bool PrepareModule(::llvm::Module* module, const std::string& target);
+
+    void notifyObjectCompiled(const ::llvm::Module* module, ::llvm::MemoryBufferRef obj) override;
+
+    std::unique_ptr<::llvm::MemoryBuffer> getObject(const ::llvm::Module* module) override;
+
+    uint64_t GetHitCnt() const { return hit_cnt_.load(std::memory_order_relaxed); }
+    uint64_t GetMissCnt() const { return miss_cnt_.load(std::memory_order_relaxed); }
+    uint64_t GetBytes() const;
+
+ private:
+    typedef std::list<std::pair<std::string, uint64_t>> ObjectList;
+
+    // return empty if the module is not prepared
+    std::string GetObjectPath(const ::llvm::Module* module) const;
+
+    // list the objects left in the dir, the oldest first
+    void LoadObjects();
+    // add the object as the most recently used one, then remove the least
+    // recently used ones beyond `max_bytes_`
+    void AddObject(const std::string& path, uint64_t size);
+    void TouchObject(const std::string& path);
+    void EvictObjects();
+
+    const std::string dir_;
+    const uint64_t max_bytes_;
+    mutable std::mutex mu_;
+    // the paths and sizes of the objects, the least recently used first
+    ObjectList objects_;
+    std::map<std::string, ObjectList::iterator> object_index_;
+    uint64_t bytes_;
+    std::atomic<uint64_t> hit_cnt_;
+    std::atomic<uint64_t> miss_cnt_;
+};
+
+}  // namespace vm
+}  // namespace hybridse
+#endif  // HYBRIDSE_SRC_VM_JIT_OBJECT_CACHE_H_
@@ -59,7 +59,49 @@ bool HybridSeJitWrapper::AddModuleFromBuffer(const base::RawBuffer& buf) {
     return this->AddModule(std::move(llvm_module), std::move(llvm_ctx));
 }
 
+namespace {
+// collect the symbols added to the jit
+class JitSymbolCollector : public HybridSeJitWrapper {
+ public:
+    explicit JitSymbolCollector(std::unordered_map<std::string, void*>* symbols) : symbols_(symbols) {}
+
+    bool Init() override { return true; }
+    bool OptModule(::llvm::Module* module) override { return false; }
+    bool AddModule(std::unique_ptr<llvm::Module> module, std::unique_ptr<llvm::LLVMContext> llvm_ctx) override {
+        return false;
+    }
+    bool AddExternalFunction(const std::string& name, void* addr) override {
+        // the first one wins as the jit refuses to define a symbol twice
+        symbols_->emplace(name, addr);
+        return true;
+    }
+    hybridse::vm::RawPtrHandle FindFunction(const std::string& funcname) override { return nullptr; }
+
+ private:
+    std::unordered_map<std::string, void*>* symbols_;
+};
+}  // namespace
+
+JitSymbolTable::JitSymbolTable() : symbols_() {
+    JitSymbolCollector collector(&symbols_);
+    InitBuiltinJitSymbols(&collector);
+    udf::DefaultUdfLibrary::get()->InitJITSymbols(&collector);
+}
+
+const JitSymbolTable* JitSymbolTable::GetInstance() {
+    static const JitSymbolTable instance;
+    return &instance;
+}
+
+void* JitSymbolTable::Find(const std::string& name) const {
+    auto iter = symbols_.find(name);
+    return iter == symbols_.end() ? nullptr : iter->second;
+}
+
 bool HybridSeJitWrapper::InitJitSymbols(HybridSeJitWrapper* jit) {
+    if (jit->LinkSymbolTable(JitSymbolTable::GetInstance())) {
+        return true;
+    }
     InitBuiltinJitSymbols(jit);
     udf::DefaultUdfLibrary::get()->InitJITSymbols(jit);
     return true;
@@ -76,14 +118,14 @@ HybridSeJitWrapper* HybridSeJitWrapper::Create(const JitOptions& jit_options) {
         return new HybridSeMcJitWrapper(jit_options);
 #else
         LOG(WARNING) << "McJit support is not enabled";
-        return new HybridSeLlvmJitWrapper();
+        return new HybridSeLlvmJitWrapper(jit_options);
 #endif
     } else {
         if (jit_options.IsEnableVtune() || jit_options.IsEnablePerf() ||
             jit_options.IsEnableGdb()) {
             LOG(WARNING) << "LLJIT do not support jit events";
         }
-        return new HybridSeLlvmJitWrapper();
+        return new HybridSeLlvmJitWrapper(jit_options);
     }
 }
 
@@ -204,6 +246,35 @@ void InitBuiltinJitSymbols(HybridSeJitWrapper* jit) {
         "hybridse_storage_get_row_slice_size",
         reinterpret_cast<void*>(&hybridse::vm::RowGetSliceSize));
 
+    // incremental window aggregation
+    jit->AddExternalFunction(
+        "hybridse_storage_window_agg_state_sync",
+        reinterpret_cast<void*>(&hybridse::vm::WindowAggStateSync));
+    jit->AddExternalFunction(
+        "hybridse_storage_window_agg_state_mode",
+        reinterpret_cast<void*>(&hybridse::vm::WindowAggStateMode));
+    jit->AddExternalFunction(
+        "hybridse_storage_window_agg_state_buf",
+        reinterpret_cast<void*>(&hybridse::vm::WindowAggStateBuf));
+    jit->AddExternalFunction(
+        "hybridse_storage_get_window_agg_delta_iter",
+        reinterpret_cast<void*>(&hybridse::vm::GetWindowAggDeltaIter));
+    jit->AddExternalFunction(
+        "hybridse_storage_window_agg_state_deque",
+        reinterpret_cast<void*>(&hybridse::vm::WindowAggStateDeque));
+    jit->AddExternalFunction(
+        "hybridse_storage_window_agg_deque_push_back",
+        reinterpret_cast<void*>(&hybridse::vm::WindowAggDequePushBack));
+    jit->AddExternalFunction(
+        "hybridse_storage_window_agg_deque_push_front",
+        reinterpret_cast<void*>(&hybridse::vm::WindowAggDequePushFront));
+    jit->AddExternalFunction(
+        "hybridse_storage_window_agg_deque_evict",
+        reinterpret_cast<void*>(&hybridse::vm::WindowAggDequeEvict));
+    jit->AddExternalFunction(
+        "hybridse_storage_window_agg_deque_front",
+        reinterpret_cast<void*>(&hybridse::vm::WindowAggDequeFront));
+
     jit->AddExternalFunction(
         "hybridse_memery_pool_alloc",
         reinterpret_cast<void*>(&udf::v1::AllocManagedStringBuf));
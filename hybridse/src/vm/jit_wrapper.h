@@ -19,6 +19,7 @@
 
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include "base/fe_status.h"
 #include "base/raw_buffer.h"
@@ -32,6 +33,25 @@ namespace vm {
 
 class JitOptions;
 
+/// \brief JitSymbolTable holds the builtin and udf symbols of the process.
+///
+/// It is built once on first use, then a jit resolves the symbols of it which
+/// a module refers to on demand, instead of defining all of them on creation.
+class JitSymbolTable {
+ public:
+    static const JitSymbolTable* GetInstance();
+
+    /// Return the address of the symbol, or null if not found
+    void* Find(const std::string& name) const;
+
+    size_t size() const { return symbols_.size(); }
+
+ private:
+    JitSymbolTable();
+
+    std::unordered_map<std::string, void*> symbols_;
+};
+
 class HybridSeJitWrapper {
  public:
     HybridSeJitWrapper() {}
@@ -46,6 +66,10 @@ class HybridSeJitWrapper {
 
     virtual bool AddExternalFunction(const std::string& name, void* addr) = 0;
 
+    /// Resolve the symbols of the table on demand, return `false` if it is not
+    /// supported, then the symbols should be added one by one.
+    virtual bool LinkSymbolTable(const JitSymbolTable* table) { return false; }
+
     bool AddModuleFromBuffer(const base::RawBuffer&);
 
     virtual hybridse::vm::RawPtrHandle FindFunction(
@@ -15,10 +15,15 @@
  */
 
 #include "vm/jit_wrapper.h"
+#include <unistd.h>
+#include <memory>
+#include <string>
 #include "codec/fe_row_codec.h"
 #include "gtest/gtest.h"
+#include "llvm/Support/FileSystem.h"
 #include "udf/udf.h"
 #include "vm/engine.h"
+#include "vm/jit_object_cache.h"
 #include "vm/simple_catalog.h"
 #include "vm/sql_compiler.h"
 
@@ -162,6 +167,107 @@ TEST_F(JitWrapperTest, test_window) {
     delete jit;
 }
 
+TEST_F(JitWrapperTest, test_link_symbol_table) {
+    EngineOptions options;
+    options.SetKeepIr(true);
+    auto catalog = GetTestCatalog();
+    auto compile_info = CompileNotPerformanceSensitive(
+        "select col_1, distinct_count(col_2) over w from t1 "
+        "window w as (PARTITION by col_2 ORDER BY col_2 ROWS BETWEEN 1 PRECEDING AND CURRENT ROW);",
+        options, catalog);
+    ASSERT_TRUE(compile_info != nullptr);
+    auto &sql_context = compile_info->get_sql_context();
+    ASSERT_FALSE(sql_context.ir.empty());
+
+    // the udf symbols the module refers to are resolved from the table on lookup
+    std::unique_ptr<HybridSeJitWrapper> jit(HybridSeJitWrapper::Create());
+    ASSERT_TRUE(jit->Init());
+    ASSERT_TRUE(jit->LinkSymbolTable(JitSymbolTable::GetInstance()));
+    base::RawBuffer ir_buf(const_cast<char *>(sql_context.ir.data()), sql_context.ir.size());
+    ASSERT_TRUE(jit->AddModuleFromBuffer(ir_buf));
+    auto fn_name = sql_context.physical_plan->GetFnInfos()[0]->fn_name();
+    ASSERT_TRUE(jit->FindFunction(fn_name) != nullptr);
+
+    // a symbol in neither the table nor the process fails the lookup
+    std::string unknown_ir =
+        "declare i32 @hybridse_jit_test_unknown_symbol(i32)\n"
+        "define i32 @call_unknown_symbol(i32 %x) {\n"
+        "  %r = call i32 @hybridse_jit_test_unknown_symbol(i32 %x)\n"
+        "  ret i32 %r\n"
+        "}\n";
+    ASSERT_TRUE(JitSymbolTable::GetInstance()->Find("hybridse_jit_test_unknown_symbol") == nullptr);
+    std::unique_ptr<HybridSeJitWrapper> unknown_jit(HybridSeJitWrapper::Create());
+    ASSERT_TRUE(unknown_jit->Init());
+    ASSERT_TRUE(unknown_jit->LinkSymbolTable(JitSymbolTable::GetInstance()));
+    base::RawBuffer unknown_buf(const_cast<char *>(unknown_ir.data()), unknown_ir.size());
+    ASSERT_TRUE(unknown_jit->AddModuleFromBuffer(unknown_buf));
+    ASSERT_TRUE(unknown_jit->FindFunction("call_unknown_symbol") == nullptr);
+}
+
+TEST_F(JitWrapperTest, test_object_cache) {
+    std::string dir = "/tmp/jit_object_cache_test_" + std::to_string(getpid());
+    EngineOptions options;
+    options.jit_options().SetObjectCacheDir(dir);
+    auto cache = JitObjectCache::Get(dir, options.jit_options().GetObjectCacheMaxBytes());
+    ASSERT_TRUE(cache != nullptr);
+    auto catalog = GetTestCatalog();
+    std::string sql = "select col_1 + 1.0 as c1, col_2 * 2 as c2 from t1;";
+
+    auto compile_info = Compile(sql, options, catalog);
+    ASSERT_TRUE(compile_info != nullptr);
+    ASSERT_EQ(0u, cache->GetHitCnt());
+    // another engine, e.g. after restart, loads the object emitted by the first one
+    compile_info = Compile(sql, options, catalog);
+    ASSERT_TRUE(compile_info != nullptr);
+    ASSERT_EQ(1u, cache->GetHitCnt());
+    // the ir of other sql is compiled
+    ASSERT_TRUE(Compile("select col_1 + 2.0 as c1, col_2 * 2 as c2 from t1;", options, catalog) != nullptr);
+    ASSERT_EQ(1u, cache->GetHitCnt());
+
+    auto &sql_context = compile_info->get_sql_context();
+    auto fn_name = sql_context.physical_plan->GetFnInfos()[0]->fn_name();
+    auto fn = sql_context.jit->FindFunction(fn_name);
+    ASSERT_TRUE(fn != nullptr);
+    int8_t buf[1024];
+    auto schema = catalog->GetTable("db", "t1")->GetSchema();
+    codec::RowBuilder row_builder(*schema);
+    row_builder.SetBuffer(buf, 1024);
+    row_builder.AppendDouble(3.14);
+    row_builder.AppendInt64(42);
+    hybridse::codec::Row empty_parameter;
+    hybridse::codec::Row row(base::RefCountedSlice::Create(buf, 1024));
+    hybridse::codec::Row output = CoreAPI::RowProject(fn, row, empty_parameter);
+    codec::RowView row_view(sql_context.schema, output.buf(), output.size());
+    double c1;
+    int64_t c2;
+    ASSERT_EQ(row_view.GetDouble(0, &c1), 0);
+    ASSERT_EQ(row_view.GetInt64(1, &c2), 0);
+    ASSERT_DOUBLE_EQ(c1, 4.14);
+    ASSERT_EQ(c2, 84);
+    ::llvm::sys::fs::remove_directories(dir);
+}
+
+TEST_F(JitWrapperTest, test_object_cache_max_bytes) {
+    std::string dir = "/tmp/jit_object_cache_max_bytes_test_" + std::to_string(getpid());
+    EngineOptions options;
+    options.jit_options().SetObjectCacheDir(dir);
+    // too small for any object, every object is removed once written
+    options.jit_options().SetObjectCacheMaxBytes(1);
+    auto cache = JitObjectCache::Get(dir, options.jit_options().GetObjectCacheMaxBytes());
+    ASSERT_TRUE(cache != nullptr);
+    auto catalog = GetTestCatalog();
+    std::string sql = "select col_1 + 1.0 as c1, col_2 * 2 as c2 from t1;";
+    ASSERT_TRUE(Compile(sql, options, catalog) != nullptr);
+    ASSERT_TRUE(Compile(sql, options, catalog) != nullptr);
+    ASSERT_EQ(0u, cache->GetHitCnt());
+    ASSERT_EQ(0u, cache->GetBytes());
+    std::error_code ec;
+    ::llvm::sys::fs::directory_iterator iter(dir, ec);
+    ASSERT_FALSE(ec);
+    ASSERT_TRUE(iter == ::llvm::sys::fs::directory_iterator());
+    ::llvm::sys::fs::remove_directories(dir);
+}
+
 }  // namespace vm
 }  // namespace hybridse
 
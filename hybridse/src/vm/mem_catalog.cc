@@ -425,5 +425,181 @@ size_t RowGetSliceSize(int8_t* row_ptr, size_t idx) {
     auto row = reinterpret_cast<Row*>(row_ptr);
     return row->size(idx);
 }
+
+void MinMaxWindowDeque::PushBack(int64_t value, bool is_null) {
+    int64_t seq = tail_seq_++;
+    if (is_null) {
+        return;
+    }
+    // older rows which are not better than the new one never come back
+    while (!items_.empty() && !Prefer(items_.back().second, value)) {
+        items_.pop_back();
+    }
+    items_.emplace_back(seq, value);
+}
+
+void MinMaxWindowDeque::PushFront(int64_t value, bool is_null) {
+    int64_t seq = --head_seq_;
+    if (is_null) {
+        return;
+    }
+    if (items_.empty() || Prefer(value, items_.front().second)) {
+        items_.emplace_front(seq, value);
+    }
+}
+
+void MinMaxWindowDeque::EvictOldest() {
+    if (!items_.empty() && items_.front().first <= head_seq_) {
+        items_.pop_front();
+    }
+    head_seq_++;
+}
+
+MinMaxWindowDeque* WindowAggState::GetDeque(size_t idx, bool is_min) {
+    if (idx >= deques_.size()) {
+        deques_.resize(idx + 1);
+    }
+    if (!deques_[idx]) {
+        deques_[idx].reset(new MinMaxWindowDeque(is_min));
+    }
+    return deques_[idx].get();
+}
+
+// the delta kept is at most this many rows or window size
+static const size_t kMinWindowDeltaSize = 64;
+
+bool Window::TrackDelta() {
+    if (agg_states_.empty()) {
+        return false;
+    }
+    if (delta_consumed_) {
+        // states have seen the last delta, start a new one
+        appended_rows_.clear();
+        retracted_rows_.clear();
+        front_retracted_ = false;
+        delta_overflow_ = false;
+        delta_consumed_ = false;
+        epoch_++;
+    }
+    if (delta_overflow_) {
+        return false;
+    }
+    if (appended_rows_.size() + retracted_rows_.size() >=
+        std::max(table_.size(), kMinWindowDeltaSize)) {
+        // rescan is cheaper than applying the delta
+        appended_rows_.clear();
+        retracted_rows_.clear();
+        delta_overflow_ = true;
+        return false;
+    }
+    return true;
+}
+
+void Window::AppendFrontRow(uint64_t key, const Row& row) {
+    AddFrontRow(key, row);
+    if (TrackDelta()) {
+        appended_rows_.emplace_back(key, row);
+    }
+}
+
+void Window::EvictBackRow() {
+    if (TrackDelta()) {
+        // appended rows are the newest ones in window
+        if (appended_rows_.size() >= table_.size()) {
+            appended_rows_.pop_front();
+        } else {
+            retracted_rows_.push_back(table_.back());
+        }
+    }
+    PopBackRow();
+}
+
+void Window::EvictFrontRow() {
+    if (TrackDelta()) {
+        if (!appended_rows_.empty()) {
+            appended_rows_.pop_back();
+        } else {
+            retracted_rows_.push_back(table_.front());
+            front_retracted_ = true;
+        }
+    }
+    PopFrontRow();
+}
+
+WindowAggState* Window::SyncAggState(uint64_t key, size_t bytes,
+                                     bool fifo_only) {
+    auto& state = agg_states_[key];
+    if (!state) {
+        state.reset(new WindowAggState(bytes));
+        state->mode_ = WindowAggState::kRescan;
+    } else if (state->epoch_ == epoch_ && delta_consumed_) {
+        state->mode_ = WindowAggState::kUpToDate;
+    } else if (state->epoch_ + 1 == epoch_ && !delta_overflow_ &&
+               !(fifo_only && front_retracted_)) {
+        state->mode_ = WindowAggState::kApplyDelta;
+    } else {
+        state->mode_ = WindowAggState::kRescan;
+    }
+    if (state->mode_ == WindowAggState::kRescan) {
+        for (auto& deque : state->deques_) {
+            if (deque) {
+                deque->Clear();
+            }
+        }
+    }
+    // the caller brings the state up to date with current window
+    state->epoch_ = epoch_;
+    delta_consumed_ = true;
+    return state.get();
+}
+
+int8_t* WindowAggStateSync(int8_t* input, uint64_t key, size_t bytes,
+                           int8_t fifo_only) {
+    auto list_ref = reinterpret_cast<codec::ListRef<Row>*>(input);
+    auto window = dynamic_cast<Window*>(
+        reinterpret_cast<codec::ListV<Row>*>(list_ref->list));
+    if (window == nullptr) {
+        return nullptr;
+    }
+    return reinterpret_cast<int8_t*>(
+        window->SyncAggState(key, bytes, fifo_only));
+}
+int32_t WindowAggStateMode(int8_t* state) {
+    return reinterpret_cast<WindowAggState*>(state)->mode();
+}
+int8_t* WindowAggStateBuf(int8_t* state) {
+    return reinterpret_cast<WindowAggState*>(state)->buf();
+}
+void GetWindowAggDeltaIter(int8_t* input, int8_t* state, int8_t retracted,
+                           int8_t* iter_addr) {
+    static const MemTimeTable empty_rows;
+    auto list_ref = reinterpret_cast<codec::ListRef<Row>*>(input);
+    auto window = dynamic_cast<Window*>(
+        reinterpret_cast<codec::ListV<Row>*>(list_ref->list));
+    const MemTimeTable* rows = &empty_rows;
+    if (reinterpret_cast<WindowAggState*>(state)->mode() ==
+        WindowAggState::kApplyDelta) {
+        rows = retracted ? &window->retracted_rows() : &window->appended_rows();
+    }
+    auto local_iter = new (iter_addr) std::unique_ptr<RowIterator>(
+        new MemTimeTableIterator(rows, window->GetSchema()));
+    (*local_iter)->SeekToFirst();
+}
+int8_t* WindowAggStateDeque(int8_t* state, size_t idx, int8_t is_min) {
+    return reinterpret_cast<int8_t*>(
+        reinterpret_cast<WindowAggState*>(state)->GetDeque(idx, is_min));
+}
+void WindowAggDequePushBack(int8_t* deque, int64_t value, int8_t is_null) {
+    reinterpret_cast<MinMaxWindowDeque*>(deque)->PushBack(value, is_null);
+}
+void WindowAggDequePushFront(int8_t* deque, int64_t value, int8_t is_null) {
+    reinterpret_cast<MinMaxWindowDeque*>(deque)->PushFront(value, is_null);
+}
+void WindowAggDequeEvict(int8_t* deque) {
+    reinterpret_cast<MinMaxWindowDeque*>(deque)->EvictOldest();
+}
+int64_t WindowAggDequeFront(int8_t* deque, int64_t default_value) {
+    return reinterpret_cast<MinMaxWindowDeque*>(deque)->Front(default_value);
+}
 }  // namespace vm
 }  // namespace hybridse
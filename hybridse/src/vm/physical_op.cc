@@ -46,6 +46,7 @@ static absl::flat_hash_map<PhysicalOpType, absl::string_view> CreatePhysicalOpTy
         {kPhysicalOpUnion, "UNION"},
         {kPhysicalOpPostRequestUnion, "POST_REQUEST_UNION"},
         {kPhysicalOpRequestUnion, "REQUEST_UNION"},
+        {kPhysicalOpRequestAggUnion, "REQUEST_AGG_UNION"},
         {kPhysicalOpRequestJoin, "REQUEST_JOIN"},
         {kPhysicalOpIndexSeek, "INDEX_SEEK"},
         {kPhysicalOpLoadData, "LOAD_DATA"},
@@ -1235,6 +1236,65 @@ PhysicalRequestUnionNode* PhysicalRequestUnionNode::CastFrom(PhysicalOpNode* nod
     return dynamic_cast<PhysicalRequestUnionNode*>(node);
 }
 
+Status PhysicalRequestAggUnionNode::WithNewChildren(node::NodeManager* nm,
+                                                    const std::vector<PhysicalOpNode*>& children,
+                                                    PhysicalOpNode** out) {
+    CHECK_TRUE(children.size() == 2, common::kPlanError);
+    SchemaSource output_source;
+    output_source.SetSchema(&output_schema_);
+    for (size_t i = 0; i < output_column_ids_.size(); ++i) {
+        output_source.SetColumnID(i, output_column_ids_[i]);
+    }
+    auto new_union_op = new PhysicalRequestAggUnionNode(children[0], children[1], window_, aggr_key_.keys(),
+                                                        bucket_size_, aggr_specs_, &output_source);
+
+    std::vector<const node::ExprNode*> depend_columns;
+    window_.ResolvedRelatedColumns(&depend_columns);
+    aggr_key_.ResolvedRelatedColumns(&depend_columns);
+    passes::ExprReplacer replacer;
+    for (auto col_expr : depend_columns) {
+        CHECK_STATUS(
+            BuildColumnReplacement(col_expr, GetProducer(0)->schemas_ctx(), children[0]->schemas_ctx(), nm, &replacer));
+    }
+    CHECK_STATUS(window_.ReplaceExpr(replacer, nm, &new_union_op->window_));
+    CHECK_STATUS(aggr_key_.ReplaceExpr(replacer, nm, &new_union_op->aggr_key_));
+    *out = nm->RegisterNode(new_union_op);
+    return Status::OK();
+}
+
+void PhysicalRequestAggUnionNode::Print(std::ostream& output, const std::string& tab) const {
+    PhysicalOpNode::Print(output, tab);
+    output << "(" << window_.ToString() << ", aggr_" << aggr_key_.ToString() << ", bucket_size=" << bucket_size_
+           << ", aggr_tables=(";
+    for (size_t i = 0; i < aggr_specs_.size(); ++i) {
+        if (i > 0) {
+            output << ", ";
+        }
+        output << aggr_specs_[i].aggr_table->GetName();
+    }
+    output << "))\n";
+    PrintChildren(output, tab);
+}
+
+base::Status PhysicalRequestAggUnionNode::InitSchema(PhysicalPlanContext* ctx) {
+    CHECK_TRUE(producers_.size() == 2, common::kPlanError, "Request agg union should have two inputs");
+    CHECK_TRUE(output_column_ids_.size() == static_cast<size_t>(output_schema_.size()), common::kPlanError,
+               "Output column ids and schema of request agg union mismatch");
+    schemas_ctx_.Clear();
+    schemas_ctx_.SetDefaultDBName(ctx->db());
+    SchemaSource* output_source = schemas_ctx_.AddSource();
+    output_source->SetSchema(&output_schema_);
+    for (size_t i = 0; i < output_column_ids_.size(); ++i) {
+        output_source->SetColumnID(i, output_column_ids_[i]);
+        output_source->SetNonSource(i);
+    }
+    return Status::OK();
+}
+
+PhysicalRequestAggUnionNode* PhysicalRequestAggUnionNode::CastFrom(PhysicalOpNode* node) {
+    return dynamic_cast<PhysicalRequestAggUnionNode*>(node);
+}
+
 void PhysicalRequestJoinNode::Print(std::ostream& output, const std::string& tab) const {
     PhysicalOpNode::Print(output, tab);
     output << "(";
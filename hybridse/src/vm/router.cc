@@ -25,7 +25,8 @@ bool Router::IsWindowNode(const PhysicalOpNode* physical_node) {
         LOG(WARNING) << "node is null";
         return false;
     }
-    if (physical_node->GetOpType() == kPhysicalOpRequestUnion) {
+    if (physical_node->GetOpType() == kPhysicalOpRequestUnion ||
+        physical_node->GetOpType() == kPhysicalOpRequestAggUnion) {
         if (physical_node->GetProducerCnt() > 0) {
             auto node = physical_node->GetProducer(0);
             if (node != nullptr &&
@@ -48,19 +49,20 @@ int Router::Parse(const PhysicalOpNode* physical_plan) {
         return -1;
     }
     if (IsWindowNode(physical_plan)) {
-        auto request_union_node =
-            dynamic_cast<const PhysicalRequestUnionNode*>(physical_plan);
-        if (request_union_node) {
+        const node::ExprListNode* keys = nullptr;
+        if (physical_plan->GetOpType() == kPhysicalOpRequestAggUnion) {
+            keys = dynamic_cast<const PhysicalRequestAggUnionNode*>(physical_plan)->window().index_key().keys();
+        } else {
             // auto keys = request_union_node->window().partition().keys();
-            auto keys = request_union_node->window().index_key().keys();
-            if (keys != nullptr && keys->GetChildNum() > 0) {
-                auto exp_node = keys->GetChild(0);
-                auto columnNode =
-                    dynamic_cast<hybridse::node::ColumnRefNode*>(exp_node);
-                if (columnNode != nullptr) {
-                    router_col_ = columnNode->GetColumnName();
-                    return 0;
-                }
+            keys = dynamic_cast<const PhysicalRequestUnionNode*>(physical_plan)->window().index_key().keys();
+        }
+        if (keys != nullptr && keys->GetChildNum() > 0) {
+            auto exp_node = keys->GetChild(0);
+            auto columnNode =
+                dynamic_cast<hybridse::node::ColumnRefNode*>(exp_node);
+            if (columnNode != nullptr) {
+                router_col_ = columnNode->GetColumnName();
+                return 0;
             }
         }
     }
@@ -16,7 +16,11 @@
 
 #include "vm/runner.h"
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <string>
 #include <utility>
 #include <vector>
@@ -28,6 +32,7 @@
 #include "vm/core_api.h"
 #include "vm/jit_runtime.h"
 #include "vm/mem_catalog.h"
+#include "vm/worker_pool.h"
 
 DECLARE_bool(enable_spark_unsaferow_format);
 
@@ -235,6 +240,7 @@ ClusterTask RunnerBuilder::Build(PhysicalOpNode* node, Status& status) {
                         op->window_, op->project().fn_info(),
                         op->instance_not_in_window(),
                         op->exclude_current_time(), op->need_append_input());
+                    runner->set_parallelism(window_agg_parallelism_);
                     size_t input_slices =
                         input->output_schemas()->GetSchemaSourceSize();
                     if (!op->window_unions_.Empty()) {
@@ -332,6 +338,34 @@ ClusterTask RunnerBuilder::Build(PhysicalOpNode* node, Status& status) {
                 node, BinaryInherit(left_task, right_task, runner, index_key,
                                     kRightBias));
         }
+        case kPhysicalOpRequestAggUnion: {
+            auto left_task = Build(node->producers().at(0), status);
+            if (!left_task.IsValid()) {
+                status.msg = "fail to build left input runner";
+                status.code = common::kExecutionPlanError;
+                LOG(WARNING) << status;
+                return fail;
+            }
+            auto right_task = Build(node->producers().at(1), status);
+            auto right = right_task.GetRoot();
+            if (!right_task.IsValid()) {
+                status.msg = "fail to build right input runner";
+                status.code = common::kExecutionPlanError;
+                LOG(WARNING) << status;
+                return fail;
+            }
+            auto op = dynamic_cast<const PhysicalRequestAggUnionNode*>(node);
+            RequestAggUnionRunner* runner = nullptr;
+            CreateRunner<RequestAggUnionRunner>(
+                &runner, id_++, node->schemas_ctx(),
+                node->producers().at(0)->GetOutputSchema(),
+                op->window().range_, op->aggr_key(), op->bucket_size(),
+                op->aggr_specs());
+            runner->AddWindowUnion(op->window_, right);
+            return RegisterTask(
+                node, BinaryInherit(left_task, right_task, runner,
+                                    op->window_.index_key_, kRightBias));
+        }
         case kPhysicalOpRequestJoin: {
             auto left_task =  // NOLINT
                 Build(node->producers().at(0), status);
@@ -794,6 +828,27 @@ ClusterTask RunnerBuilder::UnaryInheritTask(const ClusterTask& input,
     return task;
 }
 
+// Mark the runners with more than one producer doing real work, i.e. more
+// than providing a table or the request row, to run the producers in
+// parallel. The producers may share runners, which are cached and run once.
+void RunnerBuilder::MarkParallelBranches(Runner* runner,
+                                         std::set<Runner*>* visited) {
+    if (nullptr == runner || !visited->insert(runner).second) {
+        return;
+    }
+    size_t branch_cnt = 0;
+    for (auto producer : runner->GetProducers()) {
+        if (kRunnerData != producer->type_ &&
+            kRunnerRequest != producer->type_) {
+            branch_cnt++;
+        }
+        MarkParallelBranches(producer, visited);
+    }
+    if (branch_cnt > 1) {
+        runner->set_producer_parallelism(branch_parallelism_);
+    }
+}
+
 bool Runner::GetColumnBool(const int8_t* buf, const RowView* row_view, int idx,
                            type::Type type) {
     bool key = false;
@@ -1041,15 +1096,19 @@ std::shared_ptr<DataHandlerList> Runner::BatchRequestRun(RunnerContext& ctx) {
 }
 std::shared_ptr<DataHandler> Runner::RunWithCache(RunnerContext& ctx) {
     if (need_cache_) {
-        auto cached = ctx.GetCache(id_);
-        if (cached != nullptr) {
-            DLOG(INFO) << "RUNNER ID " << id_ << " HIT CACHE!";
-            return cached;
-        }
+        return ctx.GetOrRunCache(id_,
+                                 [this, &ctx]() { return RunProducersAndSelf(ctx); });
     }
+    return RunProducersAndSelf(ctx);
+}
+std::shared_ptr<DataHandler> Runner::RunProducersAndSelf(RunnerContext& ctx) {
     std::vector<std::shared_ptr<DataHandler>> inputs(producers_.size());
-    for (size_t idx = producers_.size(); idx > 0; idx--) {
-        inputs[idx - 1] = producers_[idx - 1]->RunWithCache(ctx);
+    if (producer_parallelism_ > 1 && producers_.size() > 1) {
+        RunProducersInParallel(ctx, &inputs);
+    } else {
+        for (size_t idx = producers_.size(); idx > 0; idx--) {
+            inputs[idx - 1] = producers_[idx - 1]->RunWithCache(ctx);
+        }
     }
 
     auto res = Run(ctx, inputs);
@@ -1059,11 +1118,26 @@ std::shared_ptr<DataHandler> Runner::RunWithCache(RunnerContext& ctx) {
         Runner::PrintData(oss, output_schemas_, res);
         LOG(INFO) << oss.str();
     }
-    if (need_cache_) {
-        ctx.SetCache(id_, res);
-    }
     return res;
 }
+void Runner::RunProducersInParallel(
+    RunnerContext& ctx, std::vector<std::shared_ptr<DataHandler>>* inputs) {
+    // Workers pick the next producer from a shared cursor in the serial
+    // order, the caller works too. The runners shared by the producers are
+    // cached, so they are run once by `RunnerContext::GetOrRunCache`.
+    std::atomic<size_t> next(0);
+    std::function<void()> worker = [&]() {
+        size_t idx = next.fetch_add(1, std::memory_order_relaxed);
+        while (idx < producers_.size()) {
+            size_t pos = producers_.size() - 1 - idx;
+            (*inputs)[pos] = producers_[pos]->RunWithCache(ctx);
+            idx = next.fetch_add(1, std::memory_order_relaxed);
+        }
+    };
+    size_t worker_num =
+        std::min(static_cast<size_t>(producer_parallelism_), producers_.size());
+    WorkerPool::GetInstance()->Run(worker_num, worker);
+}
 std::shared_ptr<DataHandler> DataRunner::Run(
     RunnerContext& ctx,
     const std::vector<std::shared_ptr<DataHandler>>& inputs) {
@@ -1177,19 +1251,35 @@ std::shared_ptr<DataHandler> TableProjectRunner::Run(
         LOG(WARNING) << "inputs size < 1";
         return std::shared_ptr<DataHandler>();
     }
-    auto input = inputs[0];
-    if (!input) {
+    auto output_table = std::shared_ptr<MemTableHandler>(new MemTableHandler());
+    if (!ProjectTable(ctx, inputs[0], [&output_table](const Row& row) {
+            output_table->AddRow(row);
+            return true;
+        })) {
         return std::shared_ptr<DataHandler>();
     }
+    return output_table;
+}
+bool TableProjectRunner::RunStream(RunnerContext& ctx, const std::function<bool(const Row&)>& output) {
+    if (producers_.empty()) {
+        LOG(WARNING) << "inputs size < 1";
+        return false;
+    }
+    return ProjectTable(ctx, producers_[0]->RunWithCache(ctx), output);
+}
+bool TableProjectRunner::ProjectTable(RunnerContext& ctx, const std::shared_ptr<DataHandler>& input,
+                                      const std::function<bool(const Row&)>& output) {
+    if (!input) {
+        return false;
+    }
 
     if (kTableHandler != input->GetHanlderType()) {
-        return std::shared_ptr<DataHandler>();
+        return false;
     }
-    auto output_table = std::shared_ptr<MemTableHandler>(new MemTableHandler());
     auto iter = std::dynamic_pointer_cast<TableHandler>(input)->GetIterator();
     if (!iter) {
         LOG(WARNING) << "Table Project Fail: table iter is Empty";
-        return std::shared_ptr<DataHandler>();
+        return false;
     }
     auto& parameter = ctx.GetParameterRow();
     iter->SeekToFirst();
@@ -1198,10 +1288,12 @@ std::shared_ptr<DataHandler> TableProjectRunner::Run(
         if (limit_cnt_ > 0 && cnt++ >= limit_cnt_) {
             break;
         }
-        output_table->AddRow(project_gen_.Gen(iter->GetValue(), parameter));
+        if (!output(project_gen_.Gen(iter->GetValue(), parameter))) {
+            break;
+        }
         iter->Next();
     }
-    return output_table;
+    return true;
 }
 
 std::shared_ptr<DataHandler> RowProjectRunner::Run(
@@ -1338,6 +1430,16 @@ std::shared_ptr<DataHandler> WindowAggRunner::Run(
     // Compute output
     std::shared_ptr<MemTableHandler> output_table =
         std::shared_ptr<MemTableHandler>(new MemTableHandler());
+    if (parallelism_ > 1) {
+        std::vector<std::string> keys;
+        while (instance_partition_iter->Valid()) {
+            keys.push_back(instance_partition_iter->GetKey().ToString());
+            instance_partition_iter->Next();
+        }
+        RunWindowAggOnKeys(parameter, instance_partition, union_partitions,
+                           join_right_tables, keys, output_table);
+        return output_table;
+    }
     while (instance_partition_iter->Valid()) {
         auto key = instance_partition_iter->GetKey().ToString();
         RunWindowAggOnKey(parameter, instance_partition, union_partitions,
@@ -1347,6 +1449,91 @@ std::shared_ptr<DataHandler> WindowAggRunner::Run(
     return output_table;
 }
 
+void WindowAggRunner::RunWindowAggOnKeys(
+    const Row& parameter,
+    std::shared_ptr<PartitionHandler> instance_partition,
+    const std::vector<std::shared_ptr<PartitionHandler>>& union_partitions,
+    const std::vector<std::shared_ptr<DataHandler>>& join_right_tables,
+    const std::vector<std::string>& keys,
+    std::shared_ptr<MemTableHandler> output_table) {
+    if (keys.empty()) {
+        return;
+    }
+    // The segments of every key are taken here, so a worker only iterates
+    // the segments of the keys it picks and never shares a handler or an
+    // iterator with another worker.
+    size_t unions_cnt = windows_union_gen_.inputs_cnt_;
+    std::vector<std::shared_ptr<TableHandler>> instance_segments(keys.size());
+    std::vector<std::vector<std::shared_ptr<TableHandler>>> union_segments(
+        keys.size(), std::vector<std::shared_ptr<TableHandler>>(unions_cnt));
+    for (size_t idx = 0; idx < keys.size(); idx++) {
+        instance_segments[idx] = instance_partition->GetSegment(keys[idx]);
+        for (size_t i = 0; i < unions_cnt; i++) {
+            if (union_partitions[i]) {
+                union_segments[idx][i] =
+                    union_partitions[i]->GetSegment(keys[idx]);
+            }
+        }
+    }
+    // Keys differ a lot in size, so workers pick the next key from a shared
+    // cursor instead of taking a fixed range. Each key writes to its own
+    // table, which are merged in key order to keep the serial output.
+    // With a limit, workers stop taking keys once the leading finished keys
+    // have output enough rows.
+    std::vector<std::shared_ptr<MemTableHandler>> key_outputs(keys.size());
+    std::atomic<size_t> next_key(0);
+    std::atomic<bool> limit_reached(false);
+    std::mutex finished_mu;
+    std::vector<bool> finished(keys.size(), false);
+    size_t finished_prefix = 0;
+    int64_t prefix_rows = 0;
+    std::function<void()> worker = [&]() {
+        // every worker joins with a generator of its own
+        WindowJoinGenerator join_gen(windows_join_gen_);
+        while (!limit_reached.load(std::memory_order_relaxed)) {
+            size_t idx = next_key.fetch_add(1, std::memory_order_relaxed);
+            if (idx >= keys.size()) {
+                break;
+            }
+            key_outputs[idx] = std::make_shared<MemTableHandler>();
+            RunWindowAggOnSegments(parameter, instance_segments[idx],
+                                   union_segments[idx], &join_gen,
+                                   join_right_tables, key_outputs[idx]);
+            if (limit_cnt_ <= 0) {
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(finished_mu);
+            finished[idx] = true;
+            while (finished_prefix < keys.size() && finished[finished_prefix]) {
+                prefix_rows += key_outputs[finished_prefix]->GetCount();
+                finished_prefix++;
+            }
+            if (prefix_rows >= limit_cnt_) {
+                limit_reached.store(true, std::memory_order_relaxed);
+            }
+        }
+    };
+    size_t worker_num = std::min(static_cast<size_t>(parallelism_), keys.size());
+    WorkerPool::GetInstance()->Run(worker_num, worker);
+
+    for (auto& key_output : key_outputs) {
+        // the keys after the limit is reached are not run
+        if (!key_output) {
+            return;
+        }
+        auto iter = key_output->GetIterator();
+        iter->SeekToFirst();
+        while (iter->Valid()) {
+            if (limit_cnt_ > 0 &&
+                static_cast<int32_t>(output_table->GetCount()) >= limit_cnt_) {
+                return;
+            }
+            output_table->AddRow(iter->GetValue());
+            iter->Next();
+        }
+    }
+}
+
 // Run Window Aggeregation on given key
 void WindowAggRunner::RunWindowAggOnKey(
     const Row& parameter,
@@ -1354,8 +1541,25 @@ void WindowAggRunner::RunWindowAggOnKey(
     std::vector<std::shared_ptr<PartitionHandler>> union_partitions,
     std::vector<std::shared_ptr<DataHandler>> join_right_tables,
     const std::string& key, std::shared_ptr<MemTableHandler> output_table) {
+    size_t unions_cnt = windows_union_gen_.inputs_cnt_;
+    std::vector<std::shared_ptr<TableHandler>> union_segments(unions_cnt);
+    for (size_t i = 0; i < unions_cnt; i++) {
+        if (union_partitions[i]) {
+            union_segments[i] = union_partitions[i]->GetSegment(key);
+        }
+    }
+    RunWindowAggOnSegments(parameter, instance_partition->GetSegment(key),
+                           union_segments, &windows_join_gen_,
+                           join_right_tables, output_table);
+}
+
+void WindowAggRunner::RunWindowAggOnSegments(
+    const Row& parameter, std::shared_ptr<TableHandler> instance_segment,
+    const std::vector<std::shared_ptr<TableHandler>>& union_segments,
+    WindowJoinGenerator* join_gen,
+    const std::vector<std::shared_ptr<DataHandler>>& join_right_tables,
+    std::shared_ptr<MemTableHandler> output_table) {
     // Prepare Instance Segment
-    auto instance_segment = instance_partition->GetSegment(key);
     instance_segment = instance_window_gen_.sort_gen_.Sort(instance_segment);
     if (!instance_segment) {
         LOG(WARNING) << "Instance Segment is Empty";
@@ -1371,17 +1575,17 @@ void WindowAggRunner::RunWindowAggOnKey(
 
     // Prepare Union Segment Iterators
     size_t unions_cnt = windows_union_gen_.inputs_cnt_;
-    std::vector<std::shared_ptr<TableHandler>> union_segments(unions_cnt);
+    std::vector<std::shared_ptr<TableHandler>> sorted_union_segments(unions_cnt);
     std::vector<std::unique_ptr<RowIterator>> union_segment_iters(unions_cnt);
     std::vector<IteratorStatus> union_segment_status(unions_cnt);
 
     for (size_t i = 0; i < unions_cnt; i++) {
-        if (!union_partitions[i]) {
+        if (!union_segments[i]) {
             continue;
         }
-        auto segment = union_partitions[i]->GetSegment(key);
-        segment = windows_union_gen_.windows_gen_[i].sort_gen_.Sort(segment);
-        union_segments[i] = segment;
+        auto segment =
+            windows_union_gen_.windows_gen_[i].sort_gen_.Sort(union_segments[i]);
+        sorted_union_segments[i] = segment;
         if (!segment) {
             union_segment_status[i] = IteratorStatus();
             continue;
@@ -1418,8 +1622,8 @@ void WindowAggRunner::RunWindowAggOnKey(
         while (min_union_pos >= 0 &&
                union_segment_status[min_union_pos].key_ < instance_order) {
             Row row = union_segment_iters[min_union_pos]->GetValue();
-            if (windows_join_gen_.Valid()) {
-                row = windows_join_gen_.Join(row, join_right_tables, parameter);
+            if (join_gen->Valid()) {
+                row = join_gen->Join(row, join_right_tables, parameter);
             }
             window_project_gen_.Gen(
                 union_segment_iters[min_union_pos]->GetKey(), row, parameter,
@@ -1437,9 +1641,9 @@ void WindowAggRunner::RunWindowAggOnKey(
             min_union_pos = IteratorStatus::PickIteratorWithMininumKey(
                 &union_segment_status);
         }
-        if (windows_join_gen_.Valid()) {
+        if (join_gen->Valid()) {
             Row row = instance_row;
-            row = windows_join_gen_.Join(instance_row, join_right_tables, parameter);
+            row = join_gen->Join(instance_row, join_right_tables, parameter);
             output_table->AddRow(window_project_gen_.Gen(instance_segment_iter->GetKey(), row, parameter, true,
                                                          append_slices_, &window));
         } else {
@@ -2642,6 +2846,230 @@ std::shared_ptr<TableHandler> RequestUnionRunner::RequestUnionWindow(
     return window_table;
 }
 
+std::shared_ptr<DataHandler> RequestAggUnionRunner::Run(
+    RunnerContext& ctx,
+    const std::vector<std::shared_ptr<DataHandler>>& inputs) {
+    if (inputs.size() < 2u) {
+        LOG(WARNING) << "inputs size < 2";
+        return std::shared_ptr<DataHandler>();
+    }
+    auto left = inputs[0];
+    auto right = inputs[1];
+    if (!left || !right || kRowHandler != left->GetHanlderType()) {
+        return std::shared_ptr<DataHandler>();
+    }
+    auto request = std::dynamic_pointer_cast<RowHandler>(left)->GetValue();
+    int64_t ts_gen = range_gen_.Valid() ? range_gen_.ts_gen_.Gen(request) : -1;
+    if (ts_gen < 0) {
+        LOG(WARNING) << "fail to aggregate request window: invalid request ts " << ts_gen;
+        return std::shared_ptr<DataHandler>();
+    }
+    const WindowRange& window_range = range_gen_.window_range_;
+    int64_t start = (ts_gen + window_range.start_offset_) < 0 ? 0 : (ts_gen + window_range.start_offset_);
+    int64_t end = ts_gen;
+
+    // whole buckets inside [start, end]
+    int64_t bucket_start = (start + bucket_size_ - 1) / bucket_size_ * bucket_size_;
+    int64_t bucket_end = (end + 1) / bucket_size_ * bucket_size_ - bucket_size_;
+    std::string key = aggr_key_gen_.Gen(request, ctx.GetParameterRow());
+
+    // the buckets after the latest written one are still in tablet memory,
+    // so each aggregation covers [bucket_start, covered_end] by pre-aggr table
+    // and the rest of window by raw rows
+    std::vector<codec::AggrValue> values;
+    std::vector<int64_t> covered_ends;
+    int64_t min_covered_end = INT64_MAX;
+    for (const auto& spec : aggr_specs_) {
+        auto col_type = spec.col_idx < 0 ? type::kInt64 : input_schema_->Get(spec.col_idx).type();
+        values.emplace_back(spec.func_type, col_type == type::kFloat || col_type == type::kDouble);
+        int64_t last_bucket = AggregateBuckets(spec, key, bucket_start, bucket_end, &values.back());
+        covered_ends.push_back(last_bucket < 0 ? bucket_start - 1 : last_bucket + bucket_size_ - 1);
+        min_covered_end = std::min(min_covered_end, covered_ends.back());
+        if (!AggregateRow(spec, request, &values.back())) {
+            return std::shared_ptr<DataHandler>();
+        }
+    }
+
+    auto union_inputs = windows_union_gen_.RunInputs(ctx);
+    auto union_segments = windows_union_gen_.GetRequestWindows(request, ctx.GetParameterRow(), union_inputs);
+    if (!union_segments.empty() && union_segments[0]) {
+        auto iter = union_segments[0]->GetIterator();
+        if (iter) {
+            iter->Seek(end);
+        }
+        while (iter && iter->Valid()) {
+            int64_t ts = static_cast<int64_t>(iter->GetKey());
+            if (ts < start) {
+                break;
+            }
+            if (ts >= bucket_start && ts <= min_covered_end) {
+                // skip the rows covered by all aggregations
+                if (bucket_start == 0) {
+                    break;
+                }
+                iter->Seek(bucket_start - 1);
+                continue;
+            }
+            for (size_t i = 0; i < aggr_specs_.size(); i++) {
+                if (ts < bucket_start || ts > covered_ends[i]) {
+                    if (!AggregateRow(aggr_specs_[i], iter->GetValue(), &values[i])) {
+                        return std::shared_ptr<DataHandler>();
+                    }
+                }
+            }
+            iter->Next();
+        }
+    }
+    return std::shared_ptr<MemRowHandler>(new MemRowHandler(EncodeAggrRow(values)));
+}
+
+int64_t RequestAggUnionRunner::AggregateBuckets(const RequestAggSpec& spec, const std::string& key,
+                                                int64_t bucket_start, int64_t bucket_end,
+                                                codec::AggrValue* value) {
+    if (bucket_end < bucket_start || spec.aggr_table->GetIndex().empty()) {
+        return -1;
+    }
+    auto partition = spec.aggr_table->GetPartition(spec.aggr_table->GetIndex().begin()->first);
+    if (!partition) {
+        return -1;
+    }
+    auto segment = partition->GetSegment(key);
+    if (!segment) {
+        return -1;
+    }
+    auto iter = segment->GetIterator();
+    if (!iter) {
+        return -1;
+    }
+    codec::RowView view(*spec.aggr_table->GetSchema());
+    int64_t last_bucket = -1;
+    int64_t cur_bucket = -1;
+    int64_t cur_offset = -1;
+    codec::AggrValue cur_value(spec.func_type, value->IsDouble());
+    iter->Seek(bucket_end);
+    // a bucket may be written several times with late rows, the record with
+    // max binlog_offset is the latest one
+    while (iter->Valid() && static_cast<int64_t>(iter->GetKey()) >= bucket_start) {
+        int64_t ts_start = static_cast<int64_t>(iter->GetKey());
+        if (ts_start != cur_bucket) {
+            value->Merge(cur_value);
+            cur_value.Reset();
+            cur_bucket = ts_start;
+            cur_offset = -1;
+            last_bucket = std::max(last_bucket, ts_start);
+        }
+        const Row& row = iter->GetValue();
+        int64_t offset = -1;
+        const char* aggr_val = nullptr;
+        uint32_t aggr_val_size = 0;
+        if (view.Reset(row.buf(), row.size()) &&
+            view.GetInt64(codec::kAggrBinlogOffsetPos, &offset) == 0 && offset > cur_offset &&
+            view.GetString(codec::kAggrValPos, &aggr_val, &aggr_val_size) == 0) {
+            cur_value.Decode(aggr_val, aggr_val_size);
+            cur_offset = offset;
+        }
+        iter->Next();
+    }
+    value->Merge(cur_value);
+    return last_bucket;
+}
+
+bool RequestAggUnionRunner::AggregateRow(const RequestAggSpec& spec, const Row& row, codec::AggrValue* value) {
+    if (spec.col_idx < 0) {
+        value->Update(static_cast<int64_t>(0));
+        return true;
+    }
+    codec::RowView view(*input_schema_);
+    auto type = input_schema_->Get(spec.col_idx).type();
+    const int8_t* buf = row.buf();
+    if (view.IsNULL(buf, spec.col_idx)) {
+        return true;
+    }
+    switch (type) {
+        case type::kFloat: {
+            float val = 0;
+            if (view.GetValue(buf, spec.col_idx, type, &val) != 0) {
+                return false;
+            }
+            value->Update(static_cast<double>(val));
+            break;
+        }
+        case type::kDouble: {
+            double val = 0;
+            if (view.GetValue(buf, spec.col_idx, type, &val) != 0) {
+                return false;
+            }
+            value->Update(val);
+            break;
+        }
+        case type::kInt16:
+        case type::kInt32:
+        case type::kInt64:
+        case type::kTimestamp: {
+            value->Update(GetColumnInt64(buf, &view, spec.col_idx, type));
+            break;
+        }
+        default: {
+            // count of other types only cares about nullability
+            if (spec.func_type != codec::kAggrCount) {
+                LOG(WARNING) << "fail to aggregate column of type " << type::Type_Name(type);
+                return false;
+            }
+            value->Update(static_cast<int64_t>(0));
+            break;
+        }
+    }
+    return true;
+}
+
+Row RequestAggUnionRunner::EncodeAggrRow(const std::vector<codec::AggrValue>& values) {
+    const codec::Schema& schema = *output_schemas()->GetOutputSchema();
+    codec::RowBuilder builder(schema);
+    uint32_t size = builder.CalTotalLength(0);
+    int8_t* buf = reinterpret_cast<int8_t*>(malloc(size));
+    builder.SetBuffer(buf, size);
+    for (int i = 0; i < schema.size(); i++) {
+        const codec::AggrValue& value = values[i];
+        if (value.IsNull()) {
+            builder.AppendNULL();
+            continue;
+        }
+        double f64 = value.IsDouble() ? value.GetDouble() : static_cast<double>(value.GetInt64());
+        int64_t i64 = value.IsDouble() ? static_cast<int64_t>(value.GetDouble()) : value.GetInt64();
+        if (value.GetType() == codec::kAggrCount) {
+            i64 = value.GetCount();
+            f64 = static_cast<double>(i64);
+        } else if (value.GetType() == codec::kAggrAvg) {
+            f64 = value.GetDouble() / value.GetCount();
+            i64 = static_cast<int64_t>(f64);
+        }
+        switch (schema.Get(i).type()) {
+            case type::kInt16:
+                builder.AppendInt16(static_cast<int16_t>(i64));
+                break;
+            case type::kInt32:
+                builder.AppendInt32(static_cast<int32_t>(i64));
+                break;
+            case type::kInt64:
+                builder.AppendInt64(i64);
+                break;
+            case type::kTimestamp:
+                builder.AppendTimestamp(i64);
+                break;
+            case type::kFloat:
+                builder.AppendFloat(static_cast<float>(f64));
+                break;
+            case type::kDouble:
+                builder.AppendDouble(f64);
+                break;
+            default:
+                builder.AppendNULL();
+                break;
+        }
+    }
+    return Row(base::RefCountedSlice::CreateManaged(buf, size));
+}
+
 std::shared_ptr<DataHandler> PostRequestUnionRunner::Run(
     RunnerContext& ctx,
     const std::vector<std::shared_ptr<DataHandler>>& inputs) {
@@ -3446,6 +3874,7 @@ void RunnerContext::SetBatchCache(int64_t id,
 }
 
 std::shared_ptr<DataHandler> RunnerContext::GetCache(int64_t id) const {
+    std::lock_guard<std::mutex> lock(cache_mu_);
     auto iter = cache_.find(id);
     if (iter == cache_.end()) {
         return std::shared_ptr<DataHandler>();
@@ -3456,7 +3885,32 @@ std::shared_ptr<DataHandler> RunnerContext::GetCache(int64_t id) const {
 
 void RunnerContext::SetCache(int64_t id,
                              const std::shared_ptr<DataHandler> data) {
+    std::lock_guard<std::mutex> lock(cache_mu_);
+    cache_[id] = data;
+}
+
+std::shared_ptr<DataHandler> RunnerContext::GetOrRunCache(
+    int64_t id, const std::function<std::shared_ptr<DataHandler>()>& run) {
+    std::unique_lock<std::mutex> lock(cache_mu_);
+    while (true) {
+        auto iter = cache_.find(id);
+        if (iter != cache_.end()) {
+            DLOG(INFO) << "RUNNER ID " << id << " HIT CACHE!";
+            return iter->second;
+        }
+        if (running_ids_.find(id) == running_ids_.end()) {
+            break;
+        }
+        cache_cv_.wait(lock);
+    }
+    running_ids_.insert(id);
+    lock.unlock();
+    auto data = run();
+    lock.lock();
     cache_[id] = data;
+    running_ids_.erase(id);
+    cache_cv_.notify_all();
+    return data;
 }
 
 void RunnerContext::SetRequest(const hybridse::codec::Row& request) {
@@ -17,8 +17,11 @@
 #ifndef HYBRIDSE_SRC_VM_RUNNER_H_
 #define HYBRIDSE_SRC_VM_RUNNER_H_
 
+#include <condition_variable>  // NOLINT
+#include <functional>
 #include <map>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <set>
 #include <string>
 #include <unordered_map>
@@ -339,6 +342,7 @@ enum RunnerType {
     kRunnerWindowAgg,
     kRunnerRequestUnion,
     kRunnerPostRequestUnion,
+    kRunnerRequestAggUnion,
     kRunnerIndexSeek,
     kRunnerLastJoin,
     kRunnerConcat,
@@ -380,6 +384,8 @@ inline const std::string RunnerTypeName(const RunnerType& type) {
             return "REQUEST_UNION";
         case kRunnerPostRequestUnion:
             return "POST_REQUEST_UNION";
+        case kRunnerRequestAggUnion:
+            return "REQUEST_AGG_UNION";
         case kRunnerIndexSeek:
             return "INDEX_SEEK";
         case kRunnerLastJoin:
@@ -407,6 +413,7 @@ class Runner : public node::NodeBase<Runner> {
           is_lazy_(false),
           need_cache_(false),
           need_batch_cache_(false),
+          producer_parallelism_(1),
           producers_(),
           output_schemas_() {}
     Runner(const int32_t id, const RunnerType type,
@@ -417,6 +424,7 @@ class Runner : public node::NodeBase<Runner> {
           is_lazy_(false),
           need_cache_(false),
           need_batch_cache_(false),
+          producer_parallelism_(1),
           producers_(),
           output_schemas_(output_schemas) {}
     Runner(const int32_t id, const RunnerType type,
@@ -427,6 +435,7 @@ class Runner : public node::NodeBase<Runner> {
           is_lazy_(false),
           need_cache_(false),
           need_batch_cache_(false),
+          producer_parallelism_(1),
           producers_(),
           output_schemas_(output_schemas) {}
     virtual ~Runner() {}
@@ -472,6 +481,12 @@ class Runner : public node::NodeBase<Runner> {
     void DisableCache() { need_cache_ = false; }
     void EnableBatchCache() { need_batch_cache_ = true; }
     void DisableBatchCache() { need_batch_cache_ = false; }
+    // run the producers with `parallelism` workers of `WorkerPool` in
+    // `RunWithCache`
+    void set_producer_parallelism(uint32_t parallelism) {
+        producer_parallelism_ = parallelism;
+    }
+    uint32_t producer_parallelism() const { return producer_parallelism_; }
 
     const int32_t id_;
     const RunnerType type_;
@@ -545,8 +560,16 @@ class Runner : public node::NodeBase<Runner> {
 
     bool need_cache_;
     bool need_batch_cache_;
+    uint32_t producer_parallelism_;
     std::vector<Runner*> producers_;
     const vm::SchemasContext* output_schemas_;
+
+ private:
+    std::shared_ptr<DataHandler> RunProducersAndSelf(
+        RunnerContext& ctx);  // NOLINT
+    void RunProducersInParallel(
+        RunnerContext& ctx,  // NOLINT
+        std::vector<std::shared_ptr<DataHandler>>* inputs);
 };
 
 class IteratorStatus {
@@ -774,7 +797,17 @@ class TableProjectRunner : public Runner {
         RunnerContext& ctx,  // NOLINT
         const std::vector<std::shared_ptr<DataHandler>>& inputs)
         override;  // NOLINT
+    // run the producer and pass the projected rows to output one by one
+    // without collecting them into a table, stop once output returns false.
+    // Return false if the input is not a table
+    bool RunStream(RunnerContext& ctx,  // NOLINT
+                   const std::function<bool(const Row&)>& output);
     ProjectGenerator project_gen_;
+
+ private:
+    bool ProjectTable(RunnerContext& ctx,  // NOLINT
+                      const std::shared_ptr<DataHandler>& input,
+                      const std::function<bool(const Row&)>& output);
 };
 class RowProjectRunner : public Runner {
  public:
@@ -883,8 +916,13 @@ class WindowAggRunner : public Runner {
           instance_window_gen_(window_op),
           windows_union_gen_(),
           windows_join_gen_(),
-          window_project_gen_(fn_info) {}
+          window_project_gen_(fn_info),
+          parallelism_(1) {}
     ~WindowAggRunner() {}
+    // run window aggregation on partition keys with `parallelism` workers of
+    // `WorkerPool`
+    void set_parallelism(uint32_t parallelism) { parallelism_ = parallelism; }
+    uint32_t parallelism() const { return parallelism_; }
     void AddWindowJoin(const Join& join, size_t left_slices, Runner* runner) {
         windows_join_gen_.AddWindowJoin(join, left_slices, runner);
     }
@@ -901,6 +939,23 @@ class WindowAggRunner : public Runner {
         std::vector<std::shared_ptr<PartitionHandler>> union_partitions,
         std::vector<std::shared_ptr<DataHandler>> joins, const std::string& key,
         std::shared_ptr<MemTableHandler> output_table);
+    // Run window aggregation on the segments of a key, the segments and
+    // `join_gen` are used by one worker only
+    void RunWindowAggOnSegments(
+        const Row& parameter, std::shared_ptr<TableHandler> instance_segment,
+        const std::vector<std::shared_ptr<TableHandler>>& union_segments,
+        WindowJoinGenerator* join_gen,
+        const std::vector<std::shared_ptr<DataHandler>>& joins,
+        std::shared_ptr<MemTableHandler> output_table);
+    // Run window aggregation on `keys` concurrently, output rows keep the
+    // same order as the serial run
+    void RunWindowAggOnKeys(
+        const Row& parameter,
+        std::shared_ptr<PartitionHandler> instance_partition,
+        const std::vector<std::shared_ptr<PartitionHandler>>& union_partitions,
+        const std::vector<std::shared_ptr<DataHandler>>& joins,
+        const std::vector<std::string>& keys,
+        std::shared_ptr<MemTableHandler> output_table);
 
     const bool instance_not_in_window_;
     const bool exclude_current_time_;
@@ -910,6 +965,7 @@ class WindowAggRunner : public Runner {
     WindowUnionGenerator windows_union_gen_;
     WindowJoinGenerator windows_join_gen_;
     WindowProjectGenerator window_project_gen_;
+    uint32_t parallelism_;
 };
 
 class RequestUnionRunner : public Runner {
@@ -940,6 +996,47 @@ class RequestUnionRunner : public Runner {
     bool output_request_row_;
 };
 
+class RequestAggUnionRunner : public Runner {
+ public:
+    RequestAggUnionRunner(const int32_t id, const SchemasContext* schema,
+                          const codec::Schema* input_schema,
+                          const Range& range, const Key& aggr_key,
+                          int64_t bucket_size,
+                          const std::vector<RequestAggSpec>& aggr_specs)
+        : Runner(id, kRunnerRequestAggUnion, schema),
+          input_schema_(input_schema),
+          range_gen_(range),
+          aggr_key_gen_(aggr_key.fn_info()),
+          bucket_size_(bucket_size),
+          aggr_specs_(aggr_specs) {}
+
+    std::shared_ptr<DataHandler> Run(
+        RunnerContext& ctx,  // NOLINT
+        const std::vector<std::shared_ptr<DataHandler>>& inputs)
+        override;  // NOLINT
+    void AddWindowUnion(const RequestWindowOp& window, Runner* runner) {
+        windows_union_gen_.AddWindowUnion(window, runner);
+    }
+
+ private:
+    // merge the latest record of whole buckets in [bucket_start, bucket_end]
+    // into value, return the max ts_start merged or -1 if none
+    int64_t AggregateBuckets(const RequestAggSpec& spec, const std::string& key,
+                             int64_t bucket_start, int64_t bucket_end,
+                             codec::AggrValue* value);
+    bool AggregateRow(const RequestAggSpec& spec, const Row& row,
+                      codec::AggrValue* value);
+    Row EncodeAggrRow(const std::vector<codec::AggrValue>& values);
+
+    // schema of request and base table
+    const codec::Schema* input_schema_;
+    RequestWindowUnionGenerator windows_union_gen_;
+    RangeGenerator range_gen_;
+    KeyGenerator aggr_key_gen_;
+    const int64_t bucket_size_;
+    const std::vector<RequestAggSpec> aggr_specs_;
+};
+
 class PostRequestUnionRunner : public Runner {
  public:
     PostRequestUnionRunner(const int32_t id, const SchemasContext* schema,
@@ -1342,14 +1439,18 @@ class RunnerBuilder {
                            const std::string& db,
                            bool support_cluster_optimized,
                            const std::set<size_t>& common_column_indices,
-                           const std::set<size_t>& batch_common_node_set)
+                           const std::set<size_t>& batch_common_node_set,
+                           uint32_t window_agg_parallelism = 1,
+                           uint32_t branch_parallelism = 1)
         : nm_(nm),
           support_cluster_optimized_(support_cluster_optimized),
           id_(0),
           cluster_job_(sql, db, common_column_indices),
           task_map_(),
           proxy_runner_map_(),
-          batch_common_node_set_(batch_common_node_set) {}
+          batch_common_node_set_(batch_common_node_set),
+          window_agg_parallelism_(window_agg_parallelism),
+          branch_parallelism_(branch_parallelism) {}
     virtual ~RunnerBuilder() {}
     ClusterTask RegisterTask(PhysicalOpNode* node, ClusterTask task) {
         task_map_[node] = task;
@@ -1390,6 +1491,13 @@ class RunnerBuilder {
         } else {
             cluster_job_.AddMainTask(task);
         }
+        if (branch_parallelism_ > 1) {
+            std::set<Runner*> visited;
+            for (size_t i = 0; i < cluster_job_.GetTaskSize(); i++) {
+                MarkParallelBranches(cluster_job_.GetTask(i).GetRoot(),
+                                     &visited);
+            }
+        }
         return cluster_job_;
     }
 
@@ -1412,6 +1520,9 @@ class RunnerBuilder {
     std::unordered_map<hybridse::vm::Runner*, ::hybridse::vm::Runner*>
         proxy_runner_map_;
     std::set<size_t> batch_common_node_set_;
+    uint32_t window_agg_parallelism_;
+    uint32_t branch_parallelism_;
+    void MarkParallelBranches(Runner* runner, std::set<Runner*>* visited);
     ClusterTask BinaryInherit(const ClusterTask& left, const ClusterTask& right,
                               Runner* runner, const Key& index_key,
                               const TaskBiasType bias = kNoBias);
@@ -1482,7 +1593,15 @@ class RunnerContext {
     const std::string& sp_name() { return sp_name_; }
     std::shared_ptr<DataHandler> GetCache(int64_t id) const;
     void SetCache(int64_t id, std::shared_ptr<DataHandler> data);
-    void ClearCache() { cache_.clear(); }
+    void ClearCache() {
+        std::lock_guard<std::mutex> lock(cache_mu_);
+        cache_.clear();
+    }
+    // Return the cached output of runner `id`, or call `run` and cache its
+    // output. Runners shared by the branches running concurrently are run
+    // once, the later callers wait for the output of the first one.
+    std::shared_ptr<DataHandler> GetOrRunCache(
+        int64_t id, const std::function<std::shared_ptr<DataHandler>()>& run);
     std::shared_ptr<DataHandlerList> GetBatchCache(int64_t id) const;
     void SetBatchCache(int64_t id, std::shared_ptr<DataHandlerList> data);
 
@@ -1497,6 +1616,10 @@ class RunnerContext {
     // TODO(chenjing): optimize
     std::map<int64_t, std::shared_ptr<DataHandler>> cache_;
     std::map<int64_t, std::shared_ptr<DataHandlerList>> batch_cache_;
+    // guard `cache_` for the producers running in parallel
+    mutable std::mutex cache_mu_;
+    std::condition_variable cache_cv_;
+    std::set<int64_t> running_ids_;
 };
 }  // namespace vm
 }  // namespace hybridse
@@ -122,8 +122,9 @@ bool SqlCompiler::Compile(SqlContext& ctx, Status& status) {  // NOLINT
         LOG(WARNING) << status;
         return false;
     }
-    InitBuiltinJitSymbols(jit.get());
-    ctx.udf_library->InitJITSymbols(jit.get());
+    // the symbols of the default library are resolved from the table shared
+    // by all of the jits
+    HybridSeJitWrapper::InitJitSymbols(jit.get());
     if (!jit->OptModule(m.get())) {
         LOG(WARNING) << "fail to opt ir module for sql " << ctx.sql;
         return false;
@@ -161,7 +162,8 @@ Status SqlCompiler::BuildBatchModePhysicalPlan(SqlContext* ctx, const ::hybridse
                                                PhysicalOpNode** output) {
     vm::BatchModeTransformer transformer(&ctx->nm, ctx->db, cl_, &ctx->parameter_types, llvm_module, library,
                                          ctx->is_cluster_optimized, ctx->enable_expr_optimize,
-                                         ctx->enable_batch_window_parallelization, ctx->enable_window_column_pruning);
+                                         ctx->enable_batch_window_parallelization, ctx->enable_window_column_pruning,
+                                         ctx->enable_incremental_window_agg);
     transformer.AddDefaultPasses();
     CHECK_STATUS(transformer.TransformPhysicalPlan(plan_list, output), "Fail to generate physical plan batch mode");
     ctx->schema = *(*output)->GetOutputSchema();
@@ -295,7 +297,9 @@ bool SqlCompiler::BuildClusterJob(SqlContext& ctx, Status& status) {  // NOLINT
     RunnerBuilder runner_builder(&ctx.nm, ctx.sql, ctx.db,
                                  ctx.is_cluster_optimized && is_request_mode,
                                  ctx.batch_request_info.common_column_indices,
-                                 ctx.batch_request_info.common_node_set);
+                                 ctx.batch_request_info.common_node_set,
+                                 ctx.window_agg_parallelism,
+                                 ctx.branch_parallelism);
     ctx.cluster_job = runner_builder.BuildClusterJob(ctx.physical_plan, status);
     return status.isOK();
 }
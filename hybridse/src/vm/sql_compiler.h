@@ -44,6 +44,11 @@ struct SqlContext {
     bool enable_expr_optimize = false;
     bool enable_batch_window_parallelization = true;
     bool enable_window_column_pruning = false;
+    bool enable_incremental_window_agg = false;
+    // threads used to run batch window aggregation on partition keys
+    uint32_t window_agg_parallelism = 1;
+    // threads used to run the independent inputs of a runner
+    uint32_t branch_parallelism = 1;
 
     // the sql content
     std::string sql;
@@ -0,0 +1,229 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vm/sql_normalizer.h"
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <limits>
+#include <set>
+#include <vector>
+#include "base/fe_slice.h"
+
+namespace hybridse {
+namespace vm {
+
+namespace {
+
+struct Literal {
+    type::Type type;
+    std::string value;
+};
+
+// the keywords which end the WHERE clause
+const std::set<std::string> kWhereEnds = {"group", "having", "order", "limit", "window", "union", "config"};
+
+inline bool IsWordChar(char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_'; }
+
+inline bool IsDigit(char c) { return std::isdigit(static_cast<unsigned char>(c)); }
+
+// return the end of the number starting at pos, set is_float if it has a
+// fraction or an exponent
+size_t ScanNumber(const std::string& sql, size_t pos, bool* is_float) {
+    size_t end = pos;
+    *is_float = false;
+    while (end < sql.size() && IsDigit(sql[end])) {
+        end++;
+    }
+    if (end < sql.size() && sql[end] == '.') {
+        *is_float = true;
+        end++;
+        while (end < sql.size() && IsDigit(sql[end])) {
+            end++;
+        }
+    }
+    if (end < sql.size() && (sql[end] == 'e' || sql[end] == 'E')) {
+        size_t exp = end + 1;
+        if (exp < sql.size() && (sql[exp] == '+' || sql[exp] == '-')) {
+            exp++;
+        }
+        if (exp < sql.size() && IsDigit(sql[exp])) {
+            *is_float = true;
+            end = exp;
+            while (end < sql.size() && IsDigit(sql[end])) {
+                end++;
+            }
+        }
+    }
+    return end;
+}
+
+bool ParseNumber(const std::string& text, bool is_float, Literal* literal) {
+    errno = 0;
+    char* end = nullptr;
+    if (is_float) {
+        std::strtod(text.c_str(), &end);
+        if (errno != 0 || *end != '\0') {
+            return false;
+        }
+        literal->type = type::kDouble;
+    } else {
+        int64_t value = std::strtoll(text.c_str(), &end, 10);
+        if (errno != 0 || *end != '\0') {
+            return false;
+        }
+        literal->type = value > std::numeric_limits<int32_t>::max() ? type::kInt64 : type::kInt32;
+    }
+    literal->value = text;
+    return true;
+}
+
+codec::Row EncodeLiterals(const codec::Schema& schema, const std::vector<Literal>& literals) {
+    uint32_t str_len = 0;
+    for (const auto& literal : literals) {
+        if (literal.type == type::kVarchar) {
+            str_len += literal.value.size();
+        }
+    }
+    codec::RowBuilder builder(schema);
+    uint32_t size = builder.CalTotalLength(str_len);
+    int8_t* buf = reinterpret_cast<int8_t*>(malloc(size));
+    builder.SetBuffer(buf, size);
+    for (const auto& literal : literals) {
+        switch (literal.type) {
+            case type::kInt32:
+                builder.AppendInt32(static_cast<int32_t>(std::strtoll(literal.value.c_str(), nullptr, 10)));
+                break;
+            case type::kInt64:
+                builder.AppendInt64(std::strtoll(literal.value.c_str(), nullptr, 10));
+                break;
+            case type::kDouble:
+                builder.AppendDouble(std::strtod(literal.value.c_str(), nullptr));
+                break;
+            default:
+                builder.AppendString(literal.value.c_str(), literal.value.size());
+                break;
+        }
+    }
+    return codec::Row(base::RefCountedSlice::CreateManaged(buf, size));
+}
+
+}  // namespace
+
+bool NormalizeSql(const std::string& sql, NormalizedSql* output) {
+    if (output == nullptr) {
+        return false;
+    }
+    std::string normalized;
+    normalized.reserve(sql.size());
+    std::vector<Literal> literals;
+    int depth = 0;
+    int select_cnt = 0;
+    bool in_where = false;
+    size_t pos = 0;
+    while (pos < sql.size()) {
+        char c = sql[pos];
+        size_t next = pos + 1;
+        if (c == '-' && next < sql.size() && sql[next] == '-') {
+            next = sql.find('\n', pos);
+            next = next == std::string::npos ? sql.size() : next;
+        } else if (c == '/' && next < sql.size() && sql[next] == '*') {
+            next = sql.find("*/", pos + 2);
+            if (next == std::string::npos) {
+                return false;
+            }
+            next += 2;
+        } else if (c == '`') {
+            next = sql.find('`', pos + 1);
+            if (next == std::string::npos) {
+                return false;
+            }
+            next++;
+        } else if (c == '?') {
+            // parameterized already
+            return false;
+        } else if (c == '(') {
+            depth++;
+        } else if (c == ')') {
+            depth--;
+        } else if (c == ';' && depth == 0) {
+            in_where = false;
+        } else if (c == '\'' || c == '"') {
+            next = sql.find(c, pos + 1);
+            if (next == std::string::npos) {
+                return false;
+            }
+            if (sql.find('\\', pos + 1) < next || (next + 1 < sql.size() && sql[next + 1] == c)) {
+                // the end of the escaped literal is not simple to find, leave the sql as it is
+                return false;
+            }
+            next++;
+            if (in_where) {
+                literals.push_back({type::kVarchar, sql.substr(pos + 1, next - pos - 2)});
+                normalized.push_back('?');
+                pos = next;
+                continue;
+            }
+        } else if (IsDigit(c) || (c == '.' && next < sql.size() && IsDigit(sql[next]))) {
+            bool is_float = false;
+            next = ScanNumber(sql, pos, &is_float);
+            // a number followed by letters is an interval, e.g. 3d, or has a suffix, e.g. 1L
+            Literal literal;
+            if (in_where && (next == sql.size() || !IsWordChar(sql[next])) &&
+                ParseNumber(sql.substr(pos, next - pos), is_float, &literal)) {
+                literals.push_back(literal);
+                normalized.push_back('?');
+                pos = next;
+                continue;
+            }
+            while (next < sql.size() && IsWordChar(sql[next])) {
+                next++;
+            }
+        } else if (IsWordChar(c)) {
+            while (next < sql.size() && IsWordChar(sql[next])) {
+                next++;
+            }
+            std::string word = sql.substr(pos, next - pos);
+            for (auto& ch : word) {
+                ch = std::tolower(static_cast<unsigned char>(ch));
+            }
+            if (word == "select" && ++select_cnt > 1) {
+                // subquery or union
+                return false;
+            }
+            if (depth == 0 && word == "where") {
+                in_where = true;
+            } else if (depth == 0 && kWhereEnds.count(word) > 0) {
+                in_where = false;
+            }
+        }
+        normalized.append(sql, pos, next - pos);
+        pos = next;
+    }
+    if (literals.empty()) {
+        return false;
+    }
+    output->sql = normalized;
+    output->parameter_types.Clear();
+    for (const auto& literal : literals) {
+        output->parameter_types.Add()->set_type(literal.type);
+    }
+    output->parameter_row = EncodeLiterals(output->parameter_types, literals);
+    return true;
+}
+
+}  // namespace vm
+}  // namespace hybridse
@@ -0,0 +1,46 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HYBRIDSE_SRC_VM_SQL_NORMALIZER_H_
+#define HYBRIDSE_SRC_VM_SQL_NORMALIZER_H_
+
+#include <string>
+#include "codec/fe_row_codec.h"
+
+namespace hybridse {
+namespace vm {
+
+/// \brief The sql with the literals lifted into parameters.
+struct NormalizedSql {
+    std::string sql;                ///< The sql with `?` in place of the lifted literals
+    codec::Schema parameter_types;  ///< The types of the lifted literals
+    codec::Row parameter_row;       ///< The values of the lifted literals
+};
+
+/// \brief Lift the literals of the WHERE clause of a single SELECT into
+/// parameters, so that the queries which differ only in the literals share one
+/// compiling result.
+///
+/// Only the string literals without escapes, the integers and the floating
+/// point numbers are lifted. The sql is not normalized if it has a subquery,
+/// has parameters already, or has no literal to lift.
+///
+/// \return `true` if any literal is lifted
+bool NormalizeSql(const std::string& sql, NormalizedSql* output);
+
+}  // namespace vm
+}  // namespace hybridse
+#endif  // HYBRIDSE_SRC_VM_SQL_NORMALIZER_H_
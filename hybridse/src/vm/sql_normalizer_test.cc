@@ -0,0 +1,91 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vm/sql_normalizer.h"
+#include "gtest/gtest.h"
+
+namespace hybridse {
+namespace vm {
+
+class SqlNormalizerTest : public ::testing::Test {
+ public:
+    SqlNormalizerTest() {}
+    ~SqlNormalizerTest() {}
+};
+
+TEST_F(SqlNormalizerTest, LiftWhereLiterals) {
+    NormalizedSql normalized;
+    ASSERT_TRUE(NormalizeSql(
+        "select col1, col2 + 1 from t1 where col1 = 'abc' and col2 > 10 and col3 < 1.5e2 "
+        "and col5 > 3000000000 limit 10;",
+        &normalized));
+    ASSERT_EQ("select col1, col2 + 1 from t1 where col1 = ? and col2 > ? and col3 < ? and col5 > ? limit 10;",
+              normalized.sql);
+    ASSERT_EQ(4, normalized.parameter_types.size());
+    ASSERT_EQ(type::kVarchar, normalized.parameter_types.Get(0).type());
+    ASSERT_EQ(type::kInt32, normalized.parameter_types.Get(1).type());
+    ASSERT_EQ(type::kDouble, normalized.parameter_types.Get(2).type());
+    ASSERT_EQ(type::kInt64, normalized.parameter_types.Get(3).type());
+
+    codec::RowView row_view(normalized.parameter_types);
+    ASSERT_TRUE(row_view.Reset(normalized.parameter_row.buf(), normalized.parameter_row.size()));
+    ASSERT_EQ("abc", row_view.GetStringUnsafe(0));
+    ASSERT_EQ(10, row_view.GetInt32Unsafe(1));
+    ASSERT_DOUBLE_EQ(150.0, row_view.GetDoubleUnsafe(2));
+    ASSERT_EQ(3000000000L, row_view.GetInt64Unsafe(3));
+}
+
+TEST_F(SqlNormalizerTest, SameStructure) {
+    NormalizedSql normalized1;
+    NormalizedSql normalized2;
+    ASSERT_TRUE(NormalizeSql("select * from t1 where col1 in ('a', 'b') and col2 = 1;", &normalized1));
+    ASSERT_TRUE(NormalizeSql("select * from t1 where col1 in ('c', 'd') and col2 = 2;", &normalized2));
+    ASSERT_EQ("select * from t1 where col1 in (?, ?) and col2 = ?;", normalized1.sql);
+    ASSERT_EQ(normalized1.sql, normalized2.sql);
+}
+
+TEST_F(SqlNormalizerTest, KeepUnliftable) {
+    NormalizedSql normalized;
+    // no literal in WHERE
+    ASSERT_FALSE(NormalizeSql("select col1 + 1 from t1 limit 10;", &normalized));
+    ASSERT_FALSE(NormalizeSql("select col1 from t1 where col2 = col3;", &normalized));
+    // parameterized already
+    ASSERT_FALSE(NormalizeSql("select col1 from t1 where col1 = ? and col2 = 1;", &normalized));
+    // subquery
+    ASSERT_FALSE(NormalizeSql("select col1 from (select col1 from t1 where col2 = 1) where col1 = 2;", &normalized));
+    // escaped string
+    ASSERT_FALSE(NormalizeSql("select col1 from t1 where col1 = 'a\\'b';", &normalized));
+    ASSERT_FALSE(NormalizeSql("select col1 from t1 where col1 = 'a''b';", &normalized));
+
+    // identifiers, intervals, comments and the literals out of WHERE are kept
+    ASSERT_TRUE(NormalizeSql(
+        "select col1, 'x' from `t 1` -- where 1\nwhere col2 = 1 /* 2 */ and col3 > 3d "
+        "window w as (partition by col1 order by col5 rows between 10 preceding and current row);",
+        &normalized));
+    ASSERT_EQ(
+        "select col1, 'x' from `t 1` -- where 1\nwhere col2 = ? /* 2 */ and col3 > 3d "
+        "window w as (partition by col1 order by col5 rows between 10 preceding and current row);",
+        normalized.sql);
+    ASSERT_EQ(1, normalized.parameter_types.size());
+}
+
+}  // namespace vm
+}  // namespace hybridse
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
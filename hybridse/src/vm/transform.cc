@@ -15,6 +15,7 @@
  */
 
 #include "vm/transform.h"
+#include <map>
 #include <set>
 #include <stack>
 #include <unordered_map>
@@ -63,7 +64,8 @@ BatchModeTransformer::BatchModeTransformer(node::NodeManager* node_manager, cons
                                            const codec::Schema* parameter_types, ::llvm::Module* module,
                                            const udf::UdfLibrary* library, bool cluster_optimized_mode,
                                            bool enable_expr_opt, bool enable_window_parallelization,
-                                           bool enable_window_column_pruning)
+                                           bool enable_window_column_pruning,
+                                           bool enable_incremental_window_agg)
     : node_manager_(node_manager),
       db_(db),
       catalog_(catalog),
@@ -72,6 +74,7 @@ BatchModeTransformer::BatchModeTransformer(node::NodeManager* node_manager, cons
       cluster_optimized_mode_(cluster_optimized_mode),
       enable_batch_window_parallelization_(enable_window_parallelization),
       enable_batch_window_column_pruning_(enable_window_column_pruning),
+      enable_incremental_window_agg_(enable_incremental_window_agg),
       library_(library),
       plan_ctx_(node_manager, library, db, catalog, parameter_types, enable_expr_opt) {}
 
@@ -278,6 +281,15 @@ Status BatchModeTransformer::InitFnInfo(PhysicalOpNode* node,
                                   node->GetProducer(0)->schemas_ctx()));
             break;
         }
+        case kPhysicalOpRequestAggUnion: {
+            auto agg_union_op =
+                dynamic_cast<PhysicalRequestAggUnionNode*>(node);
+            CHECK_STATUS(GenRequestWindow(&agg_union_op->window_,
+                                          node->producers()[0]));
+            CHECK_STATUS(GenKey(&agg_union_op->aggr_key_,
+                                node->producers()[0]->schemas_ctx()));
+            break;
+        }
         default:
             break;
     }
@@ -925,7 +937,7 @@ Status ExtractProjectInfos(const node::PlanNodeList& projects,
 Status BatchModeTransformer::InstantiateLLVMFunction(const FnInfo& fn_info) {
     CHECK_TRUE(fn_info.IsValid(), kCodegenError, "Fail to install llvm function, function info is invalid");
     codegen::CodeGenContext codegen_ctx(module_, fn_info.schemas_ctx(), plan_ctx_.parameter_types(), node_manager_);
-    codegen::RowFnLetIRBuilder builder(&codegen_ctx);
+    codegen::RowFnLetIRBuilder builder(&codegen_ctx, enable_incremental_window_agg_);
     return builder.Build(fn_info.fn_name(), fn_info.fn_def(), fn_info.GetPrimaryFrame(), fn_info.GetFrames(),
                          *fn_info.fn_schema());
 }
@@ -1537,6 +1549,12 @@ Status BatchModeTransformer::ValidatePlanSupported(const PhysicalOpNode* in) {
             CHECK_STATUS(CheckPartitionColumn(union_op->window().partition().keys(), union_op->schemas_ctx()));
             break;
         }
+        case kPhysicalOpRequestAggUnion: {
+            const auto& union_op = dynamic_cast<const PhysicalRequestAggUnionNode*>(in);
+            CHECK_STATUS(CheckPartitionColumn(union_op->window().partition().keys(),
+                                              union_op->GetProducer(0)->schemas_ctx()));
+            break;
+        }
         default: {
             break;
         }
@@ -1614,6 +1632,12 @@ Status BatchModeTransformer::ValidateIndexOptimization(PhysicalOpNode* in) {
             }
             break;
         }
+        case kPhysicalOpRequestAggUnion: {
+            auto union_op = dynamic_cast<PhysicalRequestAggUnionNode*>(in);
+            CHECK_STATUS(ValidateWindowIndexOptimization(
+                union_op->window(), union_op->GetProducer(1)));
+            break;
+        }
         case kPhysicalOpRequestJoin: {
             PhysicalRequestJoinNode* join_op =
                 dynamic_cast<PhysicalRequestJoinNode*>(in);
@@ -2176,6 +2200,7 @@ Status RequestModeTransformer::ValidateRequestTable(
         case vm::kPhysicalOpUnion:
         case vm::kPhysicalOpPostRequestUnion:
         case vm::kPhysicalOpRequestUnion:
+        case vm::kPhysicalOpRequestAggUnion:
         case vm::kPhysicalOpRequestJoin: {
             vm::PhysicalOpNode* left_primary_source = nullptr;
             CHECK_STATUS(ValidateRequestTable(in->GetProducer(0), &left_primary_source))
@@ -2241,9 +2266,12 @@ Status RequestModeTransformer::TransformProjectOp(
                                              output);
         case kSchemaTypeTable:
             if (project_list->has_agg_project_) {
-                return CreatePhysicalProjectNode(kAggregation, new_depend,
-                                                 project_list, append_input,
-                                                 output);
+                PhysicalOpNode* agg_op = nullptr;
+                CHECK_STATUS(CreatePhysicalProjectNode(kAggregation, new_depend,
+                                                       project_list, append_input,
+                                                       &agg_op));
+                return TransformRequestAggUnionOp(project_list, new_depend,
+                                                  agg_op, output);
             } else {
                 return CreatePhysicalProjectNode(kTableProject, new_depend,
                                                  project_list, append_input,
@@ -2254,6 +2282,179 @@ Status RequestModeTransformer::TransformProjectOp(
     }
 }
 
+Status RequestModeTransformer::TransformRequestAggUnionOp(
+    const node::ProjectListNode* project_list, PhysicalOpNode* depend,
+    PhysicalOpNode* agg_op, PhysicalOpNode** output) {
+    *output = agg_op;
+    // common column optimization splits the request union path, keep the
+    // plan as it is
+    if (enable_batch_request_opt_ &&
+        !batch_request_info_.common_column_indices.empty()) {
+        return Status::OK();
+    }
+    if (agg_op->GetOpType() != kPhysicalOpProject ||
+        depend->GetOpType() != kPhysicalOpRequestUnion ||
+        agg_op->GetOutputSchemaSourceSize() != 1) {
+        return Status::OK();
+    }
+    auto request_union_op = dynamic_cast<PhysicalRequestUnionNode*>(depend);
+    const node::WindowPlanNode* w_ptr = project_list->GetW();
+    if (w_ptr == nullptr || !w_ptr->union_tables().empty() ||
+        request_union_op->instance_not_in_window() ||
+        request_union_op->exclude_current_time() ||
+        !request_union_op->output_request_row() ||
+        nullptr != project_list->GetHavingCondition()) {
+        return Status::OK();
+    }
+    const node::FrameNode* frame = w_ptr->frame_node();
+    if (frame == nullptr || frame->frame_type() != node::kFrameRowsRange ||
+        frame->frame_maxsize() > 0 || frame->GetHistoryRangeEnd() != 0) {
+        return Status::OK();
+    }
+    auto request = request_union_op->GetProducer(0);
+    auto right = request_union_op->GetProducer(1);
+    if (request->GetOpType() != kPhysicalOpDataProvider ||
+        dynamic_cast<PhysicalDataProviderNode*>(request)->provider_type_ != kProviderTypeRequest ||
+        right->GetOpType() != kPhysicalOpDataProvider ||
+        dynamic_cast<PhysicalDataProviderNode*>(right)->provider_type_ != kProviderTypeTable) {
+        return Status::OK();
+    }
+    auto table = dynamic_cast<PhysicalDataProviderNode*>(right)->table_handler_;
+    const codec::Schema* schema = table->GetSchema();
+
+    // partition and order columns, in the format of PRE_AGG_META_INFO
+    const node::ExprListNode* keys = w_ptr->GetKeys();
+    const node::OrderByNode* orders = w_ptr->GetOrders();
+    if (node::ExprListNullOrEmpty(keys) || nullptr == orders ||
+        node::ExprListNullOrEmpty(orders->order_expressions()) ||
+        orders->order_expressions()->GetChildNum() != 1) {
+        return Status::OK();
+    }
+    std::string partition_cols;
+    std::map<std::string, node::ExprNode*> key_columns;
+    for (uint32_t i = 0; i < keys->GetChildNum(); i++) {
+        auto key = keys->GetChild(i);
+        if (key->GetExprType() != node::kExprColumnRef) {
+            return Status::OK();
+        }
+        partition_cols += key->GetExprString() + ",";
+        key_columns[dynamic_cast<node::ColumnRefNode*>(key)->GetColumnName()] = key;
+    }
+    partition_cols.pop_back();
+    auto order_expr = orders->GetOrderExpressionExpr(0);
+    if (nullptr == order_expr || order_expr->GetExprType() != node::kExprColumnRef) {
+        return Status::OK();
+    }
+    std::string order_col = order_expr->GetExprString();
+    const std::string& ts_name = dynamic_cast<const node::ColumnRefNode*>(order_expr)->GetColumnName();
+
+    // pre-aggr tables are keyed by the dimension of base table index, so the
+    // keys are reordered as the index columns
+    node::ExprListNode* aggr_keys = nullptr;
+    for (const auto& kv : table->GetIndex()) {
+        const IndexSt& index = kv.second;
+        if (index.keys.size() != key_columns.size() || index.ts_pos == INVALID_POS ||
+            schema->Get(index.ts_pos).name() != ts_name) {
+            continue;
+        }
+        auto index_keys = node_manager_->MakeExprList();
+        for (const auto& col : index.keys) {
+            auto iter = key_columns.find(col.name);
+            if (iter == key_columns.end()) {
+                break;
+            }
+            index_keys->AddChild(iter->second);
+        }
+        if (index_keys->GetChildNum() == key_columns.size()) {
+            aggr_keys = index_keys;
+            break;
+        }
+    }
+    if (nullptr == aggr_keys) {
+        return Status::OK();
+    }
+
+    int64_t bucket_size = 0;
+    std::vector<RequestAggSpec> aggr_specs;
+    for (auto project : project_list->GetProjects()) {
+        auto project_node = dynamic_cast<node::ProjectNode*>(project);
+        if (nullptr == project_node || !project_node->IsAgg() ||
+            (nullptr != project_node->frame() && !project_node->frame()->Equals(frame))) {
+            return Status::OK();
+        }
+        auto expr = project_node->GetExpression();
+        if (expr->GetExprType() != node::kExprCall) {
+            return Status::OK();
+        }
+        auto call = dynamic_cast<node::CallExprNode*>(expr);
+        RequestAggSpec spec;
+        std::string func_name = call->GetFnDef()->GetName();
+        if (call->GetChildNum() != 1 || !codec::GetAggrFuncType(func_name, &spec.func_type)) {
+            return Status::OK();
+        }
+        auto arg = call->GetChild(0);
+        spec.col_idx = -1;
+        if (arg->GetExprType() == node::kExprColumnRef) {
+            const std::string& col_name = dynamic_cast<node::ColumnRefNode*>(arg)->GetColumnName();
+            for (int i = 0; i < schema->size(); i++) {
+                if (schema->Get(i).name() == col_name) {
+                    spec.col_idx = i;
+                    break;
+                }
+            }
+            if (spec.col_idx < 0) {
+                return Status::OK();
+            }
+        } else if (arg->GetExprType() != node::kExprAll || spec.func_type != codec::kAggrCount) {
+            return Status::OK();
+        }
+        auto aggr_infos = catalog_->GetAggrTables(table->GetDatabase(), table->GetName(), func_name,
+                                                  arg->GetExprString(), partition_cols, order_col);
+        for (const auto& info : aggr_infos) {
+            bool is_row_bucket = false;
+            int64_t size = 0;
+            if (!codec::ParseAggrBucketSize(info.bucket_size, &is_row_bucket, &size) || is_row_bucket ||
+                (bucket_size > 0 && size != bucket_size)) {
+                continue;
+            }
+            spec.aggr_table = catalog_->GetTable(info.aggr_db, info.aggr_table);
+            if (spec.aggr_table) {
+                bucket_size = size;
+                break;
+            }
+        }
+        if (!spec.aggr_table) {
+            return Status::OK();
+        }
+        aggr_specs.push_back(spec);
+    }
+    // buckets only pay off when the window covers more than one of them
+    if (aggr_specs.empty() || frame->GetHistoryRangeStart() >= -bucket_size) {
+        return Status::OK();
+    }
+    const SchemaSource* output_source = agg_op->GetOutputSchemaSource(0);
+    for (size_t i = 0; i < output_source->size(); i++) {
+        switch (output_source->GetColumnType(i)) {
+            case type::kInt16:
+            case type::kInt32:
+            case type::kInt64:
+            case type::kFloat:
+            case type::kDouble:
+            case type::kTimestamp:
+                break;
+            default:
+                return Status::OK();
+        }
+    }
+
+    PhysicalRequestAggUnionNode* agg_union_op = nullptr;
+    CHECK_STATUS(CreateOp<PhysicalRequestAggUnionNode>(
+        &agg_union_op, request, right, request_union_op->window(), aggr_keys,
+        bucket_size, aggr_specs, output_source));
+    *output = agg_union_op;
+    return Status::OK();
+}
+
 void RequestModeTransformer::ApplyPasses(PhysicalOpNode* node,
                                          PhysicalOpNode** output) {
     PhysicalOpNode* optimized = nullptr;
@@ -104,7 +104,8 @@ class BatchModeTransformer {
                          ::llvm::Module* module, const udf::UdfLibrary* library,
                          bool cluster_optimized_mode = false, bool enable_expr_opt = false,
                          bool enable_window_parallelization = true,
-                         bool enable_window_column_pruning = false);
+                         bool enable_window_column_pruning = false,
+                         bool enable_incremental_window_agg = false);
     virtual ~BatchModeTransformer();
     bool AddDefaultPasses();
 
@@ -252,6 +253,8 @@ class BatchModeTransformer {
     bool cluster_optimized_mode_;
     bool enable_batch_window_parallelization_;
     bool enable_batch_window_column_pruning_;
+    // keep sliding window aggregation states between rows
+    bool enable_incremental_window_agg_;
     std::vector<PhysicalPlanPassType> passes;
     LogicalOpMap op_map_;
     const udf::UdfLibrary* library_;
@@ -292,6 +295,12 @@ class RequestModeTransformer : public BatchModeTransformer {
     Status TransformLoadDataOp(const node::LoadDataPlanNode* node, PhysicalOpNode** output) override;
 
  private:
+    // replace request union and the window aggregation over it with request
+    // agg union if all the aggregations can be read from pre-aggr tables,
+    // output is agg_op itself otherwise
+    Status TransformRequestAggUnionOp(const node::ProjectListNode* project_list, PhysicalOpNode* depend,
+                                      PhysicalOpNode* agg_op, PhysicalOpNode** output);
+
     bool enable_batch_request_opt_;
     bool performance_sensitive_;
     vm::Schema request_schema_;
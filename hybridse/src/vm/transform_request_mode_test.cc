@@ -466,6 +466,102 @@ TEST_P(TransformRequestModePassOptimizedTest, PassPassOptimizedTest) {
     PhysicalPlanCheck(catalog, in_out.first, in_out.second);
 }
 
+// catalog with pre-aggr tables registered as PRE_AGG_META_INFO does
+class PreAggrCatalog : public SimpleCatalog {
+ public:
+    PreAggrCatalog() : SimpleCatalog(true) {}
+    std::vector<AggrTableInfo> GetAggrTables(const std::string& base_db, const std::string& base_table,
+                                             const std::string& aggr_func, const std::string& aggr_col,
+                                             const std::string& partition_cols,
+                                             const std::string& order_col) override {
+        std::vector<AggrTableInfo> infos;
+        for (const auto& info : aggr_infos_) {
+            if (info.base_db == base_db && info.base_table == base_table && info.aggr_func == aggr_func &&
+                info.aggr_col == aggr_col && info.partition_cols == partition_cols &&
+                info.order_by_col == order_col) {
+                infos.push_back(info);
+            }
+        }
+        return infos;
+    }
+    std::vector<AggrTableInfo> aggr_infos_;
+};
+
+TEST(TransformRequestAggUnionTest, RequestAggUnionOptimized) {
+    hybridse::type::TableDef table_def;
+    BuildTableDef(table_def);
+    table_def.set_name("t1");
+    ::hybridse::type::IndexDef* index = table_def.add_indexes();
+    index->set_name("index1");
+    index->add_first_keys("col1");
+    index->set_second_key("col5");
+    hybridse::type::Database db;
+    db.set_name("db");
+    AddTable(db, table_def);
+
+    hybridse::type::TableDef aggr_def;
+    aggr_def.set_name("pre_t1_w1_sum_col3");
+    aggr_def.set_catalog("pre_agg_db");
+    std::vector<std::pair<std::string, hybridse::type::Type>> aggr_cols = {
+        {"key", hybridse::type::kVarchar},      {"ts_start", hybridse::type::kTimestamp},
+        {"ts_end", hybridse::type::kTimestamp}, {"num_rows", hybridse::type::kInt32},
+        {"agg_val", hybridse::type::kVarchar},  {"binlog_offset", hybridse::type::kInt64}};
+    for (const auto& col : aggr_cols) {
+        ::hybridse::type::ColumnDef* column = aggr_def.add_columns();
+        column->set_name(col.first);
+        column->set_type(col.second);
+    }
+    index = aggr_def.add_indexes();
+    index->set_name("key_index");
+    index->add_first_keys("key");
+    index->set_second_key("ts_start");
+    hybridse::type::Database aggr_db;
+    aggr_db.set_name("pre_agg_db");
+    AddTable(aggr_db, aggr_def);
+
+    auto catalog = std::make_shared<PreAggrCatalog>();
+    catalog->AddDatabase(db);
+    catalog->AddDatabase(aggr_db);
+    AggrTableInfo info;
+    info.aggr_table = "pre_t1_w1_sum_col3";
+    info.aggr_db = "pre_agg_db";
+    info.base_db = "db";
+    info.base_table = "t1";
+    info.aggr_func = "sum";
+    info.aggr_col = "col3";
+    info.partition_cols = "col1";
+    info.order_by_col = "col5";
+    info.bucket_size = "1s";
+    catalog->aggr_infos_.push_back(info);
+
+    PhysicalPlanCheck(catalog,
+                      "SELECT sum(col3) OVER w1 as w1_col3_sum FROM t1 "
+                      "WINDOW w1 AS (PARTITION BY col1 ORDER BY col5 ROWS_RANGE "
+                      "BETWEEN 3000 PRECEDING AND CURRENT ROW);",
+                      "REQUEST_AGG_UNION(partition_keys=(), orders=(ASC), range=(col5, -3000, 0), "
+                      "index_keys=(col1), aggr_keys=(col1), bucket_size=1000, aggr_tables=(pre_t1_w1_sum_col3))\n"
+                      "  DATA_PROVIDER(request=t1)\n"
+                      "  DATA_PROVIDER(type=Partition, table=t1, index=index1)");
+    // window isn't longer than one bucket
+    PhysicalPlanCheck(catalog,
+                      "SELECT sum(col3) OVER w1 as w1_col3_sum FROM t1 "
+                      "WINDOW w1 AS (PARTITION BY col1 ORDER BY col5 ROWS_RANGE "
+                      "BETWEEN 1000 PRECEDING AND CURRENT ROW);",
+                      "PROJECT(type=Aggregation)\n"
+                      "  REQUEST_UNION(partition_keys=(), orders=(ASC), range=(col5, -1000, 0), index_keys=(col1))\n"
+                      "    DATA_PROVIDER(request=t1)\n"
+                      "    DATA_PROVIDER(type=Partition, table=t1, index=index1)");
+    // no pre-aggr table of sum(col2)
+    PhysicalPlanCheck(catalog,
+                      "SELECT sum(col3) OVER w1 as w1_col3_sum, sum(col2) OVER w1 as w1_col2_sum FROM t1 "
+                      "WINDOW w1 AS (PARTITION BY col1 ORDER BY col5 ROWS_RANGE "
+                      "BETWEEN 3000 PRECEDING AND CURRENT ROW);",
+                      "PROJECT(type=Aggregation)\n"
+                      "  REQUEST_UNION(partition_keys=(), orders=(ASC), range=(col5, -3000, 0), index_keys=(col1))\n"
+                      "    DATA_PROVIDER(request=t1)\n"
+                      "    DATA_PROVIDER(type=Partition, table=t1, index=index1)");
+}
+
 }  // namespace vm
 }  // namespace hybridse
 int main(int argc, char** argv) {
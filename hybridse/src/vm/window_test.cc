@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <utility>
 #include "codec/list_iterator_codec.h"
 #include "gtest/gtest.h"
@@ -1016,6 +1017,103 @@ TEST_F(WindowIteratorTest,
         ASSERT_EQ(10L, window.GetCount());
     }
 }
+TEST_F(WindowIteratorTest, MinMaxWindowDequeTest) {
+    std::vector<int64_t> values({5, 3, 8, 1, 9, 4, 4, 2});
+    MinMaxWindowDeque min_deque(true);
+    MinMaxWindowDeque max_deque(false);
+    // slide a window of 3 rows over values
+    for (size_t i = 0; i < values.size(); ++i) {
+        min_deque.PushBack(values[i], false);
+        max_deque.PushBack(values[i], false);
+        if (i >= 3) {
+            min_deque.EvictOldest();
+            max_deque.EvictOldest();
+        }
+        auto begin = values.begin() + (i >= 3 ? i - 2 : 0);
+        auto end = values.begin() + i + 1;
+        ASSERT_EQ(*std::min_element(begin, end), min_deque.Front(0));
+        ASSERT_EQ(*std::max_element(begin, end), max_deque.Front(0));
+    }
+
+    // null rows take a position but are never the result
+    min_deque.Clear();
+    min_deque.PushBack(2, false);
+    min_deque.PushBack(0, true);
+    ASSERT_EQ(2, min_deque.Front(-1));
+    min_deque.EvictOldest();
+    ASSERT_EQ(-1, min_deque.Front(-1));
+
+    // rebuild from the newest row to the oldest one: 7, 1, 4
+    min_deque.Clear();
+    min_deque.PushFront(4, false);
+    min_deque.PushFront(1, false);
+    min_deque.PushFront(7, false);
+    ASSERT_EQ(1, min_deque.Front(0));
+    min_deque.EvictOldest();
+    ASSERT_EQ(1, min_deque.Front(0));
+    min_deque.EvictOldest();
+    ASSERT_EQ(4, min_deque.Front(0));
+    min_deque.PushBack(6, false);
+    ASSERT_EQ(4, min_deque.Front(0));
+    min_deque.EvictOldest();
+    ASSERT_EQ(6, min_deque.Front(0));
+}
+
+TEST_F(WindowIteratorTest, WindowAggStateSyncTest) {
+    int8_t* ptr = reinterpret_cast<int8_t*>(malloc(28));
+    *(reinterpret_cast<int32_t*>(ptr + 2)) = 1;
+    *(reinterpret_cast<int64_t*>(ptr + 2 + 4)) = 1;
+    Row row(base::RefCountedSlice::Create(ptr, 28));
+    vm::CurrentHistoryWindow window(vm::Window::kFrameRowsRange, -100000, 3);
+    window.BufferData(1000, row);
+    window.BufferData(2000, row);
+
+    // new state is built by rescan
+    WindowAggState* state = window.SyncAggState(1, 8, false);
+    ASSERT_EQ(WindowAggState::kRescan, state->mode());
+    ASSERT_EQ(state, window.SyncAggState(1, 8, false));
+    ASSERT_EQ(WindowAggState::kUpToDate, state->mode());
+
+    // 1000 is evicted by max size
+    window.BufferData(3000, row);
+    window.BufferData(4000, row);
+    ASSERT_EQ(2u, window.appended_rows().size());
+    ASSERT_EQ(3000u, window.appended_rows().front().first);
+    ASSERT_EQ(1u, window.retracted_rows().size());
+    ASSERT_EQ(1000u, window.retracted_rows().front().first);
+    ASSERT_EQ(WindowAggState::kApplyDelta,
+              window.SyncAggState(1, 8, false)->mode());
+    ASSERT_EQ(WindowAggState::kRescan,
+              window.SyncAggState(2, 8, false)->mode());
+
+    // every state synced at last epoch applies the same delta
+    window.BufferData(5000, row);
+    ASSERT_EQ(WindowAggState::kApplyDelta,
+              window.SyncAggState(1, 8, false)->mode());
+    ASSERT_EQ(WindowAggState::kApplyDelta,
+              window.SyncAggState(2, 8, false)->mode());
+    ASSERT_EQ(1u, window.appended_rows().size());
+    ASSERT_EQ(1u, window.retracted_rows().size());
+
+    // state missing an epoch rescans
+    window.BufferData(6000, row);
+    ASSERT_EQ(WindowAggState::kApplyDelta,
+              window.SyncAggState(2, 8, false)->mode());
+    window.BufferData(7000, row);
+    ASSERT_EQ(WindowAggState::kRescan,
+              window.SyncAggState(1, 8, false)->mode());
+    ASSERT_EQ(WindowAggState::kApplyDelta,
+              window.SyncAggState(2, 8, false)->mode());
+
+    // evicting the newest row can't be applied to min/max deques
+    window.PopFrontData();
+    ASSERT_EQ(2u, window.GetCount());
+    ASSERT_EQ(WindowAggState::kApplyDelta,
+              window.SyncAggState(1, 8, false)->mode());
+    ASSERT_EQ(WindowAggState::kRescan,
+              window.SyncAggState(2, 8, true)->mode());
+}
+
 class RequestUnionWindowTest : public ::testing::Test {
  public:
     RequestUnionWindowTest() {}
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "vm/worker_pool.h"
+
+#include <algorithm>
+#include <atomic>
+
+#include "vm/jit_runtime.h"
+
+namespace hybridse {
+namespace vm {
+
+static std::atomic<WorkerPool*> worker_pool_instance(nullptr);
+
+WorkerPool* WorkerPool::GetInstance() {
+    WorkerPool* pool = worker_pool_instance.load(std::memory_order_acquire);
+    if (pool != nullptr) {
+        return pool;
+    }
+    static ThreadWorkerPool thread_pool(
+        std::max(std::thread::hardware_concurrency(), 2u));
+    return &thread_pool;
+}
+
+void WorkerPool::SetInstance(WorkerPool* pool) {
+    worker_pool_instance.store(pool, std::memory_order_release);
+}
+
+ThreadWorkerPool::ThreadWorkerPool(size_t thread_num) : stop_(false) {
+    for (size_t i = 0; i < thread_num; i++) {
+        threads_.emplace_back(&ThreadWorkerPool::ThreadProc, this);
+    }
+}
+
+ThreadWorkerPool::~ThreadWorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void ThreadWorkerPool::Run(size_t worker_num,
+                           const std::function<void()>& worker) {
+    if (worker_num <= 1 || threads_.empty()) {
+        worker();
+        return;
+    }
+    auto job = std::make_shared<Job>();
+    job->worker = &worker;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        for (size_t i = 1; i < worker_num; i++) {
+            jobs_.push_back(job);
+        }
+    }
+    cv_.notify_all();
+    worker();
+    std::unique_lock<std::mutex> lock(job->mu);
+    job->finished = true;
+    job->cv.wait(lock, [&job] { return job->running == 0; });
+}
+
+void ThreadWorkerPool::ThreadProc() {
+    while (true) {
+        std::shared_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(mu_);
+            cv_.wait(lock, [this] { return stop_ || !jobs_.empty(); });
+            if (jobs_.empty()) {
+                return;
+            }
+            job = jobs_.front();
+            jobs_.pop_front();
+        }
+        {
+            std::lock_guard<std::mutex> lock(job->mu);
+            if (job->finished) {
+                continue;
+            }
+            job->running++;
+        }
+        (*job->worker)();
+        // the runtime of a run step lives in the thread, clear what is left
+        // behind as the thread does not exit after the run
+        JitRuntime::get()->ReleaseRunStep();
+        std::lock_guard<std::mutex> lock(job->mu);
+        job->running--;
+        job->cv.notify_all();
+    }
+}
+
+}  // namespace vm
+}  // namespace hybridse
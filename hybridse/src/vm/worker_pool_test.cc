@@ -0,0 +1,84 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vm/worker_pool.h"
+
+#include <atomic>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace hybridse {
+namespace vm {
+
+class WorkerPoolTest : public ::testing::Test {
+ public:
+    WorkerPoolTest() {}
+    ~WorkerPoolTest() {}
+};
+
+TEST_F(WorkerPoolTest, RunAllItems) {
+    ThreadWorkerPool pool(4);
+    std::vector<std::atomic<int>> hits(1000);
+    std::atomic<size_t> next(0);
+    std::function<void()> worker = [&]() {
+        for (size_t idx = next.fetch_add(1); idx < hits.size();
+             idx = next.fetch_add(1)) {
+            hits[idx].fetch_add(1);
+        }
+    };
+    pool.Run(8, worker);
+    for (auto& hit : hits) {
+        ASSERT_EQ(1, hit.load());
+    }
+}
+
+TEST_F(WorkerPoolTest, NestedRun) {
+    // every thread of the pool is taken by an outer worker, the inner runs
+    // are done by their callers
+    ThreadWorkerPool pool(2);
+    std::atomic<int> inner_cnt(0);
+    std::atomic<size_t> next(0);
+    std::function<void()> outer = [&]() {
+        while (next.fetch_add(1) < 16) {
+            std::atomic<size_t> inner_next(0);
+            std::function<void()> inner = [&]() {
+                while (inner_next.fetch_add(1) < 10) {
+                    inner_cnt.fetch_add(1);
+                }
+            };
+            pool.Run(4, inner);
+        }
+    };
+    pool.Run(3, outer);
+    ASSERT_EQ(160, inner_cnt.load());
+}
+
+TEST_F(WorkerPoolTest, SingleWorker) {
+    ThreadWorkerPool pool(0);
+    int cnt = 0;
+    std::function<void()> worker = [&]() { cnt++; };
+    pool.Run(4, worker);
+    ASSERT_EQ(1, cnt);
+}
+
+}  // namespace vm
+}  // namespace hybridse
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "base/epoch.h"
+
+#include <algorithm>
+#include <functional>
+#include <thread>  // NOLINT
+
+namespace openmldb {
+namespace base {
+
+// the slot of the first chunk the thread tries first. it is free mostly as a
+// reader exits before it enters again, and the threads start from different
+// slots so that they seldom race for one
+static thread_local uint32_t hint_idx = UINT32_MAX;
+
+EpochManager* EpochManager::GetInstance() {
+    static EpochManager instance;
+    return &instance;
+}
+
+EpochManager::EpochManager() : epoch_(1), head_() {}
+
+EpochManager::~EpochManager() {
+    Chunk* chunk = head_.next.load(std::memory_order_acquire);
+    while (chunk != nullptr) {
+        Chunk* next = chunk->next.load(std::memory_order_relaxed);
+        delete chunk;
+        chunk = next;
+    }
+}
+
+bool EpochManager::TryClaim(EpochSlot* slot, uint64_t epoch) {
+    uint64_t expected = 0;
+    if (slot->epoch.load(std::memory_order_relaxed) != 0) {
+        return false;
+    }
+    return slot->epoch.compare_exchange_strong(expected, epoch, std::memory_order_relaxed);
+}
+
+EpochSlot* EpochManager::Enter() {
+    uint64_t epoch = epoch_.load(std::memory_order_acquire);
+    if (hint_idx == UINT32_MAX) {
+        hint_idx = std::hash<std::thread::id>{}(std::this_thread::get_id()) % kChunkSize;
+    }
+    EpochSlot* slot = &head_.slots[hint_idx];
+    if (!TryClaim(slot, epoch)) {
+        slot = nullptr;
+        Chunk* chunk = &head_;
+        while (slot == nullptr) {
+            for (uint32_t i = 0; i < kChunkSize; i++) {
+                if (TryClaim(&chunk->slots[i], epoch)) {
+                    slot = &chunk->slots[i];
+                    if (chunk == &head_) {
+                        hint_idx = i;
+                    }
+                    break;
+                }
+            }
+            if (slot != nullptr) {
+                break;
+            }
+            Chunk* next = chunk->next.load(std::memory_order_acquire);
+            if (next == nullptr) {
+                // all of the slots are taken, append a chunk. the chunks are
+                // never removed, so the readers scan them without lock
+                Chunk* new_chunk = new Chunk();
+                if (chunk->next.compare_exchange_strong(next, new_chunk, std::memory_order_acq_rel)) {
+                    next = new_chunk;
+                } else {
+                    delete new_chunk;
+                }
+            }
+            chunk = next;
+        }
+    }
+    // the slot must be visible before any read of the protected memory, which
+    // pairs with the fence in GetReclaimableEpoch. the epoch may be advanced
+    // before the claim, then the slot keeps more memory than needed but never less
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return slot;
+}
+
+void EpochManager::Exit(EpochSlot* slot) {
+    if (slot == nullptr) {
+        return;
+    }
+    slot->epoch.store(0, std::memory_order_release);
+}
+
+uint64_t EpochManager::GetRetireEpoch() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return epoch_.load(std::memory_order_acquire);
+}
+
+uint64_t EpochManager::GetReclaimableEpoch() {
+    uint64_t min_epoch = epoch_.fetch_add(1, std::memory_order_acq_rel) + 1;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const Chunk* chunk = &head_;
+    while (chunk != nullptr) {
+        for (uint32_t i = 0; i < kChunkSize; i++) {
+            uint64_t epoch = chunk->slots[i].epoch.load(std::memory_order_acquire);
+            if (epoch != 0) {
+                min_epoch = std::min(min_epoch, epoch);
+            }
+        }
+        chunk = chunk->next.load(std::memory_order_acquire);
+    }
+    return min_epoch - 1;
+}
+
+}  // namespace base
+}  // namespace openmldb
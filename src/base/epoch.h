@@ -0,0 +1,91 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_BASE_EPOCH_H_
+#define SRC_BASE_EPOCH_H_
+
+#include <atomic>
+#include <cstdint>
+
+namespace openmldb {
+namespace base {
+
+// the reader slot takes a whole cache line, so a reader writes no line shared
+// with the others
+struct alignas(64) EpochSlot {
+    // the epoch the reader entered with, 0 means the slot is free
+    std::atomic<uint64_t> epoch{0};
+};
+
+// EpochManager reclaims the memory unlinked from lock free structures with
+// epochs. A reader publishes the global epoch in a slot of its own when it
+// enters and clears it when it exits. A writer tags the memory it unlinks with
+// GetRetireEpoch, and frees it once the tag is not greater than the epoch
+// returned by GetReclaimableEpoch, when all of the readers which might reach
+// it have exited.
+//
+// The slot is not bound to the thread, so a reader may exit on another thread,
+// e.g. a bthread resumed by another worker.
+class EpochManager {
+ public:
+    static EpochManager* GetInstance();
+
+    EpochManager();
+    ~EpochManager();
+    EpochManager(const EpochManager&) = delete;
+    EpochManager& operator=(const EpochManager&) = delete;
+
+    EpochSlot* Enter();
+    void Exit(EpochSlot* slot);
+
+    // call after the memory is unlinked
+    uint64_t GetRetireEpoch();
+
+    // advance the global epoch, the memory retired with an epoch not greater
+    // than the result can be freed
+    uint64_t GetReclaimableEpoch();
+
+ private:
+    static constexpr uint32_t kChunkSize = 256;
+
+    struct Chunk {
+        EpochSlot slots[kChunkSize];
+        std::atomic<Chunk*> next{nullptr};
+    };
+
+    bool TryClaim(EpochSlot* slot, uint64_t epoch);
+
+    std::atomic<uint64_t> epoch_;
+    Chunk head_;
+};
+
+// EpochGuard keeps the memory reachable on entering from being freed until it
+// is destroyed
+class EpochGuard {
+ public:
+    EpochGuard() : slot_(EpochManager::GetInstance()->Enter()) {}
+    ~EpochGuard() { EpochManager::GetInstance()->Exit(slot_); }
+    EpochGuard(const EpochGuard&) = delete;
+    EpochGuard& operator=(const EpochGuard&) = delete;
+
+ private:
+    EpochSlot* slot_;
+};
+
+}  // namespace base
+}  // namespace openmldb
+
+#endif  // SRC_BASE_EPOCH_H_
@@ -0,0 +1,114 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "base/epoch.h"
+
+#include <atomic>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace openmldb {
+namespace base {
+
+class EpochTest : public ::testing::Test {
+ public:
+    EpochTest() {}
+    ~EpochTest() {}
+};
+
+TEST_F(EpochTest, Reclaim) {
+    EpochManager manager;
+    uint64_t epoch = manager.GetRetireEpoch();
+    ASSERT_GE(manager.GetReclaimableEpoch(), epoch);
+
+    EpochSlot* slot = manager.Enter();
+    uint64_t retired = manager.GetRetireEpoch();
+    // the reader may reach the memory retired after it enters
+    ASSERT_LT(manager.GetReclaimableEpoch(), retired);
+    ASSERT_LT(manager.GetReclaimableEpoch(), retired);
+    EpochSlot* other = manager.Enter();
+    ASSERT_NE(slot, other);
+    manager.Exit(slot);
+    // the later reader enters after the memory is retired
+    ASSERT_GE(manager.GetReclaimableEpoch(), retired);
+    uint64_t new_retired = manager.GetRetireEpoch();
+    ASSERT_LT(manager.GetReclaimableEpoch(), new_retired);
+    manager.Exit(other);
+    ASSERT_GE(manager.GetReclaimableEpoch(), new_retired);
+}
+
+TEST_F(EpochTest, ManyReaders) {
+    EpochManager manager;
+    // more readers than the slots of one chunk
+    std::vector<EpochSlot*> slots;
+    for (int i = 0; i < 1000; i++) {
+        slots.push_back(manager.Enter());
+    }
+    uint64_t retired = manager.GetRetireEpoch();
+    for (auto* slot : slots) {
+        ASSERT_LT(manager.GetReclaimableEpoch(), retired);
+        manager.Exit(slot);
+    }
+    ASSERT_GE(manager.GetReclaimableEpoch(), retired);
+}
+
+TEST_F(EpochTest, Concurrent) {
+    EpochManager manager;
+    std::atomic<int*> value(new int(0));
+    std::atomic<bool> stop(false);
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 8; i++) {
+        readers.emplace_back([&] {
+            while (!stop.load(std::memory_order_relaxed)) {
+                EpochSlot* slot = manager.Enter();
+                // the value is never freed while it is read
+                int* cur = value.load(std::memory_order_acquire);
+                ASSERT_GE(*cur, 0);
+                manager.Exit(slot);
+            }
+        });
+    }
+    std::vector<std::pair<uint64_t, int*>> retired;
+    for (int i = 1; i <= 10000; i++) {
+        int* old = value.exchange(new int(i), std::memory_order_acq_rel);
+        retired.emplace_back(manager.GetRetireEpoch(), old);
+        uint64_t epoch = manager.GetReclaimableEpoch();
+        auto it = retired.begin();
+        while (it != retired.end() && it->first <= epoch) {
+            delete it->second;
+            ++it;
+        }
+        retired.erase(retired.begin(), it);
+    }
+    stop.store(true, std::memory_order_relaxed);
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    for (auto& kv : retired) {
+        delete kv.second;
+    }
+    delete value.load();
+}
+
+}  // namespace base
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
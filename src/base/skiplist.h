@@ -22,6 +22,7 @@
 
 #include <atomic>
 #include <iostream>
+#include <new>
 
 #include "base/random.h"
 
@@ -40,19 +41,29 @@ struct DefaultComparator {
 };
 
 // Skiplist node , a thread safe structure
+// The tower of next pointers is allocated inline right after the node, so a
+// node costs one allocation. Create nodes with Node::New and free them with
+// delete as usual
 template <class K, class V>
 class Node {
  public:
-    // Set data reference and Node height
-    Node(const K& key, V& value, uint8_t height)  // NOLINT
-        : height_(height), key_(key), value_(value) {
-        nexts_ = new std::atomic<Node<K, V>*>[height];
+    static Node<K, V>* New(const K& key, V& value, uint8_t height) {  // NOLINT
+        void* mem = Allocate(height);
+        return new (mem) Node<K, V>(key, value, height);
+    }
+
+    static Node<K, V>* New(uint8_t height) {
+        void* mem = Allocate(height);
+        return new (mem) Node<K, V>(height);
     }
 
-    Node(uint8_t height) : height_(height), key_(), value_() {  // NOLINT
-        nexts_ = new std::atomic<Node<K, V>*>[height];
+    static size_t ByteSize(uint8_t height) {
+        return sizeof(Node<K, V>) + (height > 1 ? height - 1 : 0) * sizeof(std::atomic<Node<K, V>*>);
     }
 
+    // the memory is allocated by Allocate, release it without size hint
+    static void operator delete(void* ptr) { ::operator delete(ptr); }
+
     // Set the next node with memory barrier
     void SetNext(uint8_t level, Node<K, V>* node) {
         assert(level < height_ && level >= 0);
@@ -81,13 +92,32 @@ class Node {
 
     const K& GetKey() const { return key_; }
 
-    ~Node() { delete[] nexts_; }
+    ~Node() {}
+
+ private:
+    // Set data reference and Node height
+    Node(const K& key, V& value, uint8_t height)  // NOLINT
+        : height_(height), key_(key), value_(value) {
+        InitNexts();
+    }
+
+    explicit Node(uint8_t height) : height_(height), key_(), value_() { InitNexts(); }
+
+    static void* Allocate(uint8_t height) { return ::operator new(ByteSize(height)); }
+
+    void InitNexts() {
+        nexts_[0].store(NULL, std::memory_order_relaxed);
+        for (uint8_t i = 1; i < height_; i++) {
+            new (&nexts_[i]) std::atomic<Node<K, V>*>(NULL);
+        }
+    }
 
  private:
     uint8_t const height_;
     K const key_;
     V value_;
-    std::atomic<Node<K, V>*>* nexts_;
+    // must be the last member, the real length is height_
+    std::atomic<Node<K, V>*> nexts_[1];
 };
 
 template <class K, class V, class Comparator>
@@ -101,7 +131,7 @@ class Skiplist {
           rand_(0xdeadbeef),
           head_(NULL),
           tail_(NULL) {
-        head_ = new Node<K, V>(MaxHeight);
+        head_ = Node<K, V>::New(MaxHeight);
         for (uint8_t i = 0; i < head_->Height(); i++) {
             head_->SetNext(i, NULL);
         }
@@ -364,7 +394,7 @@ class Skiplist {
 
  private:
     Node<K, V>* NewNode(const K& key, V& value, uint8_t height) {  // NOLINT
-        Node<K, V>* node = new Node<K, V>(key, value, height);
+        Node<K, V>* node = Node<K, V>::New(key, value, height);
         return node;
     }
 
@@ -0,0 +1,283 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "base/work_stealing_pool.h"
+
+#include <chrono>  // NOLINT
+
+namespace openmldb {
+namespace base {
+
+// a worker takes a background task after this count of foreground tasks in a
+// row, so the background tasks are not starved
+constexpr uint32_t kMaxForegroundInRow = 16;
+
+static thread_local WorkStealingPool* tls_pool = nullptr;
+static thread_local uint32_t tls_worker = 0;
+
+static inline int64_t NowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+WorkStealingPool::WorkStealingPool(uint32_t thread_num, const std::string& name)
+    : workers_(),
+      threads_(),
+      max_background_(thread_num > 1 ? thread_num - 1 : 1),
+      next_worker_(0),
+      running_background_(0),
+      idle_(0),
+      stop_(false),
+      drain_(false),
+      timer_stop_(false),
+      next_id_(1),
+      delayed_(),
+      delayed_due_(),
+      wait_latency_(name + "_wait"),
+      run_latency_(name + "_run"),
+      queue_depth_(name + "_queue_depth", &WorkStealingPool::GetQueueDepth, this) {
+    if (thread_num == 0) {
+        thread_num = 1;
+    }
+    pending_[0].store(0);
+    pending_[1].store(0);
+    for (uint32_t i = 0; i < thread_num; i++) {
+        workers_.emplace_back(new Worker());
+    }
+    for (uint32_t i = 0; i < thread_num; i++) {
+        threads_.emplace_back(&WorkStealingPool::WorkerProc, this, i);
+    }
+    timer_thread_ = std::thread(&WorkStealingPool::TimerProc, this);
+}
+
+WorkStealingPool::~WorkStealingPool() { Stop(false); }
+
+void WorkStealingPool::AddTask(const Task& task, TaskPriority priority) {
+    if (stop_.load(std::memory_order_relaxed) && !drain_) {
+        return;
+    }
+    Push(Item{task, NowUs()}, priority);
+}
+
+int64_t WorkStealingPool::DelayTask(int64_t delay_ms, const Task& task, TaskPriority priority) {
+    std::lock_guard<std::mutex> lock(timer_mu_);
+    if (timer_stop_) {
+        return -1;
+    }
+    int64_t id = next_id_++;
+    int64_t due = NowUs() + delay_ms * 1000;
+    delayed_.emplace(std::make_pair(due, id), DelayedItem{task, priority});
+    delayed_due_.emplace(id, due);
+    timer_cv_.notify_one();
+    return id;
+}
+
+bool WorkStealingPool::CancelTask(int64_t id) {
+    std::lock_guard<std::mutex> lock(timer_mu_);
+    auto it = delayed_due_.find(id);
+    if (it == delayed_due_.end()) {
+        return false;
+    }
+    delayed_.erase(std::make_pair(it->second, id));
+    delayed_due_.erase(it);
+    return true;
+}
+
+void WorkStealingPool::Stop(bool wait) {
+    {
+        std::lock_guard<std::mutex> lock(timer_mu_);
+        if (timer_stop_) {
+            return;
+        }
+        timer_stop_ = true;
+        delayed_.clear();
+        delayed_due_.clear();
+        timer_cv_.notify_all();
+    }
+    timer_thread_.join();
+    {
+        std::lock_guard<std::mutex> lock(idle_mu_);
+        drain_ = wait;
+        stop_.store(true);
+        idle_cv_.notify_all();
+    }
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+    threads_.clear();
+}
+
+int64_t WorkStealingPool::PendingNum() {
+    int64_t delayed_cnt = 0;
+    {
+        std::lock_guard<std::mutex> lock(timer_mu_);
+        delayed_cnt = delayed_.size();
+    }
+    return pending_[0].load(std::memory_order_relaxed) + pending_[1].load(std::memory_order_relaxed) + delayed_cnt;
+}
+
+int64_t WorkStealingPool::GetQueueDepth(void* arg) {
+    auto* pool = reinterpret_cast<WorkStealingPool*>(arg);
+    return pool->pending_[0].load(std::memory_order_relaxed) + pool->pending_[1].load(std::memory_order_relaxed);
+}
+
+void WorkStealingPool::Push(Item&& item, TaskPriority priority) {
+    uint32_t idx = 0;
+    if (tls_pool == this) {
+        idx = tls_worker;
+    } else {
+        idx = next_worker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+    }
+    auto& worker = *workers_[idx];
+    {
+        std::lock_guard<std::mutex> lock(worker.mu);
+        worker.queues[static_cast<int>(priority)].push_back(std::move(item));
+        pending_[static_cast<int>(priority)].fetch_add(1);
+    }
+    Wake();
+}
+
+void WorkStealingPool::Wake() {
+    if (idle_.load() > 0) {
+        std::lock_guard<std::mutex> lock(idle_mu_);
+        idle_cv_.notify_one();
+    }
+}
+
+bool WorkStealingPool::HasRunnable() const {
+    return pending_[0].load() > 0 ||
+           (pending_[1].load() > 0 && running_background_.load() < max_background_);
+}
+
+bool WorkStealingPool::PopFrom(uint32_t idx, TaskPriority priority, bool front, Item* item) {
+    auto& worker = *workers_[idx];
+    std::lock_guard<std::mutex> lock(worker.mu);
+    auto& queue = worker.queues[static_cast<int>(priority)];
+    if (queue.empty()) {
+        return false;
+    }
+    if (front) {
+        *item = std::move(queue.front());
+        queue.pop_front();
+    } else {
+        *item = std::move(queue.back());
+        queue.pop_back();
+    }
+    return true;
+}
+
+bool WorkStealingPool::Take(uint32_t idx, bool background_first, Item* item, TaskPriority* priority) {
+    TaskPriority order[2] = {TaskPriority::kForeground, TaskPriority::kBackground};
+    if (background_first) {
+        std::swap(order[0], order[1]);
+    }
+    uint32_t worker_num = workers_.size();
+    for (auto cur : order) {
+        if (pending_[static_cast<int>(cur)].load() <= 0) {
+            continue;
+        }
+        if (cur == TaskPriority::kBackground) {
+            // keep a worker for the foreground tasks
+            uint32_t running = running_background_.load();
+            do {
+                if (running >= max_background_) {
+                    break;
+                }
+            } while (!running_background_.compare_exchange_weak(running, running + 1));
+            if (running >= max_background_) {
+                continue;
+            }
+        }
+        // take the oldest task of its own and the newest one of others
+        bool found = PopFrom(idx, cur, true, item);
+        for (uint32_t i = 1; !found && i < worker_num; i++) {
+            found = PopFrom((idx + i) % worker_num, cur, false, item);
+        }
+        if (found) {
+            pending_[static_cast<int>(cur)].fetch_sub(1);
+            *priority = cur;
+            return true;
+        }
+        if (cur == TaskPriority::kBackground) {
+            running_background_.fetch_sub(1);
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::WorkerProc(uint32_t idx) {
+    tls_pool = this;
+    tls_worker = idx;
+    uint32_t foreground_in_row = 0;
+    while (true) {
+        if (stop_.load() && !drain_) {
+            break;
+        }
+        Item item;
+        TaskPriority priority;
+        if (Take(idx, foreground_in_row >= kMaxForegroundInRow, &item, &priority)) {
+            int64_t start_time = NowUs();
+            wait_latency_ << start_time - item.enqueue_time;
+            item.task();
+            run_latency_ << NowUs() - start_time;
+            if (priority == TaskPriority::kBackground) {
+                foreground_in_row = 0;
+                running_background_.fetch_sub(1);
+                // a background task may wait for the slot
+                if (pending_[1].load() > 0) {
+                    Wake();
+                }
+            } else {
+                foreground_in_row++;
+            }
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(idle_mu_);
+        if (stop_.load() && (!drain_ || (pending_[0].load() == 0 && pending_[1].load() == 0))) {
+            break;
+        }
+        idle_.fetch_add(1);
+        idle_cv_.wait(lock, [this] { return stop_.load() || HasRunnable(); });
+        idle_.fetch_sub(1);
+    }
+    tls_pool = nullptr;
+}
+
+void WorkStealingPool::TimerProc() {
+    std::unique_lock<std::mutex> lock(timer_mu_);
+    while (!timer_stop_) {
+        if (delayed_.empty()) {
+            timer_cv_.wait(lock);
+            continue;
+        }
+        auto it = delayed_.begin();
+        int64_t now = NowUs();
+        if (it->first.first > now) {
+            timer_cv_.wait_for(lock, std::chrono::microseconds(it->first.first - now));
+            continue;
+        }
+        DelayedItem delayed = std::move(it->second);
+        delayed_due_.erase(it->first.second);
+        delayed_.erase(it);
+        lock.unlock();
+        Push(Item{delayed.task, NowUs()}, delayed.priority);
+        lock.lock();
+    }
+}
+
+}  // namespace base
+}  // namespace openmldb
@@ -0,0 +1,128 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_BASE_WORK_STEALING_POOL_H_
+#define SRC_BASE_WORK_STEALING_POOL_H_
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "boost/function.hpp"
+#include "bvar/bvar.h"
+
+namespace openmldb {
+namespace base {
+
+enum class TaskPriority {
+    kForeground = 0,
+    kBackground = 1,
+};
+
+// WorkStealingPool runs the tasks with a queue per worker, a task is added to
+// the queue of the current worker or the next one in turn, and a worker takes
+// the tasks of the others once its own queue is empty.
+// The queued foreground tasks run before the background ones, and background
+// tasks never occupy all of the workers, so a long gc or snapshot task does not
+// hold back the short ones. The queue depth, the wait and run latency of tasks
+// are exposed by bvar with name as prefix.
+class WorkStealingPool {
+ public:
+    typedef boost::function<void()> Task;
+
+    WorkStealingPool(uint32_t thread_num, const std::string& name);
+    ~WorkStealingPool();
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    void AddTask(const Task& task, TaskPriority priority = TaskPriority::kForeground);
+
+    // add task after delay_ms, return the id to cancel it
+    int64_t DelayTask(int64_t delay_ms, const Task& task, TaskPriority priority = TaskPriority::kForeground);
+
+    // return false if the task has been added or canceled
+    bool CancelTask(int64_t id);
+
+    // run the queued tasks before stopping if wait, the delayed ones are dropped
+    void Stop(bool wait);
+
+    // the count of queued and delayed tasks
+    int64_t PendingNum();
+
+ private:
+    struct Item {
+        Task task;
+        int64_t enqueue_time;
+    };
+
+    struct Worker {
+        std::mutex mu;
+        std::deque<Item> queues[2];
+    };
+
+    struct DelayedItem {
+        Task task;
+        TaskPriority priority;
+    };
+
+    void Push(Item&& item, TaskPriority priority);
+    bool Take(uint32_t idx, bool background_first, Item* item, TaskPriority* priority);
+    bool PopFrom(uint32_t idx, TaskPriority priority, bool front, Item* item);
+    bool HasRunnable() const;
+    void Wake();
+    void WorkerProc(uint32_t idx);
+    void TimerProc();
+    static int64_t GetQueueDepth(void* arg);
+
+ private:
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::thread> threads_;
+    uint32_t max_background_;
+    std::atomic<uint32_t> next_worker_;
+    std::atomic<int64_t> pending_[2];
+    std::atomic<uint32_t> running_background_;
+
+    std::mutex idle_mu_;
+    std::condition_variable idle_cv_;
+    std::atomic<uint32_t> idle_;
+    std::atomic<bool> stop_;
+    bool drain_;
+
+    std::mutex timer_mu_;
+    std::condition_variable timer_cv_;
+    std::thread timer_thread_;
+    bool timer_stop_;
+    int64_t next_id_;
+    // (due time, id) -> task
+    std::map<std::pair<int64_t, int64_t>, DelayedItem> delayed_;
+    std::unordered_map<int64_t, int64_t> delayed_due_;
+
+    bvar::LatencyRecorder wait_latency_;
+    bvar::LatencyRecorder run_latency_;
+    bvar::PassiveStatus<int64_t> queue_depth_;
+};
+
+}  // namespace base
+}  // namespace openmldb
+#endif  // SRC_BASE_WORK_STEALING_POOL_H_
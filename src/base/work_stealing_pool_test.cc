@@ -0,0 +1,109 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "base/work_stealing_pool.h"
+
+#include <atomic>
+
+#include "base/count_down_latch.h"
+#include "boost/bind.hpp"
+#include "gtest/gtest.h"
+
+namespace openmldb {
+namespace base {
+
+class WorkStealingPoolTest : public ::testing::Test {
+ public:
+    WorkStealingPoolTest() {}
+    ~WorkStealingPoolTest() {}
+};
+
+void Incr(std::atomic<int32_t>* cnt) { cnt->fetch_add(1); }
+
+void Block(CountDownLatch* started, CountDownLatch* release) {
+    started->CountDown();
+    release->Wait();
+}
+
+void AddSubTask(WorkStealingPool* pool, std::atomic<int32_t>* cnt, int32_t depth) {
+    cnt->fetch_add(1);
+    if (depth > 0) {
+        pool->AddTask(boost::bind(&AddSubTask, pool, cnt, depth - 1));
+        pool->AddTask(boost::bind(&AddSubTask, pool, cnt, depth - 1));
+    }
+}
+
+TEST_F(WorkStealingPoolTest, AddTask) {
+    std::atomic<int32_t> cnt(0);
+    WorkStealingPool pool(4, "ws_test_add");
+    for (int32_t i = 0; i < 1000; i++) {
+        pool.AddTask(boost::bind(&Incr, &cnt),
+                     i % 2 == 0 ? TaskPriority::kForeground : TaskPriority::kBackground);
+    }
+    // the tasks added by a task are stolen by the other workers
+    pool.AddTask(boost::bind(&AddSubTask, &pool, &cnt, 9));
+    pool.Stop(true);
+    ASSERT_EQ(1000 + 1023, cnt.load());
+    ASSERT_EQ(0, pool.PendingNum());
+}
+
+TEST_F(WorkStealingPoolTest, BackgroundNotOccupyAll) {
+    WorkStealingPool pool(2, "ws_test_background");
+    CountDownLatch started(1);
+    CountDownLatch release(1);
+    pool.AddTask(boost::bind(&Block, &started, &release), TaskPriority::kBackground);
+    started.Wait();
+    std::atomic<int32_t> background_cnt(0);
+    pool.AddTask(boost::bind(&Incr, &background_cnt), TaskPriority::kBackground);
+    // the foreground task runs while the background one waits for the slot
+    std::atomic<int32_t> cnt(0);
+    CountDownLatch done(1);
+    pool.AddTask(boost::bind(&Incr, &cnt));
+    pool.AddTask(boost::bind(&CountDownLatch::CountDown, &done));
+    done.Wait();
+    ASSERT_EQ(1, cnt.load());
+    ASSERT_EQ(0, background_cnt.load());
+    release.CountDown();
+    pool.Stop(true);
+    ASSERT_EQ(1, background_cnt.load());
+}
+
+TEST_F(WorkStealingPoolTest, DelayTask) {
+    std::atomic<int32_t> cnt(0);
+    WorkStealingPool pool(2, "ws_test_delay");
+    CountDownLatch done(1);
+    pool.DelayTask(20, boost::bind(&Incr, &cnt), TaskPriority::kBackground);
+    pool.DelayTask(50, boost::bind(&CountDownLatch::CountDown, &done));
+    int64_t id = pool.DelayTask(10, boost::bind(&Incr, &cnt));
+    ASSERT_TRUE(pool.CancelTask(id));
+    ASSERT_FALSE(pool.CancelTask(id));
+    ASSERT_EQ(2, pool.PendingNum());
+    done.Wait();
+    ASSERT_EQ(1, cnt.load());
+    // the delayed task is dropped after stop
+    pool.DelayTask(100000, boost::bind(&Incr, &cnt));
+    pool.Stop(false);
+    ASSERT_EQ(1, cnt.load());
+    ASSERT_EQ(-1, pool.DelayTask(10, boost::bind(&Incr, &cnt)));
+}
+
+}  // namespace base
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
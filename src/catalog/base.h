@@ -50,6 +50,8 @@ class ProcedureInfoImpl : public hybridse::sdk::ProcedureInfo {
 
     ::hybridse::sdk::ProcedureType GetType() const override { return type_; }
 
+    uint64_t GetResultCacheTtl() const { return result_cache_ttl_; }
+
  private:
     std::string db_name_;
     std::string sp_name_;
@@ -61,6 +63,7 @@ class ProcedureInfoImpl : public hybridse::sdk::ProcedureInfo {
     std::string main_table_;
     std::string main_db_;
     ::hybridse::sdk::ProcedureType type_;
+    uint64_t result_cache_ttl_;
 };
 
 }  // namespace catalog
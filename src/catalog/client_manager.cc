@@ -362,6 +362,14 @@ std::shared_ptr<TabletAccessor> PartitionClientManager::GetFollower() {
     return std::shared_ptr<TabletAccessor>();
 }
 
+std::shared_ptr<TabletAccessor> PartitionClientManager::GetReadTablet() {
+    if (!leader_ || followers_.empty()) {
+        return leader_ ? leader_ : GetFollower();
+    }
+    uint32_t it = rand_.Next() % (followers_.size() + 1);
+    return it == followers_.size() ? leader_ : followers_[it];
+}
+
 TableClientManager::TableClientManager(const TablePartitions& partitions, const ClientManager& client_manager) {
     for (const auto& table_partition : partitions) {
         uint32_t pid = table_partition.pid();
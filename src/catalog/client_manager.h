@@ -218,6 +218,9 @@ class PartitionClientManager {
 
     std::shared_ptr<TabletAccessor> GetFollower();
 
+    // pick the leader or one of the followers at random to balance the reads
+    std::shared_ptr<TabletAccessor> GetReadTablet();
+
  private:
     uint32_t pid_;
     std::shared_ptr<TabletAccessor> leader_;
@@ -265,6 +268,13 @@ class TableClientManager {
         }
         return std::shared_ptr<TabletAccessor>();
     }
+    std::shared_ptr<TabletAccessor> GetReadTablet(uint32_t pid) const {
+        auto partition_manager = GetPartitionClientManager(pid);
+        if (partition_manager) {
+            return partition_manager->GetReadTablet();
+        }
+        return std::shared_ptr<TabletAccessor>();
+    }
     std::shared_ptr<TabletsAccessor> GetTablet(std::vector<uint32_t> pids) const {
         std::shared_ptr<TabletsAccessor> tablets_accessor = std::shared_ptr<TabletsAccessor>(new TabletsAccessor());
         for (size_t idx = 0; idx < pids.size(); idx++) {
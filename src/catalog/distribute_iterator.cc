@@ -19,6 +19,38 @@
 namespace openmldb {
 namespace catalog {
 
+thread_local PartitionReadRecorder* PartitionReadRecorder::current_ = nullptr;
+
+PartitionReadRecorder::PartitionReadRecorder() : prev_(current_), partitions_(), unknown_(false) { current_ = this; }
+
+PartitionReadRecorder::~PartitionReadRecorder() { current_ = prev_; }
+
+void PartitionReadRecorder::RecordPartition(uint32_t tid, uint32_t pid) {
+    if (current_ != nullptr) {
+        current_->partitions_.insert((static_cast<uint64_t>(tid) << 32) | pid);
+    }
+}
+
+void PartitionReadRecorder::RecordTable(uint32_t tid, uint32_t pid_num) {
+    for (uint32_t pid = 0; pid < pid_num; pid++) {
+        RecordPartition(tid, pid);
+    }
+}
+
+void PartitionReadRecorder::RecordUnknown() {
+    if (current_ != nullptr) {
+        current_->unknown_ = true;
+    }
+}
+
+bool PartitionReadRecorder::GetPartitions(std::vector<uint64_t>* partitions) const {
+    if (unknown_) {
+        return false;
+    }
+    partitions->assign(partitions_.begin(), partitions_.end());
+    return true;
+}
+
 FullTableIterator::FullTableIterator(std::shared_ptr<Tables> tables)
     : tables_(tables), cur_pid_(0), it_(), key_(0), value_() {}
 
@@ -65,8 +97,9 @@ const ::hybridse::codec::Row& FullTableIterator::GetValue() {
 }
 
 DistributeWindowIterator::DistributeWindowIterator(std::shared_ptr<Tables> tables, uint32_t index)
-    : tables_(tables), index_(index), cur_pid_(0), pid_num_(1), it_() {
+    : tables_(tables), index_(index), tid_(0), cur_pid_(0), pid_num_(1), it_() {
     if (tables && !tables->empty()) {
+        tid_ = tables->begin()->second->GetId();
         pid_num_ = tables->begin()->second->GetTableMeta()->table_partition_size();
     }
 }
@@ -81,6 +114,7 @@ void DistributeWindowIterator::Seek(const std::string& key) {
     if (pid_num_ > 0) {
         cur_pid_ = (uint32_t)(::openmldb::base::hash64(key) % pid_num_);
     }
+    PartitionReadRecorder::RecordPartition(tid_, cur_pid_);
     auto iter = tables_->find(cur_pid_);
     if (iter != tables_->end()) {
         it_.reset(iter->second->NewWindowIterator(index_));
@@ -108,6 +142,7 @@ void DistributeWindowIterator::SeekToFirst() {
     if (!tables_) {
         return;
     }
+    PartitionReadRecorder::RecordTable(tid_, pid_num_);
     for (const auto& kv : *tables_) {
         it_.reset(kv.second->NewWindowIterator(index_));
         it_->SeekToFirst();
@@ -144,5 +179,9 @@ std::unique_ptr<::hybridse::codec::RowIterator> DistributeWindowIterator::GetVal
 
 const ::hybridse::codec::Row DistributeWindowIterator::GetKey() { return it_->GetKey(); }
 
+uint64_t DistributeWindowIterator::GetValueCount() { return it_->GetValueCount(); }
+
+::hybridse::codec::Row DistributeWindowIterator::GetValueAt(uint64_t pos) { return it_->GetValueAt(pos); }
+
 }  // namespace catalog
 }  // namespace openmldb
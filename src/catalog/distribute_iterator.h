@@ -19,7 +19,9 @@
 
 #include <map>
 #include <memory>
+#include <set>
 #include <string>
+#include <vector>
 
 #include "base/hash.h"
 #include "storage/table.h"
@@ -30,6 +32,34 @@ namespace catalog {
 
 using Tables = std::map<uint32_t, std::shared_ptr<::openmldb::storage::Table>>;
 
+// PartitionReadRecorder collects the partitions the catalog reads on the thread it is created on,
+// until it is destroyed. The read of a table without local partitions makes the read set unknown
+class PartitionReadRecorder {
+ public:
+    PartitionReadRecorder();
+    ~PartitionReadRecorder();
+    PartitionReadRecorder(const PartitionReadRecorder&) = delete;
+    PartitionReadRecorder& operator=(const PartitionReadRecorder&) = delete;
+
+    static void RecordPartition(uint32_t tid, uint32_t pid);
+    // the read of all partitions, e.g. a full scan
+    static void RecordTable(uint32_t tid, uint32_t pid_num);
+    static void RecordUnknown();
+
+    // return false if the read set is unknown, the partitions are (tid << 32) | pid in ascending order
+    bool GetPartitions(std::vector<uint64_t>* partitions) const;
+    // the local partitions recorded, even if the read set is unknown
+    std::vector<uint64_t> GetRecordedPartitions() const {
+        return std::vector<uint64_t>(partitions_.begin(), partitions_.end());
+    }
+
+ private:
+    static thread_local PartitionReadRecorder* current_;
+    PartitionReadRecorder* prev_;
+    std::set<uint64_t> partitions_;
+    bool unknown_;
+};
+
 class FullTableIterator : public ::hybridse::codec::ConstIterator<uint64_t, ::hybridse::codec::Row> {
  public:
     explicit FullTableIterator(std::shared_ptr<Tables> tables);
@@ -60,10 +90,13 @@ class DistributeWindowIterator : public ::hybridse::codec::WindowIterator {
     std::unique_ptr<::hybridse::codec::RowIterator> GetValue() override;
     ::hybridse::codec::RowIterator* GetRawValue() override;
     const ::hybridse::codec::Row GetKey() override;
+    uint64_t GetValueCount() override;
+    ::hybridse::codec::Row GetValueAt(uint64_t pos) override;
 
  private:
     std::shared_ptr<Tables> tables_;
     uint32_t index_;
+    uint32_t tid_;
     uint32_t cur_pid_;
     uint32_t pid_num_;
     std::unique_ptr<::hybridse::codec::WindowIterator> it_;
@@ -105,6 +105,10 @@ std::shared_ptr<TabletAccessor> SDKTableHandler::GetTablet(uint32_t pid) {
     return table_client_manager_->GetTablet(pid);
 }
 
+std::shared_ptr<TabletAccessor> SDKTableHandler::GetReadTablet(uint32_t pid) {
+    return table_client_manager_->GetReadTablet(pid);
+}
+
 bool SDKTableHandler::GetTablet(std::vector<std::shared_ptr<TabletAccessor>>* tablets) {
     if (tablets == nullptr) {
         return false;
@@ -74,6 +74,9 @@ class SDKTableHandler : public ::hybridse::vm::TableHandler {
 
     std::shared_ptr<TabletAccessor> GetTablet(uint32_t pid);
 
+    // get the leader or a follower of the partition to read
+    std::shared_ptr<TabletAccessor> GetReadTablet(uint32_t pid);
+
     bool GetTablet(std::vector<std::shared_ptr<TabletAccessor>>* tablets);
 
     inline uint32_t GetTid() const { return meta_.tid(); }
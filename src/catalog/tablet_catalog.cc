@@ -119,8 +119,10 @@ bool TabletTableHandler::UpdateIndex(
 std::unique_ptr<::hybridse::codec::RowIterator> TabletTableHandler::GetIterator() {
     auto tables = std::atomic_load_explicit(&tables_, std::memory_order_acquire);
     if (!tables->empty()) {
+        PartitionReadRecorder::RecordTable(GetTid(), GetPartitionNum());
         return std::unique_ptr<catalog::FullTableIterator>(new catalog::FullTableIterator(tables));
     }
+    PartitionReadRecorder::RecordUnknown();
     return std::unique_ptr<::hybridse::codec::RowIterator>();
 }
 
@@ -136,6 +138,7 @@ std::unique_ptr<::hybridse::codec::WindowIterator> TabletTableHandler::GetWindow
         return std::unique_ptr<::hybridse::codec::WindowIterator>(
             new DistributeWindowIterator(tables, iter->second.index));
     }
+    PartitionReadRecorder::RecordUnknown();
     return std::unique_ptr<::hybridse::codec::WindowIterator>();
 }
 
@@ -151,8 +154,10 @@ const ::hybridse::codec::Row TabletTableHandler::Get(int32_t pos) {
 ::hybridse::codec::RowIterator* TabletTableHandler::GetRawIterator() {
     auto tables = std::atomic_load_explicit(&tables_, std::memory_order_acquire);
     if (!tables->empty()) {
+        PartitionReadRecorder::RecordTable(GetTid(), GetPartitionNum());
         return new catalog::FullTableIterator(tables);
     }
+    PartitionReadRecorder::RecordUnknown();
     return nullptr;
 }
 
@@ -236,6 +241,8 @@ std::shared_ptr<::hybridse::vm::Tablet> TabletTableHandler::GetTablet(const std:
         DLOG(INFO) << "get tablet index_name " << index_name << ", pk " << pk << ", local_tablet_";
         return local_tablet_;
     }
+    // the rows read by a remote tablet are not known locally
+    PartitionReadRecorder::RecordUnknown();
     auto client_tablet = table_client_manager_->GetTablet(pid);
     if (!client_tablet) {
         DLOG(INFO) << "get tablet index_name " << index_name << ", pk " << pk << ", tablet nullptr";
@@ -520,7 +527,11 @@ std::vector<::hybridse::vm::AggrTableInfo> TabletCatalog::GetAggrTables(
     const std::string& order_col) {
     AggrTableKey key{base_db, base_table, aggr_func, aggr_col, partition_cols, order_col};
     auto aggr_tables = std::atomic_load_explicit(&aggr_tables_, std::memory_order_acquire);
-    return (*aggr_tables)[key];
+    auto it = aggr_tables->find(key);
+    if (it == aggr_tables->end()) {
+        return {};
+    }
+    return it->second;
 }
 
 void TabletCatalog::RefreshAggrTables(const std::vector<::hybridse::vm::AggrTableInfo>& table_infos) {
@@ -92,27 +92,29 @@ class TabletSegmentHandler : public ::hybridse::vm::TableHandler {
     }
 
     const uint64_t GetCount() override {
-        auto iter = GetIterator();
-        if (!iter) return 0;
-        uint64_t cnt = 0;
-        while (iter->Valid()) {
-            cnt++;
-            iter->Next();
-        }
-        return cnt;
+        auto iter = SeekToKey();
+        return iter ? iter->GetValueCount() : 0;
     }
 
     ::hybridse::vm::Row At(uint64_t pos) override {
-        auto iter = GetIterator();
-        if (!iter) return ::hybridse::vm::Row();
-        while (pos-- > 0 && iter->Valid()) {
-            iter->Next();
-        }
-        return iter->Valid() ? iter->GetValue() : ::hybridse::vm::Row();
+        auto iter = SeekToKey();
+        return iter ? iter->GetValueAt(pos) : ::hybridse::vm::Row();
     }
     const std::string GetHandlerTypeName() override { return "TabletSegmentHandler"; }
 
  private:
+    // return the window iterator positioned at key_, or nullptr if key_ is not found
+    std::unique_ptr<::hybridse::vm::WindowIterator> SeekToKey() {
+        auto iter = partition_handler_->GetWindowIterator();
+        if (iter) {
+            iter->Seek(key_);
+            if (iter->Valid() && 0 == iter->GetKey().compare(hybridse::codec::Row(key_))) {
+                return iter;
+            }
+        }
+        return std::unique_ptr<::hybridse::vm::WindowIterator>();
+    }
+
     std::shared_ptr<::hybridse::vm::PartitionHandler> partition_handler_;
     std::string key_;
 };
@@ -209,6 +211,8 @@ class TabletTableHandler : public ::hybridse::vm::TableHandler,
 
     inline int32_t GetTid() { return table_st_.GetTid(); }
 
+    inline uint32_t GetPartitionNum() { return table_st_.GetPartitionNum(); }
+
     void AddTable(std::shared_ptr<::openmldb::storage::Table> table);
 
     bool HasLocalTable();
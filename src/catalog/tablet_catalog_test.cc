@@ -16,10 +16,12 @@
 
 #include "catalog/tablet_catalog.h"
 
+#include <algorithm>
 #include <vector>
 
 #include "base/fe_status.h"
 #include "codec/fe_row_codec.h"
+#include "common/timer.h"  // NOLINT
 #include "codec/schema_codec.h"
 #include "gtest/gtest.h"
 #include "proto/fe_common.pb.h"
@@ -421,6 +423,83 @@ TEST_F(TabletCatalogTest, iterator_test) {
     }
     ASSERT_EQ(record_num, 500);
 }
+
+TEST_F(TabletCatalogTest, segment_handler_count_test) {
+    std::shared_ptr<TabletCatalog> catalog(new TabletCatalog());
+    ASSERT_TRUE(catalog->Init());
+    uint32_t pid_num = 4;
+    TestArgs *args = PrepareMultiPartitionTable("t1", pid_num);
+    for (uint32_t pid = 0; pid < pid_num; pid++) {
+        ASSERT_TRUE(catalog->AddTable(args->meta[pid], args->tables[pid]));
+    }
+    auto handler = catalog->GetTable("db1", "t1");
+    auto partition = handler->GetPartition("index0");
+    auto segment = partition->GetSegment("pk120");
+    ASSERT_EQ(5u, segment->GetCount());
+    ::hybridse::vm::Schema fe_schema;
+    schema::SchemaAdapter::ConvertSchema(args->meta[0].column_desc(), &fe_schema);
+    ::hybridse::codec::RowView view(fe_schema);
+    for (uint64_t pos = 0; pos < 5; pos++) {
+        auto row = segment->At(pos);
+        ASSERT_FALSE(row.empty());
+        ASSERT_TRUE(view.Reset(row.buf(), row.size()));
+        ASSERT_EQ(1589780888004l - static_cast<int64_t>(pos), view.GetInt64Unsafe(1));
+    }
+    ASSERT_TRUE(segment->At(5).empty());
+    auto not_exist = partition->GetSegment("KEY_NOT_EXIST");
+    ASSERT_EQ(0u, not_exist->GetCount());
+    ASSERT_TRUE(not_exist->At(0).empty());
+    delete args;
+}
+
+TEST_F(TabletCatalogTest, window_iterator_count_with_ttl_test) {
+    ::openmldb::api::TableMeta meta;
+    meta.set_name("t1");
+    meta.set_tid(1);
+    meta.set_pid(0);
+    meta.set_seg_cnt(8);
+    SchemaCodec::SetColumnDesc(meta.add_column_desc(), "col1", ::openmldb::type::kString);
+    SchemaCodec::SetColumnDesc(meta.add_column_desc(), "col2", ::openmldb::type::kBigInt);
+    SchemaCodec::SetIndex(meta.add_column_key(), "index0", "col1", "col2", ::openmldb::type::kLatestTime, 0, 3);
+    SchemaCodec::SetIndex(meta.add_column_key(), "index1", "col2", "col2", ::openmldb::type::kAbsoluteTime, 1, 0);
+    ::openmldb::storage::MemTable table(meta);
+    table.Init();
+    ::hybridse::vm::Schema fe_schema;
+    schema::SchemaAdapter::ConvertSchema(meta.column_desc(), &fe_schema);
+    ::hybridse::codec::RowBuilder rb(fe_schema);
+    std::string pk = "pk1";
+    uint32_t size = rb.CalTotalLength(pk.size());
+    uint64_t now = ::baidu::common::timer::get_micros() / 1000;
+    for (uint64_t i = 0; i < 5; i++) {
+        // the first two rows are expired by the absolute ttl of index1
+        uint64_t ts = i < 2 ? now - 2 * 60 * 1000 - i : now + i;
+        std::string value;
+        value.resize(size);
+        rb.SetBuffer(reinterpret_cast<int8_t *>(&(value[0])), size);
+        rb.AppendString(pk.c_str(), pk.size());
+        rb.AppendInt64(ts);
+        ::openmldb::storage::Dimensions dims;
+        auto dim = dims.Add();
+        dim->set_key(pk);
+        dim->set_idx(0);
+        dim = dims.Add();
+        dim->set_key(pk);
+        dim->set_idx(1);
+        ASSERT_TRUE(table.Put(ts, value, dims));
+    }
+    std::unique_ptr<::hybridse::vm::WindowIterator> it(table.NewWindowIterator(0));
+    it->Seek("pk1");
+    ASSERT_TRUE(it->Valid());
+    ASSERT_EQ(3u, it->GetValueCount());
+    ASSERT_FALSE(it->GetValueAt(2).empty());
+    ASSERT_TRUE(it->GetValueAt(3).empty());
+    it.reset(table.NewWindowIterator(1));
+    it->Seek("pk1");
+    ASSERT_TRUE(it->Valid());
+    ASSERT_EQ(3u, it->GetValueCount());
+    ASSERT_TRUE(it->GetValueAt(3).empty());
+}
+
 TEST_F(TabletCatalogTest, window_iterator_seek_test_discontinuous) {
     std::vector<std::shared_ptr<TabletCatalog>> catalog_vec;
     for (int i = 0; i < 2; i++) {
@@ -553,6 +632,52 @@ TEST_F(TabletCatalogTest, get_tablet) {
     delete args;
 }
 
+TEST_F(TabletCatalogTest, partition_read_recorder_test) {
+    auto local_tablet =
+        std::make_shared<hybridse::vm::LocalTablet>(nullptr, std::shared_ptr<hybridse::vm::CompileInfoCache>());
+    uint32_t pid_num = 8;
+    TestArgs *args = PrepareMultiPartitionTable("t1", pid_num);
+    auto handler = std::make_shared<TabletTableHandler>(args->meta[0], local_tablet);
+    ClientManager client_manager;
+    ASSERT_TRUE(handler->Init(client_manager));
+    for (uint32_t pid = 0; pid < pid_num; pid++) {
+        handler->AddTable(args->tables[pid]);
+    }
+    std::vector<uint64_t> partitions;
+    {
+        PartitionReadRecorder recorder;
+        auto iterator = handler->GetWindowIterator("index0");
+        iterator->Seek("pk190");
+        ASSERT_TRUE(iterator->Valid());
+        iterator->Seek("pk195");
+        ASSERT_TRUE(iterator->Valid());
+        ASSERT_TRUE(recorder.GetPartitions(&partitions));
+        std::vector<uint64_t> expect = {(1ull << 32) | (::openmldb::base::hash64("pk190") % pid_num),
+                                        (1ull << 32) | (::openmldb::base::hash64("pk195") % pid_num)};
+        std::sort(expect.begin(), expect.end());
+        expect.erase(std::unique(expect.begin(), expect.end()), expect.end());
+        ASSERT_EQ(expect, partitions);
+    }
+    {
+        PartitionReadRecorder recorder;
+        auto iterator = handler->GetIterator();
+        ASSERT_TRUE(recorder.GetPartitions(&partitions));
+        ASSERT_EQ(pid_num, partitions.size());
+    }
+    // the rows of a remote partition are not known
+    auto remote_handler = std::make_shared<TabletTableHandler>(args->meta[0], local_tablet);
+    ASSERT_TRUE(remote_handler->Init(client_manager));
+    remote_handler->AddTable(args->tables[7]);
+    {
+        PartitionReadRecorder recorder;
+        ASSERT_TRUE(remote_handler->GetTablet("", "key0"));
+        ASSERT_TRUE(recorder.GetPartitions(&partitions));
+        remote_handler->GetTablet("", "key1");
+        ASSERT_FALSE(recorder.GetPartitions(&partitions));
+    }
+    delete args;
+}
+
 TEST_F(TabletCatalogTest, aggr_table_test) {
     std::shared_ptr<TabletCatalog> catalog(new TabletCatalog());
     ASSERT_TRUE(catalog->Init());
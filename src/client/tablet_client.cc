@@ -47,13 +47,20 @@ TabletClient::~TabletClient() {}
 int TabletClient::Init() { return client_.Init(); }
 
 bool TabletClient::Query(const std::string& db, const std::string& sql, const std::string& row, brpc::Controller* cntl,
-                         openmldb::api::QueryResponse* response, const bool is_debug) {
+                         openmldb::api::QueryResponse* response, const bool is_debug, int64_t max_read_lag,
+                         int64_t read_pid) {
     if (cntl == NULL || response == NULL) return false;
     ::openmldb::api::QueryRequest request;
     request.set_sql(sql);
     request.set_db(db);
     request.set_is_batch(false);
     request.set_is_debug(is_debug);
+    if (max_read_lag >= 0) {
+        request.set_max_read_lag(max_read_lag);
+        if (read_pid >= 0) {
+            request.set_read_pid(read_pid);
+        }
+    }
     request.set_row_size(row.size());
     request.set_row_slices(1);
     auto& io_buf = cntl->request_attachment();
@@ -98,6 +105,44 @@ bool TabletClient::Query(const std::string& db, const std::string& sql,
     return true;
 }
 
+bool TabletClient::Query(const std::string& db, const std::string& sql,
+                         const std::vector<openmldb::type::DataType>& parameter_types,
+                         const std::string& parameter_row, const brpc::StreamOptions& stream_options,
+                         brpc::Controller* cntl, ::openmldb::api::QueryResponse* response, brpc::StreamId* stream_id,
+                         const bool is_debug, uint32_t stream_max_chunks) {
+    if (cntl == NULL || response == NULL || stream_id == NULL) return false;
+    ::openmldb::api::QueryRequest request;
+    request.set_sql(sql);
+    request.set_db(db);
+    request.set_is_batch(true);
+    request.set_is_debug(is_debug);
+    request.set_stream(true);
+    if (stream_max_chunks > 0) {
+        request.set_stream_max_chunks(stream_max_chunks);
+    }
+    request.set_parameter_row_size(parameter_row.size());
+    request.set_parameter_row_slices(1);
+    for (auto& type : parameter_types) {
+        request.add_parameter_types(type);
+    }
+    auto& io_buf = cntl->request_attachment();
+    if (!codec::EncodeRpcRow(reinterpret_cast<const int8_t*>(parameter_row.data()), parameter_row.size(), &io_buf)) {
+        LOG(WARNING) << "Encode parameter buffer failed";
+        return false;
+    }
+    if (brpc::StreamCreate(stream_id, *cntl, &stream_options) != 0) {
+        LOG(WARNING) << "fail to create stream";
+        return false;
+    }
+    bool ok = client_.SendRequest(&::openmldb::api::TabletServer_Stub::Query, cntl, &request, response);
+    if (!ok || response->code() != 0) {
+        LOG(WARNING) << "fail to query tablet";
+        brpc::StreamClose(*stream_id);
+        return false;
+    }
+    return true;
+}
+
 /**
  * Utility function to encode row batch data into rpc attachment buffer
  */
@@ -270,6 +315,47 @@ bool TabletClient::Put(uint32_t tid, uint32_t pid, uint64_t time, const std::str
 
 
 
+bool TabletClient::PutBatch(uint32_t tid, uint32_t pid, ::openmldb::api::PutBatchRequest* request,
+                            std::vector<int32_t>* row_codes) {
+    request->set_tid(tid);
+    request->set_pid(pid);
+    ::openmldb::api::PutBatchResponse response;
+    bool ok = client_.SendRequest(&::openmldb::api::TabletServer_Stub::PutBatch, request, &response,
+                                  FLAGS_request_timeout_ms, 1);
+    if (!ok || response.code() != 0) {
+        LOG(WARNING) << "fail to put batch for " << response.msg() << " and error code " << response.code();
+        return false;
+    }
+    if (row_codes != nullptr) {
+        row_codes->assign(response.row_code().begin(), response.row_code().end());
+    }
+    for (int32_t code : response.row_code()) {
+        if (code != 0) {
+            LOG(WARNING) << "fail to put batch for " << response.msg();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool TabletClient::AsyncPut(const ::openmldb::api::PutRequest& request,
+                            openmldb::RpcCallback<openmldb::api::PutResponse>* callback) {
+    if (callback == nullptr) {
+        return false;
+    }
+    return client_.SendRequest(&::openmldb::api::TabletServer_Stub::Put, callback->GetController().get(), &request,
+                               callback->GetResponse().get(), callback);
+}
+
+bool TabletClient::AsyncPutBatch(const ::openmldb::api::PutBatchRequest& request,
+                                 openmldb::RpcCallback<openmldb::api::PutBatchResponse>* callback) {
+    if (callback == nullptr) {
+        return false;
+    }
+    return client_.SendRequest(&::openmldb::api::TabletServer_Stub::PutBatch, callback->GetController().get(),
+                               &request, callback->GetResponse().get(), callback);
+}
+
 bool TabletClient::Put(uint32_t tid, uint32_t pid, const char* pk, uint64_t time, const char* value, uint32_t size,
                        uint32_t format_version) {
     ::openmldb::api::PutRequest request;
@@ -1278,7 +1364,7 @@ bool TabletClient::Scan(const ::openmldb::api::ScanRequest& request, brpc::Contr
 
 bool TabletClient::CallProcedure(const std::string& db, const std::string& sp_name, const std::string& row,
                                  brpc::Controller* cntl, openmldb::api::QueryResponse* response, bool is_debug,
-                                 uint64_t timeout_ms) {
+                                 uint64_t timeout_ms, int64_t max_read_lag, int64_t read_pid) {
     if (cntl == NULL || response == NULL) return false;
     ::openmldb::api::QueryRequest request;
     request.set_sp_name(sp_name);
@@ -1286,6 +1372,12 @@ bool TabletClient::CallProcedure(const std::string& db, const std::string& sp_na
     request.set_is_debug(is_debug);
     request.set_is_batch(false);
     request.set_is_procedure(true);
+    if (max_read_lag >= 0) {
+        request.set_max_read_lag(max_read_lag);
+        if (read_pid >= 0) {
+            request.set_read_pid(read_pid);
+        }
+    }
     request.set_row_size(row.size());
     request.set_row_slices(1);
     cntl->set_timeout_ms(timeout_ms);
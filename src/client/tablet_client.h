@@ -26,6 +26,7 @@
 #include "base/kv_iterator.h"
 #include "base/status.h"
 #include "brpc/channel.h"
+#include "brpc/stream.h"
 #include "client/client.h"
 #include "codec/schema_codec.h"
 #include "proto/tablet.pb.h"
@@ -70,8 +71,18 @@ class TabletClient : public Client {
                const std::vector<openmldb::type::DataType>& parameter_types, const std::string& parameter_row,
                brpc::Controller* cntl, ::openmldb::api::QueryResponse* response, const bool is_debug = false);
 
+    // max_read_lag >= 0 allows a follower lagging at most max_read_lag binlog entries to serve the query
     bool Query(const std::string& db, const std::string& sql, const std::string& row, brpc::Controller* cntl,
-               ::openmldb::api::QueryResponse* response, const bool is_debug = false);
+               ::openmldb::api::QueryResponse* response, const bool is_debug = false, int64_t max_read_lag = -1,
+               int64_t read_pid = -1);
+
+    // batch query whose rows are received by the handler of stream_options,
+    // the stream is closed if the query fails
+    bool Query(const std::string& db, const std::string& sql,
+               const std::vector<openmldb::type::DataType>& parameter_types, const std::string& parameter_row,
+               const brpc::StreamOptions& stream_options, brpc::Controller* cntl,
+               ::openmldb::api::QueryResponse* response, brpc::StreamId* stream_id, const bool is_debug = false,
+               uint32_t stream_max_chunks = 0);
 
     bool SQLBatchRequestQuery(const std::string& db, const std::string& sql,
                               std::shared_ptr<::openmldb::sdk::SQLRequestRowBatch>, brpc::Controller* cntl,
@@ -89,6 +100,17 @@ class TabletClient : public Client {
     bool Put(uint32_t tid, uint32_t pid, uint64_t time, const std::string& value,
              const std::vector<std::pair<std::string, uint32_t>>& dimensions, uint32_t format_version);
 
+    // put the rows of request to one partition with one rpc, the return code of
+    // each row is set to row_codes in order
+    bool PutBatch(uint32_t tid, uint32_t pid, ::openmldb::api::PutBatchRequest* request,
+                  std::vector<int32_t>* row_codes);
+
+    bool AsyncPut(const ::openmldb::api::PutRequest& request,
+                  openmldb::RpcCallback<openmldb::api::PutResponse>* callback);
+
+    bool AsyncPutBatch(const ::openmldb::api::PutBatchRequest& request,
+                       openmldb::RpcCallback<openmldb::api::PutBatchResponse>* callback);
+
 
 
     bool Get(uint32_t tid, uint32_t pid, const std::string& pk, uint64_t time, std::string& value,  // NOLINT
@@ -255,7 +277,7 @@ class TabletClient : public Client {
 
     bool CallProcedure(const std::string& db, const std::string& sp_name, const std::string& row,
                        brpc::Controller* cntl, openmldb::api::QueryResponse* response, bool is_debug,
-                       uint64_t timeout_ms);
+                       uint64_t timeout_ms, int64_t max_read_lag = -1, int64_t read_pid = -1);
 
     bool CallSQLBatchRequestProcedure(const std::string& db, const std::string& sp_name,
                                       std::shared_ptr<::openmldb::sdk::SQLRequestRowBatch>, brpc::Controller* cntl,
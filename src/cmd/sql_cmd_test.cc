@@ -245,6 +245,43 @@ TEST_F(SqlCmdTest, SelectIntoOutfile) {
     remove(file_path.c_str());
 }
 
+TEST_F(SqlCmdTest, LoadDataParallel) {
+    auto sr = standalone_cli.sr;
+    std::string name = "test" + GenRand();
+    std::string db = "db" + GenRand();
+    std::string file_path = "/tmp/data" + GenRand() + ".csv";
+    std::ofstream ofile(file_path);
+    ofile << "c1,c2" << std::endl;
+    for (int i = 0; i < 1000; i++) {
+        ofile << "key" << i % 10 << "," << i << std::endl;
+        if (i == 500 || i == 900) {
+            ofile << "bad_line" << std::endl;
+        }
+    }
+    ofile.close();
+    ::hybridse::sdk::Status status;
+    ProcessSQLs(sr, {"create database " + db, "use " + db, "create table " + name + " (c1 string, c2 bigint);"});
+
+    // the error budget is less than the count of bad lines
+    sr->ExecuteSQL("load data infile '" + file_path + "' into table " + name + " options(thread = 4, max_errors = 1);",
+                   &status);
+    ASSERT_FALSE(status.IsOK());
+
+    sr->ExecuteSQL("drop table " + name, &status);
+    ASSERT_TRUE(status.IsOK()) << status.msg;
+    sr->ExecuteSQL("create table " + name + " (c1 string, c2 bigint);", &status);
+    ASSERT_TRUE(status.IsOK()) << status.msg;
+    sr->ExecuteSQL("load data infile '" + file_path + "' into table " + name + " options(thread = 4, max_errors = 2);",
+                   &status);
+    ASSERT_TRUE(status.IsOK()) << status.msg;
+    auto rs = sr->ExecuteSQL("select * from " + name, &status);
+    ASSERT_TRUE(status.IsOK()) << status.msg;
+    ASSERT_EQ(1000, rs->Size());
+
+    ProcessSQLs(sr, {"drop table " + name, "drop database " + db});
+    remove(file_path.c_str());
+}
+
 TEST_P(DBSDKTest, CreateDatabase) {
     auto cli = GetParam();
     cs = cli->cs;
@@ -16,9 +16,74 @@
 
 #include "codec/sql_rpc_row_codec.h"
 
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <utility>
+
 namespace openmldb {
 namespace codec {
 
+// the smaller slice is copied, it is cheaper than referring
+constexpr size_t kRefSliceMinSize = 1024;
+
+// UserDataSlices keeps the slices appended to IOBuf as user data until the
+// IOBuf is released, the deleter of user data is called with the data only
+class UserDataSlices {
+ public:
+    static UserDataSlices& Instance() {
+        static UserDataSlices slices;
+        return slices;
+    }
+
+    void Add(const hybridse::base::RefCountedSlice& slice) {
+        auto& shard = GetShard(slice.data());
+        std::lock_guard<std::mutex> lock(shard.mu);
+        auto& entry = shard.slices[slice.data()];
+        if (entry.second == 0) {
+            entry.first = slice;
+        }
+        entry.second++;
+    }
+
+    static void Release(void* data) {
+        auto& shard = Instance().GetShard(data);
+        std::lock_guard<std::mutex> lock(shard.mu);
+        auto it = shard.slices.find(data);
+        if (it != shard.slices.end() && --it->second.second == 0) {
+            shard.slices.erase(it);
+        }
+    }
+
+ private:
+    static constexpr uint32_t kShardCnt = 16;
+    struct Shard {
+        std::mutex mu;
+        std::unordered_map<const void*, std::pair<hybridse::base::RefCountedSlice, uint32_t>> slices;
+    };
+
+    inline Shard& GetShard(const void* data) {
+        return shards_[(reinterpret_cast<uintptr_t>(data) >> 4) % kShardCnt];
+    }
+
+    Shard shards_[kShardCnt];
+};
+
+// get the address of [offset, offset + size) in buf, NULL if it is not in one block
+static const char* GetContiguousData(const butil::IOBuf& buf, size_t offset, size_t size) {
+    size_t block_offset = 0;
+    for (size_t i = 0; i < buf.backing_block_num(); i++) {
+        butil::StringPiece block = buf.backing_block(i);
+        if (offset < block_offset + block.size()) {
+            if (offset + size > block_offset + block.size()) {
+                return NULL;
+            }
+            return block.data() + (offset - block_offset);
+        }
+        block_offset += block.size();
+    }
+    return NULL;
+}
+
 bool DecodeRpcRow(const butil::IOBuf& buf, size_t offset, size_t size, size_t slice_num, hybridse::codec::Row* row) {
     if (row == nullptr) {
         return false;
@@ -105,5 +170,102 @@ bool EncodeRpcRow(const int8_t* buf, size_t size, butil::IOBuf* io_buf) {
     return true;
 }
 
+bool AppendRpcRowSlice(const hybridse::codec::Row& row, size_t idx, butil::IOBuf* buf) {
+    auto slice = row.GetSlice(idx);
+    int code = 0;
+    if (slice.IsManaged() && slice.size() >= kRefSliceMinSize) {
+        UserDataSlices::Instance().Add(slice);
+        code = buf->append_user_data(slice.buf(), slice.size(), &UserDataSlices::Release);
+        if (code != 0) {
+            UserDataSlices::Release(slice.buf());
+        }
+    } else if (slice.size() > 0) {
+        code = buf->append(slice.data(), slice.size());
+    }
+    if (code != 0) {
+        LOG(WARNING) << "Append " << idx << "th slice of size " << slice.size() << " failed";
+        return false;
+    }
+    return true;
+}
+
+bool EncodeRpcRowRef(const hybridse::codec::Row& row, butil::IOBuf* buf, size_t* total_size) {
+    if (buf == nullptr) {
+        return false;
+    }
+    *total_size = 0;
+    size_t slice_num = row.GetRowPtrCnt();
+    for (size_t i = 0; i < slice_num; ++i) {
+        size_t slice_size = row.size(i);
+        if (row.buf(i) == nullptr || slice_size == 0) {
+            char empty_header[6] = {1, 1, 0, 0, 0, 0};
+            if (buf->append(empty_header, 6) != 0) {
+                LOG(WARNING) << "Append " << i << "th empty slice failed";
+                return false;
+            }
+            *total_size += 6;
+        } else {
+            if (!AppendRpcRowSlice(row, i, buf)) {
+                return false;
+            }
+            *total_size += slice_size;
+        }
+    }
+    return true;
+}
+
+bool DecodeRpcRowRef(const butil::IOBuf& buf, size_t offset, size_t size, size_t slice_num,
+                     hybridse::codec::Row* row) {
+    if (row == nullptr) {
+        return false;
+    }
+    if (slice_num == 0 || size == 0) {
+        *row = hybridse::codec::Row();
+        return true;
+    }
+    size_t cur_offset = offset;
+    if (cur_offset >= buf.size()) {
+        LOG(WARNING) << "Offset " << cur_offset << " out of bound, buf size=" << buf.size();
+        return false;
+    }
+    for (size_t i = 0; i < slice_num; ++i) {
+        uint32_t slice_size;
+        buf.copy_to(&slice_size, sizeof(uint32_t), cur_offset + 2);
+        size_t next_offset;
+        if (slice_size == 0) {
+            next_offset = cur_offset + 2 + sizeof(uint32_t);
+        } else {
+            next_offset = cur_offset + slice_size;
+        }
+        if (next_offset > buf.size()) {
+            LOG(WARNING) << "Size " << slice_size << " for " << i
+                         << "th row slice out of bound, buf size=" << buf.size() << " cur offset=" << cur_offset;
+            return false;
+        }
+        hybridse::base::RefCountedSlice slice;
+        if (slice_size > 0) {
+            const char* data = GetContiguousData(buf, cur_offset, slice_size);
+            if (data != NULL) {
+                slice = hybridse::base::RefCountedSlice::Create(data, slice_size);
+            } else {
+                int8_t* slice_buf = reinterpret_cast<int8_t*>(malloc(slice_size));
+                buf.copy_to(slice_buf, slice_size, cur_offset);
+                slice = hybridse::base::RefCountedSlice::CreateManaged(slice_buf, slice_size);
+            }
+        }
+        if (i == 0) {
+            *row = slice_size == 0 ? hybridse::codec::Row() : hybridse::codec::Row(slice);
+        } else {
+            row->Append(slice);
+        }
+        cur_offset = next_offset;
+    }
+    if (offset + size != cur_offset) {
+        LOG(WARNING) << "Illegal total row size " << (cur_offset - offset) << ", expect size=" << size;
+        return false;
+    }
+    return true;
+}
+
 }  // namespace codec
 }  // namespace openmldb
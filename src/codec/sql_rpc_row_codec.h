@@ -37,6 +37,18 @@ bool EncodeRpcRow(const hybridse::codec::Row& row, butil::IOBuf* buf, size_t* to
 
 bool EncodeRpcRow(const int8_t* buf, size_t size, butil::IOBuf* io_buf);
 
+// append the idx-th slice of row to buf, the managed slice is referred by buf
+// instead of being copied if it is large, and released with buf
+bool AppendRpcRowSlice(const hybridse::codec::Row& row, size_t idx, butil::IOBuf* buf);
+
+// EncodeRpcRow without copying the large managed slices
+bool EncodeRpcRowRef(const hybridse::codec::Row& row, butil::IOBuf* buf, size_t* total_size);
+
+// DecodeRpcRow referring to the slices in buf if they are contiguous, the row
+// must not be used after buf is released
+bool DecodeRpcRowRef(const butil::IOBuf& buf, size_t offset, size_t size, size_t slice_num,
+                     hybridse::codec::Row* row);
+
 }  // namespace codec
 }  // namespace openmldb
 #endif  // SRC_CODEC_SQL_RPC_ROW_CODEC_H_
@@ -123,6 +123,56 @@ TEST_F(SqlRpcRowCodecTest, TestMultiSlice) {
     ASSERT_EQ(0, decoded.size(3));
 }
 
+TEST_F(SqlRpcRowCodecTest, TestRefSlice) {
+    hybridse::codec::Schema schema;
+    InitSchema(&schema);
+    hybridse::codec::RowBuilder builder(schema);
+    std::string large_str(4096, 'a');
+    size_t large_size = builder.CalTotalLength(large_str.size());
+    int8_t* buf1 = reinterpret_cast<int8_t*>(malloc(large_size));
+    builder.SetBuffer(buf1, large_size);
+    builder.AppendInt32(42);
+    builder.AppendFloat(3.14);
+    builder.AppendString(large_str.c_str(), large_str.size());
+    size_t small_size = builder.CalTotalLength(5);
+    int8_t* buf2 = reinterpret_cast<int8_t*>(malloc(small_size));
+    builder.SetBuffer(buf2, small_size);
+    builder.AppendInt32(99);
+    builder.AppendFloat(0.618);
+    builder.AppendString("world", 5);
+
+    butil::IOBuf iobuf;
+    size_t total_size;
+    {
+        hybridse::codec::Row row(hybridse::codec::RefCountedSlice::CreateManaged(buf1, large_size));
+        row.Append(hybridse::codec::RefCountedSlice());
+        row.Append(hybridse::codec::RefCountedSlice::CreateManaged(buf2, small_size));
+        ASSERT_TRUE(EncodeRpcRowRef(row, &iobuf, &total_size));
+        ASSERT_EQ(large_size + small_size + 6, total_size);
+        // the large slice is referred and the others are copied
+        ASSERT_EQ(reinterpret_cast<const char*>(buf1), iobuf.backing_block(0).data());
+        ASSERT_EQ(large_size, iobuf.backing_block(0).size());
+    }
+
+    hybridse::codec::Row decoded;
+    ASSERT_TRUE(DecodeRpcRowRef(iobuf, 0, total_size, 3, &decoded));
+    ASSERT_EQ(reinterpret_cast<int8_t*>(buf1), decoded.buf(0));
+    hybridse::codec::RowView row_view(schema);
+    row_view.Reset(decoded.buf(0), decoded.size(0));
+    ASSERT_EQ(42, row_view.GetInt32Unsafe(0));
+    ASSERT_EQ(large_str, row_view.GetStringUnsafe(2));
+    ASSERT_EQ(nullptr, decoded.buf(1));
+    row_view.Reset(decoded.buf(2), decoded.size(2));
+    ASSERT_EQ(99, row_view.GetInt32Unsafe(0));
+    ASSERT_EQ("world", row_view.GetStringUnsafe(2));
+
+    hybridse::codec::Row decoded_copy;
+    ASSERT_TRUE(DecodeRpcRow(iobuf, 0, total_size, 3, &decoded_copy));
+    iobuf.clear();
+    row_view.Reset(decoded_copy.buf(0), decoded_copy.size(0));
+    ASSERT_EQ(large_str, row_view.GetStringUnsafe(2));
+}
+
 }  // namespace codec
 }  // namespace openmldb
 
@@ -49,7 +49,11 @@ DEFINE_int32(gc_interval, 120, "the gc interval of tablet every two hour");
 DEFINE_int32(gc_pool_size, 2, "the size of tablet gc thread pool");
 DEFINE_int32(gc_safe_offset, 1, "the safe offset of tablet gc in minute");
 DEFINE_uint64(gc_on_table_recover_count, 10000000, "make a gc on recover count");
-DEFINE_uint32(gc_deleted_pk_version_delta, 2, "config the gc version delta");
+DEFINE_bool(gc_expire_index, true, "index keys by their oldest ts so that absolute ttl gc skips unexpired keys");
+DEFINE_uint64(gc_expire_bucket_size, 60000, "the ts range of one bucket of gc expire index, in ms");
+DEFINE_uint64(gc_max_keys_per_round, 0,
+              "the max keys visited in one segment by one round of absolute ttl gc, the rest are left to next round. "
+              "0 means no limit");
 DEFINE_double(mem_release_rate, 5, "specify memory release rate, which should be in 0 ~ 10");
 DEFINE_int32(task_pool_size, 3, "the size of tablet task thread pool");
 DEFINE_int32(io_pool_size, 2, "the size of tablet io task thread pool");
@@ -62,6 +66,23 @@ DEFINE_string(mini_window_size, "1d", "the default mini window size in pre-aggr
 // scan configuration
 DEFINE_uint32(scan_max_bytes_size, 2 * 1024 * 1024, "config the max size of scan bytes size");
 DEFINE_uint32(scan_reserve_size, 1024, "config the size of vec reserve");
+DEFINE_uint32(query_stream_chunk_size, 256 * 1024, "config the bytes of rows in one message of stream query");
+DEFINE_uint32(query_stream_max_buf_size, 4 * 1024 * 1024,
+              "config the max bytes of stream query sent but not consumed by client");
+DEFINE_uint32(query_stream_wait_timeout, 60000, "config the max time in ms to wait for client consuming stream query");
+DEFINE_uint32(result_cache_max_entries, 10000, "config the max count of results cached for one deployment");
+DEFINE_bool(enable_sql_normalize, false,
+            "enable or disable lifting the literals of where clause into parameters, so that the batch queries "
+            "differing only in the literals share one compiled plan");
+DEFINE_string(jit_object_cache_dir, "",
+              "config the dir to keep the objects compiled for sql, so that a restarted tablet loads them instead of "
+              "compiling again. empty means disabled");
+DEFINE_uint32(jit_object_cache_max_mb, 1024,
+              "config the max size in MB of the objects kept in jit_object_cache_dir, the least recently used ones "
+              "are removed beyond it");
+DEFINE_uint32(sql_branch_parallelism, 1,
+              "config the threads to run the independent branches of a request concurrently, e.g. the windows and "
+              "last joins of a deployment. 1 means run serially");
 DEFINE_uint32(preview_limit_max_num, 1000, "config the max num of preview limit");
 DEFINE_uint32(preview_default_limit, 100, "config the default limit of preview");
 // binlog configuration
@@ -74,7 +95,19 @@ DEFINE_int32(binlog_sync_wait_time, 100, "config the sync log wait time");
 DEFINE_int32(binlog_sync_to_disk_interval, 20000, "config the interval of sync binlog to disk time");
 DEFINE_int32(binlog_delete_interval, 60000, "config the interval of delete binlog");
 DEFINE_int32(binlog_match_logoffset_interval, 1000, "config the interval of match log offset ");
+DEFINE_int32(binlog_heartbeat_interval, 0,
+             "config the interval(ms) the leader sends its log offset to an idle follower, 0 means never. It costs "
+             "one rpc per follower partition every interval, only set it below follower_read_max_silent_time when "
+             "follower reads are used");
+DEFINE_int32(follower_read_max_silent_time, 5000,
+             "config the time(ms) after which a follower not hearing from its leader rejects the follower reads, an "
+             "idle partition is only heard from by binlog_heartbeat_interval");
 DEFINE_int32(binlog_name_length, 8, "binlog name length");
+DEFINE_uint32(binlog_durability_mode, 0,
+              "the durability of binlog append. 0: sync to disk by timer, 1: sync after every "
+              "binlog_fsync_batch_size entries, 2: sync every group commit before respond");
+DEFINE_uint32(binlog_fsync_batch_size, 1024, "the entry count between two sync in binlog_durability_mode 1");
+DEFINE_uint32(binlog_group_commit_max_size, 1024, "the max entry count of one binlog group commit");
 DEFINE_uint32(check_binlog_sync_progress_delta, 100000, "config the delta of check binlog sync progress");
 DEFINE_uint32(go_back_max_try_cnt, 10, "config max try time of go back");
 
@@ -94,6 +127,8 @@ DEFINE_int32(request_timeout_ms, 20000, "request timeout");
 DEFINE_int32(request_sleep_time, 1000, "the sleep time when request error");
 
 DEFINE_uint32(max_traverse_cnt, 50000, "max traverse iter loop cnt");
+DEFINE_uint32(scan_epoch_renew_interval, 10000,
+              "the time in ms a full table scan holds the gc epoch before it renews it at the next key, 0 means never");
 DEFINE_string(ssd_root_path, "", "the root ssd path of db");
 DEFINE_string(hdd_root_path, "", "the root hdd path of db");
 
@@ -114,6 +149,10 @@ DEFINE_uint32(make_snapshot_offline_interval, 60 * 60 * 24,
               "config tablet self makesnapshot when how long time do not "
               "makesnapshot from ns. unit is second");
 DEFINE_string(snapshot_compression, "off", "Type of snapshot compression, can be off, snappy, zlib");
+DEFINE_bool(snapshot_image, false, "write a memory image alongside snapshot for fast recovery");
+DEFINE_uint32(snapshot_delta_max_num, 0,
+              "the max number of delta snapshots chained to the base snapshot, 0 means rewriting the "
+              "full snapshot every time");
 DEFINE_int32(snapshot_pool_size, 1, "the size of tablet thread pool for making snapshot");
 
 DEFINE_uint32(load_index_max_wait_time, 120 * 60 * 1000, "config the max wait time of load index");
@@ -126,6 +165,7 @@ DEFINE_uint32(latest_ttl_max, 1000, "the max ttl of latest");
 DEFINE_uint32(absolute_ttl_max, 60 * 24 * 365 * 30, "the max ttl of absolute time");
 DEFINE_uint32(skiplist_max_height, 12, "the max height of skiplist");
 DEFINE_uint32(key_entry_max_height, 8, "the max height of key entry");
+DEFINE_bool(segment_hash_index, false, "enable the hash index of pk in segment for point access");
 DEFINE_uint32(latest_default_skiplist_height, 1, "the default height of skiplist for latest table");
 DEFINE_uint32(absolute_default_skiplist_height, 4, "the default height of skiplist for absolute table");
 DEFINE_bool(enable_show_tp, false, "enable show tp");
@@ -145,6 +185,7 @@ DEFINE_bool(verify_compression, false, "For debug");
 DEFINE_uint32(load_table_batch, 30, "set laod table batch size");
 DEFINE_uint32(load_table_thread_num, 3, "set load tabale thread pool size");
 DEFINE_uint32(load_table_queue_size, 1000, "set load tabale queue size");
+DEFINE_uint32(load_table_dispatch_batch, 10000, "set the entry count of a batch applied in parallel in recovery");
 
 // multiple data center
 DEFINE_uint32(get_replica_status_interval, 10000, "config the interval to sync replica cluster status time");
@@ -30,11 +30,15 @@
 #include "base/file_util.h"
 #include "base/glog_wapper.h"  // NOLINT
 #include "base/strings.h"
+#include "bvar/bvar.h"
 #include "log/log_format.h"
 #include "storage/segment.h"
 
 DECLARE_int32(binlog_single_file_max_size);
 DECLARE_int32(binlog_name_length);
+DECLARE_uint32(binlog_durability_mode);
+DECLARE_uint32(binlog_fsync_batch_size);
+DECLARE_uint32(binlog_group_commit_max_size);
 DECLARE_string(zk_cluster);
 
 namespace openmldb {
@@ -42,6 +46,18 @@ namespace replica {
 
 static const ::openmldb::base::DefaultComparator scmp;
 
+// the entry count and latency(us) of every binlog group commit
+static bvar::LatencyRecorder g_group_commit_size("binlog_group_commit_size");
+static bvar::LatencyRecorder g_group_commit_latency("binlog_group_commit");
+
+struct LogReplicator::Writer {
+    Writer(LogEntry* e, uint32_t n) : entries(e), cnt(n), ok(false), done(false) {}
+    LogEntry* entries;
+    uint32_t cnt;
+    bool ok;
+    bool done;
+};
+
 LogReplicator::LogReplicator(uint32_t tid, uint32_t pid, const std::string& path,
                              const std::map<std::string, std::string>& real_ep_map,
                              const ReplicatorRole& role)
@@ -50,6 +66,8 @@ LogReplicator::LogReplicator(uint32_t tid, uint32_t pid, const std::string& path
       path_(path),
       log_path_(),
       log_offset_(0),
+      leader_offset_(UINT64_MAX),
+      leader_offset_time_(0),
       logs_(NULL),
       wh_(NULL),
       role_(role),
@@ -59,7 +77,11 @@ LogReplicator::LogReplicator(uint32_t tid, uint32_t pid, const std::string& path
       term_(0),
       mu_(),
       cv_(),
-      wmu_() {
+      wmu_(),
+      unsynced_cnt_(0),
+      commit_mu_(),
+      commit_cv_(),
+      writers_() {
     binlog_index_ = 0;
     snapshot_log_part_index_.store(-1, std::memory_order_relaxed);
     snapshot_last_offset_.store(0, std::memory_order_relaxed);
@@ -90,6 +112,8 @@ void LogReplicator::SyncToDisk() {
         ::openmldb::log::Status status = wh_->Sync();
         if (!status.ok()) {
             PDLOG(WARNING, "fail to sync data for path %s", path_.c_str());
+        } else {
+            unsynced_cnt_ = 0;
         }
         consumed = ::baidu::common::timer::get_micros() - consumed;
         if (consumed > 20000) {
@@ -242,12 +266,22 @@ void LogReplicator::SetSnapshotLogPartIndex(uint64_t offset) {
     snapshot_log_part_index_.store(log_part_index, std::memory_order_relaxed);
 }
 
-void LogReplicator::DeleteBinlog() {
+void LogReplicator::DeleteBinlog(uint64_t keep_offset) {
     if (logs_->GetSize() <= 1) {
         DEBUGLOG("log part size is one or less, need not delete");
         return;
     }
     int min_log_index = snapshot_log_part_index_.load(std::memory_order_relaxed);
+    if (keep_offset < snapshot_last_offset_.load(std::memory_order_relaxed)) {
+        ::openmldb::log::LogReader log_reader(logs_, log_path_, false);
+        log_reader.SetOffset(keep_offset);
+        log_reader.RollRLogFile();
+        int keep_log_index = log_reader.GetLogIndex();
+        if (keep_log_index < min_log_index) {
+            DEBUGLOG("keep offset %lu in log index %d", keep_offset, keep_log_index);
+            min_log_index = keep_log_index;
+        }
+    }
     {
         std::lock_guard<bthread::Mutex> lock(mu_);
         for (auto iter = nodes_.begin(); iter != nodes_.end(); ++iter) {
@@ -430,30 +464,108 @@ bool LogReplicator::DelAllReplicateNode() {
     return true;
 }
 
-bool LogReplicator::AppendEntry(LogEntry& entry) {
-    std::lock_guard<std::mutex> lock(wmu_);
-    if (wh_ == NULL || wh_->GetSize() / (1024 * 1024) > (uint32_t)FLAGS_binlog_single_file_max_size) {
-        bool ok = RollWLogFile();
-        if (!ok) {
-            return false;
+bool LogReplicator::AppendEntry(LogEntry& entry) { return GroupCommit(&entry, 1); }
+
+bool LogReplicator::AppendEntryBatch(std::vector<LogEntry>* entries) {
+    if (entries == NULL || entries->empty()) {
+        return true;
+    }
+    return GroupCommit(entries->data(), entries->size());
+}
+
+bool LogReplicator::GroupCommit(LogEntry* entries, uint32_t cnt) {
+    Writer w(entries, cnt);
+    std::unique_lock<bthread::Mutex> lock(commit_mu_);
+    writers_.push_back(&w);
+    while (!w.done && &w != writers_.front()) {
+        commit_cv_.wait(lock);
+    }
+    if (w.done) {
+        return w.ok;
+    }
+    // the current writer is the leader of this group
+    std::vector<Writer*> group;
+    uint32_t entry_cnt = 0;
+    for (auto* writer : writers_) {
+        if (!group.empty() && entry_cnt + writer->cnt > FLAGS_binlog_group_commit_max_size) {
+            break;
         }
+        group.push_back(writer);
+        entry_cnt += writer->cnt;
     }
-    uint64_t cur_offset = log_offset_.load(std::memory_order_relaxed);
-    entry.set_log_index(1 + cur_offset);
+    lock.unlock();
+    uint64_t start_time = ::baidu::common::timer::get_micros();
+    {
+        std::lock_guard<std::mutex> wlock(wmu_);
+        WriteGroup(group);
+    }
+    g_group_commit_latency << ::baidu::common::timer::get_micros() - start_time;
+    g_group_commit_size << entry_cnt;
+    lock.lock();
+    for (size_t i = 0; i < group.size(); i++) {
+        writers_.front()->done = true;
+        writers_.pop_front();
+    }
+    // wake up the writers of this group and the leader of next group
+    commit_cv_.notify_all();
+    return w.ok;
+}
+
+void LogReplicator::WriteGroup(const std::vector<Writer*>& group) {
     std::string buffer;
-    entry.SerializeToString(&buffer);
-    ::openmldb::base::Slice slice(buffer);
-    ::openmldb::log::Status status = wh_->Write(slice);
-    if (!status.ok()) {
-        PDLOG(WARNING, "fail to write replication log in dir %s for %s", path_.c_str(), status.ToString().c_str());
-        return false;
+    uint64_t written_cnt = 0;
+    for (auto* writer : group) {
+        // a failed write fails the entries of its writer only, the other
+        // writers of the group are independent and still written
+        writer->ok = true;
+        for (uint32_t i = 0; i < writer->cnt; i++) {
+            if (wh_ == NULL || wh_->GetSize() / (1024 * 1024) > (uint32_t)FLAGS_binlog_single_file_max_size) {
+                if (!RollWLogFile()) {
+                    writer->ok = false;
+                    break;
+                }
+            }
+            LogEntry& entry = writer->entries[i];
+            uint64_t cur_offset = log_offset_.load(std::memory_order_relaxed);
+            entry.set_log_index(1 + cur_offset);
+            buffer.clear();
+            entry.SerializeToString(&buffer);
+            ::openmldb::base::Slice slice(buffer);
+            ::openmldb::log::Status status = wh_->Write(slice);
+            if (!status.ok()) {
+                PDLOG(WARNING, "fail to write replication log in dir %s for %s", path_.c_str(),
+                      status.ToString().c_str());
+                writer->ok = false;
+                break;
+            }
+            log_offset_.fetch_add(1, std::memory_order_relaxed);
+            written_cnt++;
+            if (local_endpoints_.empty()) {  // if local replica are dead, leader direct
+                                             // sync to remote replica
+                follower_offset_.store(cur_offset + 1, std::memory_order_relaxed);
+            }
+        }
     }
-    log_offset_.fetch_add(1, std::memory_order_relaxed);
-    if (local_endpoints_.empty()) {  // if local replica are dead, leader direct
-                                     // sync to remote replica
-        follower_offset_.store(cur_offset + 1, std::memory_order_relaxed);
+    unsynced_cnt_ += written_cnt;
+    bool need_sync = false;
+    if (FLAGS_binlog_durability_mode == kBinlogSyncByGroup) {
+        need_sync = written_cnt > 0;
+    } else if (FLAGS_binlog_durability_mode == kBinlogSyncByBatch) {
+        need_sync = unsynced_cnt_ >= FLAGS_binlog_fsync_batch_size;
+    }
+    if (need_sync && wh_ != NULL) {
+        ::openmldb::log::Status status = wh_->Sync();
+        if (!status.ok()) {
+            PDLOG(WARNING, "fail to sync data for path %s", path_.c_str());
+            if (FLAGS_binlog_durability_mode == kBinlogSyncByGroup) {
+                for (auto* writer : group) {
+                    writer->ok = false;
+                }
+            }
+        } else {
+            unsynced_cnt_ = 0;
+        }
     }
-    return true;
 }
 
 bool LogReplicator::RollWLogFile() {
@@ -481,5 +593,19 @@ bool LogReplicator::RollWLogFile() {
 
 void LogReplicator::Notify() { cv_.notify_all(); }
 
+void LogReplicator::SetLeaderOffset(uint64_t offset) {
+    leader_offset_.store(offset, std::memory_order_relaxed);
+    leader_offset_time_.store(::baidu::common::timer::get_micros() / 1000, std::memory_order_relaxed);
+}
+
+bool LogReplicator::GetLeaderOffset(uint64_t* offset, uint64_t max_silent_ms) const {
+    *offset = leader_offset_.load(std::memory_order_relaxed);
+    if (*offset == UINT64_MAX) {
+        return false;
+    }
+    uint64_t cur_time = ::baidu::common::timer::get_micros() / 1000;
+    return cur_time <= leader_offset_time_.load(std::memory_order_relaxed) + max_silent_ms;
+}
+
 }  // namespace replica
 }  // namespace openmldb
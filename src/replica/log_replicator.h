@@ -19,6 +19,8 @@
 
 #include <atomic>
 #include <condition_variable>  // NOLINT
+#include <cstdint>
+#include <deque>
 #include <map>
 #include <memory>
 #include <mutex>  // NOLINT
@@ -48,6 +50,8 @@ using ::openmldb::storage::Table;
 
 enum ReplicatorRole { kLeaderNode = 1, kFollowerNode };
 
+enum BinlogDurabilityMode { kBinlogSyncByTimer = 0, kBinlogSyncByBatch = 1, kBinlogSyncByGroup = 2 };
+
 class LogReplicator {
  public:
     LogReplicator(uint32_t tid, uint32_t pid, const std::string& path,
@@ -66,6 +70,10 @@ class LogReplicator {
     // the master node append entry
     bool AppendEntry(::openmldb::api::LogEntry& entry);  // NOLINT
 
+    // the master node append entries with one write lock, log index is
+    // assigned to every entry in order
+    bool AppendEntryBatch(std::vector<::openmldb::api::LogEntry>* entries);
+
     //  data to slave nodes
     void Notify();
     // recover logs meta
@@ -73,7 +81,9 @@ class LogReplicator {
 
     bool RollWLogFile();
 
-    void DeleteBinlog();
+    // delete the log parts covered by snapshot and all followers, the part
+    // holding keep_offset and the ones after it are kept
+    void DeleteBinlog(uint64_t keep_offset = UINT64_MAX);
 
     // add replication
     int AddReplicateNode(const std::map<std::string, std::string>& real_ep_map);
@@ -96,7 +106,16 @@ class LogReplicator {
 
     LogParts* GetLogPart();
 
+    inline const std::string& GetLogPath() const { return log_path_; }
+
     inline uint64_t GetLogOffset() { return log_offset_.load(std::memory_order_relaxed); }
+
+    // the follower records the log offset of the leader sent with the entries
+    // and the heartbeats, together with the time it is received
+    void SetLeaderOffset(uint64_t offset);
+    // return false if the follower has not heard from the leader since started
+    // or within the last max_silent_ms
+    bool GetLeaderOffset(uint64_t* offset, uint64_t max_silent_ms) const;
     void SetRole(const ReplicatorRole& role);
 
     uint64_t GetLeaderTerm();
@@ -111,6 +130,13 @@ class LogReplicator {
  private:
     bool OpenSeqFile(const std::string& path, SequentialFile** sf);
 
+    struct Writer;
+    // append entries through the group commit queue, the first writer in the
+    // queue writes the entries of all waiting writers and wakes them up
+    bool GroupCommit(::openmldb::api::LogEntry* entries, uint32_t cnt);
+    // write one group to binlog, must hold wmu_
+    void WriteGroup(const std::vector<Writer*>& group);
+
  private:
     // the replicator root data path
     uint32_t tid_;
@@ -120,6 +146,10 @@ class LogReplicator {
     // the term for leader judgement
     std::atomic<uint64_t> log_offset_;
     std::atomic<uint64_t> follower_offset_;
+    // the latest log offset of the leader known by the follower
+    std::atomic<uint64_t> leader_offset_;
+    // the time in ms the leader offset is received
+    std::atomic<uint64_t> leader_offset_time_;
     std::atomic<uint32_t> binlog_index_;
     LogParts* logs_;
     WriteHandle* wh_;
@@ -137,6 +167,13 @@ class LogReplicator {
     std::atomic<uint64_t> snapshot_last_offset_;
 
     std::mutex wmu_;
+    // the count of entries written since last sync, guarded by wmu_
+    uint64_t unsynced_cnt_;
+
+    // group commit queue
+    bthread::Mutex commit_mu_;
+    bthread::ConditionVariable commit_cv_;
+    std::deque<Writer*> writers_;
 };
 
 }  // namespace replica
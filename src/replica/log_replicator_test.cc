@@ -17,6 +17,7 @@
 #include "replica/log_replicator.h"
 
 #include <brpc/server.h>
+#include <gflags/gflags.h>
 #include <gtest/gtest.h>
 #include <sched.h>
 #include <stdio.h>
@@ -24,7 +25,9 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <thread>  // NOLINT
 #include <utility>
+#include <vector>
 
 #include "base/glog_wapper.h"
 #include "base/status.h"
@@ -46,6 +49,8 @@ using ::openmldb::storage::Table;
 using ::openmldb::storage::TableIterator;
 using ::openmldb::storage::Ticket;
 
+DECLARE_uint32(binlog_durability_mode);
+
 namespace openmldb {
 namespace replica {
 
@@ -132,6 +137,24 @@ TEST_F(LogReplicatorTest, Init) {
     ASSERT_TRUE(ok);
 }
 
+TEST_F(LogReplicatorTest, LeaderOffset) {
+    std::map<std::string, std::string> map;
+    std::string folder = "/tmp/" + GenRand() + "/";
+    LogReplicator replicator(1, 1, folder, map, kFollowerNode);
+    ASSERT_TRUE(replicator.Init());
+    uint64_t offset = 0;
+    ASSERT_FALSE(replicator.GetLeaderOffset(&offset, 1000));
+    replicator.SetLeaderOffset(10);
+    ASSERT_TRUE(replicator.GetLeaderOffset(&offset, 1000));
+    ASSERT_EQ(10u, offset);
+    // the leader is not heard for a while
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    ASSERT_FALSE(replicator.GetLeaderOffset(&offset, 10));
+    replicator.SetLeaderOffset(11);
+    ASSERT_TRUE(replicator.GetLeaderOffset(&offset, 10));
+    ASSERT_EQ(11u, offset);
+}
+
 TEST_F(LogReplicatorTest, BenchMark) {
     std::map<std::string, std::string> map;
     std::string folder = "/tmp/" + GenRand() + "/";
@@ -147,6 +170,44 @@ TEST_F(LogReplicatorTest, BenchMark) {
     ASSERT_TRUE(ok);
 }
 
+TEST_F(LogReplicatorTest, ConcurrentAppend) {
+    std::map<std::string, std::string> map;
+    std::string folder = "/tmp/" + GenRand() + "/";
+    LogReplicator replicator(1, 1, folder, map, kLeaderNode);
+    ASSERT_TRUE(replicator.Init());
+    // restore the flags even if an assertion returns early
+    ::google::FlagSaver flag_saver;
+    FLAGS_binlog_durability_mode = kBinlogSyncByGroup;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; i++) {
+        threads.emplace_back([&replicator, i] {
+            for (int j = 0; j < 100; j++) {
+                ::openmldb::api::LogEntry entry;
+                entry.set_term(1);
+                entry.set_pk("test" + std::to_string(i));
+                entry.set_value("test");
+                entry.set_ts(9527 + j);
+                ASSERT_TRUE(replicator.AppendEntry(entry));
+            }
+            std::vector<::openmldb::api::LogEntry> entries(10);
+            for (auto& entry : entries) {
+                entry.set_term(1);
+                entry.set_pk("batch" + std::to_string(i));
+                entry.set_value("test");
+                entry.set_ts(9527);
+            }
+            ASSERT_TRUE(replicator.AppendEntryBatch(&entries));
+            for (size_t k = 1; k < entries.size(); k++) {
+                ASSERT_EQ(entries[k - 1].log_index() + 1, entries[k].log_index());
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    ASSERT_EQ(8 * 110u, replicator.GetOffset());
+}
+
 TEST_F(LogReplicatorTest, LeaderAndFollowerMulti) {
     brpc::ServerOptions options;
     brpc::Server server0;
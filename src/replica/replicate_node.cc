@@ -22,8 +22,10 @@
 
 #include "base/glog_wapper.h"  // NOLINT
 #include "base/strings.h"
+#include "common/timer.h"
 
 DECLARE_int32(binlog_sync_batch_size);
+DECLARE_int32(binlog_heartbeat_interval);
 DECLARE_int32(binlog_sync_wait_time);
 DECLARE_int32(binlog_coffee_time);
 DECLARE_int32(binlog_match_logoffset_interval);
@@ -66,7 +68,8 @@ ReplicateNode::ReplicateNode(const std::string& point, LogParts* logs, const std
       cv_(cv),
       go_back_cnt_(0),
       rep_node_(rep_follower),
-      follower_offset_(follower_offset) {
+      follower_offset_(follower_offset),
+      last_send_time_(0) {
     if (!real_point.empty()) {
         rpc_client_ = openmldb::RpcClient<::openmldb::api::TabletServer_Stub>(real_point);
     }
@@ -114,6 +117,7 @@ void ReplicateNode::SyncData() {
             bthread_usleep(coffee_time * 1000);
             coffee_time = 0;
         }
+        bool heartbeat = false;
         {
             std::unique_lock<bthread::Mutex> lock(*mu_);
             // no new data append and wait
@@ -126,8 +130,19 @@ void ReplicateNode::SyncData() {
                           endpoint_.c_str(), tid_, pid_);
                     return;
                 }
+                // the follower reading locally needs the leader offset even if no data
+                if (FLAGS_binlog_heartbeat_interval > 0 && last_sync_offset_ > 0 &&
+                    ::baidu::common::timer::get_micros() / 1000 >=
+                        last_send_time_ + FLAGS_binlog_heartbeat_interval) {
+                    heartbeat = true;
+                    break;
+                }
             }
         }
+        if (heartbeat) {
+            SendHeartbeat();
+            continue;
+        }
         int ret;
         if (rep_node_.load(std::memory_order_relaxed)) {
             ret = SyncData(follower_offset_->load(std::memory_order_relaxed));
@@ -157,6 +172,7 @@ int ReplicateNode::MatchLogOffsetFromNode() {
     request.set_pid(pid_);
     request.set_term(term_->load(std::memory_order_relaxed));
     request.set_pre_log_index(0);
+    request.set_leader_offset(leader_log_offset_->load(std::memory_order_relaxed));
     ::openmldb::api::AppendEntriesResponse response;
     bool ret = rpc_client_.SendRequest(&::openmldb::api::TabletServer_Stub::AppendEntries, &request, &response,
                                        FLAGS_request_timeout_ms, FLAGS_request_max_retry);
@@ -172,6 +188,25 @@ int ReplicateNode::MatchLogOffsetFromNode() {
     return -1;
 }
 
+void ReplicateNode::SendHeartbeat() {
+    ::openmldb::api::AppendEntriesRequest request;
+    request.set_tid(tid_);
+    request.set_pid(pid_);
+    request.set_pre_log_index(last_sync_offset_);
+    if (!FLAGS_zk_cluster.empty()) {
+        request.set_term(term_->load(std::memory_order_relaxed));
+    }
+    request.set_leader_offset(leader_log_offset_->load(std::memory_order_relaxed));
+    ::openmldb::api::AppendEntriesResponse response;
+    // the next heartbeat is sent after the interval whether this one succeeds or not
+    last_send_time_ = ::baidu::common::timer::get_micros() / 1000;
+    bool ret = rpc_client_.SendRequest(&::openmldb::api::TabletServer_Stub::AppendEntries, &request, &response,
+                                       FLAGS_request_timeout_ms, 1);
+    if (!ret || response.code() != 0) {
+        DEBUGLOG("fail to send heartbeat to node %s. tid %u pid %u", endpoint_.c_str(), tid_, pid_);
+    }
+}
+
 int ReplicateNode::SyncData(uint64_t log_offset) {
     DEBUGLOG("node[%s] offset[%lu] log offset[%lu]", endpoint_.c_str(), last_sync_offset_, log_offset);
     if (log_offset <= last_sync_offset_) {
@@ -270,11 +305,13 @@ int ReplicateNode::SyncData(uint64_t log_offset) {
         }
     }
     if (request.entries_size() > 0) {
+        request.set_leader_offset(log_offset);
         bool ret = rpc_client_.SendRequest(&::openmldb::api::TabletServer_Stub::AppendEntries, &request, &response,
                                            FLAGS_request_timeout_ms, FLAGS_request_max_retry);
         if (ret && response.code() == 0) {
             DEBUGLOG("sync log to node[%s] to offset %lld", endpoint_.c_str(), sync_log_offset);
             last_sync_offset_ = sync_log_offset;
+            last_send_time_ = ::baidu::common::timer::get_micros() / 1000;
             if (!rep_node_.load(std::memory_order_relaxed) &&
                 (last_sync_offset_ > follower_offset_->load(std::memory_order_relaxed))) {
                 follower_offset_->store(last_sync_offset_, std::memory_order_relaxed);
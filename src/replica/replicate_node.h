@@ -71,6 +71,8 @@ class ReplicateNode {
 
  private:
     int MatchLogOffsetFromNode();
+    // send the log offset of leader without entries to an idle follower
+    void SendHeartbeat();
 
  private:
     LogReader log_reader_;
@@ -90,6 +92,7 @@ class ReplicateNode {
     uint32_t go_back_cnt_;
     std::atomic<bool> rep_node_;
     std::atomic<uint64_t>* follower_offset_;  // max local cluster follower offset
+    uint64_t last_send_time_;                 // the time in ms entries or heartbeat is sent
 };
 
 }  // namespace replica
@@ -412,6 +412,27 @@ std::shared_ptr<::openmldb::catalog::TabletAccessor> DBSDK::GetTablet(const std:
     return {};
 }
 
+std::shared_ptr<::openmldb::catalog::TabletAccessor> DBSDK::GetReadTablet(const std::string& db,
+                                                                          const std::string& name,
+                                                                          const std::string& pk, uint32_t* pid) {
+    auto table_handler = GetCatalog()->GetTable(db, name);
+    if (table_handler) {
+        auto sdk_table_handler = dynamic_cast<::openmldb::catalog::SDKTableHandler*>(table_handler.get());
+        if (sdk_table_handler) {
+            uint32_t pid_num = sdk_table_handler->GetPartitionNum();
+            uint32_t read_pid = 0;
+            if (pid_num > 0) {
+                read_pid = pk.empty() ? rand_.Uniform(pid_num) : ::openmldb::base::hash64(pk) % pid_num;
+            }
+            if (pid != nullptr) {
+                *pid = read_pid;
+            }
+            return sdk_table_handler->GetReadTablet(read_pid);
+        }
+    }
+    return {};
+}
+
 std::shared_ptr<hybridse::sdk::ProcedureInfo> DBSDK::GetProcedureInfo(const std::string& db, const std::string& sp_name,
                                                                       std::string* msg) {
     if (msg == nullptr) {
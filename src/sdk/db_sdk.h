@@ -118,6 +118,10 @@ class DBSDK {
                                                                    uint32_t pid);
     std::shared_ptr<::openmldb::catalog::TabletAccessor> GetTablet(const std::string& db, const std::string& name,
                                                                    const std::string& pk);
+    // get the leader or a follower to read the partition of pk, or of a random partition if pk is empty.
+    // the partition is returned by pid if it is not null
+    std::shared_ptr<::openmldb::catalog::TabletAccessor> GetReadTablet(const std::string& db, const std::string& name,
+                                                                       const std::string& pk, uint32_t* pid = nullptr);
 
     std::shared_ptr<hybridse::sdk::ProcedureInfo> GetProcedureInfo(const std::string& db, const std::string& sp_name,
                                                                    std::string* msg);
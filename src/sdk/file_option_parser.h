@@ -145,7 +145,39 @@ class FileOptionsParser {
 
 class ReadFileOptionsParser : public FileOptionsParser {
  public:
-    ReadFileOptionsParser() { quote_ = '\0'; }
+    ReadFileOptionsParser() {
+        quote_ = '\0';
+        check_map_.emplace("thread", std::make_pair(CheckThread(), hybridse::node::kInt32));
+        check_map_.emplace("max_errors", std::make_pair(CheckMaxErrors(), hybridse::node::kInt32));
+    }
+    // the count of threads to parse and put rows
+    uint32_t GetThread() const { return thread_; }
+    // the max count of lines failed to be loaded before stop loading
+    uint32_t GetMaxErrors() const { return max_errors_; }
+
+ private:
+    uint32_t thread_ = 1;
+    uint32_t max_errors_ = 0;
+    std::function<bool(const hybridse::node::ConstNode* node)> CheckThread() {
+        return [this](const hybridse::node::ConstNode* node) {
+            int32_t thread = node->GetAsInt32();
+            if (thread <= 0) {
+                return false;
+            }
+            thread_ = thread;
+            return true;
+        };
+    }
+    std::function<bool(const hybridse::node::ConstNode* node)> CheckMaxErrors() {
+        return [this](const hybridse::node::ConstNode* node) {
+            int32_t max_errors = node->GetAsInt32();
+            if (max_errors < 0) {
+                return false;
+            }
+            max_errors_ = max_errors;
+            return true;
+        };
+    }
 };
 
 class WriteFileOptionsParser : public FileOptionsParser {
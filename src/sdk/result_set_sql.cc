@@ -155,5 +155,157 @@ std::shared_ptr<::hybridse::sdk::ResultSet> ResultSetSQL::MakeResultSet(
     return {};
 }
 
+int QueryStreamReceiver::on_received_messages(brpc::StreamId id, butil::IOBuf* const messages[], size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        butil::IOBuf* message = messages[i];
+        uint32_t meta_size = 0;
+        ::openmldb::api::QueryStreamMeta meta;
+        std::string meta_buf;
+        if (message->cutn(&meta_size, sizeof(meta_size)) != sizeof(meta_size) ||
+            message->cutn(&meta_buf, meta_size) != meta_size || !meta.ParseFromString(meta_buf)) {
+            LOG(WARNING) << "fail to parse message of stream " << id;
+            std::lock_guard<bthread::Mutex> lock(mu_);
+            code_ = -1;
+            msg_ = "invalid stream message";
+            finished_ = true;
+            cv_.notify_all();
+            return 0;
+        }
+        std::lock_guard<bthread::Mutex> lock(mu_);
+        if (meta.is_finish()) {
+            finished_ = true;
+            count_ = meta.count();
+            code_ = meta.code();
+            msg_ = meta.msg();
+            cv_.notify_all();
+            continue;
+        }
+        if (cancelled_) {
+            return 0;
+        }
+        chunks_.emplace_back();
+        chunks_.back().rows.swap(*message);
+        chunks_.back().count = meta.count();
+        cv_.notify_all();
+    }
+    return 0;
+}
+
+void QueryStreamReceiver::on_idle_timeout(brpc::StreamId id) {
+    {
+        std::lock_guard<bthread::Mutex> lock(mu_);
+        // the server waits for the chunks kept here to be consumed
+        if (finished_ || !chunks_.empty()) {
+            return;
+        }
+        code_ = -1;
+        msg_ = "stream query is timeout";
+    }
+    LOG(WARNING) << "stream " << id << " is idle timeout";
+    brpc::StreamClose(id);
+}
+
+void QueryStreamReceiver::on_closed(brpc::StreamId id) {
+    std::lock_guard<bthread::Mutex> lock(mu_);
+    if (!finished_ && code_ == 0) {
+        code_ = -1;
+        msg_ = "stream is closed before finished";
+    }
+    closed_ = true;
+    cv_.notify_all();
+}
+
+bool QueryStreamReceiver::Pop(brpc::StreamId id, butil::IOBuf* rows, uint32_t* count) {
+    {
+        std::unique_lock<bthread::Mutex> lock(mu_);
+        while (chunks_.empty() && !finished_ && !closed_ && !cancelled_) {
+            cv_.wait(lock);
+        }
+        if (chunks_.empty()) {
+            return false;
+        }
+        rows->swap(chunks_.front().rows);
+        *count = chunks_.front().count;
+        chunks_.pop_front();
+        if (finished_ || closed_) {
+            return true;
+        }
+    }
+    uint32_t credit = 1;
+    butil::IOBuf message;
+    message.append(&credit, sizeof(credit));
+    if (brpc::StreamWrite(id, message) != 0) {
+        DLOG(WARNING) << "fail to grant stream " << id;
+    }
+    return true;
+}
+
+void QueryStreamReceiver::Cancel() {
+    std::lock_guard<bthread::Mutex> lock(mu_);
+    cancelled_ = true;
+    chunks_.clear();
+    cv_.notify_all();
+}
+
+void QueryStreamReceiver::WaitClosed() {
+    std::unique_lock<bthread::Mutex> lock(mu_);
+    while (!closed_) {
+        cv_.wait(lock);
+    }
+}
+
+void QueryStreamReceiver::GetStatus(::hybridse::sdk::Status* status) {
+    std::lock_guard<bthread::Mutex> lock(mu_);
+    status->code = code_;
+    status->msg = msg_;
+}
+
+StreamResultSetSQL::StreamResultSetSQL(const ::hybridse::vm::Schema& schema, brpc::StreamId stream_id,
+                                       std::unique_ptr<QueryStreamReceiver> receiver)
+    : schema_(schema), sdk_schema_(schema), stream_id_(stream_id), receiver_(std::move(receiver)), rows_(),
+      result_set_base_() {}
+
+StreamResultSetSQL::~StreamResultSetSQL() {
+    receiver_->Cancel();
+    brpc::StreamClose(stream_id_);
+    // the receiver is used by the stream until it is closed
+    receiver_->WaitClosed();
+}
+
+std::shared_ptr<::hybridse::sdk::ResultSet> StreamResultSetSQL::MakeResultSet(
+    const std::shared_ptr<::openmldb::api::QueryResponse>& response, brpc::StreamId stream_id,
+    std::unique_ptr<QueryStreamReceiver> receiver, ::hybridse::sdk::Status* status) {
+    if (!status || !response || !receiver) {
+        return std::shared_ptr<ResultSet>();
+    }
+    ::hybridse::vm::Schema schema;
+    bool ok = ::hybridse::codec::SchemaCodec::Decode(response->schema(), &schema);
+    auto rs = std::make_shared<StreamResultSetSQL>(schema, stream_id, std::move(receiver));
+    if (!ok) {
+        status->code = -1;
+        status->msg = "request error, fail to decodec schema";
+        return std::shared_ptr<ResultSet>();
+    }
+    return rs;
+}
+
+bool StreamResultSetSQL::Next() {
+    while (!result_set_base_ || !result_set_base_->Next()) {
+        uint32_t count = 0;
+        rows_.clear();
+        if (!receiver_->Pop(stream_id_, &rows_, &count)) {
+            ::hybridse::sdk::Status status;
+            receiver_->GetStatus(&status);
+            if (!status.IsOK()) {
+                LOG(WARNING) << "fail to read stream query: " << status.msg;
+            }
+            return false;
+        }
+        std::unique_ptr<::hybridse::sdk::RowIOBufView> row_view(new ::hybridse::sdk::RowIOBufView(schema_));
+        result_set_base_.reset(new ResultSetBase(&rows_, count, rows_.size(), std::move(row_view), schema_));
+    }
+    return true;
+}
+
 }  // namespace sdk
 }  // namespace openmldb
@@ -17,11 +17,15 @@
 #ifndef SRC_SDK_RESULT_SET_SQL_H_
 #define SRC_SDK_RESULT_SET_SQL_H_
 
+#include <deque>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "brpc/controller.h"
+#include "brpc/stream.h"
+#include "bthread/condition_variable.h"
+#include "bthread/mutex.h"
 #include "butil/iobuf.h"
 #include "proto/tablet.pb.h"
 #include "sdk/base_impl.h"
@@ -213,6 +217,124 @@ class MultipleResultSetSQL : public ::hybridse::sdk::ResultSet {
     uint32_t result_idx_;
     std::shared_ptr<ResultSetSQL> result_set_base_;
 };
+// QueryStreamReceiver keeps the chunks of stream query until they are
+// consumed. The server sends at most max_chunk_cnt chunks ahead, and one more
+// every time a chunk is consumed, so the messages are never blocked here
+class QueryStreamReceiver : public brpc::StreamInputHandler {
+ public:
+    explicit QueryStreamReceiver(uint32_t max_chunk_cnt)
+        : max_chunk_cnt_(max_chunk_cnt), finished_(false), closed_(false), cancelled_(false), count_(0), code_(0) {}
+    ~QueryStreamReceiver() {}
+
+    int on_received_messages(brpc::StreamId id, butil::IOBuf* const messages[], size_t size) override;
+    void on_idle_timeout(brpc::StreamId id) override;
+    void on_closed(brpc::StreamId id) override;
+
+    // wait for the next chunk and grant the server to send one more by stream
+    // id, return false if all of the chunks are consumed or the stream fails
+    bool Pop(brpc::StreamId id, butil::IOBuf* rows, uint32_t* count);
+
+    // stop receiving the chunks not consumed
+    void Cancel();
+
+    void WaitClosed();
+
+    // the total count of rows, valid after the stream is finished
+    inline uint32_t GetCount() {
+        std::lock_guard<bthread::Mutex> lock(mu_);
+        return finished_ ? count_ : 0;
+    }
+
+    inline bool IsFinished() {
+        std::lock_guard<bthread::Mutex> lock(mu_);
+        return finished_;
+    }
+
+    void GetStatus(::hybridse::sdk::Status* status);
+
+    // the count of chunks the server may send ahead of consuming
+    inline uint32_t GetMaxChunkCnt() const { return max_chunk_cnt_; }
+
+ private:
+    struct Chunk {
+        butil::IOBuf rows;
+        uint32_t count;
+    };
+    uint32_t max_chunk_cnt_;
+    bthread::Mutex mu_;
+    bthread::ConditionVariable cv_;
+    std::deque<Chunk> chunks_;
+    bool finished_;
+    bool closed_;
+    bool cancelled_;
+    uint32_t count_;
+    int32_t code_;
+    std::string msg_;
+};
+
+// StreamResultSetSQL reads the rows of stream query lazily, it can be
+// iterated once and Size is -1 until all of the rows are read
+class StreamResultSetSQL : public ::hybridse::sdk::ResultSet {
+ public:
+    StreamResultSetSQL(const ::hybridse::vm::Schema& schema, brpc::StreamId stream_id,
+                       std::unique_ptr<QueryStreamReceiver> receiver);
+
+    ~StreamResultSetSQL();
+
+    static std::shared_ptr<::hybridse::sdk::ResultSet> MakeResultSet(
+        const std::shared_ptr<::openmldb::api::QueryResponse>& response, brpc::StreamId stream_id,
+        std::unique_ptr<QueryStreamReceiver> receiver, ::hybridse::sdk::Status* status);
+
+    bool Reset() override { return false; }
+
+    bool Next() override;
+
+    bool IsNULL(int index) override { return result_set_base_->IsNULL(index); }
+
+    bool GetString(uint32_t index, std::string* str) override { return result_set_base_->GetString(index, str); }
+
+    bool GetBool(uint32_t index, bool* result) override { return result_set_base_->GetBool(index, result); }
+
+    bool GetChar(uint32_t index, char* result) override { return result_set_base_->GetChar(index, result); }
+
+    bool GetInt16(uint32_t index, int16_t* result) override { return result_set_base_->GetInt16(index, result); }
+
+    bool GetInt32(uint32_t index, int32_t* result) override { return result_set_base_->GetInt32(index, result); }
+
+    bool GetInt64(uint32_t index, int64_t* result) override { return result_set_base_->GetInt64(index, result); }
+
+    bool GetFloat(uint32_t index, float* result) override { return result_set_base_->GetFloat(index, result); }
+
+    bool GetDouble(uint32_t index, double* result) override { return result_set_base_->GetDouble(index, result); }
+
+    bool GetDate(uint32_t index, int32_t* date) override { return result_set_base_->GetDate(index, date); }
+
+    bool GetDate(uint32_t index, int32_t* year, int32_t* month, int32_t* day) override {
+        return result_set_base_->GetDate(index, year, month, day);
+    }
+
+    bool GetTime(uint32_t index, int64_t* mills) override { return result_set_base_->GetTime(index, mills); }
+
+    const ::hybridse::sdk::Schema* GetSchema() override { return &sdk_schema_; }
+
+    int32_t Size() override {
+        return receiver_->IsFinished() ? static_cast<int32_t>(receiver_->GetCount()) : -1;
+    }
+
+    // not ok if the server fails to run the query, the stream is closed or
+    // timeout before all of the rows are received
+    void GetStatus(::hybridse::sdk::Status* status) override { receiver_->GetStatus(status); }
+
+ private:
+    ::hybridse::vm::Schema schema_;
+    ::hybridse::sdk::SchemaImpl sdk_schema_;
+    brpc::StreamId stream_id_;
+    std::unique_ptr<QueryStreamReceiver> receiver_;
+    // the rows of the chunk being read
+    butil::IOBuf rows_;
+    std::unique_ptr<ResultSetBase> result_set_base_;
+};
+
 }  // namespace sdk
 }  // namespace openmldb
 #endif  // SRC_SDK_RESULT_SET_SQL_H_
@@ -17,12 +17,21 @@
 #include "sdk/sql_cluster_router.h"
 
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <deque>
 #include <fstream>
+#include <map>
 #include <memory>
+#include <mutex>  // NOLINT
+#include <set>
 #include <string>
+#include <thread>  // NOLINT
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
+#include "absl/strings/numbers.h"
 #include "absl/strings/str_cat.h"
 #include "base/ddl_parser.h"
 #include "base/file_util.h"
@@ -183,6 +192,221 @@ class BatchQueryFutureImpl : public QueryFuture {
     openmldb::RpcCallback<openmldb::api::SQLBatchRequestQueryResponse>* callback_;
 };
 
+// InsertFutureImpl puts the rows of one insert with PutBatch rpcs grouped by
+// partition. At most max_inflight requests are in flight, a new request waits
+// for the oldest one if the window is full. Rows sent to the tablets without
+// PutBatch rpc fall back to Put rpc. It is not thread safe.
+class InsertFutureImpl : public InsertFuture {
+ public:
+    InsertFutureImpl(uint32_t tid, uint32_t row_cnt, uint32_t max_batch_rows, uint32_t max_inflight,
+                     uint64_t timeout_ms)
+        : tid_(tid),
+          row_failed_(row_cnt, false),
+          max_batch_rows_(std::max(max_batch_rows, 1u)),
+          max_inflight_(std::max(max_inflight, 1u)),
+          timeout_ms_(timeout_ms) {}
+
+    ~InsertFutureImpl() override {
+        for (auto& pending : pending_) {
+            if (pending.batch_callback) {
+                pending.batch_callback->UnRef();
+            }
+            if (pending.put_callback) {
+                pending.put_callback->UnRef();
+            }
+        }
+    }
+
+    // add the dimensions of row idx in partition pid, the rows of one
+    // partition are sent once max_batch_rows are collected
+    void Put(uint32_t idx, uint32_t pid, const std::shared_ptr<::openmldb::client::TabletClient>& client,
+             uint64_t time, const std::string& value, const std::vector<std::pair<std::string, uint32_t>>& dimensions) {
+        auto& batch = batches_[pid];
+        if (!batch.request) {
+            batch.client = client;
+            batch.request = std::make_shared<::openmldb::api::PutBatchRequest>();
+            batch.request->set_tid(tid_);
+            batch.request->set_pid(pid);
+        }
+        auto row = batch.request->add_rows();
+        row->set_time(time);
+        row->set_value(value);
+        row->set_format_version(1);
+        for (const auto& dim : dimensions) {
+            auto d = row->add_dimensions();
+            d->set_key(dim.first);
+            d->set_idx(dim.second);
+        }
+        batch.row_idx.push_back(idx);
+        if (batch.row_idx.size() >= max_batch_rows_) {
+            Send(std::move(batch));
+            batches_.erase(pid);
+        }
+    }
+
+    // send the rows left in batches
+    void Flush() {
+        for (auto& kv : batches_) {
+            Send(std::move(kv.second));
+        }
+        batches_.clear();
+    }
+
+    void SetFailed(uint32_t idx, const std::string& msg) {
+        if (idx < row_failed_.size()) {
+            row_failed_[idx] = true;
+        }
+        error_msg_ = msg;
+    }
+
+    bool Wait(hybridse::sdk::Status* status) override {
+        Flush();
+        while (!pending_.empty()) {
+            WaitOldest();
+        }
+        uint64_t failed_cnt = GetFailedCount();
+        if (failed_cnt == 0) {
+            return true;
+        }
+        if (status) {
+            status->code = 1;
+            status->msg = "Error occur when execute insert, success/total: " +
+                          std::to_string(row_failed_.size() - failed_cnt) + "/" +
+                          std::to_string(row_failed_.size()) + ", " + error_msg_;
+        }
+        return false;
+    }
+
+    uint64_t GetFailedCount() const override {
+        return std::count(row_failed_.begin(), row_failed_.end(), true);
+    }
+
+    bool IsDone() const override {
+        if (!batches_.empty()) {
+            return false;
+        }
+        for (const auto& pending : pending_) {
+            if ((pending.batch_callback && !pending.batch_callback->IsDone()) ||
+                (pending.put_callback && !pending.put_callback->IsDone())) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+ private:
+    struct PendingPut {
+        std::shared_ptr<::openmldb::client::TabletClient> client;
+        std::shared_ptr<::openmldb::api::PutBatchRequest> request;
+        std::vector<uint32_t> row_idx;
+        openmldb::RpcCallback<openmldb::api::PutBatchResponse>* batch_callback = nullptr;
+        // only set if the row is sent with Put rpc
+        openmldb::RpcCallback<openmldb::api::PutResponse>* put_callback = nullptr;
+    };
+
+    std::shared_ptr<brpc::Controller> NewController() {
+        auto cntl = std::make_shared<brpc::Controller>();
+        cntl->set_timeout_ms(timeout_ms_);
+        return cntl;
+    }
+
+    void Send(PendingPut&& batch) {
+        while (pending_.size() >= max_inflight_) {
+            WaitOldest();
+        }
+        if (no_batch_endpoints_.count(batch.client->GetEndpoint()) > 0) {
+            SendPut(batch);
+            return;
+        }
+        batch.batch_callback = new openmldb::RpcCallback<openmldb::api::PutBatchResponse>(
+            std::make_shared<openmldb::api::PutBatchResponse>(), NewController());
+        batch.batch_callback->Ref();
+        if (!batch.client->AsyncPutBatch(*batch.request, batch.batch_callback)) {
+            // the callback will never run
+            batch.batch_callback->UnRef();
+            batch.batch_callback->UnRef();
+            for (auto idx : batch.row_idx) {
+                SetFailed(idx, "fail to send put batch request to " + batch.client->GetEndpoint());
+            }
+            return;
+        }
+        pending_.push_back(std::move(batch));
+    }
+
+    // send each row of batch with Put rpc, batch must not be in pending_
+    void SendPut(const PendingPut& batch) {
+        for (int i = 0; i < batch.request->rows_size(); i++) {
+            // the rows are sent one by one, hold them back by max_inflight_ as batches
+            while (pending_.size() >= max_inflight_) {
+                WaitOldest();
+            }
+            ::openmldb::api::PutRequest request(batch.request->rows(i));
+            request.set_tid(batch.request->tid());
+            request.set_pid(batch.request->pid());
+            PendingPut put;
+            put.client = batch.client;
+            put.row_idx.push_back(batch.row_idx[i]);
+            put.put_callback = new openmldb::RpcCallback<openmldb::api::PutResponse>(
+                std::make_shared<openmldb::api::PutResponse>(), NewController());
+            put.put_callback->Ref();
+            if (!put.client->AsyncPut(request, put.put_callback)) {
+                put.put_callback->UnRef();
+                put.put_callback->UnRef();
+                SetFailed(batch.row_idx[i], "fail to send put request to " + put.client->GetEndpoint());
+                continue;
+            }
+            pending_.push_back(std::move(put));
+        }
+    }
+
+    void WaitOldest() {
+        PendingPut pending = std::move(pending_.front());
+        pending_.pop_front();
+        if (pending.put_callback) {
+            auto cntl = pending.put_callback->GetController();
+            brpc::Join(cntl->call_id());
+            if (cntl->Failed()) {
+                SetFailed(pending.row_idx[0], "request error, " + cntl->ErrorText());
+            } else if (pending.put_callback->GetResponse()->code() != ::openmldb::base::kOk) {
+                SetFailed(pending.row_idx[0], "put error, " + pending.put_callback->GetResponse()->msg());
+            }
+            pending.put_callback->UnRef();
+            return;
+        }
+        auto cntl = pending.batch_callback->GetController();
+        brpc::Join(cntl->call_id());
+        const auto& response = pending.batch_callback->GetResponse();
+        if (cntl->Failed() && cntl->ErrorCode() == brpc::ENOMETHOD) {
+            LOG(INFO) << "PutBatch is not supported by " << pending.client->GetEndpoint() << ", use Put instead";
+            no_batch_endpoints_.insert(pending.client->GetEndpoint());
+            SendPut(pending);
+        } else if (cntl->Failed()) {
+            for (auto idx : pending.row_idx) {
+                SetFailed(idx, "request error, " + cntl->ErrorText());
+            }
+        } else {
+            for (size_t i = 0; i < pending.row_idx.size(); i++) {
+                if (response->code() != ::openmldb::base::kOk || static_cast<int>(i) >= response->row_code_size() ||
+                    response->row_code(i) != ::openmldb::base::kOk) {
+                    SetFailed(pending.row_idx[i], "put error, " + response->msg());
+                }
+            }
+        }
+        pending.batch_callback->UnRef();
+    }
+
+    uint32_t tid_;
+    std::vector<bool> row_failed_;
+    std::string error_msg_;
+    uint32_t max_batch_rows_;
+    uint32_t max_inflight_;
+    uint64_t timeout_ms_;
+    // the rows not sent yet of each partition
+    std::map<uint32_t, PendingPut> batches_;
+    std::deque<PendingPut> pending_;
+    std::set<std::string> no_batch_endpoints_;
+};
+
 SQLClusterRouter::SQLClusterRouter(const SQLRouterOptions& options)
     : options_(options),
       is_cluster_mode_(true),
@@ -875,7 +1099,7 @@ std::shared_ptr<::openmldb::client::TabletClient> SQLClusterRouter::GetTabletCli
 std::shared_ptr<::openmldb::client::TabletClient> SQLClusterRouter::GetTabletClient(
     const std::string& db, const std::string& sql, const ::hybridse::vm::EngineMode engine_mode,
     const std::shared_ptr<SQLRequestRow>& row, const std::shared_ptr<openmldb::sdk::SQLRequestRow>& parameter,
-    hybridse::sdk::Status& status) {
+    hybridse::sdk::Status& status, bool read_follower, int64_t* read_pid) {
     auto cache = GetSQLCache(db, sql, engine_mode, parameter, status);
     if (0 != status.code) {
         return {};
@@ -889,10 +1113,20 @@ std::shared_ptr<::openmldb::client::TabletClient> SQLClusterRouter::GetTabletCli
             DLOG(INFO) << "get main table" << main_table;
             std::string val;
             if (!col.empty() && row && row->GetRecordVal(col, &val)) {
-                tablet = cluster_sdk_->GetTablet(main_db, main_table, val);
+                if (read_follower) {
+                    // the tablet only checks the lag of the partition the request is routed by
+                    uint32_t pid = 0;
+                    tablet = cluster_sdk_->GetReadTablet(main_db, main_table, val, &pid);
+                    if (tablet && read_pid != nullptr) {
+                        *read_pid = pid;
+                    }
+                } else {
+                    tablet = cluster_sdk_->GetTablet(main_db, main_table, val);
+                }
             }
             if (!tablet) {
-                tablet = cluster_sdk_->GetTablet(main_db, main_table);
+                tablet = read_follower ? cluster_sdk_->GetReadTablet(main_db, main_table, "")
+                                       : cluster_sdk_->GetTablet(main_db, main_table);
             }
         }
     }
@@ -955,7 +1189,8 @@ std::shared_ptr<TableReader> SQLClusterRouter::GetTableReader() {
 
 std::shared_ptr<openmldb::client::TabletClient> SQLClusterRouter::GetTablet(const std::string& db,
                                                                             const std::string& sp_name,
-                                                                            hybridse::sdk::Status* status) {
+                                                                            hybridse::sdk::Status* status,
+                                                                            bool read_follower) {
     if (status == nullptr) return nullptr;
     std::shared_ptr<hybridse::sdk::ProcedureInfo> sp_info = cluster_sdk_->GetProcedureInfo(db, sp_name, &status->msg);
     if (!sp_info) {
@@ -966,7 +1201,8 @@ std::shared_ptr<openmldb::client::TabletClient> SQLClusterRouter::GetTablet(cons
     }
     const std::string& table = sp_info->GetMainTable();
     const std::string& db_name = sp_info->GetMainDb().empty() ? db : sp_info->GetMainDb();
-    auto tablet = cluster_sdk_->GetTablet(db_name, table);
+    auto tablet =
+        read_follower ? cluster_sdk_->GetReadTablet(db_name, table, "") : cluster_sdk_->GetTablet(db_name, table);
     if (!tablet) {
         status->code = -1;
         status->msg = "fail to get tablet, table " + db_name + "." + table;
@@ -1022,7 +1258,9 @@ std::shared_ptr<hybridse::sdk::ResultSet> SQLClusterRouter::ExecuteSQLRequest(co
     auto cntl = std::make_shared<::brpc::Controller>();
     cntl->set_timeout_ms(options_.request_timeout);
     auto response = std::make_shared<::openmldb::api::QueryResponse>();
-    auto client = GetTabletClient(db, sql, hybridse::vm::kRequestMode, row, *status);
+    int64_t read_pid = -1;
+    auto client = GetTabletClient(db, sql, hybridse::vm::kRequestMode, row, std::shared_ptr<SQLRequestRow>(), *status,
+                                  options_.enable_follower_read, &read_pid);
     if (0 != status->code) {
         return {};
     }
@@ -1030,7 +1268,23 @@ std::shared_ptr<hybridse::sdk::ResultSet> SQLClusterRouter::ExecuteSQLRequest(co
         status->msg = "not tablet found";
         return {};
     }
-    if (!client->Query(db, sql, row->GetRow(), cntl.get(), response.get(), options_.enable_debug)) {
+    int64_t max_read_lag = options_.enable_follower_read ? options_.max_read_lag : -1;
+    bool ok = client->Query(db, sql, row->GetRow(), cntl.get(), response.get(), options_.enable_debug, max_read_lag,
+                            read_pid);
+    if (!ok && response->code() == ::openmldb::base::kReplicaLagTooLarge) {
+        // the follower lags too much, read the leader
+        DLOG(INFO) << "retry on leader: " << response->msg();
+        client = GetTabletClient(db, sql, hybridse::vm::kRequestMode, row, *status);
+        if (!client) {
+            status->msg = "not tablet found";
+            return {};
+        }
+        cntl = std::make_shared<::brpc::Controller>();
+        cntl->set_timeout_ms(options_.request_timeout);
+        response = std::make_shared<::openmldb::api::QueryResponse>();
+        ok = client->Query(db, sql, row->GetRow(), cntl.get(), response.get(), options_.enable_debug);
+    }
+    if (!ok) {
         status->msg = "request server error, msg: " + response->msg();
         return {};
     }
@@ -1066,6 +1320,24 @@ std::shared_ptr<::hybridse::sdk::ResultSet> SQLClusterRouter::ExecuteSQLParamete
         auto client = *(clients.begin());
         DLOG(INFO) << " send query to tablet " << client->GetEndpoint();
         auto response = std::make_shared<::openmldb::api::QueryResponse>();
+        if (options_.enable_stream_query) {
+            std::unique_ptr<QueryStreamReceiver> receiver(new QueryStreamReceiver(options_.stream_query_max_chunks));
+            brpc::StreamOptions stream_options;
+            stream_options.handler = receiver.get();
+            stream_options.idle_timeout_ms = options_.request_timeout;
+            brpc::StreamId stream_id = brpc::INVALID_STREAM_ID;
+            if (!client->Query(db, sql, parameter_types, parameter ? parameter->GetRow() : "", stream_options,
+                               cntl.get(), response.get(), &stream_id, options_.enable_debug,
+                               receiver->GetMaxChunkCnt())) {
+                if (stream_id != brpc::INVALID_STREAM_ID) {
+                    receiver->WaitClosed();
+                }
+                status->msg = response->msg();
+                status->code = -1;
+                return {};
+            }
+            return StreamResultSetSQL::MakeResultSet(response, stream_id, std::move(receiver), status);
+        }
         if (!client->Query(db, sql, parameter_types, parameter ? parameter->GetRow() : "", cntl.get(), response.get(),
                            options_.enable_debug)) {
             status->msg = response->msg();
@@ -1164,7 +1436,7 @@ bool SQLClusterRouter::ExecuteInsert(const std::string& db, const std::string& s
         LOG(WARNING) << status->msg;
         return false;
     }
-    size_t cnt = 0;
+    std::vector<std::shared_ptr<SQLInsertRow>> rows(default_maps.size());
     for (size_t i = 0; i < default_maps.size(); i++) {
         auto row = std::make_shared<SQLInsertRow>(table_info, schema, default_maps[i], str_lengths[i]);
         if (!row) {
@@ -1179,60 +1451,61 @@ bool SQLClusterRouter::ExecuteInsert(const std::string& db, const std::string& s
             LOG(WARNING) << "fail to build row[" << i << "]";
             continue;
         }
-        if (!PutRow(table_info->tid(), row, tablets, status)) {
-            LOG(WARNING) << "fail to put row[" << i << "] due to: " << status->msg;
-            continue;
-        }
-        cnt++;
+        rows[i] = row;
     }
-    if (cnt < default_maps.size()) {
-        status->msg = "Error occur when execute insert, success/total: " + std::to_string(cnt) + "/" +
-                      std::to_string(default_maps.size());
-        status->code = 1;
+    auto future = PutRows(table_info->tid(), rows, tablets);
+    if (!future->Wait(status)) {
+        LOG(WARNING) << status->msg;
         return false;
     }
     return true;
 }
 
-bool SQLClusterRouter::PutRow(uint32_t tid, const std::shared_ptr<SQLInsertRow>& row,
-                              const std::vector<std::shared_ptr<::openmldb::catalog::TabletAccessor>>& tablets,
-                              ::hybridse::sdk::Status* status) {
-    if (status == nullptr) {
-        return false;
-    }
-    const auto& dimensions = row->GetDimensions();
+std::shared_ptr<InsertFuture> SQLClusterRouter::PutRows(
+    uint32_t tid, const std::vector<std::shared_ptr<SQLInsertRow>>& rows,
+    const std::vector<std::shared_ptr<::openmldb::catalog::TabletAccessor>>& tablets) {
+    auto future = std::make_shared<InsertFutureImpl>(tid, rows.size(), options_.max_put_batch_rows,
+                                                     options_.max_put_inflight, options_.request_timeout);
     uint64_t cur_ts = ::baidu::common::timer::get_micros() / 1000;
-    for (const auto& kv : dimensions) {
-        uint32_t pid = kv.first;
-        if (pid < tablets.size()) {
-            auto tablet = tablets[pid];
-            if (tablet) {
-                auto client = tablet->GetClient();
-                if (client) {
-                    DLOG(INFO) << "put data to endpoint " << client->GetEndpoint() << " with dimensions size "
-                               << kv.second.size();
-                    bool ret = client->Put(tid, pid, cur_ts, row->GetRow(), kv.second, 1);
-                    if (!ret) {
-                        status->msg = "fail to make a put request to table. tid " + std::to_string(tid);
-                        LOG(WARNING) << status->msg;
-                        return false;
-                    }
-                    continue;
-                }
+    for (uint32_t i = 0; i < rows.size(); i++) {
+        const auto& row = rows[i];
+        if (!row) {
+            future->SetFailed(i, "fail to build row[" + std::to_string(i) + "]");
+            continue;
+        }
+        for (const auto& kv : row->GetDimensions()) {
+            uint32_t pid = kv.first;
+            std::shared_ptr<::openmldb::client::TabletClient> client;
+            if (pid < tablets.size() && tablets[pid]) {
+                client = tablets[pid]->GetClient();
+            }
+            if (!client) {
+                future->SetFailed(i, "fail to get tablet client. pid " + std::to_string(pid));
+                LOG(WARNING) << "fail to get tablet client. pid " << pid;
+                continue;
             }
+            future->Put(i, pid, client, cur_ts, row->GetRow(), kv.second);
         }
-        status->msg = "fail to get tablet client. pid " + std::to_string(pid);
-        LOG(WARNING) << status->msg;
-        return false;
     }
-    return true;
+    future->Flush();
+    return future;
 }
 
 bool SQLClusterRouter::ExecuteInsert(const std::string& db, const std::string& sql, std::shared_ptr<SQLInsertRows> rows,
                                      hybridse::sdk::Status* status) {
+    auto future = ExecuteInsertAsync(db, sql, rows, status);
+    if (!future) {
+        return false;
+    }
+    return future->Wait(status);
+}
+
+std::shared_ptr<InsertFuture> SQLClusterRouter::ExecuteInsertAsync(const std::string& db, const std::string& sql,
+                                                                   std::shared_ptr<SQLInsertRows> rows,
+                                                                   hybridse::sdk::Status* status) {
     if (!rows || !status) {
         LOG(WARNING) << "input is invalid";
-        return false;
+        return nullptr;
     }
     std::shared_ptr<SQLCache> cache = GetCache(db, sql, hybridse::vm::kBatchMode);
     if (cache) {
@@ -1241,18 +1514,16 @@ bool SQLClusterRouter::ExecuteInsert(const std::string& db, const std::string& s
         bool ret = cluster_sdk_->GetTablet(db, table_info->name(), &tablets);
         if (!ret || tablets.empty()) {
             status->msg = "fail to get table " + table_info->name() + " tablet";
-            return false;
+            return nullptr;
         }
+        std::vector<std::shared_ptr<SQLInsertRow>> insert_rows;
         for (uint32_t i = 0; i < rows->GetCnt(); ++i) {
-            std::shared_ptr<SQLInsertRow> row = rows->GetRow(i);
-            if (!PutRow(table_info->tid(), row, tablets, status)) {
-                return false;
-            }
+            insert_rows.push_back(rows->GetRow(i));
         }
-        return true;
+        return PutRows(table_info->tid(), insert_rows, tablets);
     } else {
         status->msg = "please use getInsertRow with " + sql + " first";
-        return false;
+        return nullptr;
     }
 }
 
@@ -1270,10 +1541,7 @@ bool SQLClusterRouter::ExecuteInsert(const std::string& db, const std::string& s
             status->msg = "fail to get table " + table_info->name() + " tablet";
             return false;
         }
-        if (!PutRow(table_info->tid(), row, tablets, status)) {
-            return false;
-        }
-        return true;
+        return PutRows(table_info->tid(), {row}, tablets)->Wait(status);
     } else {
         status->msg = "please use getInsertRow with " + sql + " first";
         return false;
@@ -1330,15 +1598,28 @@ std::shared_ptr<hybridse::sdk::ResultSet> SQLClusterRouter::CallProcedure(const
         LOG(WARNING) << "make sure the request row is built before execute sql";
         return nullptr;
     }
-    auto tablet = GetTablet(db, sp_name, status);
+    auto tablet = GetTablet(db, sp_name, status, options_.enable_follower_read);
     if (!tablet) {
         return nullptr;
     }
 
     auto cntl = std::make_shared<::brpc::Controller>();
     auto response = std::make_shared<::openmldb::api::QueryResponse>();
+    int64_t max_read_lag = options_.enable_follower_read ? options_.max_read_lag : -1;
     bool ok = tablet->CallProcedure(db, sp_name, row->GetRow(), cntl.get(), response.get(), options_.enable_debug,
-                                    options_.request_timeout);
+                                    options_.request_timeout, max_read_lag);
+    if (!ok && response->code() == ::openmldb::base::kReplicaLagTooLarge) {
+        // the follower lags too much, call the leader
+        DLOG(INFO) << "retry on leader: " << response->msg();
+        tablet = GetTablet(db, sp_name, status);
+        if (!tablet) {
+            return nullptr;
+        }
+        cntl = std::make_shared<::brpc::Controller>();
+        response = std::make_shared<::openmldb::api::QueryResponse>();
+        ok = tablet->CallProcedure(db, sp_name, row->GetRow(), cntl.get(), response.get(), options_.enable_debug,
+                                   options_.request_timeout);
+    }
     if (!ok) {
         status->code = -1;
         status->msg = "request server error" + response->msg();
@@ -2109,6 +2390,17 @@ bool SQLClusterRouter::UpdateOfflineTableInfo(const ::openmldb::nameserver::Tabl
     table_info.set_replica_num(base_table_info.replica_num());
     table_info.set_partition_num(base_table_info.partition_num());
     table_info.set_format_version(1);
+    // the pre-aggr table is maintained by the tablet which has the leader of base table,
+    // so the partitions are placed the same as base table
+    for (const auto& base_partition : base_table_info.table_partition()) {
+        auto partition = table_info.add_table_partition();
+        partition->set_pid(base_partition.pid());
+        for (const auto& base_meta : base_partition.partition_meta()) {
+            auto meta = partition->add_partition_meta();
+            meta->set_endpoint(base_meta.endpoint());
+            meta->set_is_leader(base_meta.is_leader());
+        }
+    }
     auto SetColumnDesc = [](const std::string& name, openmldb::type::DataType type,
                             openmldb::common::ColumnDesc* field) {
         if (field != nullptr) {
@@ -2594,6 +2886,48 @@ void SQLClusterRouter::SetInteractive(bool value) { interactive_ = value; }
     return {};
 }
 
+// FileChunkReader reads the file in blocks of about block_size bytes, every
+// chunk ends at a line boundary except the last one of the file
+class FileChunkReader {
+ public:
+    FileChunkReader(std::ifstream* file, size_t block_size) : file_(file), block_size_(block_size) {}
+
+    bool Next(std::string* chunk) {
+        std::string buf;
+        buf.swap(remain_);
+        while (!eof_) {
+            size_t old_size = buf.size();
+            buf.resize(old_size + block_size_);
+            file_->read(&buf[old_size], block_size_);
+            size_t read_size = file_->gcount();
+            buf.resize(old_size + read_size);
+            bytes_ += read_size;
+            if (read_size < block_size_) {
+                eof_ = true;
+                break;
+            }
+            auto pos = buf.rfind('\n');
+            if (pos != std::string::npos) {
+                remain_ = buf.substr(pos + 1);
+                buf.resize(pos + 1);
+                break;
+            }
+            // the line is longer than block_size, read more
+        }
+        chunk->swap(buf);
+        return !chunk->empty();
+    }
+
+    uint64_t GetReadBytes() const { return bytes_; }
+
+ private:
+    std::ifstream* file_;
+    size_t block_size_;
+    std::string remain_;
+    bool eof_ = false;
+    uint64_t bytes_ = 0;
+};
+
 // Only csv format
 hybridse::sdk::Status SQLClusterRouter::HandleLoadDataInfile(
     const std::string& database, const std::string& table, const std::string& file_path,
@@ -2614,10 +2948,13 @@ hybridse::sdk::Status SQLClusterRouter::HandleLoadDataInfile(
     if (!base::IsExists(file_path)) {
         return {::hybridse::common::StatusCode::kCmdError, "file not exist"};
     }
-    std::ifstream file(file_path);
+    std::ifstream file(file_path, std::ios::binary);
     if (!file.is_open()) {
         return {::hybridse::common::StatusCode::kCmdError, "open file failed"};
     }
+    file.seekg(0, std::ios::end);
+    uint64_t file_size = file.tellg();
+    file.seekg(0, std::ios::beg);
 
     std::string line;
     if (!std::getline(file, line)) {
@@ -2634,6 +2971,7 @@ hybridse::sdk::Status SQLClusterRouter::HandleLoadDataInfile(
         return {::hybridse::common::StatusCode::kCmdError, "mismatch column size"};
     }
 
+    std::string first_chunk;
     if (options_parse.GetHeader()) {
         // the first line is the column names, check if equal with table schema
         for (int i = 0; i < schema->GetColumnCnt(); ++i) {
@@ -2641,8 +2979,8 @@ hybridse::sdk::Status SQLClusterRouter::HandleLoadDataInfile(
                 return {::hybridse::common::StatusCode::kCmdError, "mismatch column name"};
             }
         }
-        // then read the first row of data
-        std::getline(file, line);
+    } else {
+        first_chunk = line + "\n";
     }
 
     // build placeholder
@@ -2658,35 +2996,143 @@ hybridse::sdk::Status SQLClusterRouter::HandleLoadDataInfile(
             str_cols_idx.emplace_back(i);
         }
     }
-    uint64_t i = 0;
-    do {
-        cols.clear();
-        std::string error;
-        ::openmldb::sdk::SplitLineWithDelimiterForStrings(line, options_parse.GetDelimiter(), &cols,
-                                                          options_parse.GetQuote());
-        auto ret = InsertOneRow(database, insert_placeholder, str_cols_idx, options_parse.GetNullValue(), cols);
-        if (!ret.IsOK()) {
-            return {::hybridse::common::StatusCode::kCmdError, "line [" + line + "] insert failed, " + ret.msg};
-        }
-        ++i;
-    } while (std::getline(file, line));
-    return {0, "Load " + std::to_string(i) + " rows"};
-}
-
-hybridse::sdk::Status SQLClusterRouter::InsertOneRow(const std::string& database, const std::string& insert_placeholder,
-                                                     const std::vector<int>& str_col_idx, const std::string& null_value,
-                                                     const std::vector<std::string>& cols) {
-    if (cols.empty()) {
-        return {::hybridse::common::StatusCode::kCmdError, "cols is empty"};
-    }
-    if (database.empty()) {
-        return {::hybridse::common::StatusCode::kCmdError, "database is empty"};
-    }
-    hybridse::sdk::Status status;
-    auto row = GetInsertRow(database, insert_placeholder, &status);
-    if (!row) {
-        return status;
+    // the cache of insert info is filled by GetInsertRows
+    if (!GetInsertRows(database, insert_placeholder, &status)) {
+        return {::hybridse::common::StatusCode::kCmdError, "get insert info failed, " + status.msg};
     }
+    std::shared_ptr<SQLCache> cache = GetCache(database, insert_placeholder, hybridse::vm::kBatchMode);
+    std::vector<std::shared_ptr<::openmldb::catalog::TabletAccessor>> tablets;
+    if (!cache || !cluster_sdk_->GetTablet(database, table, &tablets) || tablets.empty()) {
+        return {::hybridse::common::StatusCode::kCmdError, "fail to get table " + table + " tablet"};
+    }
+
+    // the reader reads chunks of file into a bounded queue, and the workers
+    // parse the lines of chunks and put them with PutBatch rpcs
+    uint32_t thread_num = options_parse.GetThread();
+    uint64_t max_errors = options_parse.GetMaxErrors();
+    size_t max_queue_size = 2 * thread_num;
+    std::mutex mu;
+    std::condition_variable cv;
+    std::deque<std::string> chunks;
+    bool read_done = false;
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> loaded_rows{0};
+    std::atomic<uint64_t> failed_rows{0};
+    std::string first_error;
+    auto add_error = [&](uint64_t cnt, const std::string& msg) {
+        {
+            std::lock_guard<std::mutex> lock(mu);
+            if (first_error.empty()) {
+                first_error = msg;
+            }
+            if (failed_rows.fetch_add(cnt) + cnt > max_errors) {
+                stop = true;
+            }
+        }
+        cv.notify_all();
+    };
+    auto worker = [&]() {
+        std::string chunk;
+        while (!stop) {
+            {
+                std::unique_lock<std::mutex> lock(mu);
+                cv.wait(lock, [&] { return !chunks.empty() || read_done || stop; });
+                if (chunks.empty()) {
+                    break;
+                }
+                chunk = std::move(chunks.front());
+                chunks.pop_front();
+            }
+            cv.notify_all();
+            std::vector<std::shared_ptr<SQLInsertRow>> rows;
+            std::vector<std::string> line_cols;
+            size_t begin = 0;
+            while (begin < chunk.size() && !stop) {
+                size_t end = chunk.find('\n', begin);
+                if (end == std::string::npos) {
+                    end = chunk.size();
+                }
+                if (end > begin) {
+                    std::string cur_line = chunk.substr(begin, end - begin);
+                    line_cols.clear();
+                    ::openmldb::sdk::SplitLineWithDelimiterForStrings(cur_line, options_parse.GetDelimiter(),
+                                                                      &line_cols, options_parse.GetQuote());
+                    auto row = std::make_shared<SQLInsertRow>(cache->table_info, cache->column_schema,
+                                                              cache->default_map, cache->str_length);
+                    auto ret = BuildInsertRow(row, str_cols_idx, options_parse.GetNullValue(), line_cols);
+                    if (ret.IsOK()) {
+                        rows.push_back(row);
+                    } else {
+                        add_error(1, "line [" + cur_line + "] insert failed, " + ret.msg);
+                    }
+                }
+                begin = end + 1;
+            }
+            if (rows.empty() || stop) {
+                continue;
+            }
+            hybridse::sdk::Status put_status;
+            auto future = PutRows(cache->table_info->tid(), rows, tablets);
+            if (!future->Wait(&put_status)) {
+                add_error(future->GetFailedCount(), put_status.msg);
+            }
+            loaded_rows.fetch_add(rows.size() - future->GetFailedCount());
+        }
+    };
+    std::vector<std::thread> workers;
+    for (uint32_t i = 0; i < thread_num; i++) {
+        workers.emplace_back(worker);
+    }
+    uint64_t start_time = ::baidu::common::timer::get_micros();
+    uint64_t last_report_time = start_time;
+    FileChunkReader reader(&file, 4 * 1024 * 1024);
+    std::string chunk = std::move(first_chunk);
+    while (!stop && (!chunk.empty() || reader.Next(&chunk))) {
+        {
+            std::unique_lock<std::mutex> lock(mu);
+            cv.wait(lock, [&] { return chunks.size() < max_queue_size || stop; });
+            chunks.push_back(std::move(chunk));
+        }
+        chunk.clear();
+        cv.notify_all();
+        uint64_t cur_time = ::baidu::common::timer::get_micros();
+        if (cur_time - last_report_time > 10 * 1000 * 1000) {
+            last_report_time = cur_time;
+            LOG(INFO) << "loading " << file_path << " to " << database << "." << table << ", " << loaded_rows.load()
+                      << " rows loaded, " << failed_rows.load() << " rows failed, read "
+                      << std::min<uint64_t>(100, 100 * reader.GetReadBytes() / std::max<uint64_t>(file_size, 1))
+                      << "%";
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        read_done = true;
+    }
+    cv.notify_all();
+    for (auto& t : workers) {
+        t.join();
+    }
+    double cost_s = std::max<double>((::baidu::common::timer::get_micros() - start_time) / 1000000.0, 0.001);
+    std::string metrics = std::to_string(loaded_rows.load()) + " rows loaded in " + std::to_string(cost_s) + "s, " +
+                          std::to_string(static_cast<uint64_t>(loaded_rows.load() / cost_s)) + " rows/s, " +
+                          std::to_string(file_size / 1024.0 / 1024.0 / cost_s) + " MB/s";
+    LOG(INFO) << "load " << file_path << " to " << database << "." << table << ": " << metrics << ", "
+              << failed_rows.load() << " rows failed";
+    if (failed_rows > max_errors) {
+        return {::hybridse::common::StatusCode::kCmdError,
+                first_error + ", " + std::to_string(failed_rows.load()) + " rows failed, " + metrics};
+    }
+    if (failed_rows > 0) {
+        return {0, "Load " + std::to_string(loaded_rows.load()) + " rows, " + std::to_string(failed_rows.load()) +
+                       " rows failed, the first error: " + first_error};
+    }
+    return {0, "Load " + std::to_string(loaded_rows.load()) + " rows"};
+}
+
+hybridse::sdk::Status SQLClusterRouter::BuildInsertRow(const std::shared_ptr<SQLInsertRow>& row,
+                                                       const std::vector<int>& str_col_idx,
+                                                       const std::string& null_value,
+                                                       const std::vector<std::string>& cols) {
     // build row from cols
     auto& schema = row->GetSchema();
     auto cnt = schema->GetColumnCnt();
@@ -2708,9 +3154,6 @@ hybridse::sdk::Status SQLClusterRouter::InsertOneRow(const std::string& database
             return {::hybridse::common::StatusCode::kCmdError, "translate to insert row failed"};
         }
     }
-    if (!ExecuteInsert(database, insert_placeholder, row, &status)) {
-        return {::hybridse::common::StatusCode::kCmdError, "insert row failed"};
-    }
     return {};
 }
 
@@ -2782,6 +3225,14 @@ hybridse::sdk::Status SQLClusterRouter::HandleDeploy(const hybridse::node::Deplo
 
     sp_info.set_sql(str_stream.str());
     sp_info.set_type(::openmldb::type::ProcedureType::kReqDeployment);
+    auto cache_iter = deploy_node->Options()->find("result_cache_ttl");
+    if (cache_iter != deploy_node->Options()->end()) {
+        uint64_t result_cache_ttl = 0;
+        if (!absl::SimpleAtoi(cache_iter->second->GetExprString(), &result_cache_ttl)) {
+            return {::hybridse::common::StatusCode::kCmdError, "illegal result_cache_ttl, it should be ms"};
+        }
+        sp_info.set_result_cache_ttl(result_cache_ttl);
+    }
 
     auto lw_status = HandleLongWindows(deploy_node, table_pair, select_sql);
     if (!lw_status.IsOK()) {
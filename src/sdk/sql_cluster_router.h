@@ -137,6 +137,10 @@ class SQLClusterRouter : public SQLRouter {
     bool ExecuteInsert(const std::string& db, const std::string& sql, std::shared_ptr<SQLInsertRows> rows,
                        hybridse::sdk::Status* status) override;
 
+    std::shared_ptr<InsertFuture> ExecuteInsertAsync(const std::string& db, const std::string& sql,
+                                                     std::shared_ptr<SQLInsertRows> rows,
+                                                     hybridse::sdk::Status* status) override;
+
     std::shared_ptr<TableReader> GetTableReader() override;
 
     std::shared_ptr<ExplainInfo> Explain(const std::string& db, const std::string& sql,
@@ -217,7 +221,7 @@ class SQLClusterRouter : public SQLRouter {
     std::shared_ptr<::openmldb::client::TabletClient> GetTabletClient(
         const std::string& db, const std::string& sql, const ::hybridse::vm::EngineMode engine_mode,
         const std::shared_ptr<SQLRequestRow>& row, const std::shared_ptr<SQLRequestRow>& parameter_row,
-        hybridse::sdk::Status& status); // NOLINT
+        hybridse::sdk::Status& status, bool read_follower = false, int64_t* read_pid = nullptr); // NOLINT
     std::shared_ptr<SQLCache> GetSQLCache(
         const std::string& db, const std::string& sql, const ::hybridse::vm::EngineMode engine_mode,
         const std::shared_ptr<SQLRequestRow>& parameter_row, hybridse::sdk::Status& status); // NOLINT
@@ -294,9 +298,10 @@ class SQLClusterRouter : public SQLRouter {
  private:
     void GetTables(::hybridse::vm::PhysicalOpNode* node, std::set<std::string>* tables);
 
-    bool PutRow(uint32_t tid, const std::shared_ptr<SQLInsertRow>& row,
-                const std::vector<std::shared_ptr<::openmldb::catalog::TabletAccessor>>& tablets,
-                ::hybridse::sdk::Status* status);
+    // send the rows grouped by partition, a null row is counted as failed
+    std::shared_ptr<InsertFuture> PutRows(
+        uint32_t tid, const std::vector<std::shared_ptr<SQLInsertRow>>& rows,
+        const std::vector<std::shared_ptr<::openmldb::catalog::TabletAccessor>>& tablets);
 
     bool IsConstQuery(::hybridse::vm::PhysicalOpNode* node);
     std::shared_ptr<SQLCache> GetCache(const std::string& db, const std::string& sql,
@@ -323,7 +328,8 @@ class SQLClusterRouter : public SQLRouter {
     inline bool CheckSQLSyntax(const std::string& sql);
 
     std::shared_ptr<openmldb::client::TabletClient> GetTablet(const std::string& db, const std::string& sp_name,
-                                                              hybridse::sdk::Status* status);
+                                                              hybridse::sdk::Status* status,
+                                                              bool read_follower = false);
     bool ExtractDBTypes(std::shared_ptr<hybridse::sdk::Schema> schema,
                         std::vector<openmldb::type::DataType>& parameter_types);  // NOLINT
 
@@ -343,9 +349,10 @@ class SQLClusterRouter : public SQLRouter {
             const std::string& table, const std::string& file_path,
             const std::shared_ptr<hybridse::node::OptionsMap>& options);
 
-    hybridse::sdk::Status InsertOneRow(const std::string& database,
-            const std::string& insert_placeholder, const std::vector<int>& str_col_idx,
-            const std::string& null_value, const std::vector<std::string>& cols);
+    // encode cols of one csv line to row
+    hybridse::sdk::Status BuildInsertRow(const std::shared_ptr<SQLInsertRow>& row,
+            const std::vector<int>& str_col_idx, const std::string& null_value,
+            const std::vector<std::string>& cols);
 
     hybridse::sdk::Status HandleDeploy(const hybridse::node::DeployPlanNode* deploy_node);
 
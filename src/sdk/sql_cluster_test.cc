@@ -18,6 +18,7 @@
 #include <unistd.h>
 
 #include <memory>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -34,6 +35,8 @@
 #include "sdk/sql_sdk_test.h"
 #include "vm/catalog.h"
 
+DECLARE_int32(binlog_heartbeat_interval);
+
 namespace openmldb {
 namespace sdk {
 
@@ -431,6 +434,58 @@ TEST_F(SQLSDKQueryTest, GetTabletClient) {
     ASSERT_TRUE(router->DropDB(db, &status));
 }
 
+TEST_F(SQLSDKQueryTest, FollowerRead) {
+    std::string ddl =
+        "create table t1(col1 string, col2 bigint, index(key=col1, ts=col2)) "
+        "options(partitionnum=1, replicanum=3);";
+    SQLRouterOptions sql_opt;
+    sql_opt.session_timeout = 30000;
+    sql_opt.zk_cluster = mc_->GetZkCluster();
+    sql_opt.zk_path = mc_->GetZkPath();
+    sql_opt.enable_debug = hybridse::sqlcase::SqlCase::IsDebug();
+    sql_opt.enable_follower_read = true;
+    sql_opt.max_read_lag = 0;
+    auto router = NewClusterSQLRouter(sql_opt);
+    if (!router) {
+        FAIL() << "Fail new cluster sql router";
+    }
+    SetOnlineMode(router);
+    std::string db = "followerread";
+    hybridse::sdk::Status status;
+    ASSERT_TRUE(router->CreateDB(db, &status));
+    ASSERT_TRUE(router->ExecuteDDL(db, ddl, &status));
+    ASSERT_TRUE(router->RefreshCatalog());
+    for (int i = 0; i < 10; i++) {
+        ASSERT_TRUE(router->ExecuteInsert(db, "insert into t1 values('pk', " + std::to_string(i) + ");", &status));
+    }
+    // wait for the followers to catch up
+    sleep(2);
+    std::string sql = "select col1, count(col2) over w1 as cnt from t1 window w1 as (partition by col1 order by col2 "
+                      "rows between 100 preceding and current row);";
+    auto sql_cluster_router = std::dynamic_pointer_cast<SQLClusterRouter>(router);
+    std::set<std::string> endpoints;
+    for (int i = 0; i < 30; i++) {
+        auto request_row = router->GetRequestRow(db, sql, &status);
+        ASSERT_TRUE(request_row != nullptr) << status.msg;
+        request_row->Init(2);
+        request_row->AppendString("pk");
+        request_row->AppendInt64(100);
+        ASSERT_TRUE(request_row->Build());
+        auto client = sql_cluster_router->GetTabletClient(db, sql, hybridse::vm::kRequestMode, request_row,
+                                                          std::shared_ptr<SQLRequestRow>(), status, true);
+        ASSERT_TRUE(client != nullptr);
+        endpoints.insert(client->GetEndpoint());
+        // served by a follower up to date or by the leader
+        auto rs = router->ExecuteSQLRequest(db, sql, request_row, &status);
+        ASSERT_TRUE(rs != nullptr) << status.msg;
+        ASSERT_TRUE(rs->Next());
+        ASSERT_EQ(11, rs->GetInt64Unsafe(1));
+    }
+    ASSERT_GT(endpoints.size(), 1u);
+    ASSERT_TRUE(router->ExecuteDDL(db, "drop table t1;", &status));
+    ASSERT_TRUE(router->DropDB(db, &status));
+}
+
 TEST_F(SQLClusterTest, CreatePreAggrTable) {
     SQLRouterOptions sql_opt;
     sql_opt.zk_cluster = mc_->GetZkCluster();
@@ -911,6 +966,8 @@ int main(int argc, char** argv) {
     ::openmldb::sdk::MiniCluster mc(6181);
     ::openmldb::sdk::mc_ = &mc;
     FLAGS_enable_distsql = true;
+    // the idle followers of FollowerRead hear from their leaders by heartbeat
+    FLAGS_binlog_heartbeat_interval = 1000;
     int ok = ::openmldb::sdk::mc_->SetUp(3);
     sleep(1);
     ::testing::InitGoogleTest(&argc, argv);
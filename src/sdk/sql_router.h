@@ -41,6 +41,19 @@ struct BasicRouterOptions {
     uint32_t session_timeout = 2000;
     uint32_t max_sql_cache_size = 10;
     uint32_t request_timeout = 60000;
+    // the max rows of one PutBatch request and the max put requests in flight
+    // when inserting multi rows
+    uint32_t max_put_batch_rows = 500;
+    uint32_t max_put_inflight = 8;
+    // read the rows of online batch query from single tablet lazily by stream,
+    // at most stream_query_max_chunks chunks are kept in the client
+    bool enable_stream_query = false;
+    uint32_t stream_query_max_chunks = 4;
+    // send the request mode queries and deployments to the leader or a follower of
+    // the partition, a follower serves them only if it lags behind the leader by at
+    // most max_read_lag binlog entries, otherwise they are sent to the leader again
+    bool enable_follower_read = false;
+    uint64_t max_read_lag = 0;
 };
 
 struct SQLRouterOptions : BasicRouterOptions {
@@ -75,6 +88,18 @@ class QueryFuture {
     virtual bool IsDone() const = 0;
 };
 
+class InsertFuture {
+ public:
+    InsertFuture() {}
+    virtual ~InsertFuture() {}
+
+    // wait for all the put requests, return false if any row fails to be put
+    virtual bool Wait(hybridse::sdk::Status* status) = 0;
+    virtual bool IsDone() const = 0;
+    // the count of rows failed to be put, it's final after Wait returns
+    virtual uint64_t GetFailedCount() const = 0;
+};
+
 class SQLRouter {
  public:
     SQLRouter() {}
@@ -98,6 +123,12 @@ class SQLRouter {
     virtual bool ExecuteInsert(const std::string& db, const std::string& sql,
                                std::shared_ptr<openmldb::sdk::SQLInsertRows> row, hybridse::sdk::Status* status) = 0;
 
+    // put the rows to partitions in parallel, it returns once the requests
+    // beyond the in-flight window are finished
+    virtual std::shared_ptr<openmldb::sdk::InsertFuture> ExecuteInsertAsync(
+        const std::string& db, const std::string& sql, std::shared_ptr<openmldb::sdk::SQLInsertRows> rows,
+        hybridse::sdk::Status* status) = 0;
+
     virtual std::shared_ptr<openmldb::sdk::TableReader> GetTableReader() = 0;
 
     virtual std::shared_ptr<ExplainInfo> Explain(const std::string& db, const std::string& sql,
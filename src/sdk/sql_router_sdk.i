@@ -42,6 +42,7 @@
 %shared_ptr(openmldb::sdk::ExplainInfo);
 %shared_ptr(hybridse::sdk::ProcedureInfo);
 %shared_ptr(openmldb::sdk::QueryFuture);
+%shared_ptr(openmldb::sdk::InsertFuture);
 %shared_ptr(openmldb::sdk::TableReader);
 %template(VectorUint32) std::vector<uint32_t>;
 %template(VectorString) std::vector<std::string>;
@@ -67,6 +68,7 @@ using openmldb::sdk::SQLInsertRows;
 using openmldb::sdk::ExplainInfo;
 using hybridse::sdk::ProcedureInfo;
 using openmldb::sdk::QueryFuture;
+using openmldb::sdk::InsertFuture;
 using openmldb::sdk::TableReader;
 %}
 
@@ -34,6 +34,9 @@
 #include "sdk/mini_cluster.h"
 #include "vm/catalog.h"
 
+DECLARE_uint32(query_stream_chunk_size);
+DECLARE_uint32(query_stream_wait_timeout);
+
 namespace openmldb {
 namespace sdk {
 
@@ -322,6 +325,133 @@ TEST_F(SQLRouterTest, test_sql_insert_placeholder) {
     ASSERT_TRUE(ok);
 }
 
+TEST_F(SQLRouterTest, test_sql_insert_async) {
+    SQLRouterOptions sql_opt;
+    sql_opt.zk_cluster = mc_->GetZkCluster();
+    sql_opt.zk_path = mc_->GetZkPath();
+    // several batches of one partition are in flight at the same time
+    sql_opt.max_put_batch_rows = 3;
+    sql_opt.max_put_inflight = 2;
+    auto router = NewClusterSQLRouter(sql_opt);
+    ASSERT_TRUE(router != nullptr);
+    std::string name = "test" + GenRand();
+    std::string db = "db" + GenRand();
+    ::hybridse::sdk::Status status;
+    bool ok = router->CreateDB(db, &status);
+    ASSERT_TRUE(ok);
+    std::string ddl = "create table " + name +
+                      "("
+                      "col1 string, col2 bigint, col3 string,"
+                      "index(key=col1, ts=col2), index(key=col3, ts=col2)) options(partitionnum=4);";
+    ok = router->ExecuteDDL(db, ddl, &status);
+    ASSERT_TRUE(ok);
+    ASSERT_TRUE(router->RefreshCatalog());
+
+    std::string insert_placeholder = "insert into " + name + " values(?, ?, ?);";
+    std::shared_ptr<SQLInsertRows> insert_rows = router->GetInsertRows(db, insert_placeholder, &status);
+    ASSERT_EQ(status.code, 0);
+    for (int i = 0; i < 20; i++) {
+        std::string col1 = "key" + std::to_string(i);
+        std::string col3 = "val" + std::to_string(i % 5);
+        std::shared_ptr<SQLInsertRow> row = insert_rows->NewRow();
+        ASSERT_TRUE(row->Init(col1.size() + col3.size()));
+        ASSERT_TRUE(row->AppendString(col1));
+        ASSERT_TRUE(row->AppendInt64(1000 + i));
+        ASSERT_TRUE(row->AppendString(col3));
+        ASSERT_TRUE(row->Build());
+    }
+    auto future = router->ExecuteInsertAsync(db, insert_placeholder, insert_rows, &status);
+    ASSERT_TRUE(future != nullptr);
+    ASSERT_TRUE(future->Wait(&status)) << status.msg;
+    ASSERT_TRUE(future->IsDone());
+
+    ASSERT_TRUE(router->RefreshCatalog());
+    std::string sql_select = "select col1, col2 from " + name + ";";
+    auto rs = router->ExecuteSQL(db, sql_select, &status);
+    ASSERT_TRUE(rs != nullptr);
+    ASSERT_EQ(20, rs->Size());
+
+    ok = router->ExecuteDDL(db, "drop table " + name + ";", &status);
+    ASSERT_TRUE(ok);
+    ok = router->DropDB(db, &status);
+    ASSERT_TRUE(ok);
+}
+
+TEST_F(SQLRouterTest, test_sql_stream_query) {
+    SQLRouterOptions sql_opt;
+    sql_opt.zk_cluster = mc_->GetZkCluster();
+    sql_opt.zk_path = mc_->GetZkPath();
+    sql_opt.enable_stream_query = true;
+    sql_opt.stream_query_max_chunks = 2;
+    auto router = NewClusterSQLRouter(sql_opt);
+    ASSERT_TRUE(router != nullptr);
+    std::string name = "test" + GenRand();
+    std::string db = "db" + GenRand();
+    ::hybridse::sdk::Status status;
+    bool ok = router->CreateDB(db, &status);
+    ASSERT_TRUE(ok);
+    std::string ddl = "create table " + name +
+                      "("
+                      "col1 string, col2 bigint,"
+                      "index(key=col1, ts=col2)) options(partitionnum=1);";
+    ok = router->ExecuteDDL(db, ddl, &status);
+    ASSERT_TRUE(ok);
+    ASSERT_TRUE(router->RefreshCatalog());
+    for (int i = 0; i < 100; i++) {
+        std::string insert = "insert into " + name + " values('key" + std::to_string(i % 10) + "', " +
+                             std::to_string(1000 + i) + ");";
+        ASSERT_TRUE(router->ExecuteInsert(db, insert, &status));
+    }
+    // a few rows in one message
+    uint32_t chunk_size = FLAGS_query_stream_chunk_size;
+    FLAGS_query_stream_chunk_size = 64;
+    std::string sql_select = "select col1, col2 from " + name + ";";
+    auto rs = router->ExecuteSQL(db, sql_select, &status);
+    ASSERT_TRUE(rs != nullptr) << status.msg;
+    int64_t sum = 0;
+    int32_t cnt = 0;
+    while (rs->Next()) {
+        sum += rs->GetInt64Unsafe(1);
+        cnt++;
+    }
+    ASSERT_EQ(100, cnt);
+    ASSERT_EQ(100, rs->Size());
+    ASSERT_EQ(100 * 1000 + 99 * 100 / 2, sum);
+    ASSERT_FALSE(rs->Reset());
+    rs->GetStatus(&status);
+    ASSERT_TRUE(status.IsOK()) << status.msg;
+
+    // the server gives up when the rows are not consumed in time, the result
+    // is reported incomplete instead of ending silently
+    uint32_t wait_timeout = FLAGS_query_stream_wait_timeout;
+    FLAGS_query_stream_wait_timeout = 100;
+    rs = router->ExecuteSQL(db, sql_select, &status);
+    ASSERT_TRUE(rs != nullptr) << status.msg;
+    ASSERT_TRUE(rs->Next());
+    sleep(1);
+    cnt = 1;
+    while (rs->Next()) {
+        cnt++;
+    }
+    ASSERT_LT(cnt, 100);
+    rs->GetStatus(&status);
+    ASSERT_FALSE(status.IsOK());
+    FLAGS_query_stream_wait_timeout = wait_timeout;
+
+    // stop reading before the stream is finished
+    rs = router->ExecuteSQL(db, sql_select, &status);
+    ASSERT_TRUE(rs != nullptr) << status.msg;
+    ASSERT_TRUE(rs->Next());
+    ASSERT_TRUE(rs->Next());
+    rs.reset();
+    FLAGS_query_stream_chunk_size = chunk_size;
+
+    ok = router->ExecuteDDL(db, "drop table " + name + ";", &status);
+    ASSERT_TRUE(ok);
+    ok = router->DropDB(db, &status);
+    ASSERT_TRUE(ok);
+}
+
 TEST_F(SQLRouterTest, test_sql_insert_with_column_list) {
     SQLRouterOptions sql_opt;
     sql_opt.zk_cluster = mc_->GetZkCluster();
@@ -30,9 +30,12 @@
 #include "gflags/gflags.h"
 #include "log/log_writer.h"
 #include "log/status.h"
+#include "storage/segment_dispatcher.h"
 
 DECLARE_uint64(gc_on_table_recover_count);
 DECLARE_int32(binlog_name_length);
+DECLARE_uint32(load_table_thread_num);
+DECLARE_uint32(load_table_dispatch_batch);
 
 namespace openmldb {
 namespace storage {
@@ -45,7 +48,7 @@ bool Binlog::RecoverFromBinlog(std::shared_ptr<Table> table, uint64_t offset, ui
     PDLOG(INFO, "start recover table tid %u, pid %u from binlog with start offset %lu", tid, pid, offset);
     ::openmldb::log::LogReader log_reader(log_part_, log_path_, false);
     log_reader.SetOffset(offset);
-    ::openmldb::api::LogEntry entry;
+    SegmentDispatcher dispatcher(table, FLAGS_load_table_thread_num, FLAGS_load_table_dispatch_batch);
     uint64_t cur_offset = offset;
     std::string buffer;
     uint64_t succ_cnt = 0;
@@ -88,7 +91,8 @@ bool Binlog::RecoverFromBinlog(std::shared_ptr<Table> table, uint64_t offset, ui
             failed_cnt++;
             continue;
         }
-        bool ok = entry.ParseFromString(record.ToString());
+        ::openmldb::api::LogEntry& entry = *dispatcher.NextEntry();
+        bool ok = entry.ParseFromArray(record.data(), record.size());
         if (!ok) {
             PDLOG(WARNING, "fail parse record for tid %u, pid %u with value %s", tid, pid,
                   ::openmldb::base::DebugString(record.ToString()).c_str());
@@ -108,16 +112,12 @@ bool Binlog::RecoverFromBinlog(std::shared_ptr<Table> table, uint64_t offset, ui
                   cur_offset, entry.log_index(), tid, pid);
         }
 
-        if (entry.has_method_type() && entry.method_type() == ::openmldb::api::MethodType::kDelete) {
-            if (entry.dimensions_size() == 0) {
-                PDLOG(WARNING, "no dimesion. tid %u pid %u offset %lu", tid, pid, entry.log_index());
-            } else {
-                table->Delete(entry.dimensions(0).key(), entry.dimensions(0).idx());
-            }
-        } else {
-            table->Put(entry);
+        if (entry.has_method_type() && entry.method_type() == ::openmldb::api::MethodType::kDelete &&
+            entry.dimensions_size() == 0) {
+            PDLOG(WARNING, "no dimesion. tid %u pid %u offset %lu", tid, pid, entry.log_index());
         }
         cur_offset = entry.log_index();
+        dispatcher.Submit();
         succ_cnt++;
         if (succ_cnt % 100000 == 0) {
             PDLOG(INFO,
@@ -126,9 +126,11 @@ bool Binlog::RecoverFromBinlog(std::shared_ptr<Table> table, uint64_t offset, ui
                   succ_cnt, failed_cnt, tid, pid);
         }
         if (succ_cnt % FLAGS_gc_on_table_recover_count == 0) {
+            dispatcher.Flush();
             table->SchedGc();
         }
     }
+    dispatcher.Flush();
     latest_offset = cur_offset;
     if (!reach_end_log) {
         int log_index = log_reader.GetLogIndex();
@@ -561,9 +561,9 @@ bool DiskTableIterator::Valid() {
     if (it_ == NULL || !it_->Valid()) {
         return false;
     }
-    std::string cur_pk;
+    rocksdb::Slice cur_pk;
     uint32_t cur_ts_idx = UINT32_MAX;
-    ParseKeyAndTs(has_ts_idx_, it_->key(), cur_pk, ts_, cur_ts_idx);
+    ParseKeyAndTs(has_ts_idx_, it_->key(), &cur_pk, &ts_, &cur_ts_idx);
     return has_ts_idx_ ? cur_pk == pk_ && cur_ts_idx == ts_idx_ : cur_pk == pk_;
 }
 
@@ -81,6 +81,26 @@ static int ParseKeyAndTs(const rocksdb::Slice& s, std::string& key,  // NOLINT
     return 0;
 }
 
+// parse the combined key without copy, the key refers to the memory of s
+static inline int ParseKeyAndTs(bool has_ts_idx, const rocksdb::Slice& s, rocksdb::Slice* key, uint64_t* ts,
+                                uint32_t* ts_idx) {
+    auto len = TS_LEN;
+    if (has_ts_idx) {
+        len += TS_POS_LEN;
+    }
+    if (s.size() < len) {
+        *key = rocksdb::Slice();
+        return -1;
+    }
+    *key = rocksdb::Slice(s.data(), s.size() - len);
+    if (has_ts_idx) {
+        memcpy(static_cast<void*>(ts_idx), s.data() + s.size() - len, TS_POS_LEN);
+    }
+    memcpy(static_cast<void*>(ts), s.data() + s.size() - TS_LEN, TS_LEN);
+    memrev64ifbe(static_cast<void*>(ts));
+    return 0;
+}
+
 static inline std::string CombineKeyTs(const std::string& key, uint64_t ts) {
     std::string result;
     result.resize(key.size() + TS_LEN);
@@ -107,23 +127,34 @@ class KeyTSComparator : public rocksdb::Comparator {
     KeyTSComparator() {}
     const char* Name() const override { return "KeyTSComparator"; }
 
+    // compare on the original slices, the ts_pos of multi ts index is part
+    // of the key so the same comparator works for both layouts
     int Compare(const rocksdb::Slice& a, const rocksdb::Slice& b) const override {
-        std::string key1, key2;
-        uint64_t ts1 = 0, ts2 = 0;
-        ParseKeyAndTs(a, key1, ts1);
-        ParseKeyAndTs(b, key2, ts2);
-
-        int ret = key1.compare(key2);
+        size_t key_len1 = a.size() > TS_LEN ? a.size() - TS_LEN : 0;
+        size_t key_len2 = b.size() > TS_LEN ? b.size() - TS_LEN : 0;
+        int ret = rocksdb::Slice(a.data(), key_len1).compare(rocksdb::Slice(b.data(), key_len2));
         if (ret != 0) {
             return ret;
-        } else {
-            if (ts1 > ts2) return -1;
-            if (ts1 < ts2) return 1;
-            return 0;
         }
+        uint64_t ts1 = DecodeTs(a);
+        uint64_t ts2 = DecodeTs(b);
+        if (ts1 > ts2) return -1;
+        if (ts1 < ts2) return 1;
+        return 0;
     }
     void FindShortestSeparator(std::string* /*start*/, const rocksdb::Slice& /*limit*/) const override {}
     void FindShortSuccessor(std::string* /*key*/) const override {}
+
+ private:
+    static inline uint64_t DecodeTs(const rocksdb::Slice& s) {
+        uint64_t ts = 0;
+        if (s.size() < TS_LEN) {
+            return ts;
+        }
+        memcpy(static_cast<void*>(&ts), s.data() + s.size() - TS_LEN, TS_LEN);
+        memrev64ifbe(static_cast<void*>(&ts));
+        return ts;
+    }
 };
 
 class KeyTsPrefixTransform : public rocksdb::SliceTransform {
@@ -0,0 +1,193 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gflags/gflags.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "base/file_util.h"
+#include "base/glog_wapper.h"  // NOLINT
+#include "common/timer.h"      // NOLINT
+#include "gtest/gtest.h"
+#include "storage/disk_table.h"
+#include "storage/ticket.h"
+
+DECLARE_string(hdd_root_path);
+
+namespace openmldb {
+namespace storage {
+
+static const uint32_t KEY_NUM = 1000;
+static const uint32_t RECORD_PER_KEY = 100;
+
+class DiskTableBenchmarkTest : public ::testing::Test {
+ public:
+    DiskTableBenchmarkTest() {}
+    ~DiskTableBenchmarkTest() {}
+};
+
+// the comparator before it works on slices, keep it here as the baseline
+class CopyKeyTSComparator : public rocksdb::Comparator {
+ public:
+    const char* Name() const override { return "CopyKeyTSComparator"; }
+
+    int Compare(const rocksdb::Slice& a, const rocksdb::Slice& b) const override {
+        std::string key1, key2;
+        uint64_t ts1 = 0, ts2 = 0;
+        ParseKeyAndTs(a, key1, ts1);
+        ParseKeyAndTs(b, key2, ts2);
+        int ret = key1.compare(key2);
+        if (ret != 0) {
+            return ret;
+        }
+        if (ts1 > ts2) return -1;
+        if (ts1 < ts2) return 1;
+        return 0;
+    }
+    void FindShortestSeparator(std::string* /*start*/, const rocksdb::Slice& /*limit*/) const override {}
+    void FindShortSuccessor(std::string* /*key*/) const override {}
+};
+
+static uint64_t RunCompare(const rocksdb::Comparator& cmp, const std::vector<std::string>& keys) {
+    uint64_t consumed = ::baidu::common::timer::get_micros();
+    int64_t sum = 0;
+    for (uint32_t round = 0; round < 10; round++) {
+        for (uint32_t i = 1; i < keys.size(); i++) {
+            sum += cmp.Compare(keys[i - 1], keys[i]);
+        }
+    }
+    consumed = ::baidu::common::timer::get_micros() - consumed;
+    std::cout << cmp.Name() << " compare " << 10 * (keys.size() - 1) << " times consumed " << consumed / 1000
+              << "ms, sum " << sum << std::endl;
+    return consumed;
+}
+
+TEST_F(DiskTableBenchmarkTest, Compare) {
+    std::vector<std::string> keys;
+    for (uint32_t i = 0; i < KEY_NUM; i++) {
+        std::string pk = "card_no_000000000" + std::to_string(i % 100);
+        for (uint32_t j = 0; j < RECORD_PER_KEY; j++) {
+            keys.push_back(CombineKeyTs(pk, 1552619498000 + j));
+        }
+    }
+    CopyKeyTSComparator copy_cmp;
+    KeyTSComparator cmp;
+    RunCompare(copy_cmp, keys);
+    RunCompare(cmp, keys);
+}
+
+// the pk check of DiskTableIterator::Valid, which copied the key of every
+// scanned row into a string before it works on slices
+static uint64_t RunCopyKeyCheck(const std::vector<std::string>& keys, const std::string& pk) {
+    uint64_t consumed = ::baidu::common::timer::get_micros();
+    uint64_t matched = 0;
+    for (uint32_t round = 0; round < 10; round++) {
+        for (const auto& key : keys) {
+            std::string cur_pk;
+            uint64_t ts = 0;
+            uint32_t ts_idx = UINT32_MAX;
+            ParseKeyAndTs(false, key, cur_pk, ts, ts_idx);
+            matched += cur_pk == pk ? 1 : 0;
+        }
+    }
+    consumed = ::baidu::common::timer::get_micros() - consumed;
+    std::cout << "copy key check " << 10 * keys.size() << " times consumed " << consumed / 1000 << "ms, matched "
+              << matched << std::endl;
+    return matched;
+}
+
+static uint64_t RunSliceKeyCheck(const std::vector<std::string>& keys, const std::string& pk) {
+    uint64_t consumed = ::baidu::common::timer::get_micros();
+    uint64_t matched = 0;
+    rocksdb::Slice pk_slice(pk);
+    for (uint32_t round = 0; round < 10; round++) {
+        for (const auto& key : keys) {
+            rocksdb::Slice cur_pk;
+            uint64_t ts = 0;
+            uint32_t ts_idx = UINT32_MAX;
+            ParseKeyAndTs(false, key, &cur_pk, &ts, &ts_idx);
+            matched += cur_pk == pk_slice ? 1 : 0;
+        }
+    }
+    consumed = ::baidu::common::timer::get_micros() - consumed;
+    std::cout << "slice key check " << 10 * keys.size() << " times consumed " << consumed / 1000 << "ms, matched "
+              << matched << std::endl;
+    return matched;
+}
+
+TEST_F(DiskTableBenchmarkTest, KeyCheck) {
+    std::vector<std::string> keys;
+    for (uint32_t i = 0; i < KEY_NUM; i++) {
+        std::string pk = "card_no_000000000" + std::to_string(i % 100);
+        for (uint32_t j = 0; j < RECORD_PER_KEY; j++) {
+            keys.push_back(CombineKeyTs(pk, 1552619498000 + j));
+        }
+    }
+    std::string pk = "card_no_0000000000";
+    uint64_t copy_matched = RunCopyKeyCheck(keys, pk);
+    uint64_t slice_matched = RunSliceKeyCheck(keys, pk);
+    ASSERT_EQ(copy_matched, slice_matched);
+    ASSERT_EQ(10u * KEY_NUM / 100 * RECORD_PER_KEY, slice_matched);
+}
+
+TEST_F(DiskTableBenchmarkTest, PutAndScan) {
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    std::string table_path = FLAGS_hdd_root_path + "/1_1";
+    DiskTable* table = new DiskTable("bench_table", 1, 1, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime,
+                                     ::openmldb::common::StorageMode::kHDD, table_path);
+    ASSERT_TRUE(table->Init());
+    std::string value(128, 'a');
+    uint64_t consumed = ::baidu::common::timer::get_micros();
+    for (uint32_t i = 0; i < KEY_NUM; i++) {
+        std::string key = "key" + std::to_string(i);
+        for (uint32_t j = 0; j < RECORD_PER_KEY; j++) {
+            ASSERT_TRUE(table->Put(key, 9527 + j, value.c_str(), value.size()));
+        }
+    }
+    consumed = ::baidu::common::timer::get_micros() - consumed;
+    std::cout << "put " << KEY_NUM * RECORD_PER_KEY << " records consumed " << consumed / 1000 << "ms" << std::endl;
+
+    consumed = ::baidu::common::timer::get_micros();
+    uint64_t cnt = 0;
+    for (uint32_t i = 0; i < KEY_NUM; i++) {
+        Ticket ticket;
+        TableIterator* it = table->NewIterator("key" + std::to_string(i), ticket);
+        it->SeekToFirst();
+        while (it->Valid()) {
+            cnt++;
+            it->Next();
+        }
+        delete it;
+    }
+    consumed = ::baidu::common::timer::get_micros() - consumed;
+    std::cout << "scan " << cnt << " records consumed " << consumed / 1000 << "ms" << std::endl;
+    ASSERT_EQ(KEY_NUM * RECORD_PER_KEY, cnt);
+    delete table;
+    ::openmldb::base::RemoveDir(table_path);
+}
+
+}  // namespace storage
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    ::openmldb::base::SetLogLevel(INFO);
+    FLAGS_hdd_root_path = "/tmp/disk_table_bench_test";
+    return RUN_ALL_TESTS();
+}
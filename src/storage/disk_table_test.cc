@@ -77,6 +77,40 @@ TEST_F(DiskTableTest, ParseKeyAndTs) {
     ASSERT_EQ(1122, (int64_t)ts);
 }
 
+TEST_F(DiskTableTest, ParseKeyAndTsWithoutCopy) {
+    std::string combined_key = CombineKeyTs("abcdexxx11", 1552619498000, 3);
+    rocksdb::Slice key;
+    uint64_t ts = 0;
+    uint32_t ts_idx = 0;
+    ASSERT_EQ(0, ParseKeyAndTs(true, combined_key, &key, &ts, &ts_idx));
+    ASSERT_EQ("abcdexxx11", key.ToString());
+    ASSERT_EQ(combined_key.data(), key.data());
+    ASSERT_EQ(1552619498000, (int64_t)ts);
+    ASSERT_EQ(3u, ts_idx);
+    combined_key = CombineKeyTs("abc", 1);
+    ASSERT_EQ(0, ParseKeyAndTs(false, combined_key, &key, &ts, &ts_idx));
+    ASSERT_EQ("abc", key.ToString());
+    ASSERT_EQ(1, (int64_t)ts);
+    ASSERT_EQ(-1, ParseKeyAndTs(false, "abc", &key, &ts, &ts_idx));
+    ASSERT_TRUE(key.empty());
+}
+
+TEST_F(DiskTableTest, KeyTSComparator) {
+    KeyTSComparator cmp;
+    ASSERT_LT(cmp.Compare(CombineKeyTs("a", 10), CombineKeyTs("b", 10)), 0);
+    ASSERT_LT(cmp.Compare(CombineKeyTs("a", 10), CombineKeyTs("ab", 20)), 0);
+    ASSERT_GT(cmp.Compare(CombineKeyTs("ab", 10), CombineKeyTs("a", 20)), 0);
+    // ts is in desc order
+    ASSERT_LT(cmp.Compare(CombineKeyTs("a", 20), CombineKeyTs("a", 10)), 0);
+    ASSERT_GT(cmp.Compare(CombineKeyTs("a", 10), CombineKeyTs("a", 20)), 0);
+    ASSERT_EQ(0, cmp.Compare(CombineKeyTs("a", 10), CombineKeyTs("a", 10)));
+    ASSERT_EQ(0, cmp.Compare(CombineKeyTs("", 10), CombineKeyTs("", 10)));
+    // ts_pos is compared before ts
+    ASSERT_LT(cmp.Compare(CombineKeyTs("a", 10, 1), CombineKeyTs("a", 20, 2)), 0);
+    ASSERT_LT(cmp.Compare(CombineKeyTs("a", 20, 1), CombineKeyTs("a", 10, 1)), 0);
+    ASSERT_LT(cmp.Compare("abc", CombineKeyTs("a", 10)), 0);
+}
+
 TEST_F(DiskTableTest, Put) {
     std::map<std::string, uint32_t> mapping;
     mapping.insert(std::make_pair("idx0", 0));
@@ -0,0 +1,184 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/key_hash_index.h"
+
+#include "base/epoch.h"
+#include "base/hash.h"
+
+namespace openmldb {
+namespace storage {
+
+static constexpr uint64_t EMPTY_HASH = 0;
+static constexpr uint64_t DELETED_HASH = 1;
+static constexpr uint32_t KEY_HASH_SEED = 0xe17a1465;
+
+static uint64_t RoundUpPowerOfTwo(uint64_t n) {
+    uint64_t cap = 1;
+    while (cap < n) {
+        cap <<= 1;
+    }
+    return cap;
+}
+
+KeyHashIndex::Table::Table(uint64_t cap) : capacity(cap), used(0), slots(new Slot[cap]) {
+    for (uint64_t i = 0; i < cap; i++) {
+        slots[i].hash.store(EMPTY_HASH, std::memory_order_relaxed);
+        slots[i].key = NULL;
+        slots[i].size = 0;
+        slots[i].value = NULL;
+    }
+}
+
+KeyHashIndex::Table::~Table() { delete[] slots; }
+
+KeyHashIndex::KeyHashIndex(uint64_t init_capacity)
+    : table_(NULL), init_capacity_(RoundUpPowerOfTwo(init_capacity < 16 ? 16 : init_capacity)), key_cnt_(0) {
+    table_.store(new Table(init_capacity_), std::memory_order_release);
+}
+
+KeyHashIndex::~KeyHashIndex() {
+    delete table_.load(std::memory_order_relaxed);
+    for (auto& kv : retired_) {
+        delete kv.second;
+    }
+}
+
+uint64_t KeyHashIndex::Hash(const Slice& key) {
+    uint64_t hash = ::openmldb::base::MurmurHash64A(key.data(), key.size(), KEY_HASH_SEED);
+    // keep the marks of empty and deleted slot
+    return hash <= DELETED_HASH ? hash + 2 : hash;
+}
+
+const KeyHashIndex::Slot* KeyHashIndex::Find(const Table* table, const Slice& key, uint64_t hash) const {
+    uint64_t mask = table->capacity - 1;
+    for (uint64_t i = 0, pos = hash & mask; i < table->capacity; i++, pos = (pos + 1) & mask) {
+        const Slot& slot = table->slots[pos];
+        uint64_t cur = slot.hash.load(std::memory_order_acquire);
+        if (cur == EMPTY_HASH) {
+            return NULL;
+        }
+        if (cur == hash && Match(slot, key)) {
+            return &slot;
+        }
+    }
+    return NULL;
+}
+
+bool KeyHashIndex::Get(const Slice& key, uint64_t hash, void** value) const {
+    const Slot* slot = Find(table_.load(std::memory_order_acquire), key, hash);
+    if (slot == NULL) {
+        return false;
+    }
+    *value = slot->value;
+    return true;
+}
+
+void KeyHashIndex::Insert(const Slice& key, uint64_t hash, void* value) {
+    Table* table = table_.load(std::memory_order_relaxed);
+    // keep the load factor under 3/4 so that probing ends soon
+    if ((table->used + 1) * 4 > table->capacity * 3) {
+        Grow();
+        table = table_.load(std::memory_order_relaxed);
+    }
+    uint64_t mask = table->capacity - 1;
+    uint64_t pos = hash & mask;
+    while (table->slots[pos].hash.load(std::memory_order_relaxed) != EMPTY_HASH) {
+        pos = (pos + 1) & mask;
+    }
+    Slot& slot = table->slots[pos];
+    slot.key = key.data();
+    slot.size = key.size();
+    slot.value = value;
+    slot.hash.store(hash, std::memory_order_release);
+    table->used++;
+    key_cnt_++;
+}
+
+bool KeyHashIndex::Remove(const Slice& key, uint64_t hash) {
+    Slot* slot = const_cast<Slot*>(Find(table_.load(std::memory_order_relaxed), key, hash));
+    if (slot == NULL) {
+        return false;
+    }
+    slot->hash.store(DELETED_HASH, std::memory_order_release);
+    key_cnt_--;
+    return true;
+}
+
+void KeyHashIndex::Grow() {
+    Table* old_table = table_.load(std::memory_order_relaxed);
+    // the deleted slots are dropped, so the table may not grow if many keys
+    // have been removed
+    uint64_t cap = RoundUpPowerOfTwo((key_cnt_ + 1) * 2);
+    if (cap < init_capacity_) {
+        cap = init_capacity_;
+    }
+    auto* table = new Table(cap);
+    uint64_t mask = cap - 1;
+    for (uint64_t i = 0; i < old_table->capacity; i++) {
+        const Slot& old_slot = old_table->slots[i];
+        uint64_t hash = old_slot.hash.load(std::memory_order_relaxed);
+        if (hash == EMPTY_HASH || hash == DELETED_HASH) {
+            continue;
+        }
+        uint64_t pos = hash & mask;
+        while (table->slots[pos].hash.load(std::memory_order_relaxed) != EMPTY_HASH) {
+            pos = (pos + 1) & mask;
+        }
+        Slot& slot = table->slots[pos];
+        slot.key = old_slot.key;
+        slot.size = old_slot.size;
+        slot.value = old_slot.value;
+        slot.hash.store(hash, std::memory_order_relaxed);
+        table->used++;
+    }
+    table_.store(table, std::memory_order_release);
+    uint64_t epoch = ::openmldb::base::EpochManager::GetInstance()->GetRetireEpoch();
+    std::lock_guard<std::mutex> lock(retired_mu_);
+    retired_.emplace_back(epoch, old_table);
+}
+
+void KeyHashIndex::GcRetired(uint64_t epoch) {
+    std::vector<Table*> tables;
+    {
+        std::lock_guard<std::mutex> lock(retired_mu_);
+        auto it = retired_.begin();
+        while (it != retired_.end()) {
+            if (it->first <= epoch) {
+                tables.push_back(it->second);
+                it = retired_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    for (Table* table : tables) {
+        delete table;
+    }
+}
+
+void KeyHashIndex::Clear() {
+    delete table_.exchange(new Table(init_capacity_), std::memory_order_acq_rel);
+    key_cnt_ = 0;
+    std::lock_guard<std::mutex> lock(retired_mu_);
+    for (auto& kv : retired_) {
+        delete kv.second;
+    }
+    retired_.clear();
+}
+
+}  // namespace storage
+}  // namespace openmldb
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_STORAGE_KEY_HASH_INDEX_H_
+#define SRC_STORAGE_KEY_HASH_INDEX_H_
+
+#include <atomic>
+#include <mutex>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "base/slice.h"
+
+namespace openmldb {
+namespace storage {
+
+using ::openmldb::base::Slice;
+
+// KeyHashIndex maps pk to the value of KeyEntries with open addressing, so
+// that point access need not search the key skiplist. Get is lock free, Insert
+// and Remove must be serialized by the caller (Segment::mu_).
+//
+// A slot is never reused once it is published, a removed slot is marked as
+// deleted and dropped when the table grows. The table replaced by growing is
+// retired with the epoch of base::EpochManager and freed by GcRetired, the
+// same as the removed key entries in entry_free_list_.
+class KeyHashIndex {
+ public:
+    explicit KeyHashIndex(uint64_t init_capacity = 1024);
+    ~KeyHashIndex();
+    KeyHashIndex(const KeyHashIndex&) = delete;
+    KeyHashIndex& operator=(const KeyHashIndex&) = delete;
+
+    // compute once and pass to the following functions for the same key
+    static uint64_t Hash(const Slice& key);
+
+    bool Get(const Slice& key, uint64_t hash, void** value) const;
+
+    // key must not be in the index. the memory of key is referenced until the
+    // key is removed, it should be the pk owned by KeyEntries
+    void Insert(const Slice& key, uint64_t hash, void* value);
+
+    bool Remove(const Slice& key, uint64_t hash);
+
+    // free the tables retired with an epoch not greater than epoch
+    void GcRetired(uint64_t epoch);
+
+    // drop all keys, there must be no reader
+    void Clear();
+
+    uint64_t GetCapacity() const { return table_.load(std::memory_order_relaxed)->capacity; }
+
+ private:
+    struct Slot {
+        // 0 means empty and 1 means deleted
+        std::atomic<uint64_t> hash;
+        const char* key;
+        uint32_t size;
+        void* value;
+    };
+
+    struct Table {
+        explicit Table(uint64_t cap);
+        ~Table();
+        uint64_t capacity;
+        // the slots ever used, including the deleted ones
+        uint64_t used;
+        Slot* slots;
+    };
+
+    static inline bool Match(const Slot& slot, const Slice& key) {
+        return slot.size == key.size() && memcmp(slot.key, key.data(), key.size()) == 0;
+    }
+    const Slot* Find(const Table* table, const Slice& key, uint64_t hash) const;
+    void Grow();
+
+    std::atomic<Table*> table_;
+    uint64_t init_capacity_;
+    uint64_t key_cnt_;
+    std::mutex retired_mu_;
+    std::vector<std::pair<uint64_t, Table*>> retired_;
+};
+
+}  // namespace storage
+}  // namespace openmldb
+#endif  // SRC_STORAGE_KEY_HASH_INDEX_H_
@@ -17,6 +17,7 @@
 #include "storage/mem_table.h"
 
 #include <algorithm>
+#include <memory>
 #include <utility>
 
 #include "base/glog_wapper.h"
@@ -32,6 +33,7 @@ DECLARE_uint32(key_entry_max_height);
 DECLARE_uint32(absolute_default_skiplist_height);
 DECLARE_uint32(latest_default_skiplist_height);
 DECLARE_uint32(max_traverse_cnt);
+DECLARE_uint32(scan_epoch_renew_interval);
 
 namespace openmldb {
 namespace storage {
@@ -103,16 +105,18 @@ bool MemTable::Init() {
             cur_key_entry_max_height = inner_indexs->at(i)->GetKeyEntryMaxHeight(FLAGS_absolute_default_skiplist_height,
                                                                                  FLAGS_latest_default_skiplist_height);
         }
+        // the ttl type only matters for a segment with one ts index
+        TTLType ttl_type = inner_indexs->at(i)->GetIndex().front()->GetTTLType();
         Segment** seg_arr = new Segment*[seg_cnt_];
         if (!ts_vec.empty()) {
             for (uint32_t j = 0; j < seg_cnt_; j++) {
-                seg_arr[j] = new Segment(cur_key_entry_max_height, ts_vec);
+                seg_arr[j] = new Segment(cur_key_entry_max_height, ts_vec, ttl_type);
                 PDLOG(INFO, "init %u, %u segment. height %u, ts col num %u. tid %u pid %u", i, j,
                       cur_key_entry_max_height, ts_vec.size(), id_, pid_);
             }
         } else {
             for (uint32_t j = 0; j < seg_cnt_; j++) {
-                seg_arr[j] = new Segment(cur_key_entry_max_height);
+                seg_arr[j] = new Segment(cur_key_entry_max_height, ttl_type);
                 PDLOG(INFO, "init %u, %u segment. height %u tid %u pid %u", i, j, cur_key_entry_max_height, id_, pid_);
             }
         }
@@ -135,13 +139,15 @@ bool MemTable::Put(const std::string& pk, uint64_t time, const char* data, uint3
     }
     Segment* segment = segments_[0][index];
     Slice spk(pk);
-    segment->Put(spk, time, data, size);
+    segment->Put(spk, time, data, size, segment->HashKey(spk));
     record_cnt_.fetch_add(1, std::memory_order_relaxed);
     record_byte_size_.fetch_add(GetRecordSize(size));
     return true;
 }
 
-bool MemTable::Put(uint64_t time, const std::string& value, const Dimensions& dimensions) {
+bool MemTable::ParseRow(uint64_t time, const std::string& value, const Dimensions& dimensions,
+                        std::map<int32_t, Slice>* inner_index_key_map, std::map<int32_t, uint64_t>* ts_map,
+                        uint32_t* ref_cnt) {
     if (dimensions.empty()) {
         PDLOG(WARNING, "empty dimension. tid %u pid %u", id_, pid_);
         return false;
@@ -150,14 +156,13 @@ bool MemTable::Put(uint64_t time, const std::string& value, const Dimensions& di
         PDLOG(WARNING, "invalid value. tid %u pid %u", id_, pid_);
         return false;
     }
-    std::map<int32_t, Slice> inner_index_key_map;
     for (auto iter = dimensions.begin(); iter != dimensions.end(); iter++) {
         int32_t inner_pos = table_index_.GetInnerIndexPos(iter->idx());
         if (inner_pos < 0) {
             PDLOG(WARNING, "invalid dimension. dimension idx %u, tid %u pid %u", iter->idx(), id_, pid_);
             return false;
         }
-        inner_index_key_map.emplace(inner_pos, iter->key());
+        inner_index_key_map->emplace(inner_pos, iter->key());
     }
     uint32_t real_ref_cnt = 0;
     const int8_t* data = reinterpret_cast<const int8_t*>(value.data());
@@ -167,8 +172,7 @@ bool MemTable::Put(uint64_t time, const std::string& value, const Dimensions& di
         PDLOG(WARNING, "invalid schema version %u, tid %u pid %u", version, id_, pid_);
         return false;
     }
-    std::map<int32_t, uint64_t> ts_map;
-    for (const auto& kv : inner_index_key_map) {
+    for (const auto& kv : *inner_index_key_map) {
         auto inner_index = table_index_.GetInnerIndex(kv.first);
         if (!inner_index) {
             PDLOG(WARNING, "invalid inner index pos %d. tid %u pid %u", kv.first, id_, pid_);
@@ -184,17 +188,28 @@ bool MemTable::Put(uint64_t time, const std::string& value, const Dimensions& di
                     PDLOG(WARNING, "get ts failed. tid %u pid %u", id_, pid_);
                     return false;
                 }
-                ts_map.emplace(ts_col->GetId(), ts);
+                ts_map->emplace(ts_col->GetId(), ts);
             }
             if (index_def->IsReady()) {
                 real_ref_cnt++;
             }
         }
     }
-    if (ts_map.empty()) {
+    if (ts_map->empty()) {
         return false;
     }
-    auto* block = new DataBlock(real_ref_cnt, value.c_str(), value.length());
+    *ref_cnt = real_ref_cnt;
+    return true;
+}
+
+bool MemTable::Put(uint64_t time, const std::string& value, const Dimensions& dimensions) {
+    std::map<int32_t, Slice> inner_index_key_map;
+    std::map<int32_t, uint64_t> ts_map;
+    uint32_t real_ref_cnt = 0;
+    if (!ParseRow(time, value, dimensions, &inner_index_key_map, &ts_map, &real_ref_cnt)) {
+        return false;
+    }
+    auto* block = DataBlock::New(real_ref_cnt, value.c_str(), value.length());
     for (const auto& kv : inner_index_key_map) {
         auto inner_index = table_index_.GetInnerIndex(kv.first);
         bool need_put = false;
@@ -211,7 +226,7 @@ bool MemTable::Put(uint64_t time, const std::string& value, const Dimensions& di
                 seg_idx = ::openmldb::base::hash(kv.second.data(), kv.second.size(), SEED) % seg_cnt_;
             }
             Segment* segment = segments_[kv.first][seg_idx];
-            segment->Put(::openmldb::base::Slice(kv.second), ts_map, block);
+            segment->Put(kv.second, ts_map, block, segment->HashKey(kv.second));
         }
     }
     record_cnt_.fetch_add(1, std::memory_order_relaxed);
@@ -219,19 +234,74 @@ bool MemTable::Put(uint64_t time, const std::string& value, const Dimensions& di
     return true;
 }
 
-bool MemTable::Delete(const std::string& pk, uint32_t idx) {
+bool MemTable::GetRowPlacement(uint64_t time, const std::string& value, const Dimensions& dimensions,
+                               std::vector<RowPlacement>* placements, uint32_t* ref_cnt) {
+    std::map<int32_t, Slice> inner_index_key_map;
+    std::map<int32_t, uint64_t> ts_map;
+    if (!ParseRow(time, value, dimensions, &inner_index_key_map, &ts_map, ref_cnt)) {
+        return false;
+    }
+    for (const auto& kv : inner_index_key_map) {
+        auto inner_index = table_index_.GetInnerIndex(kv.first);
+        bool need_put = false;
+        for (const auto& index_def : inner_index->GetIndex()) {
+            if (index_def->IsReady()) {
+                need_put = true;
+                break;
+            }
+        }
+        if (!need_put) {
+            continue;
+        }
+        uint32_t seg_idx = 0;
+        if (seg_cnt_ > 1) {
+            seg_idx = ::openmldb::base::hash(kv.second.data(), kv.second.size(), SEED) % seg_cnt_;
+        }
+        // the same as Segment::Put with ts_map
+        Segment* segment = segments_[kv.first][seg_idx];
+        const auto& ts_idx_map = segment->GetTsIdxMap();
+        if (ts_idx_map.empty()) {
+            continue;
+        }
+        if (segment->GetTsCnt() == 1) {
+            auto pos = ts_map.find(ts_idx_map.begin()->first);
+            if (pos != ts_map.end()) {
+                placements->push_back({(uint32_t)kv.first, seg_idx, 0, pos->second, kv.second});
+            }
+            continue;
+        }
+        for (const auto& ts_kv : ts_map) {
+            auto pos = ts_idx_map.find(ts_kv.first);
+            if (pos != ts_idx_map.end()) {
+                placements->push_back({(uint32_t)kv.first, seg_idx, pos->second, ts_kv.second, kv.second});
+            }
+        }
+    }
+    return true;
+}
+
+Segment* MemTable::GetIndexSegment(uint32_t idx, const Slice& pk, uint32_t* inner_pos, uint32_t* seg_idx) {
     std::shared_ptr<IndexDef> index_def = GetIndex(idx);
     if (!index_def || !index_def->IsReady()) {
-        return false;
+        return NULL;
     }
+    *seg_idx = 0;
+    if (seg_cnt_ > 1) {
+        *seg_idx = ::openmldb::base::hash(pk.data(), pk.size(), SEED) % seg_cnt_;
+    }
+    *inner_pos = index_def->GetInnerPos();
+    return segments_[*inner_pos][*seg_idx];
+}
+
+bool MemTable::Delete(const std::string& pk, uint32_t idx) {
     Slice spk(pk);
+    uint32_t inner_pos = 0;
     uint32_t seg_idx = 0;
-    if (seg_cnt_ > 1) {
-        seg_idx = ::openmldb::base::hash(spk.data(), spk.size(), SEED) % seg_cnt_;
+    Segment* segment = GetIndexSegment(idx, spk, &inner_pos, &seg_idx);
+    if (segment == NULL) {
+        return false;
     }
-    uint32_t real_idx = index_def->GetInnerPos();
-    Segment* segment = segments_[real_idx][seg_idx];
-    return segment->Delete(spk);
+    return segment->Delete(spk, segment->HashKey(spk));
 }
 
 uint64_t MemTable::Release() {
@@ -260,6 +330,8 @@ void MemTable::SchedGc() {
     uint64_t gc_idx_cnt = 0;
     uint64_t gc_record_cnt = 0;
     uint64_t gc_record_byte_size = 0;
+    uint64_t gc_visited_key_cnt = 0;
+    uint64_t gc_collected_key_cnt = 0;
     auto inner_indexs = table_index_.GetAllInnerIndex();
     for (uint32_t i = 0; i < inner_indexs->size(); i++) {
         const std::vector<std::shared_ptr<IndexDef>>& real_index = inner_indexs->at(i)->GetIndex();
@@ -302,13 +374,16 @@ void MemTable::SchedGc() {
         for (uint32_t j = 0; j < seg_cnt_; j++) {
             uint64_t seg_gc_time = ::baidu::common::timer::get_micros() / 1000;
             Segment* segment = segments_[i][j];
-            segment->IncrGcVersion();
             segment->GcFreeList(gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+            uint64_t visited_key_cnt = segment->GetGcVisitedKeyCnt();
+            uint64_t collected_key_cnt = segment->GetGcCollectedKeyCnt();
             if (ttl_st_map.size() == 1) {
                 segment->ExecuteGc(ttl_st_map.begin()->second, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
             } else {
                 segment->ExecuteGc(ttl_st_map, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
             }
+            gc_visited_key_cnt += segment->GetGcVisitedKeyCnt() - visited_key_cnt;
+            gc_collected_key_cnt += segment->GetGcCollectedKeyCnt() - collected_key_cnt;
             seg_gc_time = ::baidu::common::timer::get_micros() / 1000 - seg_gc_time;
             PDLOG(INFO, "gc segment[%u][%u] done consumed %lu for table %s tid %u pid %u", i, j, seg_gc_time,
                   name_.c_str(), id_, pid_);
@@ -318,9 +393,10 @@ void MemTable::SchedGc() {
     record_cnt_.fetch_sub(gc_record_cnt, std::memory_order_relaxed);
     record_byte_size_.fetch_sub(gc_record_byte_size, std::memory_order_relaxed);
     PDLOG(INFO,
-          "gc finished, gc_idx_cnt %lu, gc_record_cnt %lu consumed %lu ms for "
-          "table %s tid %u pid %u",
-          gc_idx_cnt, gc_record_cnt, consumed / 1000, name_.c_str(), id_, pid_);
+          "gc finished, gc_idx_cnt %lu, gc_record_cnt %lu, ttl gc visited keys %lu, collected keys %lu, "
+          "consumed %lu ms for table %s tid %u pid %u",
+          gc_idx_cnt, gc_record_cnt, gc_visited_key_cnt, gc_collected_key_cnt, consumed / 1000, name_.c_str(), id_,
+          pid_);
     UpdateTTL();
 }
 
@@ -435,11 +511,12 @@ int MemTable::GetCount(uint32_t index, const std::string& pk, uint64_t& count) {
     Slice spk(pk);
     uint32_t real_idx = index_def->GetInnerPos();
     Segment* segment = segments_[real_idx][seg_idx];
+    uint64_t hash = segment->HashKey(spk);
     auto ts_col = index_def->GetTsColumn();
     if (ts_col) {
-        return segment->GetCount(spk, ts_col->GetId(), count);
+        return segment->GetCount(spk, ts_col->GetId(), count, hash);
     }
-    return segment->GetCount(spk, count);
+    return segment->GetCount(spk, count, hash);
 }
 
 TableIterator* MemTable::NewIterator(const std::string& pk, Ticket& ticket) { return NewIterator(0, pk, ticket); }
@@ -457,11 +534,12 @@ TableIterator* MemTable::NewIterator(uint32_t index, const std::string& pk, Tick
     Slice spk(pk);
     uint32_t real_idx = index_def->GetInnerPos();
     Segment* segment = segments_[real_idx][seg_idx];
+    uint64_t hash = segment->HashKey(spk);
     auto ts_col = index_def->GetTsColumn();
     if (ts_col) {
-        return segment->NewIterator(spk, ts_col->GetId(), ticket);
+        return segment->NewIterator(spk, ts_col->GetId(), ticket, hash);
     }
-    return segment->NewIterator(spk, ticket);
+    return segment->NewIterator(spk, ticket, hash);
 }
 
 uint64_t MemTable::GetRecordIdxByteSize() {
@@ -587,10 +665,12 @@ bool MemTable::AddIndex(const ::openmldb::common::ColumnKey& column_key) {
         } else {
             ts_vec.push_back(DEFUALT_TS_COL_ID);
         }
+        ::openmldb::storage::TTLSt ttl_st = column_key.has_ttl() ? ::openmldb::storage::TTLSt(column_key.ttl())
+                                                                 : *(table_index_.GetIndex(0)->GetTTL());
         uint32_t inner_id = table_index_.GetAllInnerIndex()->size();
         Segment** seg_arr = new Segment*[seg_cnt_];
         for (uint32_t j = 0; j < seg_cnt_; j++) {
-            seg_arr[j] = new Segment(FLAGS_absolute_default_skiplist_height, ts_vec);
+            seg_arr[j] = new Segment(FLAGS_absolute_default_skiplist_height, ts_vec, ttl_st.ttl_type);
             PDLOG(INFO, "init %u, %u segment. height %u, ts col num %u. tid %u pid %u", inner_id, j,
                   FLAGS_absolute_default_skiplist_height, ts_vec.size(), id_, pid_);
         }
@@ -608,11 +688,7 @@ bool MemTable::AddIndex(const ::openmldb::common::ColumnKey& column_key) {
             index_def->SetTsColumn(std::make_shared<ColumnDef>(DEFUALT_TS_COL_NAME, DEFUALT_TS_COL_ID,
                         ::openmldb::type::kTimestamp, true));
         }
-        if (column_key.has_ttl()) {
-            index_def->SetTTL(::openmldb::storage::TTLSt(column_key.ttl()));
-        } else {
-            index_def->SetTTL(*(table_index_.GetIndex(0)->GetTTL()));
-        }
+        index_def->SetTTL(ttl_st);
         index_def->SetInnerPos(inner_id);
         std::vector<std::shared_ptr<IndexDef>> index_vec = {index_def};
         auto inner_index_st = std::make_shared<InnerIndexSt>(inner_id, index_vec);
@@ -749,6 +825,7 @@ bool MemTable::BulkLoad(const std::vector<DataBlock*>& data_blocks,
             for (int key_idx = 0; key_idx < segment_index.key_entries_size(); ++key_idx) {
                 const auto& key_entries = segment_index.key_entries(key_idx);
                 auto pk = Slice(key_entries.key());
+                uint64_t hash = segment->HashKey(pk);
                 for (int key_entry_idx = 0; key_entry_idx < key_entries.key_entry_size(); ++key_entry_idx) {
                     const auto& key_entry = key_entries.key_entry(key_entry_idx);
                     auto key_entry_id = key_entry.key_entry_id();
@@ -766,7 +843,7 @@ bool MemTable::BulkLoad(const std::vector<DataBlock*>& data_blocks,
                                 << ", time " << time_entry.time() << ", key_entry_id " << key_entry_id << ", block id "
                                 << time_entry.block_id();
                         block->dim_cnt_down++;
-                        segment->BulkLoadPut(key_entry_id, pk, time_entry.time(), block);
+                        segment->BulkLoadPut(key_entry_id, pk, time_entry.time(), block, hash);
                     }
                 }
             }
@@ -776,6 +853,30 @@ bool MemTable::BulkLoad(const std::vector<DataBlock*>& data_blocks,
     return true;
 }
 
+// move pk_it to the next key entry of segment. a full table scan renews its
+// ticket here once it has held the epoch for scan_epoch_renew_interval, then the
+// entries visited before may be freed, so pk_it is sought again from its key.
+// the rows got from the scan stay valid unless gc removes them meanwhile
+static void NextKeyEntry(Segment* segment, Ticket* ticket, uint64_t* ticket_time, KeyEntries::Iterator** pk_it) {
+    uint64_t interval = FLAGS_scan_epoch_renew_interval;
+    uint64_t cur_time = interval > 0 ? ::baidu::common::timer::get_micros() / 1000 : 0;
+    if (interval == 0 || cur_time < *ticket_time + interval) {
+        (*pk_it)->Next();
+        return;
+    }
+    std::string pk = (*pk_it)->GetKey().ToString();
+    delete *pk_it;
+    ticket->Renew();
+    *ticket_time = cur_time;
+    Slice spk(pk);
+    *pk_it = segment->GetKeyEntries()->NewIterator();
+    (*pk_it)->Seek(spk);
+    // the key may be removed by gc, then seek stops at the next one already
+    if ((*pk_it)->Valid() && spk.compare((*pk_it)->GetKey()) == 0) {
+        (*pk_it)->Next();
+    }
+}
+
 MemTableKeyIterator::MemTableKeyIterator(Segment** segments, uint32_t seg_cnt, ::openmldb::storage::TTLType ttl_type,
                                          uint64_t expire_time, uint64_t expire_cnt, uint32_t ts_index)
     : segments_(segments),
@@ -787,6 +888,7 @@ MemTableKeyIterator::MemTableKeyIterator(Segment** segments, uint32_t seg_cnt, :
       expire_time_(expire_time),
       expire_cnt_(expire_cnt),
       ticket_(),
+      ticket_time_(::baidu::common::timer::get_micros() / 1000),
       ts_idx_(0) {
     uint32_t idx = 0;
     if (segments_[0]->GetTsIdx(ts_index, idx) == 0) {
@@ -799,7 +901,6 @@ MemTableKeyIterator::~MemTableKeyIterator() {
 }
 
 void MemTableKeyIterator::SeekToFirst() {
-    ticket_.Pop();
     if (pk_it_ != NULL) {
         delete pk_it_;
         pk_it_ = NULL;
@@ -818,7 +919,6 @@ void MemTableKeyIterator::Seek(const std::string& key) {
         delete pk_it_;
         pk_it_ = NULL;
     }
-    ticket_.Pop();
     if (seg_cnt_ > 1) {
         seg_idx_ = ::openmldb::base::hash(key.c_str(), key.length(), SEED) % seg_cnt_;
     }
@@ -842,11 +942,9 @@ void MemTableKeyIterator::Next() { NextPK(); }
     if (segments_[seg_idx_]->GetTsCnt() > 1) {
         KeyEntry* entry = ((KeyEntry**)pk_it_->GetValue())[ts_idx_];  // NOLINT
         it = entry->entries.NewIterator();
-        ticket_.Push(entry);
     } else {
         it = ((KeyEntry*)pk_it_->GetValue())  // NOLINT
                  ->entries.NewIterator();
-        ticket_.Push((KeyEntry*)pk_it_->GetValue());  // NOLINT
     }
     it->SeekToFirst();
     return new MemTableWindowIterator(it, ttl_type_, expire_time_, expire_cnt_);
@@ -857,17 +955,74 @@ std::unique_ptr<::hybridse::vm::RowIterator> MemTableKeyIterator::GetValue() {
     if (segments_[seg_idx_]->GetTsCnt() > 1) {
         KeyEntry* entry = ((KeyEntry**)pk_it_->GetValue())[ts_idx_];  // NOLINT
         it = entry->entries.NewIterator();
-        ticket_.Push(entry);
     } else {
         it = ((KeyEntry*)pk_it_->GetValue())  // NOLINT
                  ->entries.NewIterator();
-        ticket_.Push((KeyEntry*)pk_it_->GetValue());  // NOLINT
     }
     it->SeekToFirst();
     std::unique_ptr<MemTableWindowIterator> wit(new MemTableWindowIterator(it, ttl_type_, expire_time_, expire_cnt_));
     return std::move(wit);
 }
 
+KeyEntry* MemTableKeyIterator::GetKeyEntry() {
+    KeyEntry* entry = nullptr;
+    if (segments_[seg_idx_]->GetTsCnt() > 1) {
+        entry = ((KeyEntry**)pk_it_->GetValue())[ts_idx_];  // NOLINT
+    } else {
+        entry = (KeyEntry*)pk_it_->GetValue();  // NOLINT
+    }
+    return entry;
+}
+
+uint64_t MemTableKeyIterator::GetValueCount() { return CountEntry(GetKeyEntry()); }
+
+uint64_t MemTableKeyIterator::CountEntry(KeyEntry* entry) {
+    uint64_t cnt = entry->GetCount();
+    if (cnt == 0) {
+        return 0;
+    }
+    // rows are in descending order of ts, so the expired rows always make up
+    // the tail of entries
+    TTLSt ttl(expire_time_, expire_cnt_, ttl_type_);
+    auto last = entry->entries.GetLast();
+    if (last != nullptr && !ttl.IsExpired(last->GetKey(), cnt)) {
+        return cnt;
+    }
+    if (ttl_type_ == ::openmldb::storage::TTLType::kLatestTime) {
+        return std::min(cnt, expire_cnt_);
+    }
+    cnt = 0;
+    MemTableWindowIterator it(entry->entries.NewIterator(), ttl_type_, expire_time_, expire_cnt_);
+    it.SeekToFirst();
+    while (it.Valid()) {
+        cnt++;
+        it.Next();
+    }
+    return cnt;
+}
+
+hybridse::codec::Row MemTableKeyIterator::GetValueAt(uint64_t pos) {
+    KeyEntry* entry = GetKeyEntry();
+    uint64_t cnt = CountEntry(entry);
+    if (pos >= cnt) {
+        return hybridse::codec::Row();
+    }
+    auto last = entry->entries.GetLast();
+    if (pos + 1 == cnt && cnt == entry->GetCount() && last != nullptr) {
+        return hybridse::codec::Row(
+            ::hybridse::base::RefCountedSlice::Create(last->GetValue()->data, last->GetValue()->size));
+    }
+    std::unique_ptr<TimeEntries::Iterator> it(entry->entries.NewIterator());
+    it->SeekToFirst();
+    for (uint64_t i = 0; i < pos && it->Valid(); i++) {
+        it->Next();
+    }
+    if (!it->Valid()) {
+        return hybridse::codec::Row();
+    }
+    return hybridse::codec::Row(::hybridse::base::RefCountedSlice::Create(it->GetValue()->data, it->GetValue()->size));
+}
+
 const hybridse::codec::Row MemTableKeyIterator::GetKey() {
     hybridse::codec::Row row(
         ::hybridse::base::RefCountedSlice::Create(pk_it_->GetKey().data(), pk_it_->GetKey().size()));
@@ -876,9 +1031,8 @@ const hybridse::codec::Row MemTableKeyIterator::GetKey() {
 
 void MemTableKeyIterator::NextPK() {
     do {
-        ticket_.Pop();
         if (pk_it_->Valid()) {
-            pk_it_->Next();
+            NextKeyEntry(segments_[seg_idx_], &ticket_, &ticket_time_, &pk_it_);
         }
         if (!pk_it_->Valid()) {
             delete pk_it_;
@@ -908,6 +1062,7 @@ MemTableTraverseIterator::MemTableTraverseIterator(Segment** segments, uint32_t
       ts_idx_(0),
       expire_value_(expire_time, expire_cnt, ttl_type),
       ticket_(),
+      ticket_time_(::baidu::common::timer::get_micros() / 1000),
       traverse_cnt_(0) {
     uint32_t idx = 0;
     if (segments_[0]->GetTsIdx(ts_index, idx) == 0) {
@@ -940,9 +1095,8 @@ void MemTableTraverseIterator::NextPK() {
     delete it_;
     it_ = NULL;
     do {
-        ticket_.Pop();
         if (pk_it_->Valid()) {
-            pk_it_->Next();
+            NextKeyEntry(segments_[seg_idx_], &ticket_, &ticket_time_, &pk_it_);
         }
         if (!pk_it_->Valid()) {
             delete pk_it_;
@@ -965,11 +1119,9 @@ void MemTableTraverseIterator::NextPK() {
         if (segments_[seg_idx_]->GetTsCnt() > 1) {
             KeyEntry* entry = ((KeyEntry**)pk_it_->GetValue())[0];  // NOLINT
             it_ = entry->entries.NewIterator();
-            ticket_.Push(entry);
         } else {
             it_ = ((KeyEntry*)pk_it_->GetValue())  // NOLINT
                       ->entries.NewIterator();
-            ticket_.Push((KeyEntry*)pk_it_->GetValue());  // NOLINT
         }
         it_->SeekToFirst();
         record_idx_ = 1;
@@ -989,7 +1141,6 @@ void MemTableTraverseIterator::Seek(const std::string& key, uint64_t ts) {
         delete it_;
         it_ = NULL;
     }
-    ticket_.Pop();
     if (seg_cnt_ > 1) {
         seg_idx_ = ::openmldb::base::hash(key.c_str(), key.length(), SEED) % seg_cnt_;
     }
@@ -999,11 +1150,9 @@ void MemTableTraverseIterator::Seek(const std::string& key, uint64_t ts) {
     if (pk_it_->Valid()) {
         if (segments_[seg_idx_]->GetTsCnt() > 1) {
             KeyEntry* entry = ((KeyEntry**)pk_it_->GetValue())[ts_idx_];  // NOLINT
-            ticket_.Push(entry);
             it_ = entry->entries.NewIterator();
         } else {
-            ticket_.Push((KeyEntry*)pk_it_->GetValue());  // NOLINT
-            it_ = ((KeyEntry*)pk_it_->GetValue())         // NOLINT
+            it_ = ((KeyEntry*)pk_it_->GetValue())  // NOLINT
                       ->entries.NewIterator();
         }
         if (spk.compare(pk_it_->GetKey()) != 0) {
@@ -1061,7 +1210,6 @@ std::string MemTableTraverseIterator::GetPK() const {
 }
 
 void MemTableTraverseIterator::SeekToFirst() {
-    ticket_.Pop();
     if (pk_it_ != NULL) {
         delete pk_it_;
         pk_it_ = NULL;
@@ -1076,11 +1224,9 @@ void MemTableTraverseIterator::SeekToFirst() {
         while (pk_it_->Valid()) {
             if (segments_[seg_idx_]->GetTsCnt() > 1) {
                 KeyEntry* entry = ((KeyEntry**)pk_it_->GetValue())[ts_idx_];  // NOLINT
-                ticket_.Push(entry);
                 it_ = entry->entries.NewIterator();
             } else {
-                ticket_.Push((KeyEntry*)pk_it_->GetValue());  // NOLINT
-                it_ = ((KeyEntry*)pk_it_->GetValue())         // NOLINT
+                it_ = ((KeyEntry*)pk_it_->GetValue())  // NOLINT
                           ->entries.NewIterator();
             }
             it_->SeekToFirst();
@@ -1092,7 +1238,6 @@ void MemTableTraverseIterator::SeekToFirst() {
             delete it_;
             it_ = NULL;
             pk_it_->Next();
-            ticket_.Pop();
             if (traverse_cnt_ >= FLAGS_max_traverse_cnt) {
                 return;
             }
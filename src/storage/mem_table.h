@@ -96,8 +96,15 @@ class MemTableKeyIterator : public ::hybridse::vm::WindowIterator {
 
     const hybridse::codec::Row GetKey() override;
 
+    // count with the row count of key entry, only the expired rows
+    // which have not been gc are scanned
+    uint64_t GetValueCount() override;
+    hybridse::codec::Row GetValueAt(uint64_t pos) override;
+
  private:
     void NextPK();
+    KeyEntry* GetKeyEntry();
+    uint64_t CountEntry(KeyEntry* entry);
 
  private:
     Segment** segments_;
@@ -109,7 +116,10 @@ class MemTableKeyIterator : public ::hybridse::vm::WindowIterator {
     uint64_t expire_time_;
     uint64_t expire_cnt_;
     uint32_t ts_index_{};
+    // the entries visited are not freed until the ticket is renewed, see
+    // NextKeyEntry
     Ticket ticket_;
+    uint64_t ticket_time_;
     uint32_t ts_idx_;
 };
 
@@ -140,10 +150,22 @@ class MemTableTraverseIterator : public TableIterator {
     uint32_t ts_idx_;
     // uint64_t expire_value_;
     TTLSt expire_value_;
+    // renewed between keys, so a long traverse does not hold back the memory
+    // freed by gc until it ends
     Ticket ticket_;
+    uint64_t ticket_time_;
     uint64_t traverse_cnt_;
 };
 
+// the key entry which a row is put to, key refers to the dimension of row
+struct RowPlacement {
+    uint32_t inner_pos;
+    uint32_t seg_idx;
+    uint32_t key_entry_id;
+    uint64_t ts;
+    Slice key;
+};
+
 class MemTable : public Table {
  public:
     MemTable(const std::string& name, uint32_t id, uint32_t pid, uint32_t seg_cnt,
@@ -160,6 +182,20 @@ class MemTable : public Table {
 
     bool Put(uint64_t time, const std::string& value, const Dimensions& dimensions) override;
 
+    // get the key entries which Put adds the row to without putting it, ref_cnt
+    // is the dimension count down of the row block
+    bool GetRowPlacement(uint64_t time, const std::string& value, const Dimensions& dimensions,
+                         std::vector<RowPlacement>* placements, uint32_t* ref_cnt);
+
+    inline Segment* GetSegment(uint32_t inner_pos, uint32_t seg_idx) {
+        if (inner_pos >= segments_.size() || seg_idx >= seg_cnt_ || segments_[inner_pos] == NULL) {
+            return NULL;
+        }
+        return segments_[inner_pos][seg_idx];
+    }
+
+    inline uint32_t GetInnerIndexCnt() { return table_index_.GetAllInnerIndex()->size(); }
+
     bool GetBulkLoadInfo(::openmldb::api::BulkLoadInfoResponse* response);
 
     bool BulkLoad(const std::vector<DataBlock*>& data_blocks,
@@ -167,6 +203,9 @@ class MemTable : public Table {
 
     bool Delete(const std::string& pk, uint32_t idx) override;
 
+    // get the segment which Delete removes pk from, NULL if the index is not ready
+    Segment* GetIndexSegment(uint32_t idx, const Slice& pk, uint32_t* inner_pos, uint32_t* seg_idx);
+
     // use the first demission
     TableIterator* NewIterator(const std::string& pk, Ticket& ticket) override;
 
@@ -208,7 +247,9 @@ class MemTable : public Table {
 
     inline void RecordCntIncr() { record_cnt_.fetch_add(1, std::memory_order_relaxed); }
 
-    inline void RecordCntIncr(uint32_t cnt) { record_cnt_.fetch_add(cnt, std::memory_order_relaxed); }
+    inline void RecordCntIncr(uint64_t cnt) { record_cnt_.fetch_add(cnt, std::memory_order_relaxed); }
+
+    inline void RecordByteSizeIncr(uint64_t size) { record_byte_size_.fetch_add(size, std::memory_order_relaxed); }
 
     inline uint32_t GetKeyEntryHeight() const { return key_entry_max_height_; }
 
@@ -217,6 +258,11 @@ class MemTable : public Table {
     bool AddIndex(const ::openmldb::common::ColumnKey& column_key);
 
  private:
+    // get the inner indexes and the ts of row which Put uses
+    bool ParseRow(uint64_t time, const std::string& value, const Dimensions& dimensions,
+                  std::map<int32_t, Slice>* inner_index_key_map, std::map<int32_t, uint64_t>* ts_map,
+                  uint32_t* ref_cnt);
+
     bool CheckAbsolute(const TTLSt& ttl, uint64_t ts);
 
     bool CheckLatest(uint32_t index_id, const std::string& key, uint64_t ts);
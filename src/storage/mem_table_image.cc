@@ -0,0 +1,506 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/mem_table_image.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>  // NOLINT
+
+#include "base/glog_wapper.h"
+#include "log/coding.h"
+#include "log/crc32c.h"
+#include "storage/record.h"
+
+namespace openmldb {
+namespace storage {
+
+static const char IMAGE_MAGIC[] = "OMDBIMG1";
+static constexpr uint32_t IMAGE_MAGIC_SIZE = 8;
+static constexpr uint32_t IMAGE_VERSION = 2;
+static constexpr uint32_t IMAGE_HEADER_SIZE = IMAGE_MAGIC_SIZE + 24;
+static constexpr uint32_t IMAGE_BLOCK_HEADER_SIZE = 12;
+static constexpr uint32_t IMAGE_BLOCK_SIZE = 1 << 20;
+static constexpr uint32_t IMAGE_SECTION_META_SIZE = 36;
+static constexpr uint32_t IMAGE_FOOTER_TAIL_SIZE = 4 + 8 + IMAGE_MAGIC_SIZE;
+static constexpr uint32_t SECTION_ROWS = 0;
+static constexpr uint32_t SECTION_SEGMENT = 1;
+
+using ::openmldb::log::DecodeFixed32;
+using ::openmldb::log::DecodeFixed64;
+using ::openmldb::log::EncodeFixed32;
+using ::openmldb::log::EncodeFixed64;
+
+static void PutFixed32(std::string* dst, uint32_t value) {
+    char buf[4];
+    EncodeFixed32(buf, value);
+    dst->append(buf, 4);
+}
+
+static void PutFixed64(std::string* dst, uint64_t value) {
+    char buf[8];
+    EncodeFixed64(buf, value);
+    dst->append(buf, 8);
+}
+
+// the key entries of an image are placed by inner index and ts column, so
+// the image is only valid for the index layout it is written with
+static void GetIndexLayout(MemTable* table, uint32_t* index_cnt, uint32_t* layout_crc) {
+    std::string layout;
+    auto indexs = table->GetAllIndex();
+    for (const auto& index : indexs) {
+        PutFixed32(&layout, index->GetId());
+        PutFixed32(&layout, index->GetInnerPos());
+        const auto& ts_col = index->GetTsColumn();
+        PutFixed32(&layout, ts_col ? ts_col->GetId() : UINT32_MAX);
+    }
+    *index_cnt = indexs.size();
+    *layout_crc = ::openmldb::log::Value(layout.data(), layout.size());
+}
+
+MemTableImageWriter::MemTableImageWriter(std::shared_ptr<MemTable> table, const std::string& path)
+    : table_(table), path_(path), tmp_path_(path + ".tmp"), fd_(NULL), offset_(0), row_cnt_(0), failed_(false) {
+    rows_.type = SECTION_ROWS;
+    rows_.inner_pos = 0;
+    rows_.seg_idx = 0;
+}
+
+MemTableImageWriter::~MemTableImageWriter() { Cleanup(); }
+
+void MemTableImageWriter::Cleanup() {
+    for (auto& section : segments_) {
+        if (section && section->fd != NULL) {
+            fclose(section->fd);
+            section->fd = NULL;
+            unlink(section->path.c_str());
+        }
+    }
+    if (fd_ != NULL) {
+        fclose(fd_);
+        fd_ = NULL;
+        unlink(tmp_path_.c_str());
+    }
+}
+
+bool MemTableImageWriter::Open() {
+    fd_ = fopen(tmp_path_.c_str(), "wb");
+    if (fd_ == NULL) {
+        PDLOG(WARNING, "fail to create file %s", tmp_path_.c_str());
+        return false;
+    }
+    std::string header(IMAGE_MAGIC, IMAGE_MAGIC_SIZE);
+    PutFixed32(&header, IMAGE_VERSION);
+    PutFixed32(&header, table_->GetId());
+    PutFixed32(&header, table_->GetPid());
+    PutFixed32(&header, table_->GetSegCnt());
+    uint32_t index_cnt = 0;
+    uint32_t layout_crc = 0;
+    GetIndexLayout(table_.get(), &index_cnt, &layout_crc);
+    PutFixed32(&header, index_cnt);
+    PutFixed32(&header, layout_crc);
+    if (fwrite(header.data(), 1, header.size(), fd_) != header.size()) {
+        PDLOG(WARNING, "fail to write file %s", tmp_path_.c_str());
+        return false;
+    }
+    offset_ = header.size();
+    // the rows section is written to image file directly, the segment
+    // sections are spilled to their own files and appended by Finish
+    rows_.fd = fd_;
+    segments_.resize(table_->GetInnerIndexCnt() * table_->GetSegCnt());
+    return true;
+}
+
+MemTableImageWriter::Section* MemTableImageWriter::GetSection(uint32_t inner_pos, uint32_t seg_idx) {
+    uint32_t pos = inner_pos * table_->GetSegCnt() + seg_idx;
+    if (pos >= segments_.size()) {
+        return NULL;
+    }
+    if (!segments_[pos]) {
+        std::unique_ptr<Section> section(new Section());
+        section->type = SECTION_SEGMENT;
+        section->inner_pos = inner_pos;
+        section->seg_idx = seg_idx;
+        section->path = path_ + "." + std::to_string(inner_pos) + "_" + std::to_string(seg_idx) + ".tmp";
+        section->fd = fopen(section->path.c_str(), "wb+");
+        if (section->fd == NULL) {
+            PDLOG(WARNING, "fail to create file %s", section->path.c_str());
+            return NULL;
+        }
+        segments_[pos] = std::move(section);
+    }
+    return segments_[pos].get();
+}
+
+bool MemTableImageWriter::Add(const ::openmldb::api::LogEntry& entry) {
+    if (failed_) {
+        return false;
+    }
+    placements_.clear();
+    // the row rejected by MemTable::Put is skipped as recovering from binlog
+    uint32_t ref_cnt = 0;
+    if (!table_->GetRowPlacement(entry.ts(), entry.value(), entry.dimensions(), &placements_, &ref_cnt) ||
+        placements_.empty()) {
+        return true;
+    }
+    item_.clear();
+    item_.push_back(static_cast<char>(ref_cnt));
+    PutFixed32(&item_, entry.value().size());
+    item_.append(entry.value());
+    if (!AddItem(&rows_, item_)) {
+        failed_ = true;
+        return false;
+    }
+    for (const auto& placement : placements_) {
+        Section* section = GetSection(placement.inner_pos, placement.seg_idx);
+        if (section == NULL) {
+            failed_ = true;
+            return false;
+        }
+        item_.clear();
+        PutFixed32(&item_, placement.key.size());
+        item_.append(placement.key.data(), placement.key.size());
+        PutFixed32(&item_, placement.key_entry_id);
+        PutFixed64(&item_, placement.ts);
+        PutFixed64(&item_, row_cnt_);
+        if (!AddItem(section, item_)) {
+            failed_ = true;
+            return false;
+        }
+    }
+    row_cnt_++;
+    return true;
+}
+
+bool MemTableImageWriter::AddItem(Section* section, const std::string& item) {
+    section->buf.append(item);
+    section->buf_item_cnt++;
+    section->item_cnt++;
+    if (section->buf.size() >= IMAGE_BLOCK_SIZE) {
+        return FlushBlock(section);
+    }
+    return true;
+}
+
+bool MemTableImageWriter::FlushBlock(Section* section) {
+    if (section->buf_item_cnt == 0) {
+        return true;
+    }
+    char header[IMAGE_BLOCK_HEADER_SIZE];
+    EncodeFixed32(header, section->buf.size());
+    EncodeFixed32(header + 4, ::openmldb::log::Mask(::openmldb::log::Value(section->buf.data(), section->buf.size())));
+    EncodeFixed32(header + 8, section->buf_item_cnt);
+    if (fwrite(header, 1, IMAGE_BLOCK_HEADER_SIZE, section->fd) != IMAGE_BLOCK_HEADER_SIZE ||
+        fwrite(section->buf.data(), 1, section->buf.size(), section->fd) != section->buf.size()) {
+        PDLOG(WARNING, "fail to write image block of %s", path_.c_str());
+        return false;
+    }
+    section->length += IMAGE_BLOCK_HEADER_SIZE + section->buf.size();
+    section->buf.clear();
+    section->buf_item_cnt = 0;
+    return true;
+}
+
+bool MemTableImageWriter::AppendSection(Section* section) {
+    if (!FlushBlock(section) || fflush(section->fd) != 0) {
+        return false;
+    }
+    rewind(section->fd);
+    std::string buf(IMAGE_BLOCK_SIZE, '\0');
+    uint64_t left = section->length;
+    while (left > 0) {
+        size_t len = fread(&buf[0], 1, std::min(left, (uint64_t)buf.size()), section->fd);
+        if (len == 0 || fwrite(buf.data(), 1, len, fd_) != len) {
+            PDLOG(WARNING, "fail to append section %s to image", section->path.c_str());
+            return false;
+        }
+        left -= len;
+    }
+    fclose(section->fd);
+    section->fd = NULL;
+    unlink(section->path.c_str());
+    return true;
+}
+
+bool MemTableImageWriter::Finish() {
+    if (failed_ || fd_ == NULL || !FlushBlock(&rows_)) {
+        return false;
+    }
+    std::string footer;
+    PutFixed32(&footer, 1 + std::count_if(segments_.begin(), segments_.end(),
+                                          [](const std::unique_ptr<Section>& s) { return s != nullptr; }));
+    auto add_meta = [&footer](const Section& section, uint64_t offset) {
+        PutFixed32(&footer, section.type);
+        PutFixed32(&footer, section.inner_pos);
+        PutFixed32(&footer, section.seg_idx);
+        PutFixed64(&footer, offset);
+        PutFixed64(&footer, section.length);
+        PutFixed64(&footer, section.item_cnt);
+    };
+    add_meta(rows_, offset_);
+    offset_ += rows_.length;
+    for (auto& section : segments_) {
+        if (!section) {
+            continue;
+        }
+        if (!AppendSection(section.get())) {
+            return false;
+        }
+        add_meta(*section, offset_);
+        offset_ += section->length;
+    }
+    PutFixed32(&footer, ::openmldb::log::Mask(::openmldb::log::Value(footer.data(), footer.size())));
+    PutFixed64(&footer, offset_);
+    footer.append(IMAGE_MAGIC, IMAGE_MAGIC_SIZE);
+    if (fwrite(footer.data(), 1, footer.size(), fd_) != footer.size() || fflush(fd_) != 0 ||
+        fsync(fileno(fd_)) != 0) {
+        PDLOG(WARNING, "fail to write footer of %s", tmp_path_.c_str());
+        return false;
+    }
+    fclose(fd_);
+    fd_ = NULL;
+    if (rename(tmp_path_.c_str(), path_.c_str()) != 0) {
+        PDLOG(WARNING, "fail to rename %s", tmp_path_.c_str());
+        unlink(tmp_path_.c_str());
+        return false;
+    }
+    PDLOG(INFO, "write image %s with %lu rows", path_.c_str(), row_cnt_);
+    return true;
+}
+
+MemTableImageReader::MemTableImageReader(const std::string& path) : path_(path), fd_(-1) {}
+
+MemTableImageReader::~MemTableImageReader() {
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+static bool PRead(int fd, uint64_t offset, uint64_t len, std::string* buf) {
+    buf->resize(len);
+    uint64_t done = 0;
+    while (done < len) {
+        ssize_t ret = pread(fd, &(*buf)[done], len - done, offset + done);
+        if (ret <= 0) {
+            return false;
+        }
+        done += ret;
+    }
+    return true;
+}
+
+bool MemTableImageReader::Open(std::shared_ptr<MemTable> table) {
+    uint32_t tid = table->GetId();
+    uint32_t pid = table->GetPid();
+    uint32_t seg_cnt = table->GetSegCnt();
+    fd_ = open(path_.c_str(), O_RDONLY);
+    if (fd_ < 0) {
+        PDLOG(WARNING, "fail to open image %s", path_.c_str());
+        return false;
+    }
+    off_t size = lseek(fd_, 0, SEEK_END);
+    std::string buf;
+    if (size < static_cast<off_t>(IMAGE_HEADER_SIZE + IMAGE_FOOTER_TAIL_SIZE) ||
+        !PRead(fd_, 0, IMAGE_HEADER_SIZE, &buf) || memcmp(buf.data(), IMAGE_MAGIC, IMAGE_MAGIC_SIZE) != 0) {
+        PDLOG(WARNING, "%s is not an image file", path_.c_str());
+        return false;
+    }
+    const char* header = buf.data() + IMAGE_MAGIC_SIZE;
+    if (DecodeFixed32(header) != IMAGE_VERSION || DecodeFixed32(header + 4) != tid ||
+        DecodeFixed32(header + 8) != pid || DecodeFixed32(header + 12) != seg_cnt) {
+        PDLOG(WARNING, "image %s mismatches table tid %u pid %u seg_cnt %u", path_.c_str(), tid, pid, seg_cnt);
+        return false;
+    }
+    uint32_t index_cnt = 0;
+    uint32_t layout_crc = 0;
+    GetIndexLayout(table.get(), &index_cnt, &layout_crc);
+    if (DecodeFixed32(header + 16) != index_cnt || DecodeFixed32(header + 20) != layout_crc) {
+        PDLOG(WARNING, "image %s has %u indexs, mismatches index layout of table tid %u pid %u with %u indexs",
+              path_.c_str(), DecodeFixed32(header + 16), tid, pid, index_cnt);
+        return false;
+    }
+    if (!PRead(fd_, size - IMAGE_FOOTER_TAIL_SIZE, IMAGE_FOOTER_TAIL_SIZE, &buf) ||
+        memcmp(buf.data() + 12, IMAGE_MAGIC, IMAGE_MAGIC_SIZE) != 0) {
+        PDLOG(WARNING, "image %s is incomplete", path_.c_str());
+        return false;
+    }
+    uint32_t crc = ::openmldb::log::Unmask(DecodeFixed32(buf.data()));
+    uint64_t footer_offset = DecodeFixed64(buf.data() + 4);
+    if (footer_offset < IMAGE_HEADER_SIZE || footer_offset > (uint64_t)size - IMAGE_FOOTER_TAIL_SIZE ||
+        !PRead(fd_, footer_offset, size - IMAGE_FOOTER_TAIL_SIZE - footer_offset, &buf) ||
+        ::openmldb::log::Value(buf.data(), buf.size()) != crc || buf.size() < 4) {
+        PDLOG(WARNING, "footer of image %s is corrupted", path_.c_str());
+        return false;
+    }
+    uint32_t section_cnt = DecodeFixed32(buf.data());
+    if (buf.size() != 4 + (uint64_t)section_cnt * IMAGE_SECTION_META_SIZE) {
+        PDLOG(WARNING, "footer of image %s is corrupted", path_.c_str());
+        return false;
+    }
+    const char* meta = buf.data() + 4;
+    for (uint32_t i = 0; i < section_cnt; i++, meta += IMAGE_SECTION_META_SIZE) {
+        Section section = {DecodeFixed32(meta),      DecodeFixed32(meta + 4),  DecodeFixed32(meta + 8),
+                           DecodeFixed64(meta + 12), DecodeFixed64(meta + 20), DecodeFixed64(meta + 28)};
+        if (section.offset + section.length > footer_offset) {
+            PDLOG(WARNING, "section %u of image %s is out of range", i, path_.c_str());
+            return false;
+        }
+        sections_.push_back(section);
+    }
+    if (sections_.empty() || sections_[0].type != SECTION_ROWS) {
+        PDLOG(WARNING, "no rows in image %s", path_.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool MemTableImageReader::ReadBlock(uint64_t offset, uint64_t end, std::string* payload, uint32_t* item_cnt,
+                                    uint64_t* next) {
+    std::string header;
+    if (offset + IMAGE_BLOCK_HEADER_SIZE > end || !PRead(fd_, offset, IMAGE_BLOCK_HEADER_SIZE, &header)) {
+        return false;
+    }
+    uint32_t len = DecodeFixed32(header.data());
+    uint32_t crc = ::openmldb::log::Unmask(DecodeFixed32(header.data() + 4));
+    *item_cnt = DecodeFixed32(header.data() + 8);
+    offset += IMAGE_BLOCK_HEADER_SIZE;
+    if (offset + len > end || !PRead(fd_, offset, len, payload) ||
+        ::openmldb::log::Value(payload->data(), payload->size()) != crc) {
+        PDLOG(WARNING, "block at %lu of image %s is corrupted", offset, path_.c_str());
+        return false;
+    }
+    *next = offset + len;
+    return true;
+}
+
+bool MemTableImageReader::LoadRows(const Section& section, std::vector<DataBlock*>* rows, uint64_t* byte_size) {
+    rows->reserve(section.item_cnt);
+    std::string payload;
+    uint64_t offset = section.offset;
+    uint64_t end = section.offset + section.length;
+    while (offset < end) {
+        uint32_t item_cnt = 0;
+        if (!ReadBlock(offset, end, &payload, &item_cnt, &offset)) {
+            return false;
+        }
+        const char* cur = payload.data();
+        const char* limit = cur + payload.size();
+        for (uint32_t i = 0; i < item_cnt; i++) {
+            if (cur + 5 > limit) {
+                return false;
+            }
+            uint8_t ref_cnt = static_cast<uint8_t>(cur[0]);
+            uint32_t size = DecodeFixed32(cur + 1);
+            cur += 5;
+            if (cur + size > limit) {
+                return false;
+            }
+            rows->push_back(DataBlock::New(ref_cnt, cur, size));
+            *byte_size += GetRecordSize(size);
+            cur += size;
+        }
+    }
+    return rows->size() == section.item_cnt;
+}
+
+bool MemTableImageReader::LoadSegment(const Section& section, MemTable* table, const std::vector<DataBlock*>& rows) {
+    Segment* segment = table->GetSegment(section.inner_pos, section.seg_idx);
+    if (segment == NULL) {
+        PDLOG(WARNING, "segment [%u][%u] of image %s is not in table", section.inner_pos, section.seg_idx,
+              path_.c_str());
+        return false;
+    }
+    std::string payload;
+    uint64_t offset = section.offset;
+    uint64_t end = section.offset + section.length;
+    while (offset < end) {
+        uint32_t item_cnt = 0;
+        if (!ReadBlock(offset, end, &payload, &item_cnt, &offset)) {
+            return false;
+        }
+        const char* cur = payload.data();
+        const char* limit = cur + payload.size();
+        for (uint32_t i = 0; i < item_cnt; i++) {
+            if (cur + 4 > limit) {
+                return false;
+            }
+            uint32_t key_size = DecodeFixed32(cur);
+            cur += 4;
+            if (cur + key_size + 20 > limit) {
+                return false;
+            }
+            Slice key(cur, key_size);
+            cur += key_size;
+            uint32_t key_entry_id = DecodeFixed32(cur);
+            uint64_t ts = DecodeFixed64(cur + 4);
+            uint64_t row_id = DecodeFixed64(cur + 12);
+            cur += 20;
+            if (row_id >= rows.size() || (segment->GetTsCnt() > 1 && key_entry_id >= segment->GetTsCnt())) {
+                return false;
+            }
+            segment->BulkLoadPutUnlock(key_entry_id, key, ts, rows[row_id]);
+        }
+    }
+    return true;
+}
+
+bool MemTableImageReader::Load(std::shared_ptr<MemTable> table, uint32_t thread_num, uint64_t* row_cnt) {
+    std::vector<DataBlock*> rows;
+    uint64_t byte_size = 0;
+    if (!LoadRows(sections_[0], &rows, &byte_size)) {
+        PDLOG(WARNING, "fail to load rows of image %s", path_.c_str());
+        for (auto* row : rows) {
+            delete row;
+        }
+        return false;
+    }
+    // every segment is built by one thread only
+    std::atomic<uint32_t> next_section(1);
+    std::atomic<bool> failed(false);
+    auto worker = [&]() {
+        while (!failed.load(std::memory_order_relaxed)) {
+            uint32_t pos = next_section.fetch_add(1, std::memory_order_relaxed);
+            if (pos >= sections_.size()) {
+                break;
+            }
+            if (!LoadSegment(sections_[pos], table.get(), rows)) {
+                PDLOG(WARNING, "fail to load segment [%u][%u] of image %s", sections_[pos].inner_pos,
+                      sections_[pos].seg_idx, path_.c_str());
+                failed.store(true, std::memory_order_relaxed);
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < std::max(thread_num, (uint32_t)1); i++) {
+        threads.emplace_back(worker);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    if (failed.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    table->RecordCntIncr(rows.size());
+    table->RecordByteSizeIncr(byte_size);
+    *row_cnt = rows.size();
+    return true;
+}
+
+}  // namespace storage
+}  // namespace openmldb
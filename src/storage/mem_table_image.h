@@ -0,0 +1,136 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_STORAGE_MEM_TABLE_IMAGE_H_
+#define SRC_STORAGE_MEM_TABLE_IMAGE_H_
+
+#include <stdio.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "proto/tablet.pb.h"
+#include "storage/mem_table.h"
+
+namespace openmldb {
+namespace storage {
+
+// A memory image keeps the rows of a snapshot together with the key entries
+// they are put to, so that recovery builds the segments directly instead of
+// parsing LogEntry and calling Put for every row.
+//
+// layout of image file:
+//   header:   magic(8) version(4) tid(4) pid(4) seg_cnt(4) index_cnt(4)
+//             layout_crc(4)
+//   sections: the rows section, then one section for each segment
+//   footer:   section_cnt(4) {type(4) inner_pos(4) seg_idx(4) offset(8)
+//             length(8) item_cnt(8)}... crc(4) footer_offset(8) magic(8)
+//
+// a section is a list of blocks: length(4) crc(4) item_cnt(4) payload, crc
+// is the masked crc32c of payload.
+//   row item:       ref_cnt(1) size(4) value
+//   key entry item: key_size(4) key key_entry_id(4) ts(8) row_id(8)
+// row_id is the position of row in rows section. layout_crc is the crc32c of
+// the id, inner pos and ts column of every index.
+class MemTableImageWriter {
+ public:
+    MemTableImageWriter(std::shared_ptr<MemTable> table, const std::string& path);
+    ~MemTableImageWriter();
+    MemTableImageWriter(const MemTableImageWriter&) = delete;
+    MemTableImageWriter& operator=(const MemTableImageWriter&) = delete;
+
+    bool Open();
+
+    // add the row of entry to the key entries which MemTable::Put uses. the
+    // writer stops accepting rows after an error and Finish fails
+    bool Add(const ::openmldb::api::LogEntry& entry);
+
+    // write the image to path, the temporary files are removed
+    bool Finish();
+
+    uint64_t GetRowCnt() const { return row_cnt_; }
+    bool IsFailed() const { return failed_; }
+
+ private:
+    struct Section {
+        uint32_t type;
+        uint32_t inner_pos;
+        uint32_t seg_idx;
+        std::string path;
+        FILE* fd = NULL;
+        std::string buf;
+        uint32_t buf_item_cnt = 0;
+        uint64_t item_cnt = 0;
+        uint64_t length = 0;
+    };
+
+    Section* GetSection(uint32_t inner_pos, uint32_t seg_idx);
+    bool AddItem(Section* section, const std::string& item);
+    bool FlushBlock(Section* section);
+    bool AppendSection(Section* section);
+    void Cleanup();
+
+    std::shared_ptr<MemTable> table_;
+    std::string path_;
+    std::string tmp_path_;
+    FILE* fd_;
+    uint64_t offset_;
+    uint64_t row_cnt_;
+    bool failed_;
+    Section rows_;
+    std::vector<std::unique_ptr<Section>> segments_;
+    std::string item_;
+    std::vector<RowPlacement> placements_;
+};
+
+class MemTableImageReader {
+ public:
+    explicit MemTableImageReader(const std::string& path);
+    ~MemTableImageReader();
+    MemTableImageReader(const MemTableImageReader&) = delete;
+    MemTableImageReader& operator=(const MemTableImageReader&) = delete;
+
+    // check the header and footer against the segments and index layout of
+    // table, the table is not changed
+    bool Open(std::shared_ptr<MemTable> table);
+
+    // create the rows and build the segments of table in parallel without
+    // segment lock, the table must not be accessed by others
+    bool Load(std::shared_ptr<MemTable> table, uint32_t thread_num, uint64_t* row_cnt);
+
+ private:
+    struct Section {
+        uint32_t type;
+        uint32_t inner_pos;
+        uint32_t seg_idx;
+        uint64_t offset;
+        uint64_t length;
+        uint64_t item_cnt;
+    };
+
+    bool ReadBlock(uint64_t offset, uint64_t end, std::string* payload, uint32_t* item_cnt, uint64_t* next);
+    bool LoadRows(const Section& section, std::vector<DataBlock*>* rows, uint64_t* byte_size);
+    bool LoadSegment(const Section& section, MemTable* table, const std::vector<DataBlock*>& rows);
+
+    std::string path_;
+    int fd_;
+    std::vector<Section> sections_;
+};
+
+}  // namespace storage
+}  // namespace openmldb
+#endif  // SRC_STORAGE_MEM_TABLE_IMAGE_H_
@@ -23,25 +23,23 @@
 #include <snappy.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <set>
 #include <utility>
 
-#include "base/count_down_latch.h"
 #include "base/file_util.h"
 #include "base/glog_wapper.h"
 #include "base/hash.h"
 #include "base/kv_iterator.h"
 #include "base/slice.h"
 #include "base/strings.h"
-#include "base/taskpool.hpp"
-#include "boost/bind.hpp"
 #include "codec/row_codec.h"
-#include "common/thread_pool.h"
 #include "common/timer.h"
 #include "gflags/gflags.h"
 #include "log/log_reader.h"
 #include "log/sequential_file.h"
 #include "proto/tablet.pb.h"
+#include "storage/segment_dispatcher.h"
 
 using google::protobuf::RepeatedPtrField;
 using ::openmldb::codec::SchemaCodec;
@@ -49,10 +47,11 @@ using ::openmldb::codec::SchemaCodec;
 DECLARE_uint64(gc_on_table_recover_count);
 DECLARE_int32(binlog_name_length);
 DECLARE_uint32(make_snapshot_max_deleted_keys);
-DECLARE_uint32(load_table_batch);
 DECLARE_uint32(load_table_thread_num);
-DECLARE_uint32(load_table_queue_size);
+DECLARE_uint32(load_table_dispatch_batch);
 DECLARE_string(snapshot_compression);
+DECLARE_bool(snapshot_image);
+DECLARE_uint32(snapshot_delta_max_num);
 
 namespace openmldb {
 namespace storage {
@@ -60,6 +59,25 @@ namespace storage {
 const std::string SNAPSHOT_SUBFIX = ".sdb";  // NOLINT
 const uint32_t KEY_NUM_DISPLAY = 1000000;    // NOLINT
 const std::string MANIFEST = "MANIFEST";     // NOLINT
+const std::string IMAGE_SUBFIX = ".img";     // NOLINT
+
+// the image is given up on error, the snapshot file is not affected
+static void AddToImage(MemTableImageWriter* image, const ::openmldb::api::LogEntry& entry, int ret,
+                       const std::string& tmp_buf) {
+    if (image == NULL || image->IsFailed()) {
+        return;
+    }
+    bool ok = true;
+    if (ret == 2) {
+        ::openmldb::api::LogEntry tmp_entry;
+        ok = tmp_entry.ParseFromString(tmp_buf) && image->Add(tmp_entry);
+    } else {
+        ok = image->Add(entry);
+    }
+    if (!ok) {
+        PDLOG(WARNING, "fail to add entry to image, log index %lu", entry.log_index());
+    }
+}
 
 MemTableSnapshot::MemTableSnapshot(uint32_t tid, uint32_t pid, LogParts* log_part, const std::string& db_root_path)
     : Snapshot(tid, pid), log_part_(log_part), db_root_path_(db_root_path) {}
@@ -86,7 +104,16 @@ bool MemTableSnapshot::Recover(std::shared_ptr<Table> table, uint64_t& latest_of
         return false;
     }
     if (ret == 0) {
-        RecoverFromSnapshot(manifest.name(), manifest.count(), table);
+        bool loaded = false;
+        if (!RecoverFromImage(manifest.name(), manifest.count(), table, &loaded)) {
+            return false;
+        }
+        if (!loaded) {
+            RecoverFromSnapshot(manifest.name(), manifest.count(), table);
+        }
+        for (const auto& delta : manifest.deltas()) {
+            RecoverFromSnapshot(delta.name(), delta.count(), table);
+        }
         latest_offset = manifest.offset();
         offset_ = latest_offset;
     }
@@ -107,11 +134,42 @@ void MemTableSnapshot::RecoverFromSnapshot(const std::string& snapshot_name, uin
     }
 }
 
+bool MemTableSnapshot::RecoverFromImage(const std::string& snapshot_name, uint64_t expect_cnt,
+                                        std::shared_ptr<Table> table, bool* loaded) {
+    *loaded = false;
+    std::string image_path = snapshot_path_ + snapshot_name + IMAGE_SUBFIX;
+    auto mem_table = std::dynamic_pointer_cast<MemTable>(table);
+    if (!mem_table || !::openmldb::base::IsExists(image_path)) {
+        return true;
+    }
+    uint64_t start_time = ::baidu::common::timer::now_time();
+    MemTableImageReader reader(image_path);
+    if (!reader.Open(mem_table)) {
+        // recover from the snapshot file and keep the image for analysis
+        PDLOG(WARNING, "invalid image %s, recover from snapshot. tid %u pid %u", image_path.c_str(), tid_, pid_);
+        ::openmldb::base::Rename(image_path, image_path + ".bad");
+        return true;
+    }
+    uint64_t row_cnt = 0;
+    if (!reader.Load(mem_table, FLAGS_load_table_thread_num, &row_cnt)) {
+        PDLOG(WARNING, "fail to load image %s. tid %u pid %u", image_path.c_str(), tid_, pid_);
+        ::openmldb::base::Rename(image_path, image_path + ".bad");
+        return false;
+    }
+    PDLOG(INFO, "[Recover] load image %s with %lu rows, use %lu second. tid %u pid %u", image_path.c_str(), row_cnt,
+          ::baidu::common::timer::now_time() - start_time, tid_, pid_);
+    if (row_cnt != expect_cnt) {
+        PDLOG(WARNING, "snapshot %s , expect cnt %lu but image has %lu rows", snapshot_name.c_str(), expect_cnt,
+              row_cnt);
+    }
+    *loaded = true;
+    return true;
+}
+
 void MemTableSnapshot::RecoverSingleSnapshot(const std::string& path, std::shared_ptr<Table> table,
                                              std::atomic<uint64_t>* g_succ_cnt, std::atomic<uint64_t>* g_failed_cnt) {
-    ::openmldb::base::TaskPool load_pool_(FLAGS_load_table_thread_num, FLAGS_load_table_batch);
-    std::atomic<uint64_t> succ_cnt, failed_cnt;
-    succ_cnt = failed_cnt = 0;
+    uint64_t succ_cnt = 0;
+    uint64_t failed_cnt = 0;
 
     do {
         if (table == NULL) {
@@ -129,40 +187,44 @@ void MemTableSnapshot::RecoverSingleSnapshot(const std::string& path, std::share
         std::string buffer;
         // second
         uint64_t consumed = ::baidu::common::timer::now_time();
-        std::vector<std::string*> recordPtr;
-        recordPtr.reserve(FLAGS_load_table_batch);
+        // the deleted keys at the beginning of a delta file are applied in order
+        // before the rows of it
+        SegmentDispatcher dispatcher(table, FLAGS_load_table_thread_num, FLAGS_load_table_dispatch_batch);
 
         while (true) {
             buffer.clear();
             ::openmldb::base::Slice record;
             ::openmldb::log::Status status = reader.ReadRecord(&record, &buffer);
             if (status.IsWaitRecord() || status.IsEof()) {
+                dispatcher.Flush();
                 consumed = ::baidu::common::timer::now_time() - consumed;
                 PDLOG(INFO,
                       "read path %s for table tid %u pid %u completed, "
                       "succ_cnt %lu, failed_cnt %lu, consumed %us",
-                      path.c_str(), tid_, pid_, succ_cnt.load(std::memory_order_relaxed),
-                      failed_cnt.load(std::memory_order_relaxed), consumed);
+                      path.c_str(), tid_, pid_, succ_cnt, failed_cnt, consumed);
                 break;
             }
 
             if (!status.ok()) {
                 PDLOG(WARNING, "fail to read record for tid %u, pid %u with error %s", tid_, pid_,
                       status.ToString().c_str());
-                failed_cnt.fetch_add(1, std::memory_order_relaxed);
+                failed_cnt++;
                 continue;
             }
-            std::string* sp = new std::string(record.data(), record.size());
-            recordPtr.push_back(sp);
-            if (recordPtr.size() >= FLAGS_load_table_batch) {
-                load_pool_.AddTask(
-                    boost::bind(&MemTableSnapshot::Put, this, path, table, recordPtr, &succ_cnt, &failed_cnt));
-                recordPtr.clear();
+            ::openmldb::api::LogEntry* entry = dispatcher.NextEntry();
+            if (!entry->ParseFromArray(record.data(), record.size())) {
+                failed_cnt++;
+                continue;
             }
-        }
-        if (recordPtr.size() > 0) {
-            load_pool_.AddTask(
-                boost::bind(&MemTableSnapshot::Put, this, path, table, recordPtr, &succ_cnt, &failed_cnt));
+            bool is_delete = entry->has_method_type() && entry->method_type() == ::openmldb::api::MethodType::kDelete;
+            dispatcher.Submit();
+            if (is_delete) {
+                continue;
+            }
+            if (succ_cnt % 100000 == 0) {
+                PDLOG(INFO, "load snapshot %s with succ_cnt %lu, failed_cnt %lu", path.c_str(), succ_cnt, failed_cnt);
+            }
+            succ_cnt++;
         }
         // will close the fd atomic
         delete seq_file;
@@ -173,32 +235,11 @@ void MemTableSnapshot::RecoverSingleSnapshot(const std::string& path, std::share
             g_failed_cnt->fetch_add(failed_cnt, std::memory_order_relaxed);
         }
     } while (false);
-    load_pool_.Stop();
-}
-
-void MemTableSnapshot::Put(std::string& path, std::shared_ptr<Table>& table, std::vector<std::string*> recordPtr,
-                           std::atomic<uint64_t>* succ_cnt, std::atomic<uint64_t>* failed_cnt) {
-    ::openmldb::api::LogEntry entry;
-    for (auto it = recordPtr.cbegin(); it != recordPtr.cend(); it++) {
-        bool ok = entry.ParseFromString(**it);
-        if (!ok) {
-            failed_cnt->fetch_add(1, std::memory_order_relaxed);
-            delete *it;
-            continue;
-        }
-        auto scount = succ_cnt->fetch_add(1, std::memory_order_relaxed);
-        if (scount % 100000 == 0) {
-            PDLOG(INFO, "load snapshot %s with succ_cnt %lu, failed_cnt %lu", path.c_str(), scount,
-                  failed_cnt->load(std::memory_order_relaxed));
-        }
-        table->Put(entry);
-        delete *it;
-    }
 }
 
 int MemTableSnapshot::TTLSnapshot(std::shared_ptr<Table> table, const ::openmldb::api::Manifest& manifest,
                                   WriteHandle* wh, uint64_t& count, uint64_t& expired_key_num,
-                                  uint64_t& deleted_key_num) {
+                                  uint64_t& deleted_key_num, MemTableImageWriter* image) {
     std::string full_path = snapshot_path_ + manifest.name();
     FILE* fd = fopen(full_path.c_str(), "rb");
     if (fd == NULL) {
@@ -213,6 +254,8 @@ int MemTableSnapshot::TTLSnapshot(std::shared_ptr<Table> table, const ::openmldb
     std::string tmp_buf;
     ::openmldb::api::LogEntry entry;
     bool has_error = false;
+    // the counters are accumulated when filtering a snapshot chain
+    uint64_t total = count + expired_key_num + deleted_key_num;
     std::set<uint32_t> deleted_index;
     for (const auto& it : table->GetAllIndex()) {
         if (it->GetStatus() != ::openmldb::storage::IndexStatus::kReady) {
@@ -237,6 +280,10 @@ int MemTableSnapshot::TTLSnapshot(std::shared_ptr<Table> table, const ::openmldb
             has_error = true;
             break;
         }
+        if (entry.has_method_type() && entry.method_type() == ::openmldb::api::MethodType::kDelete) {
+            // deleted keys of delta file have been collected by LoadDeltaDeletedKey
+            continue;
+        }
         int ret = RemoveDeletedKey(entry, deleted_index, &tmp_buf);
         if (ret == 1) {
             deleted_key_num++;
@@ -254,13 +301,14 @@ int MemTableSnapshot::TTLSnapshot(std::shared_ptr<Table> table, const ::openmldb
             has_error = true;
             break;
         }
+        AddToImage(image, entry, ret, tmp_buf);
         if ((count + expired_key_num + deleted_key_num) % KEY_NUM_DISPLAY == 0) {
             PDLOG(INFO, "tackled key num[%lu] total[%lu]", count + expired_key_num, manifest.count());
         }
         count++;
     }
     delete seq_file;
-    if (expired_key_num + count + deleted_key_num != manifest.count()) {
+    if (expired_key_num + count + deleted_key_num - total != manifest.count()) {
         PDLOG(WARNING,
               "key num not match! total key num[%lu] load key num[%lu] ttl key "
               "num[%lu]",
@@ -343,21 +391,126 @@ uint64_t MemTableSnapshot::CollectDeletedKey(uint64_t end_offset) {
 }
 
 int MemTableSnapshot::MakeSnapshot(std::shared_ptr<Table> table, uint64_t& out_offset, uint64_t end_offset) {
-    if (making_snapshot_.load(std::memory_order_acquire)) {
+    return MakeSnapshotInternal(table, end_offset, FLAGS_snapshot_delta_max_num > 0, &out_offset);
+}
+
+int MemTableSnapshot::MergeSnapshotChain(std::shared_ptr<Table> table) {
+    ::openmldb::api::Manifest manifest;
+    if (GetLocalManifest(snapshot_path_ + MANIFEST, manifest) != 0 || manifest.deltas_size() == 0) {
+        return 0;
+    }
+    PDLOG(INFO, "merge %d delta snapshots. tid %u pid %u", manifest.deltas_size(), tid_, pid_);
+    uint64_t out_offset = 0;
+    return MakeSnapshotInternal(table, 0, false, &out_offset);
+}
+
+int MemTableSnapshot::LoadDeltaDeletedKey(const ::openmldb::api::SnapshotDelta& delta) {
+    std::string full_path = snapshot_path_ + delta.name();
+    FILE* fd = fopen(full_path.c_str(), "rb");
+    if (fd == NULL) {
+        PDLOG(WARNING, "fail to open path %s for error %s", full_path.c_str(), strerror(errno));
+        return -1;
+    }
+    ::openmldb::log::SequentialFile* seq_file = ::openmldb::log::NewSeqFile(delta.name(), fd);
+    ::openmldb::log::Reader reader(seq_file, NULL, false, 0, IsCompressed(full_path));
+    std::string buffer;
+    ::openmldb::api::LogEntry entry;
+    int ret = 0;
+    while (true) {
+        ::openmldb::base::Slice record;
+        ::openmldb::log::Status status = reader.ReadRecord(&record, &buffer);
+        if (status.IsEof()) {
+            break;
+        }
+        if (!status.ok() || !entry.ParseFromArray(record.data(), record.size())) {
+            PDLOG(WARNING, "fail to read delta %s. tid %u pid %u", full_path.c_str(), tid_, pid_);
+            ret = -1;
+            break;
+        }
+        if (!entry.has_method_type() || entry.method_type() != ::openmldb::api::MethodType::kDelete) {
+            break;
+        }
+        if (entry.dimensions_size() == 0) {
+            continue;
+        }
+        std::string combined_key = entry.dimensions(0).key() + "|" + std::to_string(entry.dimensions(0).idx());
+        uint64_t& offset = deleted_keys_[combined_key];
+        offset = std::max(offset, entry.log_index());
+    }
+    delete seq_file;
+    return ret;
+}
+
+int MemTableSnapshot::WriteDeletedKey(WriteHandle* wh) {
+    std::string buffer;
+    for (const auto& kv : deleted_keys_) {
+        size_t pos = kv.first.rfind('|');
+        if (pos == std::string::npos) {
+            continue;
+        }
+        ::openmldb::api::LogEntry entry;
+        entry.set_log_index(kv.second);
+        entry.set_method_type(::openmldb::api::MethodType::kDelete);
+        ::openmldb::api::Dimension* dimension = entry.add_dimensions();
+        dimension->set_key(kv.first.substr(0, pos));
+        dimension->set_idx(std::stoul(kv.first.substr(pos + 1)));
+        buffer.clear();
+        entry.SerializeToString(&buffer);
+        ::openmldb::log::Status status = wh->Write(::openmldb::base::Slice(buffer));
+        if (!status.ok()) {
+            PDLOG(WARNING, "fail to write deleted key. status[%s]", status.ToString().c_str());
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int MemTableSnapshot::MakeSnapshotInternal(std::shared_ptr<Table> table, uint64_t end_offset, bool allow_delta,
+                                           uint64_t* out_offset) {
+    if (making_snapshot_.exchange(true, std::memory_order_acq_rel)) {
         PDLOG(INFO, "snapshot is doing now!");
         return 0;
     }
     if (end_offset > 0 && end_offset <= offset_) {
         PDLOG(WARNING, "end_offset %lu less than or equal offset_ %lu, do nothing", end_offset, offset_);
+        making_snapshot_.store(false, std::memory_order_release);
         return -1;
     }
-    making_snapshot_.store(true, std::memory_order_release);
+    ::openmldb::api::Manifest manifest;
+    bool has_error = false;
+    uint64_t write_count = 0;
+    uint64_t expired_key_num = 0;
+    uint64_t deleted_key_num = 0;
+    uint64_t last_term = 0;
+    int result = GetLocalManifest(snapshot_path_ + MANIFEST, manifest);
+    // write only the binlog to a delta file until the chain is long enough,
+    // then merge the chain to a new base snapshot with ttl filtered
+    bool is_delta = allow_delta && result == 0 &&
+                    manifest.deltas_size() < static_cast<int>(FLAGS_snapshot_delta_max_num);
     std::string now_time = ::openmldb::base::GetNowTime();
-    std::string snapshot_name = now_time.substr(0, now_time.length() - 2) + ".sdb";
+    std::string snapshot_name = now_time.substr(0, now_time.length() - 2);
+    if (is_delta) {
+        // deltas may be made in the same minute
+        snapshot_name.append("_" + std::to_string(offset_));
+    }
+    snapshot_name.append(".sdb");
     if (FLAGS_snapshot_compression != "off") {
         snapshot_name.append(".");
         snapshot_name.append(FLAGS_snapshot_compression);
     }
+    if (is_delta) {
+        is_delta = manifest.name() != snapshot_name;
+        for (const auto& delta : manifest.deltas()) {
+            if (delta.name() == snapshot_name) {
+                is_delta = false;
+            }
+        }
+        if (!is_delta) {
+            PDLOG(WARNING, "delta snapshot %s exists, make full snapshot. tid %u pid %u", snapshot_name.c_str(),
+                  tid_, pid_);
+            snapshot_name = GenSnapshotName();
+        }
+    }
     std::string snapshot_name_tmp = snapshot_name + ".tmp";
     std::string full_path = snapshot_path_ + snapshot_name;
     std::string tmp_file_path = snapshot_path_ + snapshot_name_tmp;
@@ -368,20 +521,49 @@ int MemTableSnapshot::MakeSnapshot(std::shared_ptr<Table> table, uint64_t& out_o
         return -1;
     }
     uint64_t collected_offset = CollectDeletedKey(end_offset);
+    // CollectDeletedKey resets deleted_keys_, so the deletes kept in the deltas are merged after it
+    if (result == 0 && !is_delta) {
+        for (const auto& delta : manifest.deltas()) {
+            if (LoadDeltaDeletedKey(delta) < 0) {
+                has_error = true;
+                break;
+            }
+        }
+    }
     uint64_t start_time = ::baidu::common::timer::now_time();
     WriteHandle* wh = new WriteHandle(FLAGS_snapshot_compression, snapshot_name_tmp, fd);
-    ::openmldb::api::Manifest manifest;
-    bool has_error = false;
-    uint64_t write_count = 0;
-    uint64_t expired_key_num = 0;
-    uint64_t deleted_key_num = 0;
-    uint64_t last_term = 0;
-    int result = GetLocalManifest(snapshot_path_ + MANIFEST, manifest);
-    if (result == 0) {
+    std::string image_path = full_path + IMAGE_SUBFIX;
+    unlink(image_path.c_str());
+    std::unique_ptr<MemTableImageWriter> image;
+    auto mem_table = std::dynamic_pointer_cast<MemTable>(table);
+    if (FLAGS_snapshot_image && mem_table && !is_delta) {
+        image.reset(new MemTableImageWriter(mem_table, image_path));
+        if (!image->Open()) {
+            image.reset();
+        }
+    }
+    if (is_delta) {
+        if (WriteDeletedKey(wh) < 0) {
+            has_error = true;
+        }
+        last_term = manifest.term();
+    } else if (result == 0 && !has_error) {
         // filter old snapshot
-        if (TTLSnapshot(table, manifest, wh, write_count, expired_key_num, deleted_key_num) < 0) {
+        if (TTLSnapshot(table, manifest, wh, write_count, expired_key_num, deleted_key_num, image.get()) < 0) {
             has_error = true;
         }
+        for (const auto& delta : manifest.deltas()) {
+            if (has_error) {
+                break;
+            }
+            ::openmldb::api::Manifest delta_manifest;
+            delta_manifest.set_name(delta.name());
+            delta_manifest.set_count(delta.count());
+            if (TTLSnapshot(table, delta_manifest, wh, write_count, expired_key_num, deleted_key_num,
+                            image.get()) < 0) {
+                has_error = true;
+            }
+        }
         last_term = manifest.term();
         DEBUGLOG("old manifest term is %lu", last_term);
     } else if (result < 0) {
@@ -445,6 +627,7 @@ int MemTableSnapshot::MakeSnapshot(std::shared_ptr<Table> table, uint64_t& out_o
                 has_error = true;
                 break;
             }
+            AddToImage(image.get(), entry, ret, tmp_buf);
             write_count++;
             if ((write_count + expired_key_num + deleted_key_num) % KEY_NUM_DISPLAY == 0) {
                 PDLOG(INFO, "has write key num[%lu] expired key num[%lu]", write_count, expired_key_num);
@@ -476,35 +659,63 @@ int MemTableSnapshot::MakeSnapshot(std::shared_ptr<Table> table, uint64_t& out_o
         delete wh;
         wh = NULL;
     }
+    if (image && (has_error || !image->Finish())) {
+        if (!has_error) {
+            PDLOG(WARNING, "fail to write image %s", image_path.c_str());
+        }
+        image.reset();
+        unlink(image_path.c_str());
+    }
     int ret = 0;
     if (has_error) {
         unlink(tmp_file_path.c_str());
         ret = -1;
     } else {
         if (rename(tmp_file_path.c_str(), full_path.c_str()) == 0) {
-            if (GenManifest(snapshot_name, write_count, cur_offset, last_term) == 0) {
+            int gen_ret = 0;
+            if (is_delta) {
+                ::openmldb::api::Manifest new_manifest(manifest);
+                auto* delta = new_manifest.add_deltas();
+                delta->set_name(snapshot_name);
+                delta->set_count(write_count);
+                delta->set_offset(cur_offset);
+                new_manifest.set_offset(cur_offset);
+                new_manifest.set_term(last_term);
+                gen_ret = GenManifest(new_manifest);
+            } else {
+                gen_ret = GenManifest(snapshot_name, write_count, cur_offset, last_term);
+            }
+            if (gen_ret == 0) {
                 // delete old snapshot
-                if (manifest.has_name() && manifest.name() != snapshot_name) {
+                if (!is_delta && manifest.has_name() && manifest.name() != snapshot_name) {
                     DEBUGLOG("old snapshot[%s] has deleted", manifest.name().c_str());
                     unlink((snapshot_path_ + manifest.name()).c_str());
+                    unlink((snapshot_path_ + manifest.name() + IMAGE_SUBFIX).c_str());
+                }
+                for (const auto& delta : manifest.deltas()) {
+                    if (!is_delta && delta.name() != snapshot_name) {
+                        unlink((snapshot_path_ + delta.name()).c_str());
+                    }
                 }
                 uint64_t consumed = ::baidu::common::timer::now_time() - start_time;
                 PDLOG(INFO,
-                      "make snapshot[%s] success. update offset from %lu to %lu."
+                      "make %s snapshot[%s] success. update offset from %lu to %lu."
                       "use %lu second. write key %lu expired key %lu deleted key "
                       "%lu",
-                      snapshot_name.c_str(), offset_, cur_offset, consumed, write_count, expired_key_num,
-                      deleted_key_num);
+                      is_delta ? "delta" : "full", snapshot_name.c_str(), offset_, cur_offset, consumed, write_count,
+                      expired_key_num, deleted_key_num);
                 offset_ = cur_offset;
-                out_offset = cur_offset;
+                *out_offset = cur_offset;
             } else {
                 PDLOG(WARNING, "GenManifest failed. delete snapshot file[%s]", full_path.c_str());
                 unlink(full_path.c_str());
+                unlink(image_path.c_str());
                 ret = -1;
             }
         } else {
             PDLOG(WARNING, "rename[%s] failed", snapshot_name.c_str());
             unlink(tmp_file_path.c_str());
+            unlink(image_path.c_str());
             ret = -1;
         }
     }
@@ -654,6 +865,9 @@ base::Status MemTableSnapshot::ExtractIndexFromSnapshot(std::shared_ptr<Table> t
     if (wh == nullptr || count == nullptr || expired_key_num == nullptr || deleted_key_num == nullptr) {
         return base::Status(base::ReturnCode::kError, "null ptr");
     }
+    if (manifest.deltas_size() > 0) {
+        return base::Status(base::ReturnCode::kError, "snapshot chain is not merged");
+    }
     uint32_t tid = table->GetId();
     uint32_t pid = table->GetPid();
     std::map<uint8_t, codec::RowView> decoder_map;
@@ -789,6 +1003,10 @@ int MemTableSnapshot::ExtractIndexFromSnapshot(std::shared_ptr<Table> table, con
                                                uint64_t& expired_key_num, uint64_t& deleted_key_num) {
     uint32_t tid = table->GetId();
     uint32_t pid = table->GetPid();
+    if (manifest.deltas_size() > 0) {
+        PDLOG(WARNING, "snapshot chain is not merged. tid %u pid %u", tid, pid);
+        return -1;
+    }
     std::string full_path = snapshot_path_ + manifest.name();
     FILE* fd = fopen(full_path.c_str(), "rb");
     if (fd == NULL) {
@@ -1100,6 +1318,11 @@ int MemTableSnapshot::ExtractIndexData(std::shared_ptr<Table> table,
     }
     uint32_t tid = table->GetId();
     uint32_t pid = table->GetPid();
+    // index data is extracted from the base snapshot only
+    if (MergeSnapshotChain(table) < 0) {
+        PDLOG(WARNING, "fail to merge snapshot chain. tid %u, pid %u", tid, pid);
+        return -1;
+    }
     if (making_snapshot_.exchange(true, std::memory_order_consume)) {
         PDLOG(INFO, "snapshot is doing now. tid %u, pid %u", tid, pid);
         return -1;
@@ -1157,12 +1380,16 @@ int MemTableSnapshot::ExtractIndexData(std::shared_ptr<Table> table,
         unlink(tmp_file_path.c_str());
         ret = -1;
     } else {
+        // the image of the snapshot with the same name is stale once the
+        // snapshot file is replaced
+        unlink((full_path + IMAGE_SUBFIX).c_str());
         if (rename(tmp_file_path.c_str(), full_path.c_str()) == 0) {
             if (GenManifest(snapshot_name, write_count, cur_offset, last_term) == 0) {
                 // delete old snapshot
                 if (manifest.has_name() && manifest.name() != snapshot_name) {
                     DEBUGLOG("old snapshot[%s] has deleted", manifest.name().c_str());
                     unlink((snapshot_path_ + manifest.name()).c_str());
+                    unlink((snapshot_path_ + manifest.name() + IMAGE_SUBFIX).c_str());
                 }
                 uint64_t consumed = ::baidu::common::timer::now_time() - start_time;
                 PDLOG(INFO,
@@ -1192,6 +1419,11 @@ int MemTableSnapshot::ExtractIndexData(std::shared_ptr<Table> table, const ::ope
                                        uint32_t idx, uint32_t partition_num, uint64_t& out_offset) {
     uint32_t tid = table->GetId();
     uint32_t pid = table->GetPid();
+    // index data is extracted from the base snapshot only
+    if (MergeSnapshotChain(table) < 0) {
+        PDLOG(WARNING, "fail to merge snapshot chain. tid %u, pid %u", tid, pid);
+        return -1;
+    }
     if (making_snapshot_.exchange(true, std::memory_order_consume)) {
         PDLOG(INFO, "snapshot is doing now. tid %u, pid %u", tid, pid);
         return -1;
@@ -1423,12 +1655,16 @@ int MemTableSnapshot::ExtractIndexData(std::shared_ptr<Table> table, const ::ope
         unlink(tmp_file_path.c_str());
         ret = -1;
     } else {
+        // the image of the snapshot with the same name is stale once the
+        // snapshot file is replaced
+        unlink((full_path + IMAGE_SUBFIX).c_str());
         if (rename(tmp_file_path.c_str(), full_path.c_str()) == 0) {
             if (GenManifest(snapshot_name, write_count, cur_offset, last_term) == 0) {
                 // delete old snapshot
                 if (manifest.has_name() && manifest.name() != snapshot_name) {
                     DEBUGLOG("old snapshot[%s] has deleted", manifest.name().c_str());
                     unlink((snapshot_path_ + manifest.name()).c_str());
+                    unlink((snapshot_path_ + manifest.name() + IMAGE_SUBFIX).c_str());
                 }
                 uint64_t consumed = ::baidu::common::timer::now_time() - start_time;
                 PDLOG(INFO,
@@ -1543,6 +1779,10 @@ bool MemTableSnapshot::DumpSnapshotIndexData(std::shared_ptr<Table> table,
     if (ret == -1) {
         return false;
     }
+    if (manifest.deltas_size() > 0) {
+        PDLOG(WARNING, "snapshot chain is not merged. tid %u pid %u", tid_, pid_);
+        return false;
+    }
     *snapshot_offset = manifest.offset();
     std::string path = snapshot_path_ + "/" + manifest.name();
     uint64_t succ_cnt = 0;
@@ -1609,6 +1849,11 @@ bool MemTableSnapshot::DumpIndexData(std::shared_ptr<Table> table, const ::openm
                                      uint32_t idx, const std::vector<::openmldb::log::WriteHandle*>& whs) {
     uint32_t tid = table->GetId();
     uint32_t pid = table->GetPid();
+    // index data is dumped from the base snapshot only
+    if (MergeSnapshotChain(table) < 0) {
+        PDLOG(WARNING, "fail to merge snapshot chain. tid %u, pid %u", tid, pid);
+        return false;
+    }
     if (making_snapshot_.exchange(true, std::memory_order_consume)) {
         PDLOG(INFO, "snapshot is doing now. tid %u, pid %u", tid, pid);
         return false;
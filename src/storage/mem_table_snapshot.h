@@ -29,6 +29,7 @@
 #include "log/log_writer.h"
 #include "log/sequential_file.h"
 #include "proto/tablet.pb.h"
+#include "storage/mem_table_image.h"
 #include "storage/snapshot.h"
 
 using ::openmldb::api::LogEntry;
@@ -52,16 +53,22 @@ class MemTableSnapshot : public Snapshot {
 
     void RecoverFromSnapshot(const std::string& snapshot_name, uint64_t expect_cnt, std::shared_ptr<Table> table);
 
+    // load the memory image written with snapshot_name, return false if the
+    // image is broken and the table may have been changed
+    bool RecoverFromImage(const std::string& snapshot_name, uint64_t expect_cnt, std::shared_ptr<Table> table,
+                          bool* loaded);
+
     int MakeSnapshot(std::shared_ptr<Table> table,
                      uint64_t& out_offset,  // NOLINT
                      uint64_t end_offset) override;
 
+    // merge the delta files of manifest to a new base snapshot
+    int MergeSnapshotChain(std::shared_ptr<Table> table);
+
     int TTLSnapshot(std::shared_ptr<Table> table, const ::openmldb::api::Manifest& manifest, WriteHandle* wh,
                     uint64_t& count, uint64_t& expired_key_num,  // NOLINT
-                    uint64_t& deleted_key_num);                  // NOLINT
-
-    void Put(std::string& path, std::shared_ptr<Table>& table,  // NOLINT
-             std::vector<std::string*> recordPtr, std::atomic<uint64_t>* succ_cnt, std::atomic<uint64_t>* failed_cnt);
+                    uint64_t& deleted_key_num,                   // NOLINT
+                    MemTableImageWriter* image = NULL);
 
     std::string GenSnapshotName();
 
@@ -121,6 +128,16 @@ class MemTableSnapshot : public Snapshot {
 
     uint64_t CollectDeletedKey(uint64_t end_offset);
 
+    // write the binlog to a delta file if allow_delta and the chain is shorter
+    // than snapshot_delta_max_num, otherwise rewrite the full snapshot
+    int MakeSnapshotInternal(std::shared_ptr<Table> table, uint64_t end_offset, bool allow_delta,
+                             uint64_t* out_offset);
+
+    // add the deleted keys at the beginning of delta file to deleted_keys_
+    int LoadDeltaDeletedKey(const ::openmldb::api::SnapshotDelta& delta);
+
+    int WriteDeletedKey(WriteHandle* wh);
+
     int DecodeData(std::shared_ptr<Table> table, const openmldb::api::LogEntry& entry, uint32_t maxIdx,
                    std::vector<std::string>& row);  // NOLINT
 
@@ -22,26 +22,34 @@
 namespace openmldb {
 namespace storage {
 
+typedef ::openmldb::base::Node<::openmldb::base::Slice, void*> EntryNode;
+typedef ::openmldb::base::Node<uint64_t, void*> DataNode;
+
 static const uint32_t DATA_BLOCK_BYTE_SIZE = sizeof(DataBlock);
 static const uint32_t KEY_ENTRY_BYTE_SIZE = sizeof(KeyEntry);
-static const uint32_t ENTRY_NODE_SIZE = sizeof(::openmldb::base::Node<::openmldb::base::Slice, void*>);
-static const uint32_t DATA_NODE_SIZE = sizeof(::openmldb::base::Node<uint64_t, void*>);
 static const uint32_t KEY_ENTRY_PTR_SIZE = sizeof(KeyEntry*);
 
+// an entry of the expire index of segment takes one node of the slot map and
+// one node of the bucket set, a node holds the next pointer, the value and
+// the cached hash. The bucket arrays are not counted
+static const uint32_t EXPIRE_IDX_BYTE_SIZE =
+    2 * (sizeof(void*) + sizeof(size_t) + KEY_ENTRY_PTR_SIZE) + sizeof(uint64_t) + sizeof(::openmldb::base::Slice);
+
 static inline uint32_t GetRecordSize(uint32_t value_size) { return value_size + DATA_BLOCK_BYTE_SIZE; }
 
-// the input height which is the height of skiplist node
+// the input height which is the height of skiplist node, the next pointers of
+// a node are allocated inline so the node size depends on its height
 static inline uint32_t GetRecordPkIdxSize(uint8_t height, uint32_t key_size, uint8_t key_entry_max_height) {
-    return height * 8 + ENTRY_NODE_SIZE + KEY_ENTRY_BYTE_SIZE + key_size + key_entry_max_height * 8 + DATA_NODE_SIZE;
+    return EntryNode::ByteSize(height) + KEY_ENTRY_BYTE_SIZE + key_size + DataNode::ByteSize(key_entry_max_height);
 }
 
 static inline uint32_t GetRecordPkMultiIdxSize(uint8_t height, uint32_t key_size, uint8_t key_entry_max_height,
                                                uint32_t ts_cnt) {
-    return height * 8 + ENTRY_NODE_SIZE + key_size +
-           (KEY_ENTRY_PTR_SIZE + KEY_ENTRY_BYTE_SIZE + key_entry_max_height * 8 + DATA_NODE_SIZE) * ts_cnt;
+    return EntryNode::ByteSize(height) + key_size +
+           (KEY_ENTRY_PTR_SIZE + KEY_ENTRY_BYTE_SIZE + DataNode::ByteSize(key_entry_max_height)) * ts_cnt;
 }
 
-static inline uint32_t GetRecordTsIdxSize(uint8_t height) { return height * 8 + DATA_NODE_SIZE; }
+static inline uint32_t GetRecordTsIdxSize(uint8_t height) { return DataNode::ByteSize(height); }
 
 }  // namespace storage
 }  // namespace openmldb
@@ -18,6 +18,9 @@
 
 #include <gflags/gflags.h>
 
+#include <algorithm>
+
+#include "base/epoch.h"
 #include "base/glog_wapper.h"
 #include "base/strings.h"
 #include "common/timer.h"
@@ -25,12 +28,25 @@
 
 DECLARE_int32(gc_safe_offset);
 DECLARE_uint32(skiplist_max_height);
-DECLARE_uint32(gc_deleted_pk_version_delta);
+DECLARE_bool(gc_expire_index);
+DECLARE_uint64(gc_expire_bucket_size);
+DECLARE_uint64(gc_max_keys_per_round);
+DECLARE_bool(segment_hash_index);
 
 namespace openmldb {
 namespace storage {
 
 static const SliceComparator scmp;
+// the bucket of the entries taken out by gc
+static constexpr uint64_t GC_TAKEN_BUCKET = UINT64_MAX;
+// the entries taken out of expire index at one time
+static constexpr uint64_t GC_TAKE_BATCH_SIZE = 256;
+
+// only absolute ttl gc splits keys by expire time without a full scan
+static inline bool UseExpireIndex(TTLType ttl_type) {
+    return FLAGS_gc_expire_index && (ttl_type == TTLType::kAbsoluteTime || ttl_type == TTLType::kAbsOrLat);
+}
+
 Segment::Segment()
     : entries_(NULL),
       mu_(),
@@ -38,14 +54,19 @@ Segment::Segment()
       idx_byte_size_(0),
       pk_cnt_(0),
       ts_cnt_(1),
-      gc_version_(0),
-      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000) {
+      retired_lists_(),
+      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000),
+      gc_visited_key_cnt_(0),
+      gc_collected_key_cnt_(0),
+      expire_index_enabled_(UseExpireIndex(TTLType::kAbsoluteTime)),
+      expire_bucket_size_(std::max(FLAGS_gc_expire_bucket_size, (uint64_t)1)),
+      key_index_(FLAGS_segment_hash_index ? new KeyHashIndex() : NULL) {
     entries_ = new KeyEntries((uint8_t)FLAGS_skiplist_max_height, 4, scmp);
     key_entry_max_height_ = (uint8_t)FLAGS_skiplist_max_height;
     entry_free_list_ = new KeyEntryNodeList(4, 4, tcmp);
 }
 
-Segment::Segment(uint8_t height)
+Segment::Segment(uint8_t height, TTLType ttl_type)
     : entries_(NULL),
       mu_(),
       idx_cnt_(0),
@@ -53,13 +74,18 @@ Segment::Segment(uint8_t height)
       pk_cnt_(0),
       key_entry_max_height_(height),
       ts_cnt_(1),
-      gc_version_(0),
-      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000) {
+      retired_lists_(),
+      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000),
+      gc_visited_key_cnt_(0),
+      gc_collected_key_cnt_(0),
+      expire_index_enabled_(UseExpireIndex(ttl_type)),
+      expire_bucket_size_(std::max(FLAGS_gc_expire_bucket_size, (uint64_t)1)),
+      key_index_(FLAGS_segment_hash_index ? new KeyHashIndex() : NULL) {
     entries_ = new KeyEntries((uint8_t)FLAGS_skiplist_max_height, 4, scmp);
     entry_free_list_ = new KeyEntryNodeList(4, 4, tcmp);
 }
 
-Segment::Segment(uint8_t height, const std::vector<uint32_t>& ts_idx_vec)
+Segment::Segment(uint8_t height, const std::vector<uint32_t>& ts_idx_vec, TTLType ttl_type)
     : entries_(NULL),
       mu_(),
       idx_cnt_(0),
@@ -67,8 +93,13 @@ Segment::Segment(uint8_t height, const std::vector<uint32_t>& ts_idx_vec)
       pk_cnt_(0),
       key_entry_max_height_(height),
       ts_cnt_(ts_idx_vec.size()),
-      gc_version_(0),
-      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000) {
+      retired_lists_(),
+      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000),
+      gc_visited_key_cnt_(0),
+      gc_collected_key_cnt_(0),
+      expire_index_enabled_(UseExpireIndex(ttl_type) && ts_idx_vec.size() <= 1),
+      expire_bucket_size_(std::max(FLAGS_gc_expire_bucket_size, (uint64_t)1)),
+      key_index_(FLAGS_segment_hash_index ? new KeyHashIndex() : NULL) {
     entries_ = new KeyEntries((uint8_t)FLAGS_skiplist_max_height, 4, scmp);
     entry_free_list_ = new KeyEntryNodeList(4, 4, tcmp);
     for (uint32_t i = 0; i < ts_idx_vec.size(); i++) {
@@ -80,6 +111,30 @@ Segment::Segment(uint8_t height, const std::vector<uint32_t>& ts_idx_vec)
 Segment::~Segment() {
     delete entries_;
     delete entry_free_list_;
+    delete key_index_;
+}
+
+bool Segment::GetEntry(const Slice& key, uint64_t hash, void** entry) {
+    if (key_index_ != NULL) {
+        return key_index_->Get(key, hash, entry) && *entry != NULL;
+    }
+    return entries_->Get(key, *entry) >= 0 && *entry != NULL;
+}
+
+uint8_t Segment::InsertEntry(const Slice& key, uint64_t hash, void* entry) {
+    uint8_t height = entries_->Insert(key, entry);
+    if (key_index_ != NULL) {
+        key_index_->Insert(key, hash, entry);
+    }
+    return height;
+}
+
+::openmldb::base::Node<Slice, void*>* Segment::RemoveEntry(const Slice& key, uint64_t hash) {
+    ::openmldb::base::Node<Slice, void*>* entry_node = entries_->Remove(key);
+    if (entry_node != NULL && key_index_ != NULL) {
+        key_index_->Remove(entry_node->GetKey(), ResolveHash(key, hash));
+    }
+    return entry_node;
 }
 
 uint64_t Segment::Release() {
@@ -105,6 +160,9 @@ uint64_t Segment::Release() {
         it->Next();
     }
     entries_->Clear();
+    if (key_index_ != NULL) {
+        key_index_->Clear();
+    }
     delete it;
 
     KeyEntryNodeList::Iterator* f_it = entry_free_list_->NewIterator();
@@ -129,7 +187,10 @@ uint64_t Segment::Release() {
     }
     delete f_it;
     entry_free_list_->Clear();
+    FreeRetiredLists(UINT64_MAX);
     idx_cnt_vec_.clear();
+    expire_buckets_.clear();
+    expire_slots_.clear();
     return cnt;
 }
 
@@ -141,7 +202,10 @@ void Segment::ReleaseAndCount(uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt, uin
         ::openmldb::base::Node<Slice, void*>* entry_node = NULL;
         {
             std::lock_guard<std::mutex> lock(mu_);
-            entry_node = entries_->Remove(key);
+            entry_node = RemoveEntry(key);
+            if (entry_node != NULL) {
+                UnindexExpire(entry_node->GetValue());
+            }
         }
         if (entry_node != NULL) {
             FreeEntry(entry_node, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
@@ -150,41 +214,51 @@ void Segment::ReleaseAndCount(uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt, uin
         pk_cnt_.fetch_sub(1, std::memory_order_relaxed);
     }
     delete it;
-    uint64_t cur_version = gc_version_.load(std::memory_order_relaxed);
-    GcEntryFreeList(cur_version, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    GcEntryFreeList(UINT64_MAX, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
     Release();
 }
 
-void Segment::Put(const Slice& key, uint64_t time, const char* data, uint32_t size) {
+void Segment::Put(const Slice& key, uint64_t time, const char* data, uint32_t size, uint64_t hash) {
     if (ts_cnt_ > 1) {
         return;
     }
-    auto* db = new DataBlock(1, data, size);
-    Put(key, time, db);
+    auto* db = DataBlock::New(1, data, size);
+    Put(key, time, db, hash);
 }
 
-void Segment::Put(const Slice& key, uint64_t time, DataBlock* row) {
+void Segment::Put(const Slice& key, uint64_t time, DataBlock* row, uint64_t hash) {
     if (ts_cnt_ > 1) {
         return;
     }
+    hash = ResolveHash(key, hash);
     std::lock_guard<std::mutex> lock(mu_);
-    PutUnlock(key, time, row);
+    PutUnlock(key, time, row, hash);
 }
 
-void Segment::PutUnlock(const Slice& key, uint64_t time, DataBlock* row) {
+void Segment::PutUnlock(const Slice& key, uint64_t time, DataBlock* row, uint64_t hash) {
     void* entry = nullptr;
     uint32_t byte_size = 0;
-    int ret = entries_->Get(key, entry);
-    if (ret < 0 || entry == NULL) {
+    hash = ResolveHash(key, hash);
+    Slice skey;
+    bool new_entry = false;
+    if (!GetEntry(key, hash, &entry)) {
         char* pk = new char[key.size()];
         memcpy(pk, key.data(), key.size());
         // need to delete memory when free node
-        Slice skey(pk, key.size());
+        skey = Slice(pk, key.size());
+        new_entry = true;
         entry = (void*)new KeyEntry(key_entry_max_height_);  // NOLINT
-        uint8_t height = entries_->Insert(skey, entry);
+        uint8_t height = InsertEntry(skey, hash, entry);
         byte_size += GetRecordPkIdxSize(height, key.size(), key_entry_max_height_);
         pk_cnt_.fetch_add(1, std::memory_order_relaxed);
     }
+    if (expire_index_enabled_) {
+        // only a row older than all of the entry may move it to an earlier bucket
+        auto last = ((KeyEntry*)entry)->entries.GetLast();  // NOLINT
+        if (last == NULL || time < last->GetKey()) {
+            IndexExpire((KeyEntry*)entry, new_entry ? &skey : NULL, time);  // NOLINT
+        }
+    }
     idx_cnt_.fetch_add(1, std::memory_order_relaxed);
     uint8_t height = ((KeyEntry*)entry)->entries.Insert(time, row);  // NOLINT
     ((KeyEntry*)entry)                                               // NOLINT
@@ -193,15 +267,22 @@ void Segment::PutUnlock(const Slice& key, uint64_t time, DataBlock* row) {
     idx_byte_size_.fetch_add(byte_size, std::memory_order_relaxed);
 }
 
-void Segment::BulkLoadPut(unsigned int key_entry_id, const Slice& key, uint64_t time, DataBlock* row) {
+void Segment::BulkLoadPut(unsigned int key_entry_id, const Slice& key, uint64_t time, DataBlock* row,
+                          uint64_t hash) {
+    hash = ResolveHash(key, hash);
+    std::lock_guard<std::mutex> lock(mu_);  // TODO(hw): need lock?
+    BulkLoadPutUnlock(key_entry_id, key, time, row, hash);
+}
+
+void Segment::BulkLoadPutUnlock(unsigned int key_entry_id, const Slice& key, uint64_t time, DataBlock* row,
+                                uint64_t hash) {
     void* key_entry_or_list = nullptr;
     uint32_t byte_size = 0;
-    std::lock_guard<std::mutex> lock(mu_);  // TODO(hw): need lock?
-    int ret = entries_->Get(key, key_entry_or_list);
     if (ts_cnt_ == 1) {
-        PutUnlock(key, time, row);
+        PutUnlock(key, time, row, hash);
     } else {
-        if (ret < 0 || key_entry_or_list == nullptr) {
+        hash = ResolveHash(key, hash);
+        if (!GetEntry(key, hash, &key_entry_or_list)) {
             char* pk = new char[key.size()];
             memcpy(pk, key.data(), key.size());
             Slice skey(pk, key.size());
@@ -209,8 +290,8 @@ void Segment::BulkLoadPut(unsigned int key_entry_id, const Slice& key, uint64_t
             for (uint32_t i = 0; i < ts_cnt_; i++) {
                 entry_arr_tmp[i] = new KeyEntry(key_entry_max_height_);
             }
-            auto entry_arr = (void*)entry_arr_tmp;  // NOLINT
-            uint8_t height = entries_->Insert(skey, entry_arr);
+            key_entry_or_list = (void*)entry_arr_tmp;  // NOLINT
+            uint8_t height = InsertEntry(skey, hash, key_entry_or_list);
             byte_size += GetRecordPkMultiIdxSize(height, key.size(), key_entry_max_height_, ts_cnt_);
             pk_cnt_.fetch_add(1, std::memory_order_relaxed);
         }
@@ -224,7 +305,7 @@ void Segment::BulkLoadPut(unsigned int key_entry_id, const Slice& key, uint64_t
     }
 }
 
-void Segment::Put(const Slice& key, const std::map<int32_t, uint64_t>& ts_map, DataBlock* row) {
+void Segment::Put(const Slice& key, const std::map<int32_t, uint64_t>& ts_map, DataBlock* row, uint64_t hash) {
     uint32_t ts_size = ts_map.size();
     if (ts_size == 0) {
         return;
@@ -232,11 +313,12 @@ void Segment::Put(const Slice& key, const std::map<int32_t, uint64_t>& ts_map, D
     if (ts_cnt_ == 1) {
         auto pos = ts_map.find(ts_idx_map_.begin()->first);
         if (pos != ts_map.end()) {
-            Put(key, pos->second, row);
+            Put(key, pos->second, row, hash);
         }
         return;
     }
     void* entry_arr = NULL;
+    hash = ResolveHash(key, hash);
     std::lock_guard<std::mutex> lock(mu_);
     for (const auto& kv : ts_map) {
         uint32_t byte_size = 0;
@@ -245,8 +327,7 @@ void Segment::Put(const Slice& key, const std::map<int32_t, uint64_t>& ts_map, D
             continue;
         }
         if (entry_arr == NULL) {
-            int ret = entries_->Get(key, entry_arr);
-            if (ret < 0 || entry_arr == NULL) {
+            if (!GetEntry(key, hash, &entry_arr)) {
                 char* pk = new char[key.size()];
                 memcpy(pk, key.data(), key.size());
                 Slice skey(pk, key.size());
@@ -255,7 +336,7 @@ void Segment::Put(const Slice& key, const std::map<int32_t, uint64_t>& ts_map, D
                     entry_arr_tmp[i] = new KeyEntry(key_entry_max_height_);
                 }
                 entry_arr = (void*)entry_arr_tmp;  // NOLINT
-                uint8_t height = entries_->Insert(skey, entry_arr);
+                uint8_t height = InsertEntry(skey, hash, entry_arr);
                 byte_size += GetRecordPkMultiIdxSize(height, key.size(), key_entry_max_height_, ts_cnt_);
                 pk_cnt_.fetch_add(1, std::memory_order_relaxed);
             }
@@ -270,19 +351,21 @@ void Segment::Put(const Slice& key, const std::map<int32_t, uint64_t>& ts_map, D
     }
 }
 
-bool Segment::Get(const Slice& key, const uint64_t time, DataBlock** block) {
+bool Segment::Get(const Slice& key, const uint64_t time, DataBlock** block, uint64_t hash) {
     if (block == NULL || ts_cnt_ > 1) {
         return false;
     }
+    // the entry and the hash index table are not freed until the guard exits
+    ::openmldb::base::EpochGuard guard;
     void* entry = NULL;
-    if (entries_->Get(key, entry) < 0 || entry == NULL) {
+    if (!GetEntry(key, ResolveHash(key, hash), &entry)) {
         return false;
     }
     *block = ((KeyEntry*)entry)->entries.Get(time);  // NOLINT
     return true;
 }
 
-bool Segment::Get(const Slice& key, uint32_t idx, const uint64_t time, DataBlock** block) {
+bool Segment::Get(const Slice& key, uint32_t idx, const uint64_t time, DataBlock** block, uint64_t hash) {
     if (block == NULL) {
         return false;
     }
@@ -291,28 +374,31 @@ bool Segment::Get(const Slice& key, uint32_t idx, const uint64_t time, DataBlock
         return false;
     }
     if (ts_cnt_ == 1) {
-        return Get(key, time, block);
+        return Get(key, time, block, hash);
     }
+    ::openmldb::base::EpochGuard guard;
     void* entry = NULL;
-    if (entries_->Get(key, entry) < 0 || entry == NULL) {
+    if (!GetEntry(key, ResolveHash(key, hash), &entry)) {
         return false;
     }
     *block = ((KeyEntry**)entry)[pos->second]->entries.Get(time);  // NOLINT
     return true;
 }
 
-bool Segment::Delete(const Slice& key) {
+bool Segment::Delete(const Slice& key, uint64_t hash) {
     ::openmldb::base::Node<Slice, void*>* entry_node = NULL;
+    hash = ResolveHash(key, hash);
     {
         std::lock_guard<std::mutex> lock(mu_);
-        entry_node = entries_->Remove(key);
+        entry_node = RemoveEntry(key, hash);
         if (entry_node == NULL) {
             return false;
         }
+        UnindexExpire(entry_node->GetValue());
     }
     {
         std::lock_guard<std::mutex> lock(gc_mu_);
-        entry_free_list_->Insert(gc_version_.load(std::memory_order_relaxed), entry_node);
+        entry_free_list_->Insert(::openmldb::base::EpochManager::GetInstance()->GetRetireEpoch(), entry_node);
     }
     return true;
 }
@@ -383,12 +469,12 @@ void Segment::FreeEntry(::openmldb::base::Node<Slice, void*>* entry_node, uint64
     }
 }
 
-void Segment::GcEntryFreeList(uint64_t version, uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt,
+void Segment::GcEntryFreeList(uint64_t epoch, uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt,
                               uint64_t& gc_record_byte_size) {
     ::openmldb::base::Node<uint64_t, ::openmldb::base::Node<Slice, void*>*>* node = NULL;
     {
         std::lock_guard<std::mutex> lock(gc_mu_);
-        node = entry_free_list_->Split(version);
+        node = entry_free_list_->Split(epoch);
     }
     while (node != NULL) {
         ::openmldb::base::Node<Slice, void*>* entry_node = node->GetValue();
@@ -402,12 +488,60 @@ void Segment::GcEntryFreeList(uint64_t version, uint64_t& gc_idx_cnt, uint64_t&
 }
 
 void Segment::GcFreeList(uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt, uint64_t& gc_record_byte_size) {
-    uint64_t cur_version = gc_version_.load(std::memory_order_relaxed);
-    if (cur_version < FLAGS_gc_deleted_pk_version_delta) {
+    uint64_t epoch = ::openmldb::base::EpochManager::GetInstance()->GetReclaimableEpoch();
+    GcEntryFreeList(epoch, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    FreeRetiredLists(epoch);
+    if (key_index_ != NULL) {
+        key_index_->GcRetired(epoch);
+    }
+}
+
+void Segment::RetireList(::openmldb::base::Node<uint64_t, DataBlock*>* node, uint64_t& gc_idx_cnt,
+                         uint64_t& gc_record_cnt, uint64_t& gc_record_byte_size) {
+    if (node == NULL) {
         return;
     }
-    uint64_t free_list_version = cur_version - FLAGS_gc_deleted_pk_version_delta;
-    GcEntryFreeList(free_list_version, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    RetiredList retired;
+    retired.node = node;
+    while (node != NULL) {
+        gc_idx_cnt++;
+        idx_byte_size_.fetch_sub(GetRecordTsIdxSize(node->Height()));
+        DataBlock* block = node->GetValue();
+        if (block->dim_cnt_down > 1) {
+            block->dim_cnt_down--;
+        } else {
+            gc_record_byte_size += GetRecordSize(block->size);
+            retired.blocks.push_back(block);
+            gc_record_cnt++;
+        }
+        node = node->GetNextNoBarrier(0);
+    }
+    // the list has been split, so a reader entering from now on never reaches it
+    retired.epoch = ::openmldb::base::EpochManager::GetInstance()->GetRetireEpoch();
+    std::lock_guard<std::mutex> lock(gc_mu_);
+    retired_lists_.push_back(std::move(retired));
+}
+
+void Segment::FreeRetiredLists(uint64_t epoch) {
+    std::vector<RetiredList> lists;
+    {
+        std::lock_guard<std::mutex> lock(gc_mu_);
+        while (!retired_lists_.empty() && retired_lists_.front().epoch <= epoch) {
+            lists.push_back(std::move(retired_lists_.front()));
+            retired_lists_.pop_front();
+        }
+    }
+    for (auto& retired : lists) {
+        ::openmldb::base::Node<uint64_t, DataBlock*>* node = retired.node;
+        while (node != NULL) {
+            ::openmldb::base::Node<uint64_t, DataBlock*>* tmp = node;
+            node = node->GetNextNoBarrier(0);
+            delete tmp;
+        }
+        for (DataBlock* block : retired.blocks) {
+            delete block;
+        }
+    }
 }
 
 void Segment::ExecuteGc(const TTLSt& ttl_st, uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt,
@@ -488,12 +622,10 @@ void Segment::Gc4Head(uint64_t keep_cnt, uint64_t& gc_idx_cnt, uint64_t& gc_reco
         ::openmldb::base::Node<uint64_t, DataBlock*>* node = NULL;
         {
             std::lock_guard<std::mutex> lock(mu_);
-            if (entry->refs_.load(std::memory_order_acquire) <= 0) {
-                node = entry->entries.SplitByPos(keep_cnt);
-            }
+            node = entry->entries.SplitByPos(keep_cnt);
         }
         uint64_t entry_gc_idx_cnt = 0;
-        FreeList(node, entry_gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+        RetireList(node, entry_gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
         entry->count_.fetch_sub(entry_gc_idx_cnt, std::memory_order_relaxed);
         gc_idx_cnt += entry_gc_idx_cnt;
         it->Next();
@@ -534,7 +666,7 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
                     } else {
                         node = NULL;
                         std::lock_guard<std::mutex> lock(mu_);
-                        SplitList(entry, kv.second.abs_ttl, &node);
+                        node = entry->entries.Split(kv.second.abs_ttl);
                         if (entry->entries.IsEmpty()) {
                             empty_cnt++;
                         }
@@ -543,9 +675,7 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
                 }
                 case ::openmldb::storage::TTLType::kLatestTime: {
                     std::lock_guard<std::mutex> lock(mu_);
-                    if (entry->refs_.load(std::memory_order_acquire) <= 0) {
-                        node = entry->entries.SplitByPos(kv.second.lat_ttl);
-                    }
+                    node = entry->entries.SplitByPos(kv.second.lat_ttl);
                     break;
                 }
                 case ::openmldb::storage::TTLType::kAbsAndLat: {
@@ -555,9 +685,7 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
                     } else {
                         node = NULL;
                         std::lock_guard<std::mutex> lock(mu_);
-                        if (entry->refs_.load(std::memory_order_acquire) <= 0) {
-                            node = entry->entries.SplitByKeyAndPos(kv.second.abs_ttl, kv.second.lat_ttl);
-                        }
+                        node = entry->entries.SplitByKeyAndPos(kv.second.abs_ttl, kv.second.lat_ttl);
                     }
                     break;
                 }
@@ -568,14 +696,12 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
                     } else {
                         node = NULL;
                         std::lock_guard<std::mutex> lock(mu_);
-                        if (entry->refs_.load(std::memory_order_acquire) <= 0) {
-                            if (kv.second.abs_ttl == 0) {
-                                node = entry->entries.SplitByPos(kv.second.lat_ttl);
-                            } else if (kv.second.lat_ttl == 0) {
-                                node = entry->entries.Split(kv.second.abs_ttl);
-                            } else {
-                                node = entry->entries.SplitByKeyOrPos(kv.second.abs_ttl, kv.second.lat_ttl);
-                            }
+                        if (kv.second.abs_ttl == 0) {
+                            node = entry->entries.SplitByPos(kv.second.lat_ttl);
+                        } else if (kv.second.lat_ttl == 0) {
+                            node = entry->entries.Split(kv.second.abs_ttl);
+                        } else {
+                            node = entry->entries.SplitByKeyOrPos(kv.second.abs_ttl, kv.second.lat_ttl);
                         }
                         if (entry->entries.IsEmpty()) {
                             empty_cnt++;
@@ -590,7 +716,7 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
                 continue;
             }
             uint64_t entry_gc_idx_cnt = 0;
-            FreeList(node, entry_gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+            RetireList(node, entry_gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
             entry->count_.fetch_sub(entry_gc_idx_cnt, std::memory_order_relaxed);
             idx_cnt_vec_[pos->second]->fetch_sub(entry_gc_idx_cnt, std::memory_order_relaxed);
             gc_idx_cnt += entry_gc_idx_cnt;
@@ -607,12 +733,12 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
                     }
                 }
                 if (is_empty) {
-                    entry_node = entries_->Remove(key);
+                    entry_node = RemoveEntry(key);
                 }
             }
             if (entry_node != NULL) {
                 std::lock_guard<std::mutex> lock(gc_mu_);
-                entry_free_list_->Insert(gc_version_.load(std::memory_order_relaxed), entry_node);
+                entry_free_list_->Insert(::openmldb::base::EpochManager::GetInstance()->GetRetireEpoch(), entry_node);
             }
         }
     }
@@ -621,24 +747,173 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
     delete it;
 }
 
-void Segment::SplitList(KeyEntry* entry, uint64_t ts, ::openmldb::base::Node<uint64_t, DataBlock*>** node) {
-    // skip entry that ocupied by reader
-    if (entry->refs_.load(std::memory_order_acquire) <= 0) {
-        *node = entry->entries.Split(ts);
+void Segment::IndexExpire(KeyEntry* entry, const Slice* key, uint64_t ts) {
+    uint64_t bucket = GetExpireBucket(ts);
+    auto slot_it = expire_slots_.find(entry);
+    if (slot_it == expire_slots_.end()) {
+        if (key == NULL) {
+            PDLOG(WARNING, "key entry is missing in expire index");
+            return;
+        }
+        expire_slots_.emplace(entry, ExpireSlot{bucket, *key});
+        expire_buckets_[bucket].insert(entry);
+        idx_byte_size_.fetch_add(EXPIRE_IDX_BYTE_SIZE, std::memory_order_relaxed);
+        return;
     }
+    ExpireSlot& slot = slot_it->second;
+    // the entry taken out by gc is put back with its oldest ts later
+    if (slot.bucket == GC_TAKEN_BUCKET || slot.bucket <= bucket) {
+        return;
+    }
+    auto bucket_it = expire_buckets_.find(slot.bucket);
+    if (bucket_it != expire_buckets_.end()) {
+        bucket_it->second.erase(entry);
+        if (bucket_it->second.empty()) {
+            expire_buckets_.erase(bucket_it);
+        }
+    }
+    slot.bucket = bucket;
+    expire_buckets_[bucket].insert(entry);
+}
+
+void Segment::UnindexExpire(void* entry) {
+    if (!expire_index_enabled_) {
+        return;
+    }
+    auto slot_it = expire_slots_.find((KeyEntry*)entry);  // NOLINT
+    if (slot_it == expire_slots_.end()) {
+        return;
+    }
+    auto bucket_it = expire_buckets_.find(slot_it->second.bucket);
+    if (bucket_it != expire_buckets_.end()) {
+        bucket_it->second.erase(slot_it->first);
+        if (bucket_it->second.empty()) {
+            expire_buckets_.erase(bucket_it);
+        }
+    }
+    expire_slots_.erase(slot_it);
+    idx_byte_size_.fetch_sub(EXPIRE_IDX_BYTE_SIZE, std::memory_order_relaxed);
+}
+
+void Segment::TakeExpired(uint64_t max_bucket, uint64_t limit, std::vector<std::pair<KeyEntry*, Slice>>* entries) {
+    auto bucket_it = expire_buckets_.begin();
+    while (bucket_it != expire_buckets_.end() && bucket_it->first <= max_bucket && entries->size() < limit) {
+        auto& bucket = bucket_it->second;
+        auto entry_it = bucket.begin();
+        while (entry_it != bucket.end() && entries->size() < limit) {
+            ExpireSlot& slot = expire_slots_[*entry_it];
+            slot.bucket = GC_TAKEN_BUCKET;
+            entries->emplace_back(*entry_it, slot.key);
+            entry_it = bucket.erase(entry_it);
+        }
+        if (bucket.empty()) {
+            bucket_it = expire_buckets_.erase(bucket_it);
+        }
+    }
+}
+
+bool Segment::ReindexExpire(KeyEntry* entry, uint64_t max_bucket, bool force) {
+    auto slot_it = expire_slots_.find(entry);
+    if (slot_it == expire_slots_.end() || slot_it->second.bucket != GC_TAKEN_BUCKET) {
+        return true;
+    }
+    // an empty entry is left in the first bucket and removed by next gc
+    auto last = entry->entries.GetLast();
+    uint64_t bucket = last == NULL ? 0 : GetExpireBucket(last->GetKey());
+    if (bucket <= max_bucket && !force) {
+        return false;
+    }
+    slot_it->second.bucket = bucket;
+    expire_buckets_[bucket].insert(entry);
+    return true;
+}
+
+void Segment::Gc4TTLByIndex(const uint64_t time, uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt,
+                            uint64_t& gc_record_byte_size) {
+    uint64_t consumed = ::baidu::common::timer::get_micros();
+    uint64_t old = gc_idx_cnt;
+    uint64_t max_bucket = GetExpireBucket(time);
+    uint64_t max_keys = FLAGS_gc_max_keys_per_round == 0 ? UINT64_MAX : FLAGS_gc_max_keys_per_round;
+    uint64_t visited_cnt = 0;
+    uint64_t collected_cnt = 0;
+    std::vector<std::pair<KeyEntry*, Slice>> entries;
+    // the entries still in expired buckets after gc, e.g. with the ts in the
+    // same bucket as expire time. put back them at the end
+    // so that they are not visited again in this round
+    std::vector<KeyEntry*> kept_entries;
+    while (visited_cnt < max_keys) {
+        entries.clear();
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            TakeExpired(max_bucket, std::min(GC_TAKE_BATCH_SIZE, max_keys - visited_cnt), &entries);
+        }
+        if (entries.empty()) {
+            break;
+        }
+        for (const auto& kv : entries) {
+            KeyEntry* entry = kv.first;
+            visited_cnt++;
+            ::openmldb::base::Node<uint64_t, DataBlock*>* node = NULL;
+            ::openmldb::base::Node<Slice, void*>* entry_node = NULL;
+            {
+                std::lock_guard<std::mutex> lock(mu_);
+                // the key has been deleted
+                if (expire_slots_.find(entry) == expire_slots_.end()) {
+                    continue;
+                }
+                node = entry->entries.Split(time);
+                if (entry->entries.IsEmpty()) {
+                    entry_node = RemoveEntry(kv.second);
+                    UnindexExpire(entry);
+                } else if (!ReindexExpire(entry, max_bucket, false)) {
+                    kept_entries.push_back(entry);
+                }
+            }
+            if (entry_node != NULL) {
+                std::lock_guard<std::mutex> lock(gc_mu_);
+                entry_free_list_->Insert(::openmldb::base::EpochManager::GetInstance()->GetRetireEpoch(), entry_node);
+            }
+            uint64_t entry_gc_idx_cnt = 0;
+            RetireList(node, entry_gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+            entry->count_.fetch_sub(entry_gc_idx_cnt, std::memory_order_relaxed);
+            gc_idx_cnt += entry_gc_idx_cnt;
+            if (entry_gc_idx_cnt > 0) {
+                collected_cnt++;
+            }
+        }
+    }
+    if (!kept_entries.empty()) {
+        std::lock_guard<std::mutex> lock(mu_);
+        for (KeyEntry* entry : kept_entries) {
+            ReindexExpire(entry, max_bucket, true);
+        }
+    }
+    idx_cnt_.fetch_sub(gc_idx_cnt - old, std::memory_order_relaxed);
+    gc_visited_key_cnt_.fetch_add(visited_cnt, std::memory_order_relaxed);
+    gc_collected_key_cnt_.fetch_add(collected_cnt, std::memory_order_relaxed);
+    DEBUGLOG("[Gc4TTL] segment gc with key %lu by expire index, consumed %lu, count %lu, visited keys %lu, "
+             "collected keys %lu", time, (::baidu::common::timer::get_micros() - consumed) / 1000,
+             gc_idx_cnt - old, visited_cnt, collected_cnt);
 }
 
 // fast gc with no global pause
 void Segment::Gc4TTL(const uint64_t time, uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt,
                      uint64_t& gc_record_byte_size) {
+    if (expire_index_enabled_) {
+        Gc4TTLByIndex(time, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+        return;
+    }
     uint64_t consumed = ::baidu::common::timer::get_micros();
     uint64_t old = gc_idx_cnt;
+    uint64_t visited_cnt = 0;
+    uint64_t collected_cnt = 0;
     KeyEntries::Iterator* it = entries_->NewIterator();
     it->SeekToFirst();
     while (it->Valid()) {
         KeyEntry* entry = (KeyEntry*)it->GetValue();  // NOLINT
         Slice key = it->GetKey();
         it->Next();
+        visited_cnt++;
         ::openmldb::base::Node<uint64_t, DataBlock*>* node = entry->entries.GetLast();
         if (node == NULL) {
             continue;
@@ -653,23 +928,28 @@ void Segment::Gc4TTL(const uint64_t time, uint64_t& gc_idx_cnt, uint64_t& gc_rec
         ::openmldb::base::Node<Slice, void*>* entry_node = NULL;
         {
             std::lock_guard<std::mutex> lock(mu_);
-            SplitList(entry, time, &node);
+            node = entry->entries.Split(time);
             if (entry->entries.IsEmpty()) {
-                entry_node = entries_->Remove(key);
+                entry_node = RemoveEntry(key);
             }
         }
         if (entry_node != NULL) {
             std::lock_guard<std::mutex> lock(gc_mu_);
-            entry_free_list_->Insert(gc_version_.load(std::memory_order_relaxed), entry_node);
+            entry_free_list_->Insert(::openmldb::base::EpochManager::GetInstance()->GetRetireEpoch(), entry_node);
         }
         uint64_t entry_gc_idx_cnt = 0;
-        FreeList(node, entry_gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+        RetireList(node, entry_gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
         entry->count_.fetch_sub(entry_gc_idx_cnt, std::memory_order_relaxed);
         gc_idx_cnt += entry_gc_idx_cnt;
+        if (entry_gc_idx_cnt > 0) {
+            collected_cnt++;
+        }
     }
     DEBUGLOG("[Gc4TTL] segment gc with key %lu ,consumed %lu, count %lu", time,
              (::baidu::common::timer::get_micros() - consumed) / 1000, gc_idx_cnt - old);
     idx_cnt_.fetch_sub(gc_idx_cnt - old, std::memory_order_relaxed);
+    gc_visited_key_cnt_.fetch_add(visited_cnt, std::memory_order_relaxed);
+    gc_collected_key_cnt_.fetch_add(collected_cnt, std::memory_order_relaxed);
     delete it;
 }
 
@@ -699,12 +979,10 @@ void Segment::Gc4TTLAndHead(const uint64_t time, const uint64_t keep_cnt, uint64
         node = NULL;
         {
             std::lock_guard<std::mutex> lock(mu_);
-            if (entry->refs_.load(std::memory_order_acquire) <= 0) {
-                node = entry->entries.SplitByKeyAndPos(time, keep_cnt);
-            }
+            node = entry->entries.SplitByKeyAndPos(time, keep_cnt);
         }
         uint64_t entry_gc_idx_cnt = 0;
-        FreeList(node, entry_gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+        RetireList(node, entry_gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
         entry->count_.fetch_sub(entry_gc_idx_cnt, std::memory_order_relaxed);
         gc_idx_cnt += entry_gc_idx_cnt;
     }
@@ -744,19 +1022,18 @@ void Segment::Gc4TTLOrHead(const uint64_t time, const uint64_t keep_cnt, uint64_
         ::openmldb::base::Node<Slice, void*>* entry_node = NULL;
         {
             std::lock_guard<std::mutex> lock(mu_);
-            if (entry->refs_.load(std::memory_order_acquire) <= 0) {
-                node = entry->entries.SplitByKeyOrPos(time, keep_cnt);
-            }
+            node = entry->entries.SplitByKeyOrPos(time, keep_cnt);
             if (entry->entries.IsEmpty()) {
-                entry_node = entries_->Remove(key);
+                entry_node = RemoveEntry(key);
+                UnindexExpire(entry);
             }
         }
         if (entry_node != NULL) {
             std::lock_guard<std::mutex> lock(gc_mu_);
-            entry_free_list_->Insert(gc_version_.load(std::memory_order_relaxed), entry_node);
+            entry_free_list_->Insert(::openmldb::base::EpochManager::GetInstance()->GetRetireEpoch(), entry_node);
         }
         uint64_t entry_gc_idx_cnt = 0;
-        FreeList(node, entry_gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+        RetireList(node, entry_gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
         entry->count_.fetch_sub(entry_gc_idx_cnt, std::memory_order_relaxed);
         gc_idx_cnt += entry_gc_idx_cnt;
     }
@@ -768,28 +1045,30 @@ void Segment::Gc4TTLOrHead(const uint64_t time, const uint64_t keep_cnt, uint64_
     delete it;
 }
 
-int Segment::GetCount(const Slice& key, uint64_t& count) {
+int Segment::GetCount(const Slice& key, uint64_t& count, uint64_t hash) {
     if (ts_cnt_ > 1) {
         return -1;
     }
+    ::openmldb::base::EpochGuard guard;
     void* entry = NULL;
-    if (entries_->Get(key, entry) < 0 || entry == NULL) {
+    if (!GetEntry(key, ResolveHash(key, hash), &entry)) {
         return -1;
     }
     count = ((KeyEntry*)entry)->count_.load(std::memory_order_relaxed);  // NOLINT
     return 0;
 }
 
-int Segment::GetCount(const Slice& key, uint32_t idx, uint64_t& count) {
+int Segment::GetCount(const Slice& key, uint32_t idx, uint64_t& count, uint64_t hash) {
     auto pos = ts_idx_map_.find(idx);
     if (pos == ts_idx_map_.end()) {
         return -1;
     }
     if (ts_cnt_ == 1) {
-        return GetCount(key, count);
+        return GetCount(key, count, hash);
     }
+    ::openmldb::base::EpochGuard guard;
     void* entry_arr = NULL;
-    if (entries_->Get(key, entry_arr) < 0 || entry_arr == NULL) {
+    if (!GetEntry(key, ResolveHash(key, hash), &entry_arr)) {
         return -1;
     }
     count = ((KeyEntry**)entry_arr)[pos->second]->count_.load(  // NOLINT
@@ -798,31 +1077,29 @@ int Segment::GetCount(const Slice& key, uint32_t idx, uint64_t& count) {
 }
 
 // Iterator
-MemTableIterator* Segment::NewIterator(const Slice& key, Ticket& ticket) {
+MemTableIterator* Segment::NewIterator(const Slice& key, Ticket& ticket, uint64_t hash) {
     if (entries_ == NULL || ts_cnt_ > 1) {
         return new MemTableIterator(NULL);
     }
     void* entry = NULL;
-    if (entries_->Get(key, entry) < 0 || entry == NULL) {
+    if (!GetEntry(key, ResolveHash(key, hash), &entry)) {
         return new MemTableIterator(NULL);
     }
-    ticket.Push((KeyEntry*)entry);                                           // NOLINT
     return new MemTableIterator(((KeyEntry*)entry)->entries.NewIterator());  // NOLINT
 }
 
-MemTableIterator* Segment::NewIterator(const Slice& key, uint32_t idx, Ticket& ticket) {
+MemTableIterator* Segment::NewIterator(const Slice& key, uint32_t idx, Ticket& ticket, uint64_t hash) {
     auto pos = ts_idx_map_.find(idx);
     if (pos == ts_idx_map_.end()) {
         return new MemTableIterator(NULL);
     }
     if (ts_cnt_ == 1) {
-        return NewIterator(key, ticket);
+        return NewIterator(key, ticket, hash);
     }
     void* entry_arr = NULL;
-    if (entries_->Get(key, entry_arr) < 0 || entry_arr == NULL) {
+    if (!GetEntry(key, ResolveHash(key, hash), &entry_arr)) {
         return new MemTableIterator(NULL);
     }
-    ticket.Push(((KeyEntry**)entry_arr)[pos->second]);                                         // NOLINT
     return new MemTableIterator(((KeyEntry**)entry_arr)[pos->second]->entries.NewIterator());  // NOLINT
 }
 
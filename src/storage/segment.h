@@ -18,15 +18,21 @@
 #define SRC_STORAGE_SEGMENT_H_
 
 #include <atomic>
+#include <deque>
 #include <map>
 #include <memory>
 #include <mutex>  // NOLINT
+#include <new>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "base/skiplist.h"
 #include "base/slice.h"
 #include "proto/tablet.pb.h"
 #include "storage/iterator.h"
+#include "storage/key_hash_index.h"
 #include "storage/schema.h"
 #include "storage/ticket.h"
 
@@ -43,6 +49,8 @@ class Ticket;
 struct DataBlock {
     // dimension count down
     uint8_t dim_cnt_down;
+    // the payload is allocated together with the block by New
+    bool inlined = false;
     uint32_t size;
     char* data;
 
@@ -61,8 +69,23 @@ struct DataBlock {
         }
     }
 
+    // allocate the block and its payload in one piece of memory, it can be
+    // released by delete as the blocks created by constructor
+    static DataBlock* New(uint8_t dim_cnt, const char* input, uint32_t len) {
+        void* mem = ::operator new(sizeof(DataBlock) + len);
+        char* payload = reinterpret_cast<char*>(mem) + sizeof(DataBlock);
+        memcpy(payload, input, len);
+        auto* block = new (mem) DataBlock(dim_cnt, payload, len, true);
+        block->inlined = true;
+        return block;
+    }
+
+    static void operator delete(void* ptr) { ::operator delete(ptr); }
+
     ~DataBlock() {
-        delete[] data;
+        if (!inlined) {
+            delete[] data;
+        }
         data = NULL;
     }
 };
@@ -100,8 +123,8 @@ class MemTableIterator : public TableIterator {
 
 class KeyEntry {
  public:
-    KeyEntry() : entries(12, 4, tcmp), refs_(0), count_(0) {}
-    explicit KeyEntry(uint8_t height) : entries(height, 4, tcmp), refs_(0), count_(0) {}
+    KeyEntry() : entries(12, 4, tcmp), count_(0) {}
+    explicit KeyEntry(uint8_t height) : entries(height, 4, tcmp), count_(0) {}
     ~KeyEntry() {}
 
     // just return the count of datablock
@@ -125,15 +148,10 @@ class KeyEntry {
         return cnt;
     }
 
-    void Ref() { refs_.fetch_add(1, std::memory_order_relaxed); }
-
-    void UnRef() { refs_.fetch_sub(1, std::memory_order_relaxed); }
-
     uint64_t GetCount() { return count_.load(std::memory_order_relaxed); }
 
  public:
     TimeEntries entries;
-    std::atomic<uint64_t> refs_;
     std::atomic<uint64_t> count_;
     friend Segment;
 };
@@ -148,27 +166,38 @@ typedef ::openmldb::base::Skiplist<uint64_t, ::openmldb::base::Node<Slice, void*
 class Segment {
  public:
     Segment();
-    explicit Segment(uint8_t height);
-    Segment(uint8_t height, const std::vector<uint32_t>& ts_idx_vec);
+    // the expire index is only built for the ttl types gc by absolute time
+    explicit Segment(uint8_t height, TTLType ttl_type = TTLType::kAbsoluteTime);
+    Segment(uint8_t height, const std::vector<uint32_t>& ts_idx_vec, TTLType ttl_type = TTLType::kAbsoluteTime);
     ~Segment();
 
+    // the hash of key for the hash index of pk, it is 0 without hash index.
+    // The methods taking a key take its hash too, so that the caller hashes a
+    // key once, out of the put lock. A hash of 0 is computed by the segment
+    inline uint64_t HashKey(const Slice& key) const { return key_index_ == NULL ? 0 : KeyHashIndex::Hash(key); }
+
     // Put time data
-    void Put(const Slice& key, uint64_t time, const char* data, uint32_t size);
+    void Put(const Slice& key, uint64_t time, const char* data, uint32_t size, uint64_t hash = 0);
+
+    void Put(const Slice& key, uint64_t time, DataBlock* row, uint64_t hash = 0);
 
-    void Put(const Slice& key, uint64_t time, DataBlock* row);
+    void PutUnlock(const Slice& key, uint64_t time, DataBlock* row, uint64_t hash = 0);
 
-    void PutUnlock(const Slice& key, uint64_t time, DataBlock* row);
+    void BulkLoadPut(unsigned int key_entry_id, const Slice& key, uint64_t time, DataBlock* row, uint64_t hash = 0);
 
-    void BulkLoadPut(unsigned int key_entry_id, const Slice& key, uint64_t time, DataBlock* row);
+    // the caller makes sure that no one else accesses the segment, e.g. when
+    // the segment is being recovered
+    void BulkLoadPutUnlock(unsigned int key_entry_id, const Slice& key, uint64_t time, DataBlock* row,
+                           uint64_t hash = 0);
 
-    void Put(const Slice& key, const std::map<int32_t, uint64_t>& ts_map, DataBlock* row);
+    void Put(const Slice& key, const std::map<int32_t, uint64_t>& ts_map, DataBlock* row, uint64_t hash = 0);
 
     // Get time data
-    bool Get(const Slice& key, uint64_t time, DataBlock** block);
+    bool Get(const Slice& key, uint64_t time, DataBlock** block, uint64_t hash = 0);
 
-    bool Get(const Slice& key, uint32_t idx, uint64_t time, DataBlock** block);
+    bool Get(const Slice& key, uint32_t idx, uint64_t time, DataBlock** block, uint64_t hash = 0);
 
-    bool Delete(const Slice& key);
+    bool Delete(const Slice& key, uint64_t hash = 0);
 
     uint64_t Release();
 
@@ -194,9 +223,11 @@ class Segment {
     void GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& gc_idx_cnt,  // NOLINT
                    uint64_t& gc_record_cnt,                                            // NOLINT
                    uint64_t& gc_record_byte_size);                                     // NOLINT
-    MemTableIterator* NewIterator(const Slice& key, Ticket& ticket);                   // NOLINT
-    MemTableIterator* NewIterator(const Slice& key, uint32_t idx,
-                                  Ticket& ticket);  // NOLINT
+    // the iterator must be destroyed before the ticket, which keeps the key entry
+    // from being freed by gc
+    MemTableIterator* NewIterator(const Slice& key, Ticket& ticket, uint64_t hash = 0);  // NOLINT
+    MemTableIterator* NewIterator(const Slice& key, uint32_t idx, Ticket& ticket,        // NOLINT
+                                  uint64_t hash = 0);
 
     inline uint64_t GetIdxCnt() {
         return ts_cnt_ > 1 ? idx_cnt_vec_[0]->load(std::memory_order_relaxed)
@@ -230,28 +261,74 @@ class Segment {
 
     inline uint64_t GetPkCnt() { return pk_cnt_.load(std::memory_order_relaxed); }
 
+    // free the memory retired by gc and delete once no reader may reach it,
+    // see base::EpochManager
     void GcFreeList(uint64_t& entry_gc_idx_cnt,      // NOLINT
                     uint64_t& gc_record_cnt,         // NOLINT
                     uint64_t& gc_record_byte_size);  // NOLINT
 
     KeyEntries* GetKeyEntries() { return entries_; }
 
-    int GetCount(const Slice& key, uint64_t& count);                // NOLINT
-    int GetCount(const Slice& key, uint32_t idx, uint64_t& count);  // NOLINT
-
-    void IncrGcVersion() { gc_version_.fetch_add(1, std::memory_order_relaxed); }
+    int GetCount(const Slice& key, uint64_t& count, uint64_t hash = 0);                // NOLINT
+    int GetCount(const Slice& key, uint32_t idx, uint64_t& count, uint64_t hash = 0);  // NOLINT
 
     void ReleaseAndCount(uint64_t& gc_idx_cnt,            // NOLINT
                          uint64_t& gc_record_cnt,         // NOLINT
                          uint64_t& gc_record_byte_size);  // NOLINT
 
+    // the count of keys checked and the count of keys freed some data by gc
+    // since the segment is created
+    inline uint64_t GetGcVisitedKeyCnt() { return gc_visited_key_cnt_.load(std::memory_order_relaxed); }
+    inline uint64_t GetGcCollectedKeyCnt() { return gc_collected_key_cnt_.load(std::memory_order_relaxed); }
+
+    inline bool HasExpireIndex() const { return expire_index_enabled_; }
+
+    inline bool HasHashIndex() const { return key_index_ != NULL; }
+
  private:
+    // the hash passed by the caller, or HashKey if the caller passed 0
+    inline uint64_t ResolveHash(const Slice& key, uint64_t hash) const { return hash == 0 ? HashKey(key) : hash; }
+    // access entries_ together with the hash index of pk. hash is computed by
+    // HashKey once per key, it is ignored without hash index
+    bool GetEntry(const Slice& key, uint64_t hash, void** entry);
+    uint8_t InsertEntry(const Slice& key, uint64_t hash, void* entry);
+    ::openmldb::base::Node<Slice, void*>* RemoveEntry(const Slice& key, uint64_t hash = 0);
+
+    // the position of key entry in expire index
+    struct ExpireSlot {
+        uint64_t bucket;
+        Slice key;
+    };
+
+    // gc absolute ttl with expire index, only the entries whose oldest ts is
+    // in an expired bucket are visited
+    void Gc4TTLByIndex(const uint64_t time, uint64_t& gc_idx_cnt,  // NOLINT
+                       uint64_t& gc_record_cnt,                    // NOLINT
+                       uint64_t& gc_record_byte_size);             // NOLINT
+    // the following expire index functions should be called with mu_ locked.
+    // key is the pk owned by entries_ for a new entry, otherwise NULL
+    void IndexExpire(KeyEntry* entry, const Slice* key, uint64_t ts);
+    void UnindexExpire(void* entry);
+    // take out at most `limit` entries of the buckets not greater than
+    // max_bucket, they are put back by ReindexExpire after gc
+    void TakeExpired(uint64_t max_bucket, uint64_t limit, std::vector<std::pair<KeyEntry*, Slice>>* entries);
+    // put back the entry taken out by its oldest ts. return false if it still
+    // falls into the buckets not greater than max_bucket and force is not set,
+    // the entry is left taken out
+    bool ReindexExpire(KeyEntry* entry, uint64_t max_bucket, bool force);
+    inline uint64_t GetExpireBucket(uint64_t ts) const { return ts / expire_bucket_size_; }
+
     void FreeList(::openmldb::base::Node<uint64_t, DataBlock*>* node, uint64_t& gc_idx_cnt,  // NOLINT
                   uint64_t& gc_record_cnt,         // NOLINT
                   uint64_t& gc_record_byte_size);  // NOLINT
-    void SplitList(KeyEntry* entry, uint64_t ts, ::openmldb::base::Node<uint64_t, DataBlock*>** node);
+    // count the nodes split by gc as freed and retire them, they are freed by
+    // FreeRetiredLists after the readers in the current epoch exit
+    void RetireList(::openmldb::base::Node<uint64_t, DataBlock*>* node, uint64_t& gc_idx_cnt,  // NOLINT
+                    uint64_t& gc_record_cnt,         // NOLINT
+                    uint64_t& gc_record_byte_size);  // NOLINT
+    void FreeRetiredLists(uint64_t epoch);
 
-    void GcEntryFreeList(uint64_t version, uint64_t& gc_idx_cnt,  // NOLINT
+    void GcEntryFreeList(uint64_t epoch, uint64_t& gc_idx_cnt,  // NOLINT
                          uint64_t& gc_record_cnt,                 // NOLINT
                          uint64_t& gc_record_byte_size);          // NOLINT
     void FreeEntry(::openmldb::base::Node<Slice, void*>* entry_node, uint64_t& gc_idx_cnt,  // NOLINT
@@ -267,12 +344,32 @@ class Segment {
     std::atomic<uint64_t> idx_byte_size_;
     std::atomic<uint64_t> pk_cnt_;
     uint8_t key_entry_max_height_;
+    // the removed entries keyed by the epoch they are retired with
     KeyEntryNodeList* entry_free_list_;
+    // the data nodes split by gc, guarded by gc_mu_
+    struct RetiredList {
+        uint64_t epoch;
+        ::openmldb::base::Node<uint64_t, DataBlock*>* node;
+        // the blocks referenced by no other dimension
+        std::vector<DataBlock*> blocks;
+    };
+    std::deque<RetiredList> retired_lists_;
     uint32_t ts_cnt_;
-    std::atomic<uint64_t> gc_version_;
     std::map<uint32_t, uint32_t> ts_idx_map_;
     std::vector<std::shared_ptr<std::atomic<uint64_t>>> idx_cnt_vec_;
     uint64_t ttl_offset_;
+    std::atomic<uint64_t> gc_visited_key_cnt_;
+    std::atomic<uint64_t> gc_collected_key_cnt_;
+    // key entries indexed by the bucket of their oldest ts, only for segment
+    // with one ts index of absolute or abs_or_lat ttl. the bucket of an entry
+    // may be less than the one of its oldest ts but never greater, guarded by
+    // mu_. its size is counted in idx_byte_size_
+    bool expire_index_enabled_;
+    uint64_t expire_bucket_size_;
+    std::map<uint64_t, std::unordered_set<KeyEntry*>> expire_buckets_;
+    std::unordered_map<KeyEntry*, ExpireSlot> expire_slots_;
+    // NULL if segment_hash_index is disabled
+    KeyHashIndex* key_index_;
 };
 
 }  // namespace storage
@@ -0,0 +1,221 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gflags/gflags.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "base/glog_wapper.h"  // NOLINT
+#include "base/slice.h"
+#include "common/timer.h"
+#include "gtest/gtest.h"
+#include "storage/segment.h"
+#include "storage/ticket.h"
+
+DECLARE_bool(segment_hash_index);
+
+namespace openmldb {
+namespace storage {
+
+static const uint32_t KEY_NUM = 1000;
+static const uint32_t RECORD_PER_KEY = 200;
+static const uint32_t VALUE_SIZE = 128;
+static const uint32_t LOOKUP_KEY_NUM = 200000;
+static const uint32_t LOOKUP_ROUND = 10;
+static const uint32_t HOT_KEY_READER_NUM = 64;
+static const uint32_t HOT_KEY_READ_PER_THREAD = 100000;
+static const uint32_t HOT_KEY_SCAN_CNT = 10;
+
+class SegmentBenchmarkTest : public ::testing::Test {
+ public:
+    SegmentBenchmarkTest() {}
+    ~SegmentBenchmarkTest() {}
+};
+
+// resident memory of current process in KB
+static uint64_t GetRssKB() {
+    std::ifstream statm("/proc/self/statm");
+    uint64_t size = 0;
+    uint64_t resident = 0;
+    if (!(statm >> size >> resident)) {
+        return 0;
+    }
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// inline_block means the payload is allocated together with DataBlock
+static void RunPut(bool inline_block) {
+    std::string value(VALUE_SIZE, 'a');
+    uint64_t rss = GetRssKB();
+    uint64_t consumed = ::baidu::common::timer::get_micros();
+    {
+        Segment segment(4);
+        for (uint32_t i = 0; i < RECORD_PER_KEY; i++) {
+            for (uint32_t j = 0; j < KEY_NUM; j++) {
+                std::string key = "key" + std::to_string(j);
+                DataBlock* block = inline_block ? DataBlock::New(1, value.c_str(), value.size())
+                                                : new DataBlock(1, value.c_str(), value.size());
+                segment.Put(Slice(key), 9527 + i, block);
+            }
+        }
+        consumed = ::baidu::common::timer::get_micros() - consumed;
+        rss = GetRssKB() - rss;
+        ASSERT_EQ(KEY_NUM * RECORD_PER_KEY, segment.GetIdxCnt());
+        segment.Release();
+    }
+    uint64_t total = KEY_NUM * RECORD_PER_KEY;
+    std::cout << (inline_block ? "inline" : "separate") << " data block put " << total << " records consumed "
+              << consumed / 1000 << "ms, " << total * 1000000 / (consumed + 1) << " records/s, rss grows " << rss
+              << "KB" << std::endl;
+}
+
+TEST_F(SegmentBenchmarkTest, Put) {
+    RunPut(false);
+    RunPut(true);
+}
+
+// point access of pk, with the key skiplist only or with the hash index
+static void RunLookup(bool hash_index) {
+    FLAGS_segment_hash_index = hash_index;
+    Segment segment;
+    FLAGS_segment_hash_index = false;
+    std::vector<std::string> keys;
+    for (uint32_t i = 0; i < LOOKUP_KEY_NUM; i++) {
+        keys.push_back("card_" + std::to_string(i * 7919 % LOOKUP_KEY_NUM));
+    }
+    uint64_t consumed = ::baidu::common::timer::get_micros();
+    for (const auto& key : keys) {
+        segment.Put(Slice(key), 9527, "value", 5);
+    }
+    uint64_t put_consumed = ::baidu::common::timer::get_micros() - consumed;
+    uint64_t found = 0;
+    consumed = ::baidu::common::timer::get_micros();
+    for (uint32_t round = 0; round < LOOKUP_ROUND; round++) {
+        for (const auto& key : keys) {
+            Ticket ticket;
+            std::unique_ptr<MemTableIterator> it(segment.NewIterator(Slice(key), ticket));
+            it->SeekToFirst();
+            if (it->Valid()) {
+                found++;
+            }
+        }
+    }
+    consumed = ::baidu::common::timer::get_micros() - consumed;
+    ASSERT_EQ(LOOKUP_KEY_NUM * LOOKUP_ROUND, found);
+    segment.Release();
+    uint64_t total = LOOKUP_KEY_NUM * LOOKUP_ROUND;
+    std::cout << (hash_index ? "hash index" : "skiplist") << " put " << LOOKUP_KEY_NUM << " keys consumed "
+              << put_consumed / 1000 << "ms, lookup " << total << " times consumed " << consumed / 1000 << "ms, "
+              << consumed * 1000 / total << "ns per lookup" << std::endl;
+}
+
+TEST_F(SegmentBenchmarkTest, Lookup) {
+    RunLookup(false);
+    RunLookup(true);
+}
+
+// many readers of one hot key while it is written and collected by gc. with
+// ref_cnt every read also writes a counter shared by all of the readers, as
+// the tickets referencing the key entry did
+static void RunHotKeyRead(bool ref_cnt) {
+    Segment segment;
+    Slice pk("hot_key");
+    uint64_t ts = 1;
+    for (; ts <= 1000; ts++) {
+        segment.Put(pk, ts, "value", 5);
+    }
+    std::atomic<bool> stop(false);
+    std::atomic<uint64_t> shared_refs(0);
+    std::atomic<uint64_t> read_cnt(0);
+    std::thread writer([&] {
+        uint64_t cur = ts;
+        while (!stop.load(std::memory_order_relaxed)) {
+            segment.Put(pk, cur++, "value", 5);
+        }
+    });
+    std::thread gc([&] {
+        uint64_t gc_idx_cnt = 0;
+        uint64_t gc_record_cnt = 0;
+        uint64_t gc_record_byte_size = 0;
+        while (!stop.load(std::memory_order_relaxed)) {
+            segment.Gc4Head(1000, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+            segment.GcFreeList(gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+        }
+    });
+    uint64_t consumed = ::baidu::common::timer::get_micros();
+    std::vector<std::thread> readers;
+    for (uint32_t i = 0; i < HOT_KEY_READER_NUM; i++) {
+        readers.emplace_back([&] {
+            uint64_t cnt = 0;
+            for (uint32_t j = 0; j < HOT_KEY_READ_PER_THREAD; j++) {
+                if (ref_cnt) {
+                    shared_refs.fetch_add(1, std::memory_order_relaxed);
+                }
+                {
+                    Ticket ticket;
+                    std::unique_ptr<MemTableIterator> it(segment.NewIterator(pk, ticket));
+                    it->SeekToFirst();
+                    for (uint32_t k = 0; k < HOT_KEY_SCAN_CNT && it->Valid(); k++) {
+                        cnt += it->GetValue().size() == 5 ? 1 : 0;
+                        it->Next();
+                    }
+                }
+                if (ref_cnt) {
+                    shared_refs.fetch_sub(1, std::memory_order_relaxed);
+                }
+            }
+            read_cnt.fetch_add(cnt, std::memory_order_relaxed);
+        });
+    }
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    consumed = ::baidu::common::timer::get_micros() - consumed;
+    stop.store(true, std::memory_order_relaxed);
+    writer.join();
+    gc.join();
+    ASSERT_EQ(HOT_KEY_READER_NUM * HOT_KEY_READ_PER_THREAD * HOT_KEY_SCAN_CNT, read_cnt.load());
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    segment.GcFreeList(gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    segment.Release();
+    uint64_t total = HOT_KEY_READER_NUM * HOT_KEY_READ_PER_THREAD;
+    std::cout << (ref_cnt ? "shared ref count" : "epoch") << " " << HOT_KEY_READER_NUM << " readers read hot key "
+              << total << " times consumed " << consumed / 1000 << "ms, " << total * 1000000 / (consumed + 1)
+              << " reads/s" << std::endl;
+}
+
+TEST_F(SegmentBenchmarkTest, HotKeyRead) {
+    RunHotKeyRead(true);
+    RunHotKeyRead(false);
+}
+
+}  // namespace storage
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    ::openmldb::base::SetLogLevel(INFO);
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
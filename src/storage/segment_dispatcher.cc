@@ -0,0 +1,170 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/segment_dispatcher.h"
+
+#include "boost/bind.hpp"
+#include "storage/record.h"
+
+namespace openmldb {
+namespace storage {
+
+SegmentDispatcher::SegmentDispatcher(std::shared_ptr<Table> table, uint32_t worker_num, uint32_t batch_size)
+    : table_(table),
+      mem_table_(std::dynamic_pointer_cast<MemTable>(table)),
+      worker_num_(worker_num == 0 ? 1 : worker_num),
+      batch_size_(batch_size == 0 ? 1 : batch_size),
+      cur_(0) {
+    if (mem_table_) {
+        for (auto& batch : batches_) {
+            batch.entries.resize(batch_size_);
+            batch.tasks.resize(worker_num_);
+        }
+        pool_.reset(new ::openmldb::base::TaskPool(worker_num_, worker_num_ * 2));
+    }
+}
+
+SegmentDispatcher::~SegmentDispatcher() {
+    Flush();
+    if (pool_) {
+        pool_->Stop();
+    }
+}
+
+::openmldb::api::LogEntry* SegmentDispatcher::NextEntry() {
+    if (!mem_table_) {
+        return &entry_;
+    }
+    Batch& batch = batches_[cur_];
+    if (batch.entry_cnt >= batch_size_) {
+        Dispatch();
+    }
+    auto* entry = &batches_[cur_].entries[batches_[cur_].entry_cnt];
+    entry->Clear();
+    return entry;
+}
+
+bool SegmentDispatcher::Submit() {
+    if (!mem_table_) {
+        if (entry_.has_method_type() && entry_.method_type() == ::openmldb::api::MethodType::kDelete) {
+            return entry_.dimensions_size() > 0 &&
+                   table_->Delete(entry_.dimensions(0).key(), entry_.dimensions(0).idx());
+        }
+        return table_->Put(entry_);
+    }
+    Batch& batch = batches_[cur_];
+    const auto& entry = batch.entries[batch.entry_cnt];
+    bool ok = false;
+    if (entry.has_method_type() && entry.method_type() == ::openmldb::api::MethodType::kDelete) {
+        ok = SubmitDelete(entry, &batch);
+    } else {
+        ok = SubmitPut(entry, &batch);
+    }
+    if (ok) {
+        // keep the entry until the tasks referring to it are applied
+        batch.entry_cnt++;
+    }
+    return ok;
+}
+
+bool SegmentDispatcher::SubmitPut(const ::openmldb::api::LogEntry& entry, Batch* batch) {
+    placements_.clear();
+    uint32_t ref_cnt = 0;
+    if (!mem_table_->GetRowPlacement(entry.ts(), entry.value(), entry.dimensions(), &placements_, &ref_cnt)) {
+        return false;
+    }
+    if (!placements_.empty()) {
+        auto* row = DataBlock::New(ref_cnt, entry.value().c_str(), entry.value().length());
+        for (const auto& placement : placements_) {
+            Segment* segment = mem_table_->GetSegment(placement.inner_pos, placement.seg_idx);
+            batch->tasks[GetWorker(placement.inner_pos, placement.seg_idx)].push_back(
+                {segment, false, placement.key_entry_id, placement.ts, placement.key, row});
+        }
+    }
+    mem_table_->RecordCntIncr();
+    mem_table_->RecordByteSizeIncr(GetRecordSize(entry.value().length()));
+    return true;
+}
+
+bool SegmentDispatcher::SubmitDelete(const ::openmldb::api::LogEntry& entry, Batch* batch) {
+    if (entry.dimensions_size() == 0) {
+        return false;
+    }
+    const auto& dimension = entry.dimensions(0);
+    uint32_t inner_pos = 0;
+    uint32_t seg_idx = 0;
+    Segment* segment = mem_table_->GetIndexSegment(dimension.idx(), Slice(dimension.key()), &inner_pos, &seg_idx);
+    if (segment == NULL) {
+        return false;
+    }
+    batch->tasks[GetWorker(inner_pos, seg_idx)].push_back({segment, true, 0, 0, Slice(dimension.key()), NULL});
+    return true;
+}
+
+void SegmentDispatcher::Dispatch() {
+    Batch& batch = batches_[cur_];
+    Batch& prev = batches_[cur_ ^ 1];
+    // a segment may be in both batches
+    Wait(&prev);
+    uint32_t task_cnt = 0;
+    for (const auto& tasks : batch.tasks) {
+        if (!tasks.empty()) {
+            task_cnt++;
+        }
+    }
+    if (task_cnt > 0) {
+        batch.latch.reset(new ::openmldb::base::CountDownLatch(task_cnt));
+        for (auto& tasks : batch.tasks) {
+            if (!tasks.empty()) {
+                pool_->AddTask(boost::bind(&SegmentDispatcher::Apply, &tasks, batch.latch.get()));
+            }
+        }
+    }
+    cur_ ^= 1;
+    for (auto& tasks : prev.tasks) {
+        tasks.clear();
+    }
+    prev.entry_cnt = 0;
+}
+
+void SegmentDispatcher::Flush() {
+    if (!mem_table_) {
+        return;
+    }
+    Dispatch();
+    Wait(&batches_[cur_ ^ 1]);
+}
+
+void SegmentDispatcher::Wait(Batch* batch) {
+    if (batch->latch) {
+        batch->latch->Wait();
+        batch->latch.reset();
+    }
+}
+
+void SegmentDispatcher::Apply(std::vector<Task>* tasks, ::openmldb::base::CountDownLatch* latch) {
+    for (const auto& task : *tasks) {
+        if (task.is_delete) {
+            task.segment->Delete(task.key);
+        } else {
+            task.segment->BulkLoadPut(task.key_entry_id, task.key, task.ts, task.row);
+        }
+    }
+    latch->CountDown();
+}
+
+}  // namespace storage
+}  // namespace openmldb
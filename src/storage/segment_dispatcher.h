@@ -0,0 +1,102 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_STORAGE_SEGMENT_DISPATCHER_H_
+#define SRC_STORAGE_SEGMENT_DISPATCHER_H_
+
+#include <memory>
+#include <vector>
+
+#include "base/count_down_latch.h"
+#include "base/taskpool.hpp"
+#include "proto/tablet.pb.h"
+#include "storage/mem_table.h"
+
+namespace openmldb {
+namespace storage {
+
+// SegmentDispatcher applies the log entries of recovery to a table. The entries
+// are decoded by the caller and split into the segments they are put to or
+// deleted from, every segment is owned by one worker in a batch, so the order
+// of the entries of a key is kept and the workers never contend for a segment
+// lock. The next batch is decoded while the current one is applied.
+//
+// usage:
+//     auto* entry = dispatcher.NextEntry();
+//     if (entry->ParseFromArray(data, size)) dispatcher.Submit();
+//     ...
+//     dispatcher.Flush();
+//
+// the entries are applied by Table::Put and Table::Delete in the caller thread
+// if the table is not a MemTable.
+class SegmentDispatcher {
+ public:
+    SegmentDispatcher(std::shared_ptr<Table> table, uint32_t worker_num, uint32_t batch_size);
+    ~SegmentDispatcher();
+    SegmentDispatcher(const SegmentDispatcher&) = delete;
+    SegmentDispatcher& operator=(const SegmentDispatcher&) = delete;
+
+    // the entry to parse the next record into, it is dropped if not submitted
+    ::openmldb::api::LogEntry* NextEntry();
+
+    // put or delete with the entry from NextEntry, return false if the entry
+    // is rejected the same as Table::Put and Table::Delete
+    bool Submit();
+
+    // apply all of the submitted entries and wait
+    void Flush();
+
+ private:
+    struct Task {
+        Segment* segment;
+        bool is_delete;
+        uint32_t key_entry_id;
+        uint64_t ts;
+        Slice key;
+        DataBlock* row;
+    };
+
+    struct Batch {
+        // entries own the keys referred by tasks
+        std::vector<::openmldb::api::LogEntry> entries;
+        uint32_t entry_cnt = 0;
+        std::vector<std::vector<Task>> tasks;
+        std::unique_ptr<::openmldb::base::CountDownLatch> latch;
+    };
+
+    inline uint32_t GetWorker(uint32_t inner_pos, uint32_t seg_idx) const {
+        return (inner_pos * mem_table_->GetSegCnt() + seg_idx) % worker_num_;
+    }
+    bool SubmitPut(const ::openmldb::api::LogEntry& entry, Batch* batch);
+    bool SubmitDelete(const ::openmldb::api::LogEntry& entry, Batch* batch);
+    void Dispatch();
+    static void Wait(Batch* batch);
+    static void Apply(std::vector<Task>* tasks, ::openmldb::base::CountDownLatch* latch);
+
+    std::shared_ptr<Table> table_;
+    std::shared_ptr<MemTable> mem_table_;
+    uint32_t worker_num_;
+    uint32_t batch_size_;
+    Batch batches_[2];
+    uint32_t cur_;
+    ::openmldb::api::LogEntry entry_;
+    std::vector<RowPlacement> placements_;
+    std::unique_ptr<::openmldb::base::TaskPool> pool_;
+};
+
+}  // namespace storage
+}  // namespace openmldb
+#endif  // SRC_STORAGE_SEGMENT_DISPATCHER_H_
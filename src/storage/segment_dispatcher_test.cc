@@ -0,0 +1,115 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/segment_dispatcher.h"
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include "base/glog_wapper.h"
+#include "gtest/gtest.h"
+#include "storage/mem_table.h"
+
+namespace openmldb {
+namespace storage {
+
+class SegmentDispatcherTest : public ::testing::Test {
+ public:
+    SegmentDispatcherTest() {}
+    ~SegmentDispatcherTest() {}
+};
+
+static void SetEntry(const std::string& key, uint64_t ts, ::openmldb::api::LogEntry* entry) {
+    entry->set_ts(ts);
+    entry->set_value("value" + std::to_string(ts));
+    auto* dimension = entry->add_dimensions();
+    dimension->set_key(key);
+    dimension->set_idx(0);
+}
+
+static void SetDeleteEntry(const std::string& key, ::openmldb::api::LogEntry* entry) {
+    entry->set_method_type(::openmldb::api::MethodType::kDelete);
+    auto* dimension = entry->add_dimensions();
+    dimension->set_key(key);
+    dimension->set_idx(0);
+}
+
+TEST_F(SegmentDispatcherTest, ReplayInOrder) {
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    auto table = std::make_shared<MemTable>("t1", 1, 1, 8, mapping, 0, ::openmldb::type::kAbsoluteTime);
+    table->Init();
+    auto expect = std::make_shared<MemTable>("t2", 2, 1, 8, mapping, 0, ::openmldb::type::kAbsoluteTime);
+    expect->Init();
+    {
+        // a small batch to dispatch many times
+        SegmentDispatcher dispatcher(table, 4, 7);
+        for (uint64_t i = 0; i < 1000; i++) {
+            std::string key = "key" + std::to_string(i % 20);
+            ::openmldb::api::LogEntry entry;
+            if (i % 97 == 0) {
+                SetDeleteEntry(key, &entry);
+                expect->Delete(key, 0);
+            } else {
+                SetEntry(key, i + 1, &entry);
+                expect->Put(entry);
+            }
+            *dispatcher.NextEntry() = entry;
+            ASSERT_TRUE(dispatcher.Submit());
+        }
+        // the index is not exist
+        auto* entry = dispatcher.NextEntry();
+        SetDeleteEntry("key1", entry);
+        entry->mutable_dimensions(0)->set_idx(5);
+        ASSERT_FALSE(dispatcher.Submit());
+        dispatcher.Flush();
+    }
+    ASSERT_EQ(expect->GetRecordCnt(), table->GetRecordCnt());
+    ASSERT_EQ(expect->GetRecordIdxCnt(), table->GetRecordIdxCnt());
+    ASSERT_EQ(expect->GetRecordPkCnt(), table->GetRecordPkCnt());
+    for (uint32_t i = 0; i < 20; i++) {
+        std::string key = "key" + std::to_string(i);
+        uint64_t cnt = 0;
+        uint64_t expect_cnt = 0;
+        table->GetCount(0, key, cnt);
+        expect->GetCount(0, key, expect_cnt);
+        ASSERT_EQ(expect_cnt, cnt);
+        Ticket ticket;
+        Ticket expect_ticket;
+        std::unique_ptr<TableIterator> it(table->NewIterator(0, key, ticket));
+        std::unique_ptr<TableIterator> expect_it(expect->NewIterator(0, key, expect_ticket));
+        it->SeekToFirst();
+        expect_it->SeekToFirst();
+        while (expect_it->Valid()) {
+            ASSERT_TRUE(it->Valid());
+            ASSERT_EQ(expect_it->GetKey(), it->GetKey());
+            ASSERT_EQ(expect_it->GetValue().ToString(), it->GetValue().ToString());
+            it->Next();
+            expect_it->Next();
+        }
+        ASSERT_FALSE(it->Valid());
+    }
+}
+
+}  // namespace storage
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    ::openmldb::base::SetLogLevel(INFO);
+    return RUN_ALL_TESTS();
+}
@@ -16,16 +16,23 @@
 
 #include "storage/segment.h"
 
+#include <gflags/gflags.h>
+
 #include <iostream>
+#include <memory>
 #include <string>
 
 #include "base/glog_wapper.h"  // NOLINT
 #include "base/slice.h"
 #include "gtest/gtest.h"
 #include "storage/record.h"
+#include "storage/ticket.h"
 
 using ::openmldb::base::Slice;
 
+DECLARE_uint64(gc_max_keys_per_round);
+DECLARE_bool(segment_hash_index);
+
 namespace openmldb {
 namespace storage {
 
@@ -37,7 +44,7 @@ class SegmentTest : public ::testing::Test {
 
 TEST_F(SegmentTest, Size) {
     ASSERT_EQ(16, (int64_t)sizeof(DataBlock));
-    ASSERT_EQ(40, (int64_t)sizeof(KeyEntry));
+    ASSERT_EQ(32, (int64_t)sizeof(KeyEntry));
 }
 
 TEST_F(SegmentTest, DataBlock) {
@@ -51,6 +58,16 @@ TEST_F(SegmentTest, DataBlock) {
     delete db;
 }
 
+TEST_F(SegmentTest, InlineDataBlock) {
+    const char* test = "test";
+    DataBlock* db = DataBlock::New(2, test, 4);
+    ASSERT_EQ(2, (int64_t)db->dim_cnt_down);
+    ASSERT_EQ(4, (int64_t)db->size);
+    ASSERT_EQ(reinterpret_cast<char*>(db) + sizeof(DataBlock), db->data);
+    ASSERT_EQ("test", std::string(db->data, db->size));
+    delete db;
+}
+
 TEST_F(SegmentTest, PutAndGet) {
     Segment segment;
     const char* test = "test";
@@ -100,25 +117,31 @@ TEST_F(SegmentTest, Delete) {
     segment.Put(pk, 9528, value.c_str(), value.size());
     segment.Put(pk, 9529, value.c_str(), value.size());
     ASSERT_EQ(1, (int64_t)segment.GetPkCnt());
-    Ticket ticket;
-    MemTableIterator* it = segment.NewIterator("test1", ticket);
-    int size = 0;
-    it->SeekToFirst();
-    while (it->Valid()) {
-        it->Next();
-        size++;
-    }
-    ASSERT_EQ(4, size);
-    delete it;
-    ASSERT_TRUE(segment.Delete(pk));
-    it = segment.NewIterator("test1", ticket);
-    ASSERT_FALSE(it->Valid());
-    delete it;
     uint64_t gc_idx_cnt = 0;
     uint64_t gc_record_cnt = 0;
     uint64_t gc_record_byte_size = 0;
-    segment.IncrGcVersion();
-    segment.IncrGcVersion();
+    {
+        Ticket ticket;
+        MemTableIterator* it = segment.NewIterator("test1", ticket);
+        int size = 0;
+        it->SeekToFirst();
+        while (it->Valid()) {
+            it->Next();
+            size++;
+        }
+        ASSERT_EQ(4, size);
+        ASSERT_TRUE(segment.Delete(pk));
+        MemTableIterator* new_it = segment.NewIterator("test1", ticket);
+        ASSERT_FALSE(new_it->Valid());
+        delete new_it;
+        // the deleted entry is still reachable by the iterator
+        segment.GcFreeList(gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+        ASSERT_EQ(0, (int64_t)gc_idx_cnt);
+        it->SeekToFirst();
+        ASSERT_TRUE(it->Valid());
+        ASSERT_EQ(9529, (int64_t)it->GetKey());
+        delete it;
+    }
     segment.GcFreeList(gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
     ASSERT_EQ(4, (int64_t)gc_idx_cnt);
     ASSERT_EQ(4, (int64_t)gc_record_cnt);
@@ -250,6 +273,121 @@ TEST_F(SegmentTest, TestGc4TTL) {
     ASSERT_EQ(2 * GetRecordSize(5), (int64_t)gc_record_byte_size);
 }
 
+TEST_F(SegmentTest, TestGc4TTLByExpireIndex) {
+    Segment segment;
+    ASSERT_TRUE(segment.HasExpireIndex());
+    // one key in each bucket of expire index
+    for (int i = 0; i < 100; i++) {
+        std::string pk = "key" + std::to_string(i);
+        segment.Put(Slice(pk), i * 60000 + 2, "test1", 5);
+        segment.Put(Slice(pk), i * 60000 + 1, "test2", 5);
+    }
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    segment.Gc4TTL(10 * 60000 + 1, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(21, (int64_t)gc_idx_cnt);
+    ASSERT_EQ(11, (int64_t)segment.GetGcVisitedKeyCnt());
+    ASSERT_EQ(11, (int64_t)segment.GetGcCollectedKeyCnt());
+    uint64_t count = 0;
+    ASSERT_EQ(-1, segment.GetCount("key9", count));
+    ASSERT_EQ(0, segment.GetCount("key10", count));
+    ASSERT_EQ(1, (int64_t)count);
+    // only the key in the bucket of expire time is visited again
+    segment.Gc4TTL(10 * 60000 + 1, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(21, (int64_t)gc_idx_cnt);
+    ASSERT_EQ(12, (int64_t)segment.GetGcVisitedKeyCnt());
+    ASSERT_EQ(11, (int64_t)segment.GetGcCollectedKeyCnt());
+    // an older row moves the key to an expired bucket
+    segment.Put("key99", 100, "test3", 5);
+    segment.Gc4TTL(10 * 60000 + 1, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(22, (int64_t)gc_idx_cnt);
+    ASSERT_EQ(0, segment.GetCount("key99", count));
+    ASSERT_EQ(2, (int64_t)count);
+
+    // the round is bounded and the rest keys are visited by next rounds
+    FLAGS_gc_max_keys_per_round = 5;
+    uint64_t visited = segment.GetGcVisitedKeyCnt();
+    segment.Gc4TTL(30 * 60000 + 10, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(visited + 5, segment.GetGcVisitedKeyCnt());
+    FLAGS_gc_max_keys_per_round = 0;
+    segment.Gc4TTL(30 * 60000 + 10, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(visited + 21, segment.GetGcVisitedKeyCnt());
+    ASSERT_EQ(-1, segment.GetCount("key30", count));
+    ASSERT_EQ(0, segment.GetCount("key31", count));
+    ASSERT_EQ(2, (int64_t)count);
+    ASSERT_EQ(22 + 20 * 2 + 1, (int64_t)gc_idx_cnt);
+    ASSERT_EQ(69 * 2, (int64_t)segment.GetIdxCnt());
+}
+
+TEST_F(SegmentTest, ExpireIndexByTTLType) {
+    ASSERT_TRUE(Segment(8, TTLType::kAbsoluteTime).HasExpireIndex());
+    ASSERT_TRUE(Segment(8, TTLType::kAbsOrLat).HasExpireIndex());
+    ASSERT_FALSE(Segment(8, TTLType::kLatestTime).HasExpireIndex());
+    ASSERT_FALSE(Segment(8, TTLType::kAbsAndLat).HasExpireIndex());
+    std::vector<uint32_t> ts_idx_vec = {1};
+    ASSERT_FALSE(Segment(8, ts_idx_vec, TTLType::kLatestTime).HasExpireIndex());
+    Segment abs_segment(8, TTLType::kAbsoluteTime);
+    Segment lat_segment(8, TTLType::kLatestTime);
+    for (int i = 0; i < 10; i++) {
+        std::string pk = "key" + std::to_string(i);
+        abs_segment.Put(Slice(pk), 100, "test1", 5);
+        lat_segment.Put(Slice(pk), 100, "test1", 5);
+    }
+    // the key entry of a deleted key is freed later, its expire index at once
+    uint64_t abs_size = abs_segment.GetIdxByteSize();
+    uint64_t lat_size = lat_segment.GetIdxByteSize();
+    ASSERT_TRUE(abs_segment.Delete(Slice("key0")));
+    ASSERT_TRUE(lat_segment.Delete(Slice("key0")));
+    ASSERT_EQ(abs_size - EXPIRE_IDX_BYTE_SIZE, abs_segment.GetIdxByteSize());
+    ASSERT_EQ(lat_size, lat_segment.GetIdxByteSize());
+}
+
+TEST_F(SegmentTest, PutAndGetWithHashIndex) {
+    FLAGS_segment_hash_index = true;
+    Segment segment;
+    FLAGS_segment_hash_index = false;
+    ASSERT_TRUE(segment.HasHashIndex());
+    // grow the hash index several times
+    for (int i = 0; i < 10000; i++) {
+        std::string pk = "pk" + std::to_string(i);
+        segment.Put(Slice(pk), 9527, "test1", 5);
+        segment.Put(Slice(pk), 9528, "test2", 5);
+    }
+    ASSERT_EQ(10000, (int64_t)segment.GetPkCnt());
+    for (int i = 0; i < 10000; i += 2) {
+        std::string pk = "pk" + std::to_string(i);
+        ASSERT_TRUE(segment.Delete(Slice(pk)));
+    }
+    segment.Put("pk0", 9529, "test3", 5);
+    for (int i = 0; i < 10000; i++) {
+        std::string pk = "pk" + std::to_string(i);
+        uint64_t count = 0;
+        DataBlock* block = NULL;
+        if (i > 0 && i % 2 == 0) {
+            ASSERT_EQ(-1, segment.GetCount(Slice(pk), count));
+            ASSERT_FALSE(segment.Get(Slice(pk), 9527, &block));
+            continue;
+        }
+        ASSERT_EQ(0, segment.GetCount(Slice(pk), count));
+        ASSERT_EQ(i == 0 ? 1 : 2, (int64_t)count);
+        Ticket ticket;
+        std::unique_ptr<MemTableIterator> it(segment.NewIterator(Slice(pk), ticket));
+        it->SeekToFirst();
+        ASSERT_TRUE(it->Valid());
+        ASSERT_EQ(i == 0 ? 9529 : 9528, (int64_t)it->GetKey());
+    }
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    segment.Gc4TTL(9528, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(10000, (int64_t)gc_idx_cnt);
+    DataBlock* block = NULL;
+    ASSERT_FALSE(segment.Get("pk1", 9528, &block));
+    ASSERT_TRUE(segment.Get("pk0", 9529, &block));
+    ASSERT_TRUE(block != NULL);
+}
+
 TEST_F(SegmentTest, TestGc4TTLAndHead) {
     Segment segment;
     segment.Put("PK1", 9766, "test1", 5);
@@ -37,7 +37,12 @@ class Snapshot {
     virtual bool Recover(std::shared_ptr<Table> table,
                          uint64_t& latest_offset) = 0;  // NOLINT
     uint64_t GetOffset() { return offset_; }
+    // keep the snapshot files from being replaced or deleted, e.g. while they are sent.
+    // return false if a snapshot is being made
+    bool TryHold() { return !making_snapshot_.exchange(true, std::memory_order_acq_rel); }
+    void Release() { making_snapshot_.store(false, std::memory_order_release); }
     int GenManifest(const std::string& snapshot_name, uint64_t key_count, uint64_t offset, uint64_t term);
+    int GenManifest(const ::openmldb::api::Manifest& manifest);
     static int GetLocalManifest(const std::string& full_path,
                                 ::openmldb::api::Manifest& manifest);  // NOLINT
 
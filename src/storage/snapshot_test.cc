@@ -42,6 +42,8 @@
 
 DECLARE_string(db_root_path);
 DECLARE_string(snapshot_compression);
+DECLARE_bool(snapshot_image);
+DECLARE_uint32(snapshot_delta_max_num);
 
 using ::openmldb::api::LogEntry;
 namespace openmldb {
@@ -1708,6 +1710,255 @@ TEST_F(SnapshotTest, Recover_large_snapshot_and_binlog) {
     delete it;
 }
 
+TEST_F(SnapshotTest, Recover_snapshot_image) {
+    std::string snapshot_dir = FLAGS_db_root_path + "/102_0/snapshot/";
+    std::string binlog_dir = FLAGS_db_root_path + "/102_0/binlog/";
+    LogParts* log_part = new LogParts(12, 4, scmp);
+    uint64_t offset = 0;
+    uint32_t binlog_index = 0;
+    WriteHandle* wh = NULL;
+    RollWLogFile(&wh, log_part, binlog_dir, binlog_index, offset);
+    uint32_t key_num = 100;
+    uint32_t ts_num = 20;
+    for (uint32_t i = 0; i < key_num; i++) {
+        for (uint32_t j = 0; j < ts_num; j++) {
+            offset++;
+            auto entry = ::openmldb::test::PackKVEntry(offset, "key" + std::to_string(i),
+                                                       "value" + std::to_string(i * ts_num + j), j + 1, 1);
+            std::string buffer;
+            entry.SerializeToString(&buffer);
+            ::openmldb::log::Status status = wh->Write(::openmldb::base::Slice(buffer));
+            ASSERT_TRUE(status.ok());
+        }
+    }
+    wh->Sync();
+    MemTableSnapshot snapshot(102, 0, log_part, FLAGS_db_root_path);
+    snapshot.Init();
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    std::shared_ptr<MemTable> table =
+        std::make_shared<MemTable>("test", 102, 0, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+    table->Init();
+    FLAGS_snapshot_image = true;
+    uint64_t offset_value = 0;
+    int ret = snapshot.MakeSnapshot(table, offset_value, 0);
+    FLAGS_snapshot_image = false;
+    ASSERT_EQ(0, ret);
+    ::openmldb::api::Manifest manifest;
+    GetManifest(snapshot_dir + "MANIFEST", &manifest);
+    std::string image_path = snapshot_dir + manifest.name() + ".img";
+    ASSERT_TRUE(::openmldb::base::IsExists(image_path));
+
+    // recover from image
+    std::shared_ptr<MemTable> image_table =
+        std::make_shared<MemTable>("test", 102, 0, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+    image_table->Init();
+    uint64_t snapshot_offset = 0;
+    ASSERT_TRUE(snapshot.Recover(image_table, snapshot_offset));
+    ASSERT_EQ(key_num * ts_num, snapshot_offset);
+    ASSERT_EQ(key_num * ts_num, image_table->GetRecordCnt());
+    ASSERT_EQ(key_num * ts_num, image_table->GetRecordIdxCnt());
+    ASSERT_EQ(key_num, image_table->GetRecordPkCnt());
+
+    // recover from snapshot file as before and compare
+    std::string bad_image_path = image_path + ".bad";
+    FILE* fd = fopen(image_path.c_str(), "r+b");
+    ASSERT_TRUE(fd != NULL);
+    fwrite("x", 1, 1, fd);
+    fclose(fd);
+    std::shared_ptr<MemTable> sdb_table =
+        std::make_shared<MemTable>("test", 102, 0, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+    sdb_table->Init();
+    ASSERT_TRUE(snapshot.Recover(sdb_table, snapshot_offset));
+    ASSERT_FALSE(::openmldb::base::IsExists(image_path));
+    ASSERT_TRUE(::openmldb::base::IsExists(bad_image_path));
+    ASSERT_EQ(sdb_table->GetRecordCnt(), image_table->GetRecordCnt());
+    ASSERT_EQ(sdb_table->GetRecordByteSize(), image_table->GetRecordByteSize());
+    ASSERT_EQ(sdb_table->GetRecordIdxByteSize(), image_table->GetRecordIdxByteSize());
+    for (uint32_t i = 0; i < key_num; i++) {
+        Ticket ticket;
+        std::unique_ptr<TableIterator> it(image_table->NewIterator("key" + std::to_string(i), ticket));
+        std::unique_ptr<TableIterator> sdb_it(sdb_table->NewIterator("key" + std::to_string(i), ticket));
+        it->SeekToFirst();
+        sdb_it->SeekToFirst();
+        uint32_t cnt = 0;
+        while (sdb_it->Valid()) {
+            ASSERT_TRUE(it->Valid());
+            ASSERT_EQ(sdb_it->GetKey(), it->GetKey());
+            ASSERT_EQ(sdb_it->GetValue().ToString(), it->GetValue().ToString());
+            it->Next();
+            sdb_it->Next();
+            cnt++;
+        }
+        ASSERT_FALSE(it->Valid());
+        ASSERT_EQ(ts_num, cnt);
+    }
+    RemoveData(FLAGS_db_root_path);
+}
+
+TEST_F(SnapshotTest, Recover_snapshot_image_index_changed) {
+    std::string snapshot_dir = FLAGS_db_root_path + "/102_1/snapshot/";
+    std::string binlog_dir = FLAGS_db_root_path + "/102_1/binlog/";
+    LogParts* log_part = new LogParts(12, 4, scmp);
+    uint64_t offset = 0;
+    uint32_t binlog_index = 0;
+    WriteHandle* wh = NULL;
+    RollWLogFile(&wh, log_part, binlog_dir, binlog_index, offset);
+    uint32_t key_num = 10;
+    for (uint32_t i = 0; i < key_num; i++) {
+        offset++;
+        auto entry = ::openmldb::test::PackKVEntry(offset, "key" + std::to_string(i), "value" + std::to_string(i),
+                                                   i + 1, 1);
+        std::string buffer;
+        entry.SerializeToString(&buffer);
+        ::openmldb::log::Status status = wh->Write(::openmldb::base::Slice(buffer));
+        ASSERT_TRUE(status.ok());
+    }
+    wh->Sync();
+    MemTableSnapshot snapshot(102, 1, log_part, FLAGS_db_root_path);
+    snapshot.Init();
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    std::shared_ptr<MemTable> table =
+        std::make_shared<MemTable>("test", 102, 1, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+    table->Init();
+    FLAGS_snapshot_image = true;
+    uint64_t offset_value = 0;
+    int ret = snapshot.MakeSnapshot(table, offset_value, 0);
+    FLAGS_snapshot_image = false;
+    ASSERT_EQ(0, ret);
+    ::openmldb::api::Manifest manifest;
+    GetManifest(snapshot_dir + "MANIFEST", &manifest);
+    std::string image_path = snapshot_dir + manifest.name() + ".img";
+    ASSERT_TRUE(::openmldb::base::IsExists(image_path));
+
+    // the image is written with one index, recover from snapshot file
+    mapping.insert(std::make_pair("idx1", 1));
+    std::shared_ptr<MemTable> new_table =
+        std::make_shared<MemTable>("test", 102, 1, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+    new_table->Init();
+    uint64_t snapshot_offset = 0;
+    ASSERT_TRUE(snapshot.Recover(new_table, snapshot_offset));
+    ASSERT_FALSE(::openmldb::base::IsExists(image_path));
+    ASSERT_TRUE(::openmldb::base::IsExists(image_path + ".bad"));
+    ASSERT_EQ(key_num, new_table->GetRecordCnt());
+    RemoveData(FLAGS_db_root_path);
+}
+
+TEST_F(SnapshotTest, MakeSnapshotChain) {
+    std::string snapshot_dir = FLAGS_db_root_path + "/103_0/snapshot/";
+    std::string binlog_dir = FLAGS_db_root_path + "/103_0/binlog/";
+    LogParts* log_part = new LogParts(12, 4, scmp);
+    uint64_t offset = 0;
+    uint32_t binlog_index = 0;
+    WriteHandle* wh = NULL;
+    RollWLogFile(&wh, log_part, binlog_dir, binlog_index, offset);
+    auto write_rows = [&](uint32_t start, uint32_t end) {
+        for (uint32_t i = start; i < end; i++) {
+            offset++;
+            auto entry = ::openmldb::test::PackKVEntry(offset, "key" + std::to_string(i % 10),
+                                                       "value" + std::to_string(i), i + 1, 1);
+            std::string buffer;
+            entry.SerializeToString(&buffer);
+            ASSERT_TRUE(wh->Write(::openmldb::base::Slice(buffer)).ok());
+        }
+        wh->Sync();
+    };
+    auto delete_key = [&](const std::string& key) {
+        offset++;
+        ::openmldb::api::LogEntry entry;
+        entry.set_log_index(offset);
+        entry.set_method_type(::openmldb::api::MethodType::kDelete);
+        ::openmldb::api::Dimension* dimension = entry.add_dimensions();
+        dimension->set_key(key);
+        dimension->set_idx(0);
+        std::string buffer;
+        entry.SerializeToString(&buffer);
+        ASSERT_TRUE(wh->Write(::openmldb::base::Slice(buffer)).ok());
+        wh->Sync();
+    };
+    MemTableSnapshot snapshot(103, 0, log_part, FLAGS_db_root_path);
+    snapshot.Init();
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    std::shared_ptr<MemTable> table =
+        std::make_shared<MemTable>("test", 103, 0, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+    table->Init();
+    FLAGS_snapshot_delta_max_num = 2;
+    uint64_t offset_value = 0;
+    ::openmldb::api::Manifest manifest;
+
+    // the first snapshot is the base
+    write_rows(0, 100);
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+    GetManifest(snapshot_dir + "MANIFEST", &manifest);
+    std::string base_name = manifest.name();
+    ASSERT_EQ(100u, manifest.count());
+    ASSERT_EQ(0, manifest.deltas_size());
+
+    // key1 is deleted in the first delta, rows of key1 put after it are kept
+    delete_key("key1");
+    write_rows(100, 150);
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+    write_rows(150, 200);
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+    manifest.Clear();
+    GetManifest(snapshot_dir + "MANIFEST", &manifest);
+    ASSERT_EQ(base_name, manifest.name());
+    ASSERT_EQ(100u, manifest.count());
+    ASSERT_EQ(2, manifest.deltas_size());
+    ASSERT_EQ(50u, manifest.deltas(0).count());
+    ASSERT_EQ(151u, manifest.deltas(0).offset());
+    ASSERT_EQ(50u, manifest.deltas(1).count());
+    ASSERT_EQ(201u, manifest.offset());
+    for (const auto& delta : manifest.deltas()) {
+        ASSERT_TRUE(::openmldb::base::IsExists(snapshot_dir + delta.name()));
+    }
+    std::vector<std::string> delta_names = {manifest.deltas(0).name(), manifest.deltas(1).name()};
+
+    auto check_table = [&](uint32_t row_cnt) {
+        std::shared_ptr<MemTable> new_table =
+            std::make_shared<MemTable>("test", 103, 0, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+        new_table->Init();
+        uint64_t snapshot_offset = 0;
+        ASSERT_TRUE(snapshot.Recover(new_table, snapshot_offset));
+        ASSERT_EQ(manifest.offset(), snapshot_offset);
+        for (uint32_t k = 0; k < 10; k++) {
+            Ticket ticket;
+            std::unique_ptr<TableIterator> it(new_table->NewIterator("key" + std::to_string(k), ticket));
+            it->SeekToFirst();
+            uint32_t cnt = 0;
+            while (it->Valid()) {
+                uint64_t ts = it->GetKey();
+                if (k == 1) {
+                    ASSERT_GT(ts, 100u);
+                }
+                std::string value_str(it->GetValue().data(), it->GetValue().size());
+                ASSERT_EQ("value" + std::to_string(ts - 1), ::openmldb::test::DecodeV(value_str));
+                cnt++;
+                it->Next();
+            }
+            ASSERT_EQ(k == 1 ? row_cnt / 10 - 10 : row_cnt / 10, cnt);
+        }
+    };
+    check_table(200);
+
+    // the chain reaches snapshot_delta_max_num and is merged
+    write_rows(200, 250);
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+    manifest.Clear();
+    GetManifest(snapshot_dir + "MANIFEST", &manifest);
+    ASSERT_EQ(0, manifest.deltas_size());
+    ASSERT_EQ(240u, manifest.count());
+    ASSERT_EQ(251u, manifest.offset());
+    for (const auto& name : delta_names) {
+        ASSERT_FALSE(::openmldb::base::IsExists(snapshot_dir + name));
+    }
+    check_table(250);
+    FLAGS_snapshot_delta_max_num = 0;
+    RemoveData(FLAGS_db_root_path);
+}
+
 }  // namespace storage
 }  // namespace openmldb
 
@@ -17,6 +17,7 @@
 #include <gflags/gflags.h>
 #include <atomic>
 #include <iostream>
+#include <thread>  // NOLINT
 #include <utility>
 
 #include "base/glog_wapper.h"
@@ -37,6 +38,7 @@ using ::openmldb::codec::SchemaCodec;
 DECLARE_string(ssd_root_path);
 DECLARE_string(hdd_root_path);
 DECLARE_uint32(max_traverse_cnt);
+DECLARE_uint32(scan_epoch_renew_interval);
 DECLARE_int32(gc_safe_offset);
 
 namespace openmldb {
@@ -977,6 +979,47 @@ TEST_P(TableTest, TraverseIteratorCount) {
     delete table;
 }
 
+TEST_P(TableTest, TraverseIteratorRenewEpoch) {
+    ::openmldb::common::StorageMode storageMode = GetParam();
+    if (storageMode != ::openmldb::common::kMemory) {
+        return;
+    }
+    uint32_t old_interval = FLAGS_scan_epoch_renew_interval;
+    FLAGS_scan_epoch_renew_interval = 1;
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    Table* table = CreateTable("tx_log", 1, 1, 8, mapping, 0, ::openmldb::type::kAbsoluteTime, "", storageMode);
+    table->Init();
+    for (int i = 0; i < 100; i++) {
+        std::string key = "pk" + std::to_string(i);
+        std::string value = "test" + std::to_string(i);
+        table->Put(key, 9527, value.c_str(), value.size());
+        table->Put(key, 9528, value.c_str(), value.size());
+    }
+    TableIterator* it = table->NewTraverseIterator(0);
+    it->SeekToFirst();
+    int count = 0;
+    std::string last_pk;
+    while (it->Valid()) {
+        if (it->GetPK() != last_pk) {
+            last_pk = it->GetPK();
+            // the key the scan renews from is removed by gc, the scan goes
+            // on from the next key
+            if (count % 10 == 0) {
+                table->Delete(last_pk, 0);
+                table->SchedGc();
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        count++;
+        it->Next();
+    }
+    ASSERT_EQ(200, count);
+    delete it;
+    delete table;
+    FLAGS_scan_epoch_renew_interval = old_interval;
+}
+
 TEST_P(TableTest, UpdateTTL) {
     ::openmldb::common::StorageMode storageMode = GetParam();
     ::openmldb::api::TableMeta table_meta;
@@ -19,29 +19,14 @@
 namespace openmldb {
 namespace storage {
 
-Ticket::Ticket() {}
+Ticket::Ticket() : slot_(::openmldb::base::EpochManager::GetInstance()->Enter()) {}
 
-Ticket::~Ticket() {
-    std::vector<KeyEntry*>::iterator it = entries_.begin();
-    for (; it != entries_.end(); ++it) {
-        (*it)->UnRef();
-    }
-}
-
-void Ticket::Push(KeyEntry* entry) {
-    if (entry == NULL) {
-        return;
-    }
-    entry->Ref();
-    entries_.push_back(entry);
-}
+Ticket::~Ticket() { ::openmldb::base::EpochManager::GetInstance()->Exit(slot_); }
 
-void Ticket::Pop() {
-    if (!entries_.empty()) {
-        KeyEntry* entry = entries_.back();
-        entries_.pop_back();
-        entry->UnRef();
-    }
+void Ticket::Renew() {
+    auto* manager = ::openmldb::base::EpochManager::GetInstance();
+    manager->Exit(slot_);
+    slot_ = manager->Enter();
 }
 
 }  // namespace storage
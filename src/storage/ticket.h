@@ -17,15 +17,15 @@
 #ifndef SRC_STORAGE_TICKET_H_
 #define SRC_STORAGE_TICKET_H_
 
-#include <vector>
-
-#include "storage/segment.h"
+#include "base/epoch.h"
 
 namespace openmldb {
 namespace storage {
 
-class KeyEntry;
-
+// Ticket keeps the memory of tables reachable by the iterators created with it
+// from being freed by gc, until the ticket is destroyed. It enters the epoch of
+// base::EpochManager once instead of referencing every key entry visited, so
+// the readers of the same key write no shared counter.
 class Ticket {
  public:
     Ticket();
@@ -33,11 +33,12 @@ class Ticket {
     Ticket(const Ticket&) = delete;
     Ticket& operator=(const Ticket& s) = delete;
 
-    void Push(KeyEntry* entry);
-    void Pop();
+    // exit the epoch and enter it again, the memory reached before may be
+    // freed once gc has removed it
+    void Renew();
 
  private:
-    std::vector<KeyEntry*> entries_;
+    ::openmldb::base::EpochSlot* slot_;
 };
 
 }  // namespace storage
@@ -0,0 +1,595 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tablet/aggregator.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "base/glog_wapper.h"
+#include "base/strings.h"
+#include "boost/algorithm/string.hpp"
+#include "common/timer.h"
+#include "gflags/gflags.h"
+#include "log/log_reader.h"
+#include "storage/ticket.h"
+
+DECLARE_bool(binlog_notify_on_put);
+
+namespace openmldb::tablet {
+
+using ::hybridse::codec::AggrFuncType;
+using ::hybridse::codec::AggrValue;
+
+Aggregator::Aggregator(const ::openmldb::api::TableMeta& base_meta, std::shared_ptr<storage::Table> aggr_table,
+                       std::shared_ptr<replica::LogReplicator> aggr_replicator, uint32_t index_pos,
+                       int32_t aggr_col_idx, uint32_t ts_col_idx, AggrFuncType func_type, bool is_row_bucket,
+                       int64_t bucket_size)
+    : base_schema_(base_meta.column_desc()),
+      aggr_schema_(),
+      aggr_table_(aggr_table),
+      aggr_replicator_(aggr_replicator),
+      index_pos_(index_pos),
+      aggr_col_idx_(aggr_col_idx),
+      ts_col_idx_(ts_col_idx),
+      aggr_col_type_(::openmldb::type::kBigInt),
+      func_type_(func_type),
+      is_row_bucket_(is_row_bucket),
+      bucket_size_(bucket_size),
+      mu_(),
+      aggr_buffers_(),
+      pending_mu_(),
+      pending_rows_(),
+      replayed_offset_(0),
+      ready_(false) {
+    if (aggr_col_idx_ >= 0) {
+        aggr_col_type_ = base_schema_.Get(aggr_col_idx_).data_type();
+    }
+    aggr_schema_.CopyFrom(aggr_table_->GetTableMeta()->column_desc());
+}
+
+bool Aggregator::Init(std::shared_ptr<replica::LogReplicator> base_replicator) {
+    if (!base_replicator) {
+        return false;
+    }
+    uint32_t tid = GetAggrTid();
+    uint32_t pid = GetAggrPid();
+    // the rows appended before the aggregator is published are only in binlog
+    base_replicator->SyncToDisk();
+    // the binlog covered by snapshot may have been deleted, start from the
+    // oldest log part left which holds all the rows of unwritten buckets
+    uint64_t start_offset = 0;
+    auto* it = base_replicator->GetLogPart()->NewIterator();
+    it->SeekToFirst();
+    while (it->Valid()) {
+        start_offset = it->GetValue();
+        it->Next();
+    }
+    delete it;
+    ::openmldb::log::LogReader log_reader(base_replicator->GetLogPart(), base_replicator->GetLogPath(), false);
+    log_reader.SetOffset(start_offset);
+    ::openmldb::api::LogEntry entry;
+    std::string buffer;
+    // the max offset in pre-aggr table of every key, only used by row buckets
+    std::unordered_map<std::string, uint64_t> flushed_offsets;
+    uint64_t cur_offset = 0;
+    uint64_t succ_cnt = 0;
+    uint64_t consumed = ::baidu::common::timer::get_micros();
+    int last_log_index = log_reader.GetLogIndex();
+    while (true) {
+        buffer.clear();
+        ::openmldb::base::Slice record;
+        ::openmldb::log::Status status = log_reader.ReadNextRecord(&record, &buffer);
+        if (status.IsWaitRecord()) {
+            int end_log_index = log_reader.GetEndLogIndex();
+            int cur_log_index = log_reader.GetLogIndex();
+            if (end_log_index >= 0 && end_log_index > cur_log_index) {
+                log_reader.RollRLogFile();
+                continue;
+            }
+            break;
+        }
+        if (status.IsEof()) {
+            if (log_reader.GetLogIndex() != last_log_index) {
+                last_log_index = log_reader.GetLogIndex();
+                continue;
+            }
+            break;
+        }
+        if (!status.ok()) {
+            continue;
+        }
+        if (!entry.ParseFromString(record.ToString())) {
+            PDLOG(WARNING, "fail parse record for aggr table tid %u, pid %u with value %s", tid, pid,
+                  ::openmldb::base::DebugString(record.ToString()).c_str());
+            continue;
+        }
+        if (cur_offset >= entry.log_index()) {
+            continue;
+        }
+        cur_offset = entry.log_index();
+        if (entry.has_method_type() && entry.method_type() == ::openmldb::api::MethodType::kDelete) {
+            continue;
+        }
+        for (const auto& dimension : entry.dimensions()) {
+            if (dimension.idx() != index_pos_) {
+                continue;
+            }
+            const std::string& key = dimension.key();
+            if (is_row_bucket_) {
+                auto iter = flushed_offsets.find(key);
+                if (iter == flushed_offsets.end()) {
+                    iter = flushed_offsets.emplace(key, GetFlushedOffset(key)).first;
+                }
+                if (entry.log_index() <= iter->second) {
+                    break;
+                }
+            }
+            if (UpdateRow(key, entry.value(), entry.log_index(), true)) {
+                succ_cnt++;
+            }
+            break;
+        }
+    }
+    // the rows put during the replay are either read from binlog above or
+    // held in pending_rows_, apply the ones after the replayed offset
+    uint64_t pending_cnt = 0;
+    {
+        std::lock_guard<std::mutex> lock(pending_mu_);
+        for (const auto& pending : pending_rows_) {
+            if (pending.offset > 0 && pending.offset <= cur_offset) {
+                continue;
+            }
+            UpdateRow(pending.key, pending.row, pending.offset, false);
+            pending_cnt++;
+        }
+        std::vector<PendingRow>().swap(pending_rows_);
+        replayed_offset_ = cur_offset;
+        ready_.store(true, std::memory_order_release);
+    }
+    consumed = ::baidu::common::timer::get_micros() - consumed;
+    PDLOG(INFO,
+          "recover aggr table tid %u pid %u from binlog, start offset %lu, offset %lu, aggregated %lu rows, applied "
+          "%lu pending rows, consumed %lums",
+          tid, pid, start_offset, cur_offset, succ_cnt, pending_cnt, consumed / 1000);
+    return true;
+}
+
+bool Aggregator::Update(const std::string& key, const std::string& row, uint64_t offset) {
+    if (!ready_.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(pending_mu_);
+        if (!ready_.load(std::memory_order_relaxed)) {
+            pending_rows_.push_back({key, row, offset});
+            return true;
+        }
+    }
+    // offset is 0 if the row is not from binlog, it is never replayed
+    if (offset > 0 && offset <= replayed_offset_) {
+        return true;
+    }
+    return UpdateRow(key, row, offset, false);
+}
+
+uint64_t Aggregator::GetRecoverOffset() {
+    if (!ready_.load(std::memory_order_acquire)) {
+        return 0;
+    }
+    std::vector<std::shared_ptr<AggrBufferLocked>> buffers;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        buffers.reserve(aggr_buffers_.size());
+        for (const auto& kv : aggr_buffers_) {
+            buffers.push_back(kv.second);
+        }
+    }
+    uint64_t recover_offset = UINT64_MAX;
+    for (const auto& buffer_locked : buffers) {
+        std::lock_guard<std::mutex> lock(buffer_locked->mu);
+        const AggrBuffer& buffer = buffer_locked->buffer;
+        if (buffer.num_rows > 0 && buffer.first_offset > 0) {
+            recover_offset = std::min(recover_offset, buffer.first_offset - 1);
+        }
+    }
+    return recover_offset;
+}
+
+bool Aggregator::UpdateRow(const std::string& key, const std::string& row, uint64_t offset, bool recover) {
+    int64_t ts = 0;
+    if (!GetRowTs(row, &ts)) {
+        return false;
+    }
+    std::shared_ptr<AggrBufferLocked> buffer_locked = GetBufferLocked(key);
+    std::lock_guard<std::mutex> lock(buffer_locked->mu);
+    return UpdateBuffer(key, buffer_locked.get(), ts, row, offset, recover);
+}
+
+bool Aggregator::GetAggrBuffer(const std::string& key, AggrBuffer* buffer) {
+    std::shared_ptr<AggrBufferLocked> buffer_locked;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        auto iter = aggr_buffers_.find(key);
+        if (iter == aggr_buffers_.end()) {
+            return false;
+        }
+        buffer_locked = iter->second;
+    }
+    std::lock_guard<std::mutex> lock(buffer_locked->mu);
+    *buffer = buffer_locked->buffer;
+    return true;
+}
+
+std::shared_ptr<Aggregator::AggrBufferLocked> Aggregator::GetBufferLocked(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto iter = aggr_buffers_.find(key);
+    if (iter == aggr_buffers_.end()) {
+        auto buffer_locked = std::make_shared<AggrBufferLocked>();
+        buffer_locked->buffer.value = NewAggrValue();
+        iter = aggr_buffers_.emplace(key, std::move(buffer_locked)).first;
+    }
+    return iter->second;
+}
+
+bool Aggregator::UpdateBuffer(const std::string& key, AggrBufferLocked* buffer_locked, int64_t ts,
+                              const std::string& row, uint64_t offset, bool recover) {
+    AggrBuffer* buffer = &buffer_locked->buffer;
+    if (is_row_bucket_) {
+        if (buffer->num_rows == 0) {
+            buffer->ts_begin = ts;
+            buffer->ts_end = ts;
+        } else {
+            buffer->ts_begin = std::min(buffer->ts_begin, ts);
+            buffer->ts_end = std::max(buffer->ts_end, ts);
+        }
+        if (!AggregateRow(buffer, row)) {
+            return false;
+        }
+        buffer->num_rows++;
+        buffer->binlog_offset = std::max(buffer->binlog_offset, offset);
+        SetFirstOffset(buffer, offset);
+        if (buffer->num_rows >= bucket_size_) {
+            bool ok = FlushBuffer(key, *buffer);
+            ResetBuffer(buffer);
+            return ok;
+        }
+        return true;
+    }
+    int64_t ts_start = GetBucketStart(ts);
+    if (buffer->num_rows == 0 || ts_start < buffer->ts_begin) {
+        // the bucket may have been written into pre-aggr table, merge the row
+        // into the record and write it again. Late rows mostly fall into the
+        // last written bucket, so the table is only scanned on a cache miss
+        AggrBuffer& flushed = buffer_locked->flushed;
+        bool found = flushed.num_rows > 0 && flushed.ts_begin == ts_start;
+        if (!found) {
+            AggrBuffer record;
+            if (GetFlushedBucket(key, ts_start, &record)) {
+                flushed = record;
+                found = true;
+            }
+        }
+        if (found) {
+            if (recover && offset <= flushed.binlog_offset) {
+                return true;
+            }
+            AggrBuffer merged = flushed;
+            if (!AggregateRow(&merged, row)) {
+                return false;
+            }
+            merged.num_rows++;
+            merged.binlog_offset = std::max(merged.binlog_offset, offset);
+            if (!FlushBuffer(key, merged)) {
+                return false;
+            }
+            flushed = merged;
+            return true;
+        }
+        if (buffer->num_rows > 0) {
+            // a late row of one bucket without any record
+            AggrBuffer late;
+            late.ts_begin = ts_start;
+            late.ts_end = ts_start + bucket_size_ - 1;
+            late.value = NewAggrValue();
+            if (!AggregateRow(&late, row)) {
+                return false;
+            }
+            late.num_rows = 1;
+            late.binlog_offset = offset;
+            if (!FlushBuffer(key, late)) {
+                return false;
+            }
+            flushed = late;
+            return true;
+        }
+    } else if (ts_start > buffer->ts_begin) {
+        if (!FlushBuffer(key, *buffer)) {
+            return false;
+        }
+        buffer_locked->flushed = *buffer;
+        ResetBuffer(buffer);
+    }
+    if (buffer->num_rows == 0) {
+        buffer->ts_begin = ts_start;
+        buffer->ts_end = ts_start + bucket_size_ - 1;
+    }
+    if (!AggregateRow(buffer, row)) {
+        return false;
+    }
+    buffer->num_rows++;
+    buffer->binlog_offset = std::max(buffer->binlog_offset, offset);
+    SetFirstOffset(buffer, offset);
+    return true;
+}
+
+bool Aggregator::AggregateRow(AggrBuffer* buffer, const std::string& row) {
+    if (aggr_col_idx_ < 0) {
+        buffer->value.Update(static_cast<int64_t>(1));
+        return true;
+    }
+    ::openmldb::codec::RowView view(base_schema_, reinterpret_cast<const int8_t*>(row.data()), row.size());
+    if (view.IsNULL(aggr_col_idx_)) {
+        return true;
+    }
+    if (func_type_ == ::hybridse::codec::kAggrCount) {
+        buffer->value.Update(static_cast<int64_t>(1));
+        return true;
+    }
+    int32_t ret = 0;
+    switch (aggr_col_type_) {
+        case ::openmldb::type::kSmallInt: {
+            int16_t val = 0;
+            ret = view.GetInt16(aggr_col_idx_, &val);
+            buffer->value.Update(static_cast<int64_t>(val));
+            break;
+        }
+        case ::openmldb::type::kInt: {
+            int32_t val = 0;
+            ret = view.GetInt32(aggr_col_idx_, &val);
+            buffer->value.Update(static_cast<int64_t>(val));
+            break;
+        }
+        case ::openmldb::type::kBigInt: {
+            int64_t val = 0;
+            ret = view.GetInt64(aggr_col_idx_, &val);
+            buffer->value.Update(val);
+            break;
+        }
+        case ::openmldb::type::kTimestamp: {
+            int64_t val = 0;
+            ret = view.GetTimestamp(aggr_col_idx_, &val);
+            buffer->value.Update(val);
+            break;
+        }
+        case ::openmldb::type::kFloat: {
+            float val = 0;
+            ret = view.GetFloat(aggr_col_idx_, &val);
+            buffer->value.Update(static_cast<double>(val));
+            break;
+        }
+        case ::openmldb::type::kDouble: {
+            double val = 0;
+            ret = view.GetDouble(aggr_col_idx_, &val);
+            buffer->value.Update(val);
+            break;
+        }
+        default:
+            return false;
+    }
+    return ret == 0;
+}
+
+bool Aggregator::FlushBuffer(const std::string& key, const AggrBuffer& buffer) {
+    std::string aggr_val;
+    buffer.value.Encode(&aggr_val);
+    ::openmldb::codec::RowBuilder builder(aggr_schema_);
+    uint32_t size = builder.CalTotalLength(key.size() + aggr_val.size());
+    std::string row;
+    row.resize(size);
+    builder.SetBuffer(reinterpret_cast<int8_t*>(&row[0]), size);
+    builder.AppendString(key.c_str(), key.size());
+    builder.AppendTimestamp(buffer.ts_begin);
+    builder.AppendTimestamp(buffer.ts_end);
+    builder.AppendInt32(buffer.num_rows);
+    builder.AppendString(aggr_val.c_str(), aggr_val.size());
+    builder.AppendInt64(buffer.binlog_offset);
+
+    ::openmldb::api::LogEntry entry;
+    entry.set_pk(key);
+    entry.set_ts(buffer.ts_begin);
+    entry.set_value(row);
+    auto dimension = entry.add_dimensions();
+    dimension->set_key(key);
+    dimension->set_idx(0);
+    if (!aggr_table_->Put(entry)) {
+        PDLOG(WARNING, "fail to put aggr record. tid %u pid %u key %s ts_start %ld", GetAggrTid(), GetAggrPid(),
+              key.c_str(), buffer.ts_begin);
+        return false;
+    }
+    if (aggr_replicator_) {
+        entry.set_term(aggr_replicator_->GetLeaderTerm());
+        aggr_replicator_->AppendEntry(entry);
+        if (FLAGS_binlog_notify_on_put) {
+            aggr_replicator_->Notify();
+        }
+    }
+    return true;
+}
+
+bool Aggregator::GetFlushedBucket(const std::string& key, int64_t ts_start, AggrBuffer* buffer) {
+    storage::Ticket ticket;
+    std::unique_ptr<storage::TableIterator> it(aggr_table_->NewIterator(0, key, ticket));
+    if (!it) {
+        return false;
+    }
+    bool found = false;
+    it->Seek(ts_start);
+    while (it->Valid() && static_cast<int64_t>(it->GetKey()) == ts_start) {
+        AggrBuffer record;
+        if (DecodeAggrRow(it->GetValue(), &record) && (!found || record.binlog_offset > buffer->binlog_offset)) {
+            *buffer = record;
+            found = true;
+        }
+        it->Next();
+    }
+    return found;
+}
+
+uint64_t Aggregator::GetFlushedOffset(const std::string& key) {
+    storage::Ticket ticket;
+    std::unique_ptr<storage::TableIterator> it(aggr_table_->NewIterator(0, key, ticket));
+    if (!it) {
+        return 0;
+    }
+    uint64_t offset = 0;
+    it->SeekToFirst();
+    while (it->Valid()) {
+        AggrBuffer record;
+        if (DecodeAggrRow(it->GetValue(), &record)) {
+            offset = std::max(offset, record.binlog_offset);
+        }
+        it->Next();
+    }
+    return offset;
+}
+
+bool Aggregator::DecodeAggrRow(const ::openmldb::base::Slice& row, AggrBuffer* buffer) {
+    ::openmldb::codec::RowView view(aggr_schema_, reinterpret_cast<const int8_t*>(row.data()), row.size());
+    int64_t binlog_offset = 0;
+    char* aggr_val = nullptr;
+    uint32_t aggr_val_size = 0;
+    if (view.GetTimestamp(::hybridse::codec::kAggrTsStartPos, &buffer->ts_begin) != 0 ||
+        view.GetTimestamp(::hybridse::codec::kAggrTsEndPos, &buffer->ts_end) != 0 ||
+        view.GetInt32(::hybridse::codec::kAggrNumRowsPos, &buffer->num_rows) != 0 ||
+        view.GetString(::hybridse::codec::kAggrValPos, &aggr_val, &aggr_val_size) != 0 ||
+        view.GetInt64(::hybridse::codec::kAggrBinlogOffsetPos, &binlog_offset) != 0) {
+        return false;
+    }
+    buffer->binlog_offset = binlog_offset;
+    buffer->value = NewAggrValue();
+    return buffer->value.Decode(aggr_val, aggr_val_size);
+}
+
+bool Aggregator::GetRowTs(const std::string& row, int64_t* ts) {
+    ::openmldb::codec::RowView view(base_schema_, reinterpret_cast<const int8_t*>(row.data()), row.size());
+    if (base_schema_.Get(ts_col_idx_).data_type() == ::openmldb::type::kTimestamp) {
+        return view.GetTimestamp(ts_col_idx_, ts) == 0;
+    }
+    return view.GetInt64(ts_col_idx_, ts) == 0;
+}
+
+void Aggregator::ResetBuffer(AggrBuffer* buffer) {
+    buffer->ts_begin = -1;
+    buffer->ts_end = -1;
+    buffer->num_rows = 0;
+    buffer->first_offset = 0;
+    buffer->value.Reset();
+}
+
+AggrValue Aggregator::NewAggrValue() const {
+    bool is_double = aggr_col_type_ == ::openmldb::type::kFloat || aggr_col_type_ == ::openmldb::type::kDouble;
+    return AggrValue(func_type_, is_double);
+}
+
+static std::string StripRelation(const std::string& col) {
+    size_t pos = col.find_last_of('.');
+    return pos == std::string::npos ? col : col.substr(pos + 1);
+}
+
+std::shared_ptr<Aggregator> CreateAggregator(const ::openmldb::api::TableMeta& base_meta,
+                                             std::shared_ptr<storage::Table> aggr_table,
+                                             std::shared_ptr<replica::LogReplicator> aggr_replicator,
+                                             const std::string& aggr_func, const std::string& aggr_col,
+                                             const std::string& partition_cols, const std::string& order_by_col,
+                                             const std::string& bucket_size) {
+    AggrFuncType func_type;
+    if (!::hybridse::codec::GetAggrFuncType(aggr_func, &func_type)) {
+        PDLOG(WARNING, "unsupported aggr func %s", aggr_func.c_str());
+        return nullptr;
+    }
+    bool is_row_bucket = false;
+    int64_t size = 0;
+    if (!::hybridse::codec::ParseAggrBucketSize(bucket_size, &is_row_bucket, &size)) {
+        PDLOG(WARNING, "invalid bucket size %s", bucket_size.c_str());
+        return nullptr;
+    }
+    std::vector<std::string> partitions;
+    boost::split(partitions, partition_cols, boost::is_any_of(","));
+    std::string order_col = StripRelation(order_by_col);
+    int32_t index_pos = -1;
+    for (int i = 0; i < base_meta.column_key_size(); i++) {
+        const auto& column_key = base_meta.column_key(i);
+        if (column_key.ts_name() != order_col || column_key.col_name_size() != static_cast<int>(partitions.size())) {
+            continue;
+        }
+        bool match = true;
+        for (int j = 0; j < column_key.col_name_size(); j++) {
+            if (column_key.col_name(j) != StripRelation(partitions[j])) {
+                match = false;
+                break;
+            }
+        }
+        if (match) {
+            index_pos = i;
+            break;
+        }
+    }
+    if (index_pos < 0) {
+        PDLOG(WARNING, "no index of base table %s matches partition %s order by %s", base_meta.name().c_str(),
+              partition_cols.c_str(), order_by_col.c_str());
+        return nullptr;
+    }
+    int32_t aggr_col_idx = -1;
+    int32_t ts_col_idx = -1;
+    std::string col = StripRelation(aggr_col);
+    for (int i = 0; i < base_meta.column_desc_size(); i++) {
+        const auto& column = base_meta.column_desc(i);
+        if (column.name() == col) {
+            aggr_col_idx = i;
+        }
+        if (column.name() == order_col) {
+            ts_col_idx = i;
+        }
+    }
+    if (ts_col_idx < 0) {
+        return nullptr;
+    }
+    if (aggr_col_idx < 0) {
+        if (func_type != ::hybridse::codec::kAggrCount || col != "*") {
+            PDLOG(WARNING, "aggr column %s is not found in base table %s", aggr_col.c_str(), base_meta.name().c_str());
+            return nullptr;
+        }
+    } else if (func_type != ::hybridse::codec::kAggrCount) {
+        switch (base_meta.column_desc(aggr_col_idx).data_type()) {
+            case ::openmldb::type::kSmallInt:
+            case ::openmldb::type::kInt:
+            case ::openmldb::type::kBigInt:
+            case ::openmldb::type::kFloat:
+            case ::openmldb::type::kDouble:
+                break;
+            case ::openmldb::type::kTimestamp:
+                if (func_type == ::hybridse::codec::kAggrMin || func_type == ::hybridse::codec::kAggrMax) {
+                    break;
+                }
+                return nullptr;
+            default:
+                PDLOG(WARNING, "unsupported type of aggr column %s", aggr_col.c_str());
+                return nullptr;
+        }
+    }
+    return std::make_shared<Aggregator>(base_meta, aggr_table, aggr_replicator, index_pos, aggr_col_idx, ts_col_idx,
+                                        func_type, is_row_bucket, size);
+}
+
+}  // namespace openmldb::tablet
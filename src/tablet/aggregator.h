@@ -0,0 +1,160 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_TABLET_AGGREGATOR_H_
+#define SRC_TABLET_AGGREGATOR_H_
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "codec/aggr_codec.h"
+#include "codec/codec.h"
+#include "proto/tablet.pb.h"
+#include "replica/log_replicator.h"
+#include "storage/table.h"
+
+namespace openmldb::tablet {
+
+// partial aggregate of the rows in one bucket of one key
+struct AggrBuffer {
+    int64_t ts_begin = -1;
+    int64_t ts_end = -1;
+    int32_t num_rows = 0;
+    // the max binlog offset of base table which has been aggregated
+    uint64_t binlog_offset = 0;
+    // the min binlog offset of the rows in the buffer, 0 if it is empty
+    uint64_t first_offset = 0;
+    ::hybridse::codec::AggrValue value;
+};
+
+// Aggregator maintains one pre-aggr table partition for the base table
+// partition on the same tablet. Every row put to base table is aggregated into
+// the buffer of its key, the buffer is written to pre-aggr table once a row of
+// a later bucket comes. A late row of a written bucket is merged into the
+// record and written again with larger binlog_offset, readers should take the
+// record with max binlog_offset among the ones with the same ts_start.
+class Aggregator {
+ public:
+    Aggregator(const ::openmldb::api::TableMeta& base_meta, std::shared_ptr<storage::Table> aggr_table,
+               std::shared_ptr<replica::LogReplicator> aggr_replicator, uint32_t index_pos, int32_t aggr_col_idx,
+               uint32_t ts_col_idx, ::hybridse::codec::AggrFuncType func_type, bool is_row_bucket,
+               int64_t bucket_size);
+
+    ~Aggregator() = default;
+
+    // rebuild the buffers by replaying the binlog of base table, the rows which
+    // have been aggregated into pre-aggr table are skipped. The aggregator
+    // should be published before Init, rows updated during the replay are
+    // held and applied once the replay reaches the end of binlog
+    bool Init(std::shared_ptr<replica::LogReplicator> base_replicator);
+
+    // aggregate one row of base table, key is the dimension key of index_pos
+    bool Update(const std::string& key, const std::string& row, uint64_t offset);
+
+    inline bool IsReady() const { return ready_.load(std::memory_order_acquire); }
+
+    bool GetAggrBuffer(const std::string& key, AggrBuffer* buffer);
+
+    // the rows not written to pre-aggr table are rebuilt from the binlog of
+    // base table after restart, the binlog after the returned offset should be
+    // kept. Return 0 if the aggregator is not ready
+    uint64_t GetRecoverOffset();
+
+    inline uint32_t GetIndexPos() const { return index_pos_; }
+    inline uint32_t GetAggrTid() const { return aggr_table_->GetId(); }
+    inline uint32_t GetAggrPid() const { return aggr_table_->GetPid(); }
+
+ private:
+    struct AggrBufferLocked {
+        std::mutex mu;
+        AggrBuffer buffer;
+        // the last record written to pre-aggr table, num_rows is 0 if unknown
+        AggrBuffer flushed;
+    };
+
+    struct PendingRow {
+        std::string key;
+        std::string row;
+        uint64_t offset;
+    };
+
+    bool UpdateRow(const std::string& key, const std::string& row, uint64_t offset, bool recover);
+    std::shared_ptr<AggrBufferLocked> GetBufferLocked(const std::string& key);
+    bool UpdateBuffer(const std::string& key, AggrBufferLocked* buffer_locked, int64_t ts, const std::string& row,
+                      uint64_t offset, bool recover);
+    bool AggregateRow(AggrBuffer* buffer, const std::string& row);
+    bool FlushBuffer(const std::string& key, const AggrBuffer& buffer);
+    // get the latest written record of the bucket starts with ts_start
+    bool GetFlushedBucket(const std::string& key, int64_t ts_start, AggrBuffer* buffer);
+    // the max binlog offset of all written records of key
+    uint64_t GetFlushedOffset(const std::string& key);
+    bool DecodeAggrRow(const ::openmldb::base::Slice& row, AggrBuffer* buffer);
+    bool GetRowTs(const std::string& row, int64_t* ts);
+    void ResetBuffer(AggrBuffer* buffer);
+    inline void SetFirstOffset(AggrBuffer* buffer, uint64_t offset) const {
+        if (offset > 0 && (buffer->first_offset == 0 || offset < buffer->first_offset)) {
+            buffer->first_offset = offset;
+        }
+    }
+    ::hybridse::codec::AggrValue NewAggrValue() const;
+    // floor ts to the bucket, ts before 1970 falls into the bucket below it
+    inline int64_t GetBucketStart(int64_t ts) const {
+        int64_t remainder = ts % bucket_size_;
+        return remainder < 0 ? ts - remainder - bucket_size_ : ts - remainder;
+    }
+
+    ::openmldb::codec::Schema base_schema_;
+    ::openmldb::codec::Schema aggr_schema_;
+    std::shared_ptr<storage::Table> aggr_table_;
+    std::shared_ptr<replica::LogReplicator> aggr_replicator_;
+    uint32_t index_pos_;
+    // -1 if the aggr column is `*` of count
+    int32_t aggr_col_idx_;
+    uint32_t ts_col_idx_;
+    ::openmldb::type::DataType aggr_col_type_;
+    ::hybridse::codec::AggrFuncType func_type_;
+    bool is_row_bucket_;
+    int64_t bucket_size_;
+
+    std::mutex mu_;
+    std::unordered_map<std::string, std::shared_ptr<AggrBufferLocked>> aggr_buffers_;
+
+    // rows put while replaying the binlog, guarded by pending_mu_
+    std::mutex pending_mu_;
+    std::vector<PendingRow> pending_rows_;
+    // the last binlog offset replayed by Init, rows at or below it are skipped
+    uint64_t replayed_offset_;
+    std::atomic<bool> ready_;
+};
+
+using Aggregators = std::vector<std::shared_ptr<Aggregator>>;
+
+// create the aggregator of one pre-aggr table partition with the meta info in
+// PRE_AGG_META_INFO, return nullptr if the aggregation can't be maintained
+std::shared_ptr<Aggregator> CreateAggregator(const ::openmldb::api::TableMeta& base_meta,
+                                             std::shared_ptr<storage::Table> aggr_table,
+                                             std::shared_ptr<replica::LogReplicator> aggr_replicator,
+                                             const std::string& aggr_func, const std::string& aggr_col,
+                                             const std::string& partition_cols, const std::string& order_by_col,
+                                             const std::string& bucket_size);
+
+}  // namespace openmldb::tablet
+#endif  // SRC_TABLET_AGGREGATOR_H_
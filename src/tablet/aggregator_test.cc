@@ -0,0 +1,362 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tablet/aggregator.h"
+
+#include <gflags/gflags.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "base/file_util.h"
+#include "base/glog_wapper.h"
+#include "codec/sdk_codec.h"
+#include "gtest/gtest.h"
+#include "storage/mem_table.h"
+#include "storage/ticket.h"
+#include "test/util.h"
+
+namespace openmldb {
+namespace tablet {
+
+using ::openmldb::codec::SchemaCodec;
+
+static const std::map<std::string, std::string> g_endpoints;
+
+class AggregatorTest : public ::testing::Test {
+ public:
+    AggregatorTest() {}
+    ~AggregatorTest() {}
+};
+
+static ::openmldb::api::TableMeta GetBaseMeta() {
+    ::openmldb::api::TableMeta meta;
+    meta.set_name("t1");
+    meta.set_tid(1);
+    meta.set_pid(0);
+    meta.set_format_version(1);
+    SchemaCodec::SetColumnDesc(meta.add_column_desc(), "id", ::openmldb::type::kString);
+    SchemaCodec::SetColumnDesc(meta.add_column_desc(), "ts_col", ::openmldb::type::kTimestamp);
+    SchemaCodec::SetColumnDesc(meta.add_column_desc(), "val", ::openmldb::type::kBigInt);
+    SchemaCodec::SetIndex(meta.add_column_key(), "idx0", "id", "ts_col", ::openmldb::type::kAbsoluteTime, 0, 0);
+    return meta;
+}
+
+static std::shared_ptr<storage::Table> CreateAggrTable(uint32_t tid) {
+    ::openmldb::api::TableMeta meta;
+    meta.set_name("pre_t1_w1_sum_val");
+    meta.set_tid(tid);
+    meta.set_pid(0);
+    meta.set_format_version(1);
+    SchemaCodec::SetColumnDesc(meta.add_column_desc(), "key", ::openmldb::type::kString);
+    SchemaCodec::SetColumnDesc(meta.add_column_desc(), "ts_start", ::openmldb::type::kTimestamp);
+    SchemaCodec::SetColumnDesc(meta.add_column_desc(), "ts_end", ::openmldb::type::kTimestamp);
+    SchemaCodec::SetColumnDesc(meta.add_column_desc(), "num_rows", ::openmldb::type::kInt);
+    SchemaCodec::SetColumnDesc(meta.add_column_desc(), "agg_val", ::openmldb::type::kString);
+    SchemaCodec::SetColumnDesc(meta.add_column_desc(), "binlog_offset", ::openmldb::type::kBigInt);
+    SchemaCodec::SetIndex(meta.add_column_key(), "key_index", "key", "ts_start", ::openmldb::type::kAbsoluteTime, 0,
+                          0);
+    auto table = std::make_shared<storage::MemTable>(meta);
+    table->Init();
+    return table;
+}
+
+static ::openmldb::api::LogEntry PackEntry(::openmldb::codec::SDKCodec* codec, const std::string& key, int64_t ts,
+                                           int64_t val) {
+    ::openmldb::api::LogEntry entry;
+    entry.set_ts(ts);
+    codec->EncodeRow({key, std::to_string(ts), std::to_string(val)}, entry.mutable_value());
+    auto dimension = entry.add_dimensions();
+    dimension->set_key(key);
+    dimension->set_idx(0);
+    return entry;
+}
+
+// collect the latest record of every bucket as ts_start -> (num_rows, sum)
+static std::map<int64_t, std::pair<int32_t, int64_t>> ScanAggrTable(std::shared_ptr<storage::Table> table,
+                                                                    const std::string& key) {
+    ::openmldb::codec::Schema schema = table->GetTableMeta()->column_desc();
+    std::map<int64_t, std::pair<int32_t, int64_t>> result;
+    std::map<int64_t, int64_t> offsets;
+    storage::Ticket ticket;
+    std::unique_ptr<storage::TableIterator> it(table->NewIterator(0, key, ticket));
+    it->SeekToFirst();
+    while (it->Valid()) {
+        auto value = it->GetValue();
+        ::openmldb::codec::RowView view(schema, reinterpret_cast<const int8_t*>(value.data()), value.size());
+        int64_t ts_start = 0;
+        int32_t num_rows = 0;
+        int64_t offset = 0;
+        char* ch = nullptr;
+        uint32_t len = 0;
+        view.GetTimestamp(::hybridse::codec::kAggrTsStartPos, &ts_start);
+        view.GetInt32(::hybridse::codec::kAggrNumRowsPos, &num_rows);
+        view.GetString(::hybridse::codec::kAggrValPos, &ch, &len);
+        view.GetInt64(::hybridse::codec::kAggrBinlogOffsetPos, &offset);
+        ::hybridse::codec::AggrValue aggr_val(::hybridse::codec::kAggrSum, false);
+        aggr_val.Decode(ch, len);
+        if (offsets.find(ts_start) == offsets.end() || offsets[ts_start] < offset) {
+            offsets[ts_start] = offset;
+            result[ts_start] = std::make_pair(num_rows, aggr_val.GetInt64());
+        }
+        it->Next();
+    }
+    return result;
+}
+
+static std::shared_ptr<replica::LogReplicator> CreateBaseReplicator(uint32_t tid, const std::string& folder) {
+    auto replicator = std::make_shared<replica::LogReplicator>(tid, 0, folder, g_endpoints, replica::kLeaderNode);
+    if (!replicator->Init()) {
+        return nullptr;
+    }
+    return replicator;
+}
+
+TEST_F(AggregatorTest, CreateAggregator) {
+    auto base_meta = GetBaseMeta();
+    auto aggr_table = CreateAggrTable(2);
+    ASSERT_TRUE(CreateAggregator(base_meta, aggr_table, nullptr, "sum", "val", "id", "ts_col", "1s"));
+    ASSERT_TRUE(CreateAggregator(base_meta, aggr_table, nullptr, "count", "*", "id", "ts_col", "100"));
+    // no index on partition cols and order col
+    ASSERT_FALSE(CreateAggregator(base_meta, aggr_table, nullptr, "sum", "val", "val", "ts_col", "1s"));
+    ASSERT_FALSE(CreateAggregator(base_meta, aggr_table, nullptr, "sum", "id", "id", "ts_col", "1s"));
+    ASSERT_FALSE(CreateAggregator(base_meta, aggr_table, nullptr, "distinct_count", "val", "id", "ts_col", "1s"));
+    ASSERT_FALSE(CreateAggregator(base_meta, aggr_table, nullptr, "sum", "val", "id", "ts_col", "1w"));
+}
+
+TEST_F(AggregatorTest, UpdateTimeBucket) {
+    auto base_meta = GetBaseMeta();
+    ::openmldb::codec::SDKCodec codec(base_meta);
+    auto aggr_table = CreateAggrTable(3);
+    auto aggregator = CreateAggregator(base_meta, aggr_table, nullptr, "sum", "val", "id", "ts_col", "1s");
+    ASSERT_TRUE(aggregator);
+    std::string folder = "/tmp/" + ::openmldb::test::GenRand() + "/";
+    ASSERT_TRUE(aggregator->Init(CreateBaseReplicator(1, folder)));
+    uint64_t offset = 0;
+    for (int64_t ts = 0; ts < 3500; ts += 100) {
+        auto entry = PackEntry(&codec, "k1", ts, 1);
+        ASSERT_TRUE(aggregator->Update("k1", entry.value(), ++offset));
+    }
+    auto records = ScanAggrTable(aggr_table, "k1");
+    ASSERT_EQ(3u, records.size());
+    ASSERT_EQ(10, records[0].first);
+    ASSERT_EQ(10, records[1000].second);
+    AggrBuffer buffer;
+    ASSERT_TRUE(aggregator->GetAggrBuffer("k1", &buffer));
+    ASSERT_EQ(3000, buffer.ts_begin);
+    ASSERT_EQ(3999, buffer.ts_end);
+    ASSERT_EQ(5, buffer.num_rows);
+    ASSERT_EQ(5, buffer.value.GetInt64());
+
+    // a late row is merged into the written bucket
+    auto entry = PackEntry(&codec, "k1", 1500, 10);
+    ASSERT_TRUE(aggregator->Update("k1", entry.value(), ++offset));
+    records = ScanAggrTable(aggr_table, "k1");
+    ASSERT_EQ(11, records[1000].first);
+    ASSERT_EQ(20, records[1000].second);
+    ASSERT_TRUE(aggregator->GetAggrBuffer("k1", &buffer));
+    ASSERT_EQ(5, buffer.num_rows);
+    ::openmldb::base::RemoveDirRecursive(folder);
+}
+
+TEST_F(AggregatorTest, UpdateNegativeTs) {
+    auto base_meta = GetBaseMeta();
+    ::openmldb::codec::SDKCodec codec(base_meta);
+    auto aggr_table = CreateAggrTable(7);
+    auto aggregator = CreateAggregator(base_meta, aggr_table, nullptr, "sum", "val", "id", "ts_col", "1s");
+    ASSERT_TRUE(aggregator);
+    std::string folder = "/tmp/" + ::openmldb::test::GenRand() + "/";
+    ASSERT_TRUE(aggregator->Init(CreateBaseReplicator(1, folder)));
+    uint64_t offset = 0;
+    for (int64_t ts : {-1500, -500, -1, 0, 500}) {
+        auto entry = PackEntry(&codec, "k1", ts, 1);
+        ASSERT_TRUE(aggregator->Update("k1", entry.value(), ++offset));
+    }
+    auto records = ScanAggrTable(aggr_table, "k1");
+    ASSERT_EQ(2u, records.size());
+    ASSERT_EQ(1, records[-2000].first);
+    ASSERT_EQ(2, records[-1000].first);
+    AggrBuffer buffer;
+    ASSERT_TRUE(aggregator->GetAggrBuffer("k1", &buffer));
+    ASSERT_EQ(0, buffer.ts_begin);
+    ASSERT_EQ(2, buffer.num_rows);
+    ::openmldb::base::RemoveDirRecursive(folder);
+}
+
+TEST_F(AggregatorTest, UpdateRowBucket) {
+    auto base_meta = GetBaseMeta();
+    ::openmldb::codec::SDKCodec codec(base_meta);
+    auto aggr_table = CreateAggrTable(4);
+    auto aggregator = CreateAggregator(base_meta, aggr_table, nullptr, "sum", "val", "id", "ts_col", "4");
+    ASSERT_TRUE(aggregator);
+    std::string folder = "/tmp/" + ::openmldb::test::GenRand() + "/";
+    ASSERT_TRUE(aggregator->Init(CreateBaseReplicator(1, folder)));
+    for (int64_t i = 0; i < 10; i++) {
+        auto entry = PackEntry(&codec, "k1", 1000 + i, i);
+        ASSERT_TRUE(aggregator->Update("k1", entry.value(), i + 1));
+    }
+    auto records = ScanAggrTable(aggr_table, "k1");
+    ASSERT_EQ(2u, records.size());
+    ASSERT_EQ(6, records[1000].second);
+    ASSERT_EQ(22, records[1004].second);
+    AggrBuffer buffer;
+    ASSERT_TRUE(aggregator->GetAggrBuffer("k1", &buffer));
+    ASSERT_EQ(2, buffer.num_rows);
+    ASSERT_EQ(17, buffer.value.GetInt64());
+    ::openmldb::base::RemoveDirRecursive(folder);
+}
+
+TEST_F(AggregatorTest, RecoverFromBinlog) {
+    auto base_meta = GetBaseMeta();
+    ::openmldb::codec::SDKCodec codec(base_meta);
+    std::string folder = "/tmp/" + ::openmldb::test::GenRand() + "/";
+    auto base_replicator = CreateBaseReplicator(1, folder);
+    ASSERT_TRUE(base_replicator);
+    auto aggr_table = CreateAggrTable(5);
+    {
+        auto aggregator = CreateAggregator(base_meta, aggr_table, nullptr, "sum", "val", "id", "ts_col", "1s");
+        ASSERT_TRUE(aggregator);
+        ASSERT_TRUE(aggregator->Init(base_replicator));
+        for (int64_t ts = 0; ts < 2500; ts += 100) {
+            auto entry = PackEntry(&codec, "k1", ts, 2);
+            ASSERT_TRUE(base_replicator->AppendEntry(entry));
+            ASSERT_TRUE(aggregator->Update("k1", entry.value(), entry.log_index()));
+        }
+    }
+    // the row of k2 is only in binlog
+    auto entry = PackEntry(&codec, "k2", 100, 3);
+    ASSERT_TRUE(base_replicator->AppendEntry(entry));
+    base_replicator->SyncToDisk();
+
+    auto aggregator = CreateAggregator(base_meta, aggr_table, nullptr, "sum", "val", "id", "ts_col", "1s");
+    ASSERT_TRUE(aggregator->Init(base_replicator));
+    auto records = ScanAggrTable(aggr_table, "k1");
+    ASSERT_EQ(2u, records.size());
+    ASSERT_EQ(10, records[0].first);
+    ASSERT_EQ(20, records[1000].second);
+    AggrBuffer buffer;
+    ASSERT_TRUE(aggregator->GetAggrBuffer("k1", &buffer));
+    ASSERT_EQ(2000, buffer.ts_begin);
+    ASSERT_EQ(5, buffer.num_rows);
+    ASSERT_EQ(10, buffer.value.GetInt64());
+    ASSERT_TRUE(aggregator->GetAggrBuffer("k2", &buffer));
+    ASSERT_EQ(1, buffer.num_rows);
+    ASSERT_EQ(3, buffer.value.GetInt64());
+    ::openmldb::base::RemoveDirRecursive(folder);
+}
+
+TEST_F(AggregatorTest, RecoverAfterDeleteBinlog) {
+    auto base_meta = GetBaseMeta();
+    ::openmldb::codec::SDKCodec codec(base_meta);
+    std::string folder = "/tmp/" + ::openmldb::test::GenRand() + "/";
+    auto base_replicator = CreateBaseReplicator(1, folder);
+    ASSERT_TRUE(base_replicator);
+    auto aggr_table = CreateAggrTable(7);
+    uint64_t keep_offset = 0;
+    {
+        auto aggregator = CreateAggregator(base_meta, aggr_table, nullptr, "sum", "val", "id", "ts_col", "1s");
+        ASSERT_TRUE(aggregator);
+        ASSERT_TRUE(aggregator->Init(base_replicator));
+        // one bucket of k1 in every log part, the bucket of k2 in the third
+        // part is never written to pre-aggr table
+        for (int64_t ts = 0; ts < 4300; ts += 100) {
+            if (ts % 1000 == 0 && ts > 0) {
+                ASSERT_TRUE(base_replicator->RollWLogFile());
+            }
+            if (ts == 2000) {
+                auto entry = PackEntry(&codec, "k2", 100, 3);
+                ASSERT_TRUE(base_replicator->AppendEntry(entry));
+                ASSERT_TRUE(aggregator->Update("k2", entry.value(), entry.log_index()));
+            }
+            auto entry = PackEntry(&codec, "k1", ts, 2);
+            ASSERT_TRUE(base_replicator->AppendEntry(entry));
+            ASSERT_TRUE(aggregator->Update("k1", entry.value(), entry.log_index()));
+        }
+        keep_offset = aggregator->GetRecoverOffset();
+    }
+    ASSERT_EQ(20u, keep_offset);
+    ASSERT_EQ(5u, base_replicator->GetLogPart()->GetSize());
+    // the snapshot covers all the rows, only the first part can be deleted
+    base_replicator->SetSnapshotLogPartIndex(base_replicator->GetOffset());
+    base_replicator->DeleteBinlog(keep_offset);
+    ASSERT_EQ(4u, base_replicator->GetLogPart()->GetSize());
+    base_replicator->SyncToDisk();
+
+    auto aggregator = CreateAggregator(base_meta, aggr_table, nullptr, "sum", "val", "id", "ts_col", "1s");
+    ASSERT_TRUE(aggregator->Init(base_replicator));
+    auto records = ScanAggrTable(aggr_table, "k1");
+    ASSERT_EQ(4u, records.size());
+    for (const auto& kv : records) {
+        ASSERT_EQ(10, kv.second.first);
+        ASSERT_EQ(20, kv.second.second);
+    }
+    AggrBuffer buffer;
+    ASSERT_TRUE(aggregator->GetAggrBuffer("k1", &buffer));
+    ASSERT_EQ(4000, buffer.ts_begin);
+    ASSERT_EQ(3, buffer.num_rows);
+    ASSERT_EQ(6, buffer.value.GetInt64());
+    ASSERT_TRUE(aggregator->GetAggrBuffer("k2", &buffer));
+    ASSERT_EQ(1, buffer.num_rows);
+    ASSERT_EQ(3, buffer.value.GetInt64());
+    ASSERT_EQ(20u, aggregator->GetRecoverOffset());
+    // a row not from binlog has offset 0 and is aggregated as well
+    auto entry = PackEntry(&codec, "k1", 4300, 2);
+    ASSERT_TRUE(aggregator->Update("k1", entry.value(), 0));
+    ASSERT_TRUE(aggregator->GetAggrBuffer("k1", &buffer));
+    ASSERT_EQ(4, buffer.num_rows);
+    ::openmldb::base::RemoveDirRecursive(folder);
+}
+
+TEST_F(AggregatorTest, UpdateDuringRecover) {
+    auto base_meta = GetBaseMeta();
+    ::openmldb::codec::SDKCodec codec(base_meta);
+    std::string folder = "/tmp/" + ::openmldb::test::GenRand() + "/";
+    auto base_replicator = CreateBaseReplicator(1, folder);
+    ASSERT_TRUE(base_replicator);
+    auto aggr_table = CreateAggrTable(6);
+    auto aggregator = CreateAggregator(base_meta, aggr_table, nullptr, "sum", "val", "id", "ts_col", "1s");
+    ASSERT_TRUE(aggregator);
+    // the rows are put after the aggregator is published and before it is
+    // recovered, the ones in binlog must not be aggregated twice
+    for (int64_t ts = 0; ts < 500; ts += 100) {
+        auto entry = PackEntry(&codec, "k1", ts, 1);
+        ASSERT_TRUE(base_replicator->AppendEntry(entry));
+        ASSERT_TRUE(aggregator->Update("k1", entry.value(), entry.log_index()));
+    }
+    ASSERT_FALSE(aggregator->IsReady());
+    AggrBuffer buffer;
+    ASSERT_FALSE(aggregator->GetAggrBuffer("k1", &buffer));
+    ASSERT_TRUE(aggregator->Init(base_replicator));
+    ASSERT_TRUE(aggregator->IsReady());
+    auto entry = PackEntry(&codec, "k1", 500, 1);
+    ASSERT_TRUE(base_replicator->AppendEntry(entry));
+    ASSERT_TRUE(aggregator->Update("k1", entry.value(), entry.log_index()));
+    ASSERT_TRUE(aggregator->GetAggrBuffer("k1", &buffer));
+    ASSERT_EQ(6, buffer.num_rows);
+    ASSERT_EQ(6, buffer.value.GetInt64());
+    ::openmldb::base::RemoveDirRecursive(folder);
+}
+
+}  // namespace tablet
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    srand(time(NULL));
+    ::testing::InitGoogleTest(&argc, argv);
+    ::openmldb::base::SetLogLevel(INFO);
+    return RUN_ALL_TESTS();
+}
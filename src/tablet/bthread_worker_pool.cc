@@ -0,0 +1,58 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tablet/bthread_worker_pool.h"
+
+#include "base/glog_wapper.h"
+#include "bthread/bthread.h"
+#include "bthread/countdown_event.h"
+
+namespace openmldb::tablet {
+
+struct BthreadWorkerArg {
+    const std::function<void()>* worker;
+    bthread::CountdownEvent* done;
+};
+
+static void* RunBthreadWorker(void* arg) {
+    auto worker_arg = reinterpret_cast<BthreadWorkerArg*>(arg);
+    (*worker_arg->worker)();
+    worker_arg->done->signal();
+    return nullptr;
+}
+
+void BthreadWorkerPool::Run(size_t worker_num, const std::function<void()>& worker) {
+    if (worker_num <= 1) {
+        worker();
+        return;
+    }
+    bthread::CountdownEvent done(worker_num - 1);
+    BthreadWorkerArg arg{&worker, &done};
+    for (size_t i = 1; i < worker_num; i++) {
+        bthread_t tid;
+        int ret = bthread_start_background(&tid, nullptr, RunBthreadWorker, &arg);
+        if (ret != 0) {
+            // the work left is taken by the caller and the started workers
+            PDLOG(WARNING, "fail to start worker bthread with errno %d", ret);
+            done.signal(worker_num - i);
+            break;
+        }
+    }
+    worker();
+    done.wait();
+}
+
+}  // namespace openmldb::tablet
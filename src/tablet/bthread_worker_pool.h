@@ -0,0 +1,37 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_TABLET_BTHREAD_WORKER_POOL_H_
+#define SRC_TABLET_BTHREAD_WORKER_POOL_H_
+
+#include <functional>
+
+#include "vm/worker_pool.h"
+
+namespace openmldb::tablet {
+
+// BthreadWorkerPool runs the workers of a sql run as bthreads. The queries of
+// the tablet run in bthreads, so the caller waits on a bthread countdown
+// event and yields its worker thread to other requests instead of blocking it
+// as the default thread pool of the engine does.
+class BthreadWorkerPool : public ::hybridse::vm::WorkerPool {
+ public:
+    void Run(size_t worker_num, const std::function<void()>& worker) override;
+};
+
+}  // namespace openmldb::tablet
+
+#endif  // SRC_TABLET_BTHREAD_WORKER_POOL_H_
@@ -0,0 +1,94 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tablet/result_cache.h"
+
+#include <functional>
+
+#include "common/timer.h"
+
+namespace openmldb::tablet {
+
+constexpr uint32_t kResultCacheShardNum = 16;
+
+ResultCache::ResultCache(const std::string& db, const std::string& sp_name, uint64_t ttl_ms, uint32_t max_entries)
+    : ttl_ms_(ttl_ms),
+      shards_(),
+      hit_cnt_("result_cache_" + db + "_" + sp_name + "_hit"),
+      miss_cnt_("result_cache_" + db + "_" + sp_name + "_miss"),
+      invalidation_cnt_("result_cache_" + db + "_" + sp_name + "_invalidation") {
+    uint32_t capacity = max_entries / kResultCacheShardNum;
+    if (capacity == 0) {
+        capacity = 1;
+    }
+    for (uint32_t i = 0; i < kResultCacheShardNum; i++) {
+        shards_.emplace_back(new Shard(capacity));
+    }
+}
+
+ResultCache::Shard& ResultCache::GetShard(const std::string& key) {
+    return *shards_[std::hash<std::string>{}(key) % shards_.size()];
+}
+
+std::shared_ptr<ResultCache::Entry> ResultCache::GetEntry(const std::string& key) {
+    Shard& shard = GetShard(key);
+    std::lock_guard<std::mutex> lock(shard.mu);
+    auto result = shard.entries.get(key);
+    return result ? *result : std::shared_ptr<Entry>();
+}
+
+bool ResultCache::GetPartitions(const std::string& key, std::vector<uint64_t>* partitions) {
+    auto entry = GetEntry(key);
+    if (!entry || entry->expire_time <= ::baidu::common::timer::get_micros() / 1000) {
+        return false;
+    }
+    *partitions = entry->partitions;
+    return true;
+}
+
+bool ResultCache::Get(const std::string& key, const std::vector<uint64_t>& partitions,
+                      const std::vector<uint64_t>& version, std::string* value) {
+    uint64_t now = ::baidu::common::timer::get_micros() / 1000;
+    auto entry = GetEntry(key);
+    if (!entry || entry->expire_time <= now || entry->version.empty() || version.empty()) {
+        miss_cnt_ << 1;
+        return false;
+    }
+    if (entry->partitions != partitions || entry->version != version) {
+        invalidation_cnt_ << 1;
+        miss_cnt_ << 1;
+        return false;
+    }
+    value->assign(entry->value);
+    hit_cnt_ << 1;
+    return true;
+}
+
+void ResultCache::Put(const std::string& key, const std::vector<uint64_t>& partitions,
+                      const std::vector<uint64_t>& version, const std::string& value) {
+    auto entry = std::make_shared<Entry>();
+    entry->partitions = partitions;
+    entry->version = version;
+    entry->expire_time = ::baidu::common::timer::get_micros() / 1000 + ttl_ms_;
+    if (!version.empty()) {
+        entry->value = value;
+    }
+    Shard& shard = GetShard(key);
+    std::lock_guard<std::mutex> lock(shard.mu);
+    shard.entries.upsert(key, entry);
+}
+
+}  // namespace openmldb::tablet
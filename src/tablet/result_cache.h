@@ -0,0 +1,86 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_TABLET_RESULT_CACHE_H_
+#define SRC_TABLET_RESULT_CACHE_H_
+
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "base/lru_cache.h"
+#include "bvar/bvar.h"
+
+namespace openmldb::tablet {
+
+// ResultCache keeps the output rows of a deployment in request mode, keyed by
+// the bytes of the request row. Every result is stored with the partitions it
+// reads and their version, which is the binlog offset and the record count of
+// the partitions read before the run. A request row reads the same partitions
+// every time, so the partitions are learnt by its first run and the result is
+// stored from the next run. A result is returned only if the version is not
+// changed and it is not expired, so a write after the version is read makes
+// the result a miss instead of a stale hit.
+class ResultCache {
+ public:
+    ResultCache(const std::string& db, const std::string& sp_name, uint64_t ttl_ms, uint32_t max_entries);
+    ResultCache(const ResultCache&) = delete;
+    ResultCache& operator=(const ResultCache&) = delete;
+
+    // get the partitions the result of key reads, (tid << 32) | pid in ascending order
+    bool GetPartitions(const std::string& key, std::vector<uint64_t>* partitions);
+
+    // return true and set the output row if hit, an empty version is never a hit
+    bool Get(const std::string& key, const std::vector<uint64_t>& partitions, const std::vector<uint64_t>& version,
+             std::string* value);
+
+    // an empty version keeps only the partitions, for the version read before the next run
+    void Put(const std::string& key, const std::vector<uint64_t>& partitions, const std::vector<uint64_t>& version,
+             const std::string& value);
+
+    int64_t GetHitCnt() const { return hit_cnt_.get_value(); }
+    int64_t GetMissCnt() const { return miss_cnt_.get_value(); }
+    int64_t GetInvalidationCnt() const { return invalidation_cnt_.get_value(); }
+
+ private:
+    struct Entry {
+        std::vector<uint64_t> partitions;
+        std::vector<uint64_t> version;
+        uint64_t expire_time;
+        std::string value;
+    };
+
+    struct Shard {
+        explicit Shard(uint32_t capacity) : mu(), entries(capacity) {}
+        std::mutex mu;
+        ::openmldb::base::lru_cache<std::string, std::shared_ptr<Entry>> entries;
+    };
+
+    Shard& GetShard(const std::string& key);
+    std::shared_ptr<Entry> GetEntry(const std::string& key);
+
+    uint64_t ttl_ms_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    bvar::Adder<int64_t> hit_cnt_;
+    bvar::Adder<int64_t> miss_cnt_;
+    // the misses caused by the changed data
+    bvar::Adder<int64_t> invalidation_cnt_;
+};
+
+}  // namespace openmldb::tablet
+
+#endif  // SRC_TABLET_RESULT_CACHE_H_
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tablet/result_cache.h"
+
+#include <chrono>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace openmldb {
+namespace tablet {
+
+class ResultCacheTest : public ::testing::Test {
+ public:
+    ResultCacheTest() {}
+    ~ResultCacheTest() {}
+};
+
+TEST_F(ResultCacheTest, Version) {
+    ResultCache cache("db1", "sp_version", 100000, 100);
+    std::vector<uint64_t> partitions = {(1ull << 32) | 0};
+    std::vector<uint64_t> version = {10, 5};
+    std::string value;
+    ASSERT_FALSE(cache.GetPartitions("row1", &partitions));
+    ASSERT_FALSE(cache.Get("row1", partitions, version, &value));
+    cache.Put("row1", partitions, version, "output1");
+    ASSERT_TRUE(cache.Get("row1", partitions, version, &value));
+    ASSERT_EQ("output1", value);
+    ASSERT_FALSE(cache.Get("row2", partitions, version, &value));
+    // the table is updated
+    std::vector<uint64_t> new_version = {11, 6};
+    ASSERT_FALSE(cache.Get("row1", partitions, new_version, &value));
+    cache.Put("row1", partitions, new_version, "output2");
+    ASSERT_TRUE(cache.Get("row1", partitions, new_version, &value));
+    ASSERT_EQ("output2", value);
+    ASSERT_EQ(2, cache.GetHitCnt());
+    ASSERT_EQ(3, cache.GetMissCnt());
+    ASSERT_EQ(1, cache.GetInvalidationCnt());
+}
+
+TEST_F(ResultCacheTest, Partitions) {
+    ResultCache cache("db1", "sp_partitions", 100000, 100);
+    std::vector<uint64_t> partitions = {(1ull << 32) | 3, (2ull << 32) | 0};
+    std::string value;
+    // the first run only learns the partitions
+    cache.Put("row1", partitions, {}, "output1");
+    std::vector<uint64_t> learnt;
+    ASSERT_TRUE(cache.GetPartitions("row1", &learnt));
+    ASSERT_EQ(partitions, learnt);
+    std::vector<uint64_t> version = {10, 5, 7, 2};
+    ASSERT_FALSE(cache.Get("row1", learnt, version, &value));
+    ASSERT_FALSE(cache.Get("row1", learnt, {}, &value));
+    ASSERT_EQ(0, cache.GetInvalidationCnt());
+    cache.Put("row1", learnt, version, "output1");
+    ASSERT_TRUE(cache.Get("row1", learnt, version, &value));
+    ASSERT_EQ("output1", value);
+    // the same version of other partitions is not a hit
+    std::vector<uint64_t> other_partitions = {(1ull << 32) | 4, (2ull << 32) | 0};
+    ASSERT_FALSE(cache.Get("row1", other_partitions, version, &value));
+    ASSERT_EQ(1, cache.GetInvalidationCnt());
+}
+
+TEST_F(ResultCacheTest, Expire) {
+    ResultCache cache("db1", "sp_expire", 10, 100);
+    std::vector<uint64_t> partitions = {1};
+    std::vector<uint64_t> version = {1, 1};
+    std::string value;
+    cache.Put("row1", partitions, version, "output1");
+    ASSERT_TRUE(cache.Get("row1", partitions, version, &value));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    ASSERT_FALSE(cache.Get("row1", partitions, version, &value));
+    ASSERT_FALSE(cache.GetPartitions("row1", &partitions));
+    ASSERT_EQ(0, cache.GetInvalidationCnt());
+}
+
+TEST_F(ResultCacheTest, Evict) {
+    // one entry in every shard
+    ResultCache cache("db1", "sp_evict", 100000, 1);
+    std::vector<uint64_t> partitions = {1};
+    std::vector<uint64_t> version = {1, 1};
+    for (int i = 0; i < 1000; i++) {
+        cache.Put("row" + std::to_string(i), partitions, version, "output" + std::to_string(i));
+    }
+    std::string value;
+    uint32_t cnt = 0;
+    for (int i = 0; i < 1000; i++) {
+        if (cache.Get("row" + std::to_string(i), partitions, version, &value)) {
+            ASSERT_EQ("output" + std::to_string(i), value);
+            cnt++;
+        }
+    }
+    ASSERT_GT(cnt, 0u);
+    ASSERT_LE(cnt, 16u);
+    ASSERT_TRUE(cache.Get("row999", partitions, version, &value));
+}
+
+}  // namespace tablet
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
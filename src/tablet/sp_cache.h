@@ -21,6 +21,7 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include "tablet/result_cache.h"
 #include "vm/engine.h"
 
 namespace openmldb {
@@ -33,11 +34,14 @@ struct SQLProcedureCacheEntry {
     std::shared_ptr<hybridse::sdk::ProcedureInfo> procedure_info;
     std::shared_ptr<hybridse::vm::CompileInfo> request_info;
     std::shared_ptr<hybridse::vm::CompileInfo> batch_request_info;
+    // null if the results of the procedure are not cached
+    std::shared_ptr<ResultCache> result_cache;
 
     SQLProcedureCacheEntry(const std::shared_ptr<hybridse::sdk::ProcedureInfo> pinfo,
                            std::shared_ptr<hybridse::vm::CompileInfo> rinfo,
-                           std::shared_ptr<hybridse::vm::CompileInfo> brinfo)
-        : procedure_info(pinfo), request_info(rinfo), batch_request_info(brinfo) {}
+                           std::shared_ptr<hybridse::vm::CompileInfo> brinfo,
+                           std::shared_ptr<ResultCache> rcache)
+        : procedure_info(pinfo), request_info(rinfo), batch_request_info(brinfo), result_cache(rcache) {}
 };
 
 class SpCache : public hybridse::vm::CompileInfoCache {
@@ -47,11 +51,12 @@ class SpCache : public hybridse::vm::CompileInfoCache {
     void InsertSQLProcedureCacheEntry(const std::string& db, const std::string& sp_name,
                                       std::shared_ptr<hybridse::sdk::ProcedureInfo> procedure_info,
                                       std::shared_ptr<hybridse::vm::CompileInfo> request_info,
-                                      std::shared_ptr<hybridse::vm::CompileInfo> batch_request_info) {
+                                      std::shared_ptr<hybridse::vm::CompileInfo> batch_request_info,
+                                      std::shared_ptr<ResultCache> result_cache = std::shared_ptr<ResultCache>()) {
         std::lock_guard<SpinMutex> spin_lock(spin_mutex_);
         auto& sp_map_of_db = db_sp_map_[db];
-        sp_map_of_db.insert(
-            std::make_pair(sp_name, SQLProcedureCacheEntry(procedure_info, request_info, batch_request_info)));
+        sp_map_of_db.insert(std::make_pair(
+            sp_name, SQLProcedureCacheEntry(procedure_info, request_info, batch_request_info, result_cache)));
     }
 
     void DropSQLProcedureCacheEntry(const std::string& db, const std::string& sp_name) {
@@ -111,6 +116,19 @@ class SpCache : public hybridse::vm::CompileInfoCache {
         return sp_it->second.batch_request_info;
     }
 
+    std::shared_ptr<ResultCache> GetResultCache(const std::string& db, const std::string& sp_name) {
+        std::lock_guard<SpinMutex> spin_lock(spin_mutex_);
+        auto db_it = db_sp_map_.find(db);
+        if (db_it == db_sp_map_.end()) {
+            return std::shared_ptr<ResultCache>();
+        }
+        auto sp_it = db_it->second.find(sp_name);
+        if (sp_it == db_it->second.end()) {
+            return std::shared_ptr<ResultCache>();
+        }
+        return sp_it->second.result_cache;
+    }
+
  private:
     std::map<std::string, std::map<std::string, SQLProcedureCacheEntry>> db_sp_map_;
     SpinMutex spin_mutex_;
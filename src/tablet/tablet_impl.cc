@@ -44,6 +44,8 @@
 #include "base/status.h"
 #include "base/strings.h"
 #include "brpc/controller.h"
+#include "brpc/stream.h"
+#include "bthread/condition_variable.h"
 #include "butil/iobuf.h"
 #include "codec/codec.h"
 #include "codec/row_codec.h"
@@ -53,6 +55,7 @@
 #include "schema/schema_adapter.h"
 #include "storage/binlog.h"
 #include "storage/segment.h"
+#include "tablet/bthread_worker_pool.h"
 #include "tablet/file_sender.h"
 
 using google::protobuf::RepeatedPtrField;
@@ -66,6 +69,9 @@ DECLARE_int32(gc_pool_size);
 DECLARE_int32(statdb_ttl);
 DECLARE_uint32(scan_max_bytes_size);
 DECLARE_uint32(scan_reserve_size);
+DECLARE_uint32(query_stream_chunk_size);
+DECLARE_uint32(query_stream_max_buf_size);
+DECLARE_uint32(query_stream_wait_timeout);
 DECLARE_double(mem_release_rate);
 DECLARE_string(db_root_path);
 DECLARE_bool(binlog_notify_on_put);
@@ -103,6 +109,12 @@ DECLARE_uint32(snapshot_ttl_check_interval);
 DECLARE_uint32(put_slow_log_threshold);
 DECLARE_uint32(query_slow_log_threshold);
 DECLARE_int32(snapshot_pool_size);
+DECLARE_uint32(result_cache_max_entries);
+DECLARE_bool(enable_sql_normalize);
+DECLARE_string(jit_object_cache_dir);
+DECLARE_uint32(jit_object_cache_max_mb);
+DECLARE_uint32(sql_branch_parallelism);
+DECLARE_int32(follower_read_max_silent_time);
 
 namespace openmldb {
 namespace tablet {
@@ -113,14 +125,15 @@ static const uint32_t SEED = 0xe17a1465;
 TabletImpl::TabletImpl()
     : tables_(),
       mu_(),
-      gc_pool_(FLAGS_gc_pool_size),
+      gc_pool_(FLAGS_gc_pool_size, "tablet_gc_pool"),
       replicators_(),
       snapshots_(),
+      cache_partitions_(std::make_shared<std::map<uint64_t, CachePartition>>()),
       zk_client_(NULL),
       keep_alive_pool_(1),
-      task_pool_(FLAGS_task_pool_size),
+      task_pool_(FLAGS_task_pool_size, "tablet_task_pool"),
       io_pool_(FLAGS_io_pool_size),
-      snapshot_pool_(FLAGS_snapshot_pool_size),
+      snapshot_pool_(FLAGS_snapshot_pool_size, "tablet_snapshot_pool"),
       mode_root_paths_(),
       mode_recycle_root_paths_(),
       follower_(false),
@@ -179,7 +192,25 @@ bool TabletImpl::Init(const std::string& zk_cluster, const std::string& zk_path,
     } else {
         options.SetClusterOptimized(false);
     }
+    options.SetEnableSqlNormalize(FLAGS_enable_sql_normalize);
+    options.jit_options().SetObjectCacheDir(FLAGS_jit_object_cache_dir);
+    options.jit_options().SetObjectCacheMaxBytes(static_cast<uint64_t>(FLAGS_jit_object_cache_max_mb) * 1024 * 1024);
+    options.SetBranchParallelism(FLAGS_sql_branch_parallelism);
+    // the queries run in bthreads, wait for the parallel branches without
+    // blocking the worker thread
+    static BthreadWorkerPool worker_pool;
+    ::hybridse::vm::WorkerPool::SetInstance(&worker_pool);
     engine_ = std::unique_ptr<::hybridse::vm::Engine>(new ::hybridse::vm::Engine(catalog_, options));
+    engine_stats_.emplace_back(
+        new bvar::PassiveStatus<double>("tablet_sql_cache_hit_rate", &TabletImpl::GetSqlCacheHitRate, this));
+    engine_stats_.emplace_back(
+        new bvar::PassiveStatus<double>("tablet_sql_compile_latency_us", &TabletImpl::GetSqlCompileLatency, this));
+    engine_stats_.emplace_back(new bvar::PassiveStatus<int64_t>("tablet_sql_compile_max_latency_us",
+                                                                &TabletImpl::GetSqlCompileMaxLatency, this));
+    engine_stats_.emplace_back(new bvar::PassiveStatus<int64_t>("tablet_sql_compile_dedup_count",
+                                                                &TabletImpl::GetSqlCompileDedupCnt, this));
+    engine_stats_.emplace_back(
+        new bvar::PassiveStatus<int64_t>("tablet_sql_normalized_count", &TabletImpl::GetSqlNormalizedCnt, this));
     catalog_->SetLocalTablet(
         std::shared_ptr<::hybridse::vm::Tablet>(new ::hybridse::vm::LocalTablet(engine_.get(), sp_cache_)));
     std::set<std::string> snapshot_compression_set{"off", "zlib", "snappy"};
@@ -213,10 +244,12 @@ bool TabletImpl::Init(const std::string& zk_cluster, const std::string& zk_path,
         return false;
     }
 
-    snapshot_pool_.DelayTask(FLAGS_make_snapshot_check_interval, boost::bind(&TabletImpl::SchedMakeSnapshot, this));
-    task_pool_.AddTask(boost::bind(&TabletImpl::GetDiskused, this));
+    snapshot_pool_.DelayTask(FLAGS_make_snapshot_check_interval, boost::bind(&TabletImpl::SchedMakeSnapshot, this),
+                             ::openmldb::base::TaskPriority::kBackground);
+    task_pool_.AddTask(boost::bind(&TabletImpl::GetDiskused, this), ::openmldb::base::TaskPriority::kBackground);
     if (FLAGS_recycle_ttl != 0) {
-        task_pool_.DelayTask(FLAGS_recycle_ttl * 60 * 1000, boost::bind(&TabletImpl::SchedDelRecycle, this));
+        task_pool_.DelayTask(FLAGS_recycle_ttl * 60 * 1000, boost::bind(&TabletImpl::SchedDelRecycle, this),
+                             ::openmldb::base::TaskPriority::kBackground);
     }
 #ifdef TCMALLOC_ENABLE
     MallocExtension* tcmalloc = MallocExtension::instance();
@@ -641,6 +674,7 @@ void TabletImpl::Put(RpcController* controller, const ::openmldb::api::PutReques
             entry.mutable_ts_dimensions()->CopyFrom(request->ts_dimensions());
         }
         replicator->AppendEntry(entry);
+        UpdateAggrs(request->tid(), request->pid(), entry);
     } while (false);
 
     uint64_t end_time = ::baidu::common::timer::get_micros();
@@ -670,6 +704,95 @@ void TabletImpl::Put(RpcController* controller, const ::openmldb::api::PutReques
     }
 }
 
+void TabletImpl::PutBatch(RpcController* controller, const ::openmldb::api::PutBatchRequest* request,
+                          ::openmldb::api::PutBatchResponse* response, Closure* done) {
+    brpc::ClosureGuard done_guard(done);
+    if (follower_.load(std::memory_order_relaxed)) {
+        response->set_code(::openmldb::base::ReturnCode::kIsFollowerCluster);
+        response->set_msg("is follower cluster");
+        return;
+    }
+    uint64_t start_time = ::baidu::common::timer::get_micros();
+    uint32_t tid = request->tid();
+    uint32_t pid = request->pid();
+    std::shared_ptr<Table> table = GetTable(tid, pid);
+    if (!table) {
+        PDLOG(WARNING, "table is not exist. tid %u, pid %u", tid, pid);
+        response->set_code(::openmldb::base::ReturnCode::kTableIsNotExist);
+        response->set_msg("table is not exist");
+        return;
+    }
+    if (!table->IsLeader()) {
+        response->set_code(::openmldb::base::ReturnCode::kTableIsFollower);
+        response->set_msg("table is follower");
+        return;
+    }
+    if (table->GetTableStat() == ::openmldb::storage::kLoading) {
+        PDLOG(WARNING, "table is loading. tid %u, pid %u", tid, pid);
+        response->set_code(::openmldb::base::ReturnCode::kTableIsLoading);
+        response->set_msg("table is loading");
+        return;
+    }
+    std::shared_ptr<LogReplicator> replicator = GetReplicator(tid, pid);
+    if (!replicator) {
+        PDLOG(WARNING, "fail to find table tid %u pid %u leader's log replicator", tid, pid);
+    }
+    std::vector<::openmldb::api::LogEntry> entries;
+    entries.reserve(request->rows_size());
+    uint32_t failed_cnt = 0;
+    for (const auto& row : request->rows()) {
+        int32_t code = ::openmldb::base::ReturnCode::kOk;
+        if (row.dimensions_size() == 0 || CheckDimessionPut(&row, table->GetIdxCnt()) != 0) {
+            code = ::openmldb::base::ReturnCode::kInvalidDimensionParameter;
+        } else if (!table->Put(row.time(), row.value(), row.dimensions())) {
+            code = ::openmldb::base::ReturnCode::kPutFailed;
+        }
+        response->add_row_code(code);
+        if (code != ::openmldb::base::ReturnCode::kOk) {
+            failed_cnt++;
+            continue;
+        }
+        if (replicator) {
+            entries.emplace_back();
+            ::openmldb::api::LogEntry& entry = entries.back();
+            entry.set_pk(row.pk());
+            entry.set_ts(row.time());
+            entry.set_value(row.value());
+            entry.mutable_dimensions()->CopyFrom(row.dimensions());
+            if (row.ts_dimensions_size() > 0) {
+                entry.mutable_ts_dimensions()->CopyFrom(row.ts_dimensions());
+            }
+        }
+    }
+    if (replicator && !entries.empty()) {
+        uint64_t term = replicator->GetLeaderTerm();
+        for (auto& entry : entries) {
+            entry.set_term(term);
+        }
+        if (!replicator->AppendEntryBatch(&entries)) {
+            PDLOG(WARNING, "fail to append %lu entries to binlog. tid %u pid %u", entries.size(), tid, pid);
+        } else {
+            for (const auto& entry : entries) {
+                UpdateAggrs(tid, pid, entry);
+            }
+        }
+    }
+    if (failed_cnt > 0) {
+        response->set_msg("put failed for " + std::to_string(failed_cnt) + " rows");
+    }
+    response->set_code(::openmldb::base::ReturnCode::kOk);
+    uint64_t end_time = ::baidu::common::timer::get_micros();
+    if (start_time + FLAGS_put_slow_log_threshold < end_time) {
+        PDLOG(INFO, "slow log[put batch]. rows %d time %lu. tid %u, pid %u", request->rows_size(),
+              end_time - start_time, tid, pid);
+    }
+    // response the client before notify replicators
+    done_guard.release()->Run();
+    if (replicator && !entries.empty() && FLAGS_binlog_notify_on_put) {
+        replicator->Notify();
+    }
+}
+
 int TabletImpl::CheckTableMeta(const openmldb::api::TableMeta* table_meta, std::string& msg) {
     msg.clear();
     if (table_meta->name().empty()) {
@@ -1480,50 +1603,238 @@ void TabletImpl::Query(RpcController* ctrl, const openmldb::api::QueryRequest* r
     DLOG(INFO) << "handle query request begin!";
     brpc::ClosureGuard done_guard(done);
     brpc::Controller* cntl = static_cast<brpc::Controller*>(ctrl);
+    if (request->is_batch() && request->stream()) {
+        ProcessStreamQuery(cntl, request, response, done_guard.release());
+        return;
+    }
     butil::IOBuf& buf = cntl->response_attachment();
     ProcessQuery(ctrl, request, response, &buf);
 }
 
-void TabletImpl::ProcessQuery(RpcController* ctrl, const openmldb::api::QueryRequest* request,
-                              ::openmldb::api::QueryResponse* response, butil::IOBuf* buf) {
-    ::hybridse::base::Status status;
-    if (request->is_batch()) {
-        // convert repeated openmldb:type::DataType into hybridse::codec::Schema
-        hybridse::codec::Schema parameter_schema;
-        for (int i = 0; i < request->parameter_types().size(); i++) {
-            auto column = parameter_schema.Add();
-            hybridse::type::Type hybridse_type;
-
-            if (!openmldb::schema::SchemaAdapter::ConvertType(request->parameter_types(i), &hybridse_type)) {
-                response->set_msg("Invalid parameter type: " +
-                                  openmldb::type::DataType_Name(request->parameter_types(i)));
-                response->set_code(::openmldb::base::kSQLCompileError);
-                return;
-            }
-            column->set_type(hybridse_type);
+bool TabletImpl::PrepareBatchQuery(RpcController* ctrl, const openmldb::api::QueryRequest* request,
+                                   ::openmldb::api::QueryResponse* response, ::hybridse::vm::BatchRunSession* session,
+                                   ::hybridse::codec::Row* parameter_row) {
+    // convert repeated openmldb:type::DataType into hybridse::codec::Schema
+    hybridse::codec::Schema parameter_schema;
+    for (int i = 0; i < request->parameter_types().size(); i++) {
+        auto column = parameter_schema.Add();
+        hybridse::type::Type hybridse_type;
+
+        if (!openmldb::schema::SchemaAdapter::ConvertType(request->parameter_types(i), &hybridse_type)) {
+            response->set_msg("Invalid parameter type: " +
+                              openmldb::type::DataType_Name(request->parameter_types(i)));
+            response->set_code(::openmldb::base::kSQLCompileError);
+            return false;
         }
-        ::hybridse::vm::BatchRunSession session;
-        if (request->is_debug()) {
-            session.EnableDebug();
+        column->set_type(hybridse_type);
+    }
+    if (request->is_debug()) {
+        session->EnableDebug();
+    }
+    session->SetParameterSchema(parameter_schema);
+    {
+        ::hybridse::base::Status status;
+        bool ok = engine_->Get(request->sql(), request->db(), *session, status);
+        if (!ok) {
+            response->set_msg(status.msg);
+            response->set_code(::openmldb::base::kSQLCompileError);
+            DLOG(WARNING) << "fail to compile sql " << request->sql() << ", message: " << status.msg;
+            return false;
         }
-        session.SetParameterSchema(parameter_schema);
-        {
-            bool ok = engine_->Get(request->sql(), request->db(), session, status);
-            if (!ok) {
-                response->set_msg(status.msg);
-                response->set_code(::openmldb::base::kSQLCompileError);
-                DLOG(WARNING) << "fail to compile sql " << request->sql() << ", message: " << status.msg;
-                return;
+    }
+
+    auto& request_buf = static_cast<brpc::Controller*>(ctrl)->request_attachment();
+    if (request->parameter_row_size() > 0 &&
+        !codec::DecodeRpcRow(request_buf, 0, request->parameter_row_size(), request->parameter_row_slices(),
+                             parameter_row)) {
+        response->set_code(::openmldb::base::kSQLRunError);
+        response->set_msg("fail to decode parameter row");
+        return false;
+    }
+    return true;
+}
+
+// QueryStreamWindow receives the credits the client writes after consuming
+// the chunks, so no more than the chunks granted are sent. It is released
+// once the stream is closed and the writer drops it
+class QueryStreamWindow : public brpc::StreamInputHandler {
+ public:
+    static std::shared_ptr<QueryStreamWindow> Create(uint32_t max_chunks) {
+        std::shared_ptr<QueryStreamWindow> window(new QueryStreamWindow(max_chunks));
+        window->self_ = window;
+        return window;
+    }
+
+    int on_received_messages(brpc::StreamId id, butil::IOBuf* const messages[], size_t size) override {
+        uint64_t credits = 0;
+        for (size_t i = 0; i < size; i++) {
+            uint32_t credit = 0;
+            while (messages[i]->cutn(&credit, sizeof(credit)) == sizeof(credit)) {
+                credits += credit;
             }
         }
+        std::lock_guard<bthread::Mutex> lock(mu_);
+        granted_ += credits;
+        cv_.notify_all();
+        return 0;
+    }
+
+    void on_idle_timeout(brpc::StreamId id) override {}
+
+    void on_closed(brpc::StreamId id) override {
+        std::shared_ptr<QueryStreamWindow> self;
+        std::lock_guard<bthread::Mutex> lock(mu_);
+        closed_ = true;
+        cv_.notify_all();
+        self.swap(self_);
+    }
+
+    // wait until one more chunk is granted, return false if the stream is
+    // closed or the client does not consume in timeout_ms
+    bool Acquire(uint32_t timeout_ms) {
+        std::unique_lock<bthread::Mutex> lock(mu_);
+        timespec due_time = butil::milliseconds_from_now(timeout_ms);
+        while (sent_ >= granted_ && !closed_) {
+            if (cv_.wait_until(lock, due_time) == ETIMEDOUT) {
+                break;
+            }
+        }
+        if (sent_ >= granted_ || closed_) {
+            return false;
+        }
+        sent_++;
+        return true;
+    }
+
+    // the stream is not accepted and on_closed is never called
+    void Release() {
+        std::lock_guard<bthread::Mutex> lock(mu_);
+        self_.reset();
+    }
+
+ private:
+    explicit QueryStreamWindow(uint32_t max_chunks) : granted_(max_chunks), sent_(0), closed_(false) {}
+
+    bthread::Mutex mu_;
+    bthread::ConditionVariable cv_;
+    uint64_t granted_;
+    uint64_t sent_;
+    bool closed_;
+    std::shared_ptr<QueryStreamWindow> self_;
+};
+
+static bool WriteQueryStream(brpc::StreamId stream_id, const ::openmldb::api::QueryStreamMeta& meta,
+                             butil::IOBuf* rows) {
+    std::string meta_buf;
+    meta.SerializeToString(&meta_buf);
+    uint32_t meta_size = meta_buf.size();
+    butil::IOBuf message;
+    message.append(&meta_size, sizeof(meta_size));
+    message.append(meta_buf);
+    message.append(butil::IOBuf::Movable(*rows));
+    while (true) {
+        int ret = brpc::StreamWrite(stream_id, message);
+        if (ret == 0) {
+            return true;
+        }
+        if (ret != EAGAIN) {
+            PDLOG(WARNING, "fail to write stream %lu, ret %d", stream_id, ret);
+            return false;
+        }
+        // the client has not consumed the rows sent
+        timespec due_time = butil::milliseconds_from_now(FLAGS_query_stream_wait_timeout);
+        ret = brpc::StreamWait(stream_id, &due_time);
+        if (ret != 0) {
+            PDLOG(WARNING, "fail to wait stream %lu, ret %d", stream_id, ret);
+            return false;
+        }
+    }
+}
+
+void TabletImpl::ProcessStreamQuery(brpc::Controller* cntl, const openmldb::api::QueryRequest* request,
+                                    ::openmldb::api::QueryResponse* response, Closure* done) {
+    brpc::ClosureGuard done_guard(done);
+    ::hybridse::vm::BatchRunSession session;
+    ::hybridse::codec::Row parameter_row;
+    if (!PrepareBatchQuery(cntl, request, response, &session, &parameter_row)) {
+        return;
+    }
+    brpc::StreamId stream_id;
+    brpc::StreamOptions options;
+    options.max_buf_size = FLAGS_query_stream_max_buf_size;
+    // the client without stream_max_chunks is only held back by max_buf_size
+    std::shared_ptr<QueryStreamWindow> window;
+    if (request->stream_max_chunks() > 0) {
+        window = QueryStreamWindow::Create(request->stream_max_chunks());
+        options.handler = window.get();
+    }
+    if (brpc::StreamAccept(&stream_id, *cntl, &options) != 0) {
+        if (window) {
+            window->Release();
+        }
+        response->set_code(::openmldb::base::kSQLRunError);
+        response->set_msg("fail to accept stream");
+        PDLOG(WARNING, "fail to accept stream for sql %s", request->sql().c_str());
+        return;
+    }
+    response->set_schema(session.GetEncodedSchema());
+    response->set_code(::openmldb::base::kOk);
+    // the request is released with the controller once the response is sent
+    const std::string sql = request->sql();
+    // the stream can be written after the response is sent
+    done_guard.reset(NULL);
 
+    ::openmldb::api::QueryStreamMeta meta;
+    butil::IOBuf rows;
+    uint32_t count = 0;
+    uint64_t byte_size = 0;
+    bool stream_ok = true;
+    int32_t run_ret = session.Run(parameter_row, [&](const ::hybridse::codec::Row& row) {
+        codec::AppendRpcRowSlice(row, 0, &rows);
+        meta.set_count(meta.count() + 1);
+        if (rows.size() >= FLAGS_query_stream_chunk_size) {
+            meta.set_byte_size(rows.size());
+            count += meta.count();
+            byte_size += rows.size();
+            stream_ok = (!window || window->Acquire(FLAGS_query_stream_wait_timeout)) &&
+                        WriteQueryStream(stream_id, meta, &rows);
+            meta.Clear();
+        }
+        return stream_ok;
+    });
+    if (stream_ok && !rows.empty()) {
+        meta.set_byte_size(rows.size());
+        count += meta.count();
+        byte_size += rows.size();
+        stream_ok = (!window || window->Acquire(FLAGS_query_stream_wait_timeout)) &&
+                    WriteQueryStream(stream_id, meta, &rows);
+    }
+    if (stream_ok) {
+        meta.Clear();
+        meta.set_is_finish(true);
+        meta.set_count(count);
+        meta.set_byte_size(byte_size);
+        if (run_ret != 0) {
+            meta.set_code(::openmldb::base::kSQLRunError);
+            meta.set_msg("fail to run sql");
+            DLOG(WARNING) << "fail to run sql: " << sql;
+        } else {
+            meta.set_code(::openmldb::base::kOk);
+        }
+        WriteQueryStream(stream_id, meta, &rows);
+    }
+    brpc::StreamClose(stream_id);
+    DLOG(INFO) << "handle stream sql " << sql << " with record cnt " << count << " byte size "
+               << byte_size;
+}
+
+void TabletImpl::ProcessQuery(RpcController* ctrl, const openmldb::api::QueryRequest* request,
+                              ::openmldb::api::QueryResponse* response, butil::IOBuf* buf) {
+    ::hybridse::base::Status status;
+    if (request->is_batch()) {
+        ::hybridse::vm::BatchRunSession session;
         ::hybridse::codec::Row parameter_row;
-        auto& request_buf = static_cast<brpc::Controller*>(ctrl)->request_attachment();
-        if (request->parameter_row_size() > 0 &&
-            !codec::DecodeRpcRow(request_buf, 0, request->parameter_row_size(), request->parameter_row_slices(),
-                                 &parameter_row)) {
-            response->set_code(::openmldb::base::kSQLRunError);
-            response->set_msg("fail to decode parameter row");
+        if (!PrepareBatchQuery(ctrl, request, response, &session, &parameter_row)) {
             return;
         }
         std::vector<::hybridse::codec::Row> output_rows;
@@ -1546,7 +1857,7 @@ void TabletImpl::ProcessQuery(RpcController* ctrl, const openmldb::api::QueryReq
                 return;
             }
             byte_size += output_row.size();
-            buf->append(reinterpret_cast<void*>(output_row.buf()), output_row.size());
+            codec::AppendRpcRowSlice(output_row, 0, buf);
             count += 1;
         }
         response->set_schema(session.GetEncodedSchema());
@@ -1576,7 +1887,8 @@ void TabletImpl::ProcessQuery(RpcController* ctrl, const openmldb::api::QueryReq
             }
             session.SetCompileInfo(request_compile_info);
             session.SetSpName(sp_name);
-            RunRequestQuery(ctrl, *request, session, *response, *buf);
+            auto result_cache = sp_cache_->GetResultCache(db_name, sp_name);
+            RunRequestQuery(ctrl, *request, session, *response, *buf, result_cache.get());
         } else {
             bool ok = engine_->Get(request->sql(), request->db(), session, status);
             if (!ok || session.GetCompileInfo() == nullptr) {
@@ -1678,7 +1990,7 @@ void TabletImpl::ProcessBatchRequestQuery(RpcController* ctrl,
     if (has_common_and_uncommon_row) {
         size_t common_size = request->row_sizes().Get(0);
         ::hybridse::codec::Row common_row;
-        if (!codec::DecodeRpcRow(io_buf, buf_offset, common_size, request->common_slices(), &common_row)) {
+        if (!codec::DecodeRpcRowRef(io_buf, buf_offset, common_size, request->common_slices(), &common_row)) {
             response->set_msg("decode input common row failed");
             response->set_code(::openmldb::base::kSQLRunError);
             return;
@@ -1687,8 +1999,8 @@ void TabletImpl::ProcessBatchRequestQuery(RpcController* ctrl,
         for (size_t i = 0; i < input_row_num; ++i) {
             ::hybridse::codec::Row non_common_row;
             size_t non_common_size = request->row_sizes().Get(i + 1);
-            if (!codec::DecodeRpcRow(io_buf, buf_offset, non_common_size, request->non_common_slices(),
-                                     &non_common_row)) {
+            if (!codec::DecodeRpcRowRef(io_buf, buf_offset, non_common_size, request->non_common_slices(),
+                                        &non_common_row)) {
                 response->set_msg("decode input non common row failed");
                 response->set_code(::openmldb::base::kSQLRunError);
                 return;
@@ -1699,8 +2011,8 @@ void TabletImpl::ProcessBatchRequestQuery(RpcController* ctrl,
     } else {
         for (size_t i = 0; i < input_row_num; ++i) {
             size_t non_common_size = request->row_sizes().Get(i);
-            if (!codec::DecodeRpcRow(io_buf, buf_offset, non_common_size, request->non_common_slices(),
-                                     &input_rows[i])) {
+            if (!codec::DecodeRpcRowRef(io_buf, buf_offset, non_common_size, request->non_common_slices(),
+                                        &input_rows[i])) {
                 response->set_msg("decode input non common row failed");
                 response->set_code(::openmldb::base::kSQLRunError);
                 return;
@@ -1736,7 +2048,7 @@ void TabletImpl::ProcessBatchRequestQuery(RpcController* ctrl,
             LOG(WARNING) << "illegal row ptrs: expect 2";
             return;
         }
-        buf.append(first_row.buf(0), first_row.size(0));
+        codec::AppendRpcRowSlice(first_row, 0, &buf);
         response->add_row_sizes(first_row.size(0));
         response->set_common_slices(1);
     } else {
@@ -1751,7 +2063,7 @@ void TabletImpl::ProcessBatchRequestQuery(RpcController* ctrl,
                 LOG(WARNING) << "illegal row ptrs: expect 2";
                 return;
             }
-            buf.append(output_row.buf(1), output_row.size(1));
+            codec::AppendRpcRowSlice(output_row, 1, &buf);
             response->add_row_sizes(output_row.size(1));
         } else {
             if (output_row.GetRowPtrCnt() != 1) {
@@ -1760,7 +2072,7 @@ void TabletImpl::ProcessBatchRequestQuery(RpcController* ctrl,
                 LOG(WARNING) << "illegal row ptrs: expect 1";
                 return;
             }
-            buf.append(output_row.buf(0), output_row.size(0));
+            codec::AppendRpcRowSlice(output_row, 0, &buf);
             response->add_row_sizes(output_row.size(0));
         }
     }
@@ -2040,6 +2352,9 @@ void TabletImpl::AppendEntries(RpcController* controller, const ::openmldb::api:
     }
     response->set_code(::openmldb::base::ReturnCode::kOk);
     response->set_msg("ok");
+    if (request->has_leader_offset()) {
+        replicator->SetLeaderOffset(request->leader_offset());
+    }
     uint64_t last_log_offset = replicator->GetOffset();
     if (request->pre_log_index() == 0 && request->entries_size() == 0) {
         response->set_log_offset(last_log_offset);
@@ -2390,7 +2705,8 @@ void TabletImpl::MakeSnapshot(RpcController* controller, const ::openmldb::api::
 void TabletImpl::SchedMakeSnapshot() {
     int now_hour = ::openmldb::base::GetNowHour();
     if (now_hour != FLAGS_make_snapshot_time) {
-        snapshot_pool_.DelayTask(FLAGS_make_snapshot_check_interval, boost::bind(&TabletImpl::SchedMakeSnapshot, this));
+        snapshot_pool_.DelayTask(FLAGS_make_snapshot_check_interval, boost::bind(&TabletImpl::SchedMakeSnapshot, this),
+                                 ::openmldb::base::TaskPriority::kBackground);
         return;
     }
     std::vector<std::pair<uint32_t, uint32_t>> table_set;
@@ -2417,7 +2733,8 @@ void TabletImpl::SchedMakeSnapshot() {
     }
     // delay task one hour later avoid execute  more than one time
     snapshot_pool_.DelayTask(FLAGS_make_snapshot_check_interval + 60 * 60 * 1000,
-                             boost::bind(&TabletImpl::SchedMakeSnapshot, this));
+                             boost::bind(&TabletImpl::SchedMakeSnapshot, this),
+                             ::openmldb::base::TaskPriority::kBackground);
 }
 
 void TabletImpl::SendData(RpcController* controller, const ::openmldb::api::SendDataRequest* request,
@@ -2627,33 +2944,18 @@ void TabletImpl::SendSnapshotInternal(const std::string& endpoint, uint32_t tid,
             break;
         }
         full_path.append("snapshot/");
-        std::string manifest_file = full_path + "MANIFEST";
-        std::string snapshot_file;
-        {
-            int fd = open(manifest_file.c_str(), O_RDONLY);
-            if (fd < 0) {
-                PDLOG(WARNING, "[%s] is not exist", manifest_file.c_str());
-                has_error = false;
-                break;
-            }
-            google::protobuf::io::FileInputStream fileInput(fd);
-            fileInput.SetCloseOnDelete(true);
-            ::openmldb::api::Manifest manifest;
-            if (!google::protobuf::TextFormat::Parse(&fileInput, &manifest)) {
-                PDLOG(WARNING, "parse manifest failed. tid[%u] pid[%u]", tid, pid);
-                break;
-            }
-            snapshot_file = manifest.name();
-        }
-        // send snapshot file
-        if (sender.SendFile(snapshot_file, full_path + snapshot_file) < 0) {
-            PDLOG(WARNING, "send snapshot failed. tid[%u] pid[%u]", tid, pid);
+        std::shared_ptr<Snapshot> snapshot = GetSnapshot(tid, pid);
+        if (!snapshot) {
+            PDLOG(WARNING, "snapshot is not exist. tid[%u] pid[%u]", tid, pid);
             break;
         }
-        // send manifest file
-        file_name = "MANIFEST";
-        if (sender.SendFile(file_name, full_path + file_name) < 0) {
-            PDLOG(WARNING, "send MANIFEST failed. tid[%u] pid[%u]", tid, pid);
+        // a merge of the delta chain deletes the delta files, wait for it and hold it off until the manifest is sent
+        while (!snapshot->TryHold()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        int ret = SendSnapshotFiles(&sender, full_path, tid, pid);
+        snapshot->Release();
+        if (ret < 0) {
             break;
         }
         has_error = false;
@@ -2671,6 +2973,41 @@ void TabletImpl::SendSnapshotInternal(const std::string& endpoint, uint32_t tid,
     sync_snapshot_set_.erase(sync_snapshot_key);
 }
 
+int TabletImpl::SendSnapshotFiles(FileSender* sender, const std::string& snapshot_path, uint32_t tid, uint32_t pid) {
+    std::string manifest_file = snapshot_path + "MANIFEST";
+    std::vector<std::string> snapshot_files;
+    {
+        int fd = open(manifest_file.c_str(), O_RDONLY);
+        if (fd < 0) {
+            PDLOG(WARNING, "[%s] is not exist", manifest_file.c_str());
+            return 0;
+        }
+        google::protobuf::io::FileInputStream fileInput(fd);
+        fileInput.SetCloseOnDelete(true);
+        ::openmldb::api::Manifest manifest;
+        if (!google::protobuf::TextFormat::Parse(&fileInput, &manifest)) {
+            PDLOG(WARNING, "parse manifest failed. tid[%u] pid[%u]", tid, pid);
+            return -1;
+        }
+        snapshot_files.push_back(manifest.name());
+        for (const auto& delta : manifest.deltas()) {
+            snapshot_files.push_back(delta.name());
+        }
+    }
+    // send the base snapshot and delta files before manifest
+    for (const auto& snapshot_file : snapshot_files) {
+        if (sender->SendFile(snapshot_file, snapshot_path + snapshot_file) < 0) {
+            PDLOG(WARNING, "send snapshot %s failed. tid[%u] pid[%u]", snapshot_file.c_str(), tid, pid);
+            return -1;
+        }
+    }
+    if (sender->SendFile("MANIFEST", manifest_file) < 0) {
+        PDLOG(WARNING, "send MANIFEST failed. tid[%u] pid[%u]", tid, pid);
+        return -1;
+    }
+    return 0;
+}
+
 void TabletImpl::PauseSnapshot(RpcController* controller, const ::openmldb::api::GeneralRequest* request,
                                ::openmldb::api::GeneralResponse* response, Closure* done) {
     brpc::ClosureGuard done_guard(done);
@@ -2887,7 +3224,8 @@ int TabletImpl::LoadTableInternal(uint32_t tid, uint32_t pid, std::shared_ptr<::
             io_pool_.DelayTask(FLAGS_binlog_sync_to_disk_interval,
                                boost::bind(&TabletImpl::SchedSyncDisk, this, tid, pid));
             task_pool_.DelayTask(FLAGS_binlog_delete_interval,
-                                 boost::bind(&TabletImpl::SchedDelBinlog, this, tid, pid));
+                                 boost::bind(&TabletImpl::SchedDelBinlog, this, tid, pid),
+                                 ::openmldb::base::TaskPriority::kBackground);
             PDLOG(INFO, "load table success. tid %u pid %u", tid, pid);
             if (task_ptr) {
                 std::lock_guard<std::mutex> lock(mu_);
@@ -2931,6 +3269,7 @@ int32_t TabletImpl::DeleteTableInternal(uint32_t tid, uint32_t pid,
             tables_[tid].erase(pid);
             replicators_[tid].erase(pid);
             snapshots_[tid].erase(pid);
+            aggregators_.erase((static_cast<uint64_t>(tid) << 32) | pid);
             if (tables_[tid].empty()) {
                 tables_.erase(tid);
             }
@@ -2940,6 +3279,7 @@ int32_t TabletImpl::DeleteTableInternal(uint32_t tid, uint32_t pid,
             if (snapshots_[tid].empty()) {
                 snapshots_.erase(tid);
             }
+            RefreshCachePartitionsUnLock();
         }
         if (replicator) {
             replicator->DelAllReplicateNode();
@@ -3055,7 +3395,8 @@ void TabletImpl::CreateTable(RpcController* controller, const ::openmldb::api::C
     table->SetTableStat(::openmldb::storage::kNormal);
     replicator->StartSyncing();
     io_pool_.DelayTask(FLAGS_binlog_sync_to_disk_interval, boost::bind(&TabletImpl::SchedSyncDisk, this, tid, pid));
-    task_pool_.DelayTask(FLAGS_binlog_delete_interval, boost::bind(&TabletImpl::SchedDelBinlog, this, tid, pid));
+    task_pool_.DelayTask(FLAGS_binlog_delete_interval, boost::bind(&TabletImpl::SchedDelBinlog, this, tid, pid),
+                         ::openmldb::base::TaskPriority::kBackground);
     PDLOG(INFO, "create table with id %u pid %u name %s", tid, pid, name.c_str());
     gc_pool_.DelayTask(FLAGS_gc_interval * 60 * 1000, boost::bind(&TabletImpl::GcTable, this, tid, pid, false));
     response->set_code(::openmldb::base::ReturnCode::kOk);
@@ -3491,6 +3832,7 @@ int TabletImpl::CreateTableInternal(const ::openmldb::api::TableMeta* table_meta
     tables_[table_meta->tid()].insert(std::make_pair(table_meta->pid(), table));
     snapshots_[table_meta->tid()].insert(std::make_pair(table_meta->pid(), snapshot));
     replicators_[table_meta->tid()].insert(std::make_pair(table_meta->pid(), replicator));
+    RefreshCachePartitionsUnLock();
     if (!table_meta->db().empty()) {
         bool ok = catalog_->AddTable(*table_meta, table);
         engine_->ClearCacheLocked(table_meta->db());
@@ -3706,6 +4048,7 @@ void TabletImpl::GcTable(uint32_t tid, uint32_t pid, bool execute_once) {
         int32_t gc_interval = FLAGS_gc_interval;
         table->SchedGc();
         if (!execute_once) {
+            // gc_pool_ only runs gc, a background task would leave a worker idle
             gc_pool_.DelayTask(gc_interval * 60 * 1000, boost::bind(&TabletImpl::GcTable, this, tid, pid, false));
         }
         return;
@@ -3955,6 +4298,122 @@ void TabletImpl::RefreshTableInfo() {
     // refresh the pre-aggr tables info
     auto entries = sr_->GetAggrTables();
     catalog_->RefreshAggrTables(entries);
+    RefreshAggregators(entries);
+}
+
+std::shared_ptr<Aggregators> TabletImpl::GetAggregators(uint32_t tid, uint32_t pid) {
+    std::lock_guard<SpinMutex> spin_lock(spin_mutex_);
+    auto it = aggregators_.find((static_cast<uint64_t>(tid) << 32) | pid);
+    if (it != aggregators_.end()) {
+        return it->second;
+    }
+    return std::shared_ptr<Aggregators>();
+}
+
+void TabletImpl::RefreshAggregators(const std::vector<::hybridse::vm::AggrTableInfo>& infos) {
+    // db.table -> leader partitions on this tablet
+    std::map<std::string, std::map<uint32_t, std::shared_ptr<Table>>> leader_tables;
+    std::map<uint64_t, std::shared_ptr<Aggregators>> old_aggregators;
+    {
+        std::lock_guard<SpinMutex> spin_lock(spin_mutex_);
+        for (const auto& kv : tables_) {
+            for (const auto& table_kv : kv.second) {
+                const auto& table = table_kv.second;
+                if (table->IsLeader() && table->GetTableStat() != ::openmldb::storage::kLoading) {
+                    leader_tables[table->GetDB() + "." + table->GetName()].emplace(table_kv.first, table);
+                }
+            }
+        }
+        old_aggregators = aggregators_;
+    }
+    std::map<uint64_t, std::shared_ptr<Aggregators>> new_aggregators;
+    // the created aggregators with the replicator of base table to replay
+    std::vector<std::pair<std::shared_ptr<Aggregator>, std::shared_ptr<LogReplicator>>> created;
+    for (const auto& info : infos) {
+        auto base_it = leader_tables.find(info.base_db + "." + info.base_table);
+        auto aggr_it = leader_tables.find(info.aggr_db + "." + info.aggr_table);
+        if (base_it == leader_tables.end() || aggr_it == leader_tables.end()) {
+            continue;
+        }
+        for (const auto& kv : base_it->second) {
+            uint32_t pid = kv.first;
+            auto aggr_table_it = aggr_it->second.find(pid);
+            if (aggr_table_it == aggr_it->second.end()) {
+                continue;
+            }
+            const auto& base_table = kv.second;
+            const auto& aggr_table = aggr_table_it->second;
+            uint64_t key = (static_cast<uint64_t>(base_table->GetId()) << 32) | pid;
+            auto& aggrs = new_aggregators[key];
+            if (!aggrs) {
+                aggrs = std::make_shared<Aggregators>();
+            }
+            std::shared_ptr<Aggregator> aggregator;
+            auto old_it = old_aggregators.find(key);
+            if (old_it != old_aggregators.end()) {
+                for (const auto& old : *old_it->second) {
+                    if (old->GetAggrTid() == aggr_table->GetId() && old->GetAggrPid() == pid) {
+                        aggregator = old;
+                        break;
+                    }
+                }
+            }
+            if (!aggregator) {
+                auto base_replicator = GetReplicator(base_table->GetId(), pid);
+                if (base_replicator) {
+                    aggregator = CreateAggregator(*base_table->GetTableMeta(), aggr_table,
+                                                  GetReplicator(aggr_table->GetId(), pid), info.aggr_func,
+                                                  info.aggr_col, info.partition_cols, info.order_by_col,
+                                                  info.bucket_size);
+                }
+                if (!aggregator) {
+                    PDLOG(WARNING, "fail to create aggregator for pre-aggr table %s.%s pid %u", info.aggr_db.c_str(),
+                          info.aggr_table.c_str(), pid);
+                    continue;
+                }
+                PDLOG(INFO, "create aggregator for pre-aggr table %s.%s pid %u", info.aggr_db.c_str(),
+                      info.aggr_table.c_str(), pid);
+                created.emplace_back(aggregator, base_replicator);
+            }
+            aggrs->push_back(aggregator);
+        }
+    }
+    {
+        // publish the aggregators before replaying binlog, so the rows put
+        // during the replay are held by the aggregators instead of being lost
+        std::lock_guard<SpinMutex> spin_lock(spin_mutex_);
+        aggregators_.swap(new_aggregators);
+        RefreshCachePartitionsUnLock();
+    }
+    for (const auto& kv : created) {
+        task_pool_.AddTask(boost::bind(&TabletImpl::InitAggregator, this, kv.first, kv.second));
+    }
+}
+
+void TabletImpl::InitAggregator(std::shared_ptr<Aggregator> aggregator,
+                                std::shared_ptr<LogReplicator> base_replicator) {
+    if (!aggregator->Init(base_replicator)) {
+        PDLOG(WARNING, "fail to recover aggregator of pre-aggr table tid %u pid %u", aggregator->GetAggrTid(),
+              aggregator->GetAggrPid());
+    }
+}
+
+void TabletImpl::UpdateAggrs(uint32_t tid, uint32_t pid, const ::openmldb::api::LogEntry& entry) {
+    auto aggrs = GetAggregators(tid, pid);
+    if (!aggrs) {
+        return;
+    }
+    for (const auto& aggr : *aggrs) {
+        for (const auto& dimension : entry.dimensions()) {
+            if (dimension.idx() == aggr->GetIndexPos()) {
+                if (!aggr->Update(dimension.key(), entry.value(), entry.log_index())) {
+                    PDLOG(WARNING, "fail to update aggr table tid %u pid %u with key %s", aggr->GetAggrTid(),
+                          aggr->GetAggrPid(), dimension.key().c_str());
+                }
+                break;
+            }
+        }
+    }
 }
 
 int TabletImpl::CheckDimessionPut(const ::openmldb::api::PutRequest* request, uint32_t idx_cnt) {
@@ -3985,8 +4444,17 @@ void TabletImpl::SchedSyncDisk(uint32_t tid, uint32_t pid) {
 void TabletImpl::SchedDelBinlog(uint32_t tid, uint32_t pid) {
     std::shared_ptr<LogReplicator> replicator = GetReplicator(tid, pid);
     if (replicator) {
-        replicator->DeleteBinlog();
-        task_pool_.DelayTask(FLAGS_binlog_delete_interval, boost::bind(&TabletImpl::SchedDelBinlog, this, tid, pid));
+        // the unwritten buckets of pre-aggr tables are rebuilt from binlog
+        uint64_t keep_offset = UINT64_MAX;
+        auto aggrs = GetAggregators(tid, pid);
+        if (aggrs) {
+            for (const auto& aggr : *aggrs) {
+                keep_offset = std::min(keep_offset, aggr->GetRecoverOffset());
+            }
+        }
+        replicator->DeleteBinlog(keep_offset);
+        task_pool_.DelayTask(FLAGS_binlog_delete_interval, boost::bind(&TabletImpl::SchedDelBinlog, this, tid, pid),
+                             ::openmldb::base::TaskPriority::kBackground);
     }
 }
 
@@ -4046,7 +4514,8 @@ void TabletImpl::SchedDelRecycle() {
     for (auto path : mode_recycle_root_paths_) {
         DelRecycle(path);
     }
-    task_pool_.DelayTask(FLAGS_recycle_ttl * 60 * 1000, boost::bind(&TabletImpl::SchedDelRecycle, this));
+    task_pool_.DelayTask(FLAGS_recycle_ttl * 60 * 1000, boost::bind(&TabletImpl::SchedDelRecycle, this),
+                         ::openmldb::base::TaskPriority::kBackground);
 }
 
 bool TabletImpl::CreateMultiDir(const std::vector<std::string>& dirs) {
@@ -4107,7 +4576,8 @@ void TabletImpl::GetDiskused() {
             table->SetDiskused(size);
         }
     }
-    task_pool_.DelayTask(FLAGS_get_table_diskused_interval, boost::bind(&TabletImpl::GetDiskused, this));
+    task_pool_.DelayTask(FLAGS_get_table_diskused_interval, boost::bind(&TabletImpl::GetDiskused, this),
+                         ::openmldb::base::TaskPriority::kBackground);
 }
 
 void TabletImpl::SetMode(RpcController* controller, const ::openmldb::api::SetModeRequest* request,
@@ -4847,7 +5317,7 @@ void TabletImpl::CreateProcedure(RpcController* controller, const openmldb::api:
     }
 
     sp_cache_->InsertSQLProcedureCacheEntry(db_name, sp_name, sp_info_impl, session.GetCompileInfo(),
-                                            batch_session.GetCompileInfo());
+                                            batch_session.GetCompileInfo(), NewResultCache(sp_info_impl));
 
     response->set_code(::openmldb::base::ReturnCode::kOk);
     response->set_msg("ok");
@@ -4870,36 +5340,100 @@ void TabletImpl::DropProcedure(RpcController* controller, const ::openmldb::api:
 
 void TabletImpl::RunRequestQuery(RpcController* ctrl, const openmldb::api::QueryRequest& request,
                                  ::hybridse::vm::RequestRunSession& session, openmldb::api::QueryResponse& response,
-                                 butil::IOBuf& buf) {
+                                 butil::IOBuf& buf, ResultCache* result_cache) {
     if (request.is_debug()) {
         session.EnableDebug();
     }
+    if (request.has_max_read_lag()) {
+        const std::string& db =
+            session.GetRequestDbName().empty() ? request.db() : session.GetRequestDbName();
+        int64_t read_pid = request.has_read_pid() ? static_cast<int64_t>(request.read_pid()) : -1;
+        // reject early by the routed partition, the others read are checked after the run
+        if (!CheckReadLag(GetReadLag(db, session.GetRequestName(), read_pid), request.max_read_lag(), &response)) {
+            return;
+        }
+    }
     ::hybridse::codec::Row row;
     auto& request_buf = dynamic_cast<brpc::Controller*>(ctrl)->request_attachment();
     size_t input_slices = request.row_slices();
-    if (!codec::DecodeRpcRow(request_buf, 0, request.row_size(), input_slices, &row)) {
+    // the sub task of a cluster request and the debug run are not cached
+    std::string cache_key;
+    std::vector<uint64_t> cache_partitions;
+    std::vector<uint64_t> cache_version;
+    bool use_cache = result_cache != nullptr && !request.has_task_id() && !request.is_debug() && input_slices == 1;
+    if (use_cache) {
+        request_buf.copy_to(&cache_key, request.row_size(), 0);
+        // only the partitions the request row read by its last run are versioned
+        if (!result_cache->GetPartitions(cache_key, &cache_partitions) ||
+            !GetResultCacheVersion(cache_partitions, &cache_version)) {
+            cache_version.clear();
+        }
+        std::string value;
+        if (result_cache->Get(cache_key, cache_partitions, cache_version, &value)) {
+            response.set_schema(session.GetEncodedSchema());
+            response.set_byte_size(value.size());
+            response.set_count(1);
+            response.set_row_slices(1);
+            response.set_code(::openmldb::base::kOk);
+            buf.append(value);
+            return;
+        }
+    }
+    // the input row refers to the request which outlives the run
+    if (!codec::DecodeRpcRowRef(request_buf, 0, request.row_size(), input_slices, &row)) {
         response.set_code(::openmldb::base::kSQLRunError);
         response.set_msg("fail to decode input row");
         return;
     }
     ::hybridse::codec::Row output;
     int32_t ret = 0;
-    if (request.has_task_id()) {
-        ret = session.Run(request.task_id(), row, &output);
-    } else {
-        ret = session.Run(row, &output);
+    std::vector<uint64_t> read_partitions;
+    std::vector<uint64_t> local_partitions;
+    {
+        ::openmldb::catalog::PartitionReadRecorder recorder;
+        if (request.has_task_id()) {
+            ret = session.Run(request.task_id(), row, &output);
+        } else {
+            ret = session.Run(row, &output);
+        }
+        // a read of a remote or missing partition is not versioned, neither is the result
+        use_cache = use_cache && recorder.GetPartitions(&read_partitions);
+        local_partitions = recorder.GetRecordedPartitions();
     }
     if (ret != 0) {
         response.set_code(::openmldb::base::kSQLRunError);
         response.set_msg("fail to run sql");
         return;
-    } else if (row.GetRowPtrCnt() != 1) {
+    }
+    if (request.has_max_read_lag()) {
+        if (FLAGS_sql_branch_parallelism > 1) {
+            // the reads of the branches run in other threads are not recorded
+            local_partitions.clear();
+            auto cache_partitions = std::atomic_load_explicit(&cache_partitions_, std::memory_order_acquire);
+            for (const auto& kv : *cache_partitions) {
+                local_partitions.push_back(kv.first);
+            }
+        }
+        if (!CheckReadLag(GetReadLag(local_partitions), request.max_read_lag(), &response)) {
+            return;
+        }
+    }
+    if (row.GetRowPtrCnt() != 1) {
         response.set_code(::openmldb::base::kSQLRunError);
         response.set_msg("do not support multiple output row slices");
         return;
     }
+    if (use_cache) {
+        // the version is read before the run, a concurrent write makes the next lookup a miss. The result of
+        // a run which reads other partitions than the versioned ones is not stored, only its partitions are
+        if (read_partitions != cache_partitions) {
+            cache_version.clear();
+        }
+        result_cache->Put(cache_key, read_partitions, cache_version,
+                          std::string(reinterpret_cast<const char*>(output.buf()), output.size()));
+    }
     size_t buf_total_size;
-    if (!codec::EncodeRpcRow(output, &buf, &buf_total_size)) {
+    if (!codec::EncodeRpcRowRef(output, &buf, &buf_total_size)) {
         response.set_code(::openmldb::base::kSQLRunError);
         response.set_msg("fail to encode sql output row");
         return;
@@ -4913,6 +5447,150 @@ void TabletImpl::RunRequestQuery(RpcController* ctrl, const openmldb::api::Query
     response.set_code(::openmldb::base::kOk);
 }
 
+std::shared_ptr<ResultCache> TabletImpl::NewResultCache(
+    const std::shared_ptr<hybridse::sdk::ProcedureInfo>& sp_info) {
+    auto sp_info_impl = std::dynamic_pointer_cast<::openmldb::catalog::ProcedureInfoImpl>(sp_info);
+    if (!sp_info_impl || sp_info_impl->GetResultCacheTtl() == 0 ||
+        sp_info_impl->GetType() != ::hybridse::sdk::ProcedureType::kReqDeployment) {
+        return std::shared_ptr<ResultCache>();
+    }
+    if (FLAGS_sql_branch_parallelism > 1) {
+        // the partitions read by the branches run in other threads are not recorded
+        LOG(WARNING) << "result cache of deployment " << sp_info_impl->GetDbName() << "."
+                     << sp_info_impl->GetSpName() << " is disabled as sql_branch_parallelism > 1";
+        return std::shared_ptr<ResultCache>();
+    }
+    LOG(INFO) << "enable result cache of deployment " << sp_info_impl->GetDbName() << "."
+              << sp_info_impl->GetSpName() << " with ttl " << sp_info_impl->GetResultCacheTtl() << "ms";
+    return std::make_shared<ResultCache>(sp_info_impl->GetDbName(), sp_info_impl->GetSpName(),
+                                         sp_info_impl->GetResultCacheTtl(), FLAGS_result_cache_max_entries);
+}
+
+bool TabletImpl::GetResultCacheVersion(const std::vector<uint64_t>& partitions, std::vector<uint64_t>* version) {
+    version->clear();
+    auto cache_partitions = std::atomic_load_explicit(&cache_partitions_, std::memory_order_acquire);
+    for (uint64_t partition : partitions) {
+        auto it = cache_partitions->find(partition);
+        // the follower puts to the table after the offset is updated, and the
+        // pre-aggr table is updated after the offset of the base table
+        if (it == cache_partitions->end() || !it->second.table->IsLeader() || it->second.has_aggr) {
+            version->clear();
+            return false;
+        }
+        version->push_back(it->second.replicator->GetOffset());
+        version->push_back(it->second.table->GetRecordCnt());
+    }
+    return !version->empty();
+}
+
+void TabletImpl::RefreshCachePartitionsUnLock() {
+    auto cache_partitions = std::make_shared<std::map<uint64_t, CachePartition>>();
+    for (const auto& tid_tables : tables_) {
+        auto replicators_it = replicators_.find(tid_tables.first);
+        if (replicators_it == replicators_.end()) {
+            continue;
+        }
+        for (const auto& pid_table : tid_tables.second) {
+            auto replicator_it = replicators_it->second.find(pid_table.first);
+            if (replicator_it == replicators_it->second.end()) {
+                continue;
+            }
+            uint64_t partition = (static_cast<uint64_t>(tid_tables.first) << 32) | pid_table.first;
+            cache_partitions->emplace(partition, CachePartition{pid_table.second, replicator_it->second,
+                                                                aggregators_.count(partition) > 0});
+        }
+    }
+    std::atomic_store_explicit(&cache_partitions_, cache_partitions, std::memory_order_release);
+}
+
+uint64_t TabletImpl::GetReadLag(const std::string& db, const std::string& table_name, int64_t read_pid) {
+    auto handler =
+        std::dynamic_pointer_cast<::openmldb::catalog::TabletTableHandler>(catalog_->GetTable(db, table_name));
+    if (!handler) {
+        return 0;
+    }
+    if (read_pid >= 0) {
+        return GetReadLag(handler->GetTid(), read_pid);
+    }
+    // the request is not routed by a partition, check all local partitions
+    uint64_t max_lag = 0;
+    for (uint32_t pid = 0; pid < handler->GetPartitionNum(); pid++) {
+        uint64_t lag = GetReadLag(handler->GetTid(), pid);
+        if (lag == UINT64_MAX) {
+            return lag;
+        }
+        max_lag = std::max(max_lag, lag);
+    }
+    return max_lag;
+}
+
+uint64_t TabletImpl::GetReadLag(const std::vector<uint64_t>& partitions) {
+    uint64_t max_lag = 0;
+    for (uint64_t partition : partitions) {
+        uint64_t lag = GetReadLag(static_cast<uint32_t>(partition >> 32), static_cast<uint32_t>(partition));
+        if (lag == UINT64_MAX) {
+            return lag;
+        }
+        max_lag = std::max(max_lag, lag);
+    }
+    return max_lag;
+}
+
+bool TabletImpl::CheckReadLag(uint64_t lag, uint64_t max_read_lag, ::openmldb::api::QueryResponse* response) {
+    if (lag <= max_read_lag) {
+        return true;
+    }
+    response->set_code(::openmldb::base::kReplicaLagTooLarge);
+    response->set_msg("replica lag " + (lag == UINT64_MAX ? std::string("unknown") : std::to_string(lag)) +
+                      " exceeds max read lag " + std::to_string(max_read_lag));
+    return false;
+}
+
+uint64_t TabletImpl::GetReadLag(uint32_t tid, uint32_t pid) {
+    std::shared_ptr<Table> table;
+    std::shared_ptr<LogReplicator> replicator;
+    {
+        std::lock_guard<SpinMutex> spin_lock(spin_mutex_);
+        table = GetTableUnLock(tid, pid);
+        replicator = GetReplicatorUnLock(tid, pid);
+    }
+    // the partitions not on this tablet are read from the leaders
+    if (!table || table->IsLeader()) {
+        return 0;
+    }
+    uint64_t leader_offset = 0;
+    if (!replicator ||
+        !replicator->GetLeaderOffset(&leader_offset, static_cast<uint64_t>(FLAGS_follower_read_max_silent_time))) {
+        return UINT64_MAX;
+    }
+    uint64_t offset = replicator->GetOffset();
+    return leader_offset > offset ? leader_offset - offset : 0;
+}
+
+double TabletImpl::GetSqlCacheHitRate(void* arg) {
+    auto stats = reinterpret_cast<TabletImpl*>(arg)->engine_->GetCacheStats();
+    // the queries waiting for an in-progress compiling are served without compiling
+    uint64_t total = stats.hit_cnt + stats.dedup_cnt + stats.miss_cnt;
+    return total == 0 ? 0 : static_cast<double>(stats.hit_cnt + stats.dedup_cnt) / total;
+}
+
+double TabletImpl::GetSqlCompileLatency(void* arg) {
+    auto stats = reinterpret_cast<TabletImpl*>(arg)->engine_->GetCacheStats();
+    return stats.miss_cnt == 0 ? 0 : static_cast<double>(stats.compile_time_us) / stats.miss_cnt;
+}
+
+int64_t TabletImpl::GetSqlCompileMaxLatency(void* arg) {
+    return reinterpret_cast<TabletImpl*>(arg)->engine_->GetCacheStats().max_compile_time_us;
+}
+
+int64_t TabletImpl::GetSqlCompileDedupCnt(void* arg) {
+    return reinterpret_cast<TabletImpl*>(arg)->engine_->GetCacheStats().dedup_cnt;
+}
+
+int64_t TabletImpl::GetSqlNormalizedCnt(void* arg) {
+    return reinterpret_cast<TabletImpl*>(arg)->engine_->GetCacheStats().normalized_cnt;
+}
+
 void TabletImpl::CreateProcedure(const std::shared_ptr<hybridse::sdk::ProcedureInfo>& sp_info) {
     const std::string& db_name = sp_info->GetDbName();
     const std::string& sp_name = sp_info->GetSpName();
@@ -4939,7 +5617,7 @@ void TabletImpl::CreateProcedure(const std::shared_ptr<hybridse::sdk::ProcedureI
         return;
     }
     sp_cache_->InsertSQLProcedureCacheEntry(db_name, sp_name, sp_info, session.GetCompileInfo(),
-                                            batch_session.GetCompileInfo());
+                                            batch_session.GetCompileInfo(), NewResultCache(sp_info));
     LOG(INFO) << "refresh procedure success! sp_name: " << sp_name << ", db: " << db_name << ", sql: " << sql;
 }
 
@@ -17,7 +17,9 @@
 #ifndef SRC_TABLET_TABLET_IMPL_H_
 #define SRC_TABLET_TABLET_IMPL_H_
 
+#include <brpc/controller.h>
 #include <brpc/server.h>
+#include <bvar/bvar.h>
 
 #include <list>
 #include <map>
@@ -29,15 +31,18 @@
 #include <vector>
 
 #include "base/spinlock.h"
+#include "base/work_stealing_pool.h"
 #include "catalog/tablet_catalog.h"
 #include "common/thread_pool.h"
 #include "proto/tablet.pb.h"
 #include "replica/log_replicator.h"
 #include "storage/mem_table.h"
 #include "storage/mem_table_snapshot.h"
+#include "tablet/aggregator.h"
 #include "tablet/bulk_load_mgr.h"
 #include "tablet/combine_iterator.h"
 #include "tablet/file_receiver.h"
+#include "tablet/file_sender.h"
 #include "tablet/sp_cache.h"
 #include "vm/engine.h"
 #include "zk/zk_client.h"
@@ -81,6 +86,9 @@ class TabletImpl : public ::openmldb::api::TabletServer {
     void Put(RpcController* controller, const ::openmldb::api::PutRequest* request,
              ::openmldb::api::PutResponse* response, Closure* done);
 
+    void PutBatch(RpcController* controller, const ::openmldb::api::PutBatchRequest* request,
+                  ::openmldb::api::PutBatchResponse* response, Closure* done);
+
     void Get(RpcController* controller, const ::openmldb::api::GetRequest* request,
              ::openmldb::api::GetResponse* response, Closure* done);
 
@@ -275,6 +283,17 @@ class TabletImpl : public ::openmldb::api::TabletServer {
 
     std::shared_ptr<Snapshot> GetSnapshotUnLock(uint32_t tid, uint32_t pid);
 
+    std::shared_ptr<Aggregators> GetAggregators(uint32_t tid, uint32_t pid);
+
+    // rebuild the aggregators of the pre-aggr tables whose base table and
+    // pre-aggr table leader partitions are both on this tablet
+    void RefreshAggregators(const std::vector<::hybridse::vm::AggrTableInfo>& infos);
+
+    // replay the binlog of base table to recover the buffers of aggregator
+    void InitAggregator(std::shared_ptr<Aggregator> aggregator, std::shared_ptr<LogReplicator> base_replicator);
+
+    void UpdateAggrs(uint32_t tid, uint32_t pid, const ::openmldb::api::LogEntry& entry);
+
     void GcTable(uint32_t tid, uint32_t pid, bool execute_once);
 
     void GcTableSnapshot(uint32_t tid, uint32_t pid);
@@ -291,6 +310,9 @@ class TabletImpl : public ::openmldb::api::TabletServer {
     void SendSnapshotInternal(const std::string& endpoint, uint32_t tid, uint32_t pid, uint32_t remote_tid,
                               std::shared_ptr<::openmldb::api::TaskInfo> task);
 
+    // send the files the manifest of snapshot_path lists and then the manifest, return 0 if there is no manifest
+    int SendSnapshotFiles(FileSender* sender, const std::string& snapshot_path, uint32_t tid, uint32_t pid);
+
     void DumpIndexDataInternal(std::shared_ptr<::openmldb::storage::Table> table,
                                std::shared_ptr<::openmldb::storage::MemTableSnapshot> memtable_snapshot,
                                uint32_t partition_num,
@@ -380,6 +402,14 @@ class TabletImpl : public ::openmldb::api::TabletServer {
 
     void ProcessQuery(RpcController* controller, const openmldb::api::QueryRequest* request,
                       ::openmldb::api::QueryResponse* response, butil::IOBuf* buf);
+    // compile the batch query and decode the parameter row
+    bool PrepareBatchQuery(RpcController* controller, const openmldb::api::QueryRequest* request,
+                           ::openmldb::api::QueryResponse* response, ::hybridse::vm::BatchRunSession* session,
+                           ::hybridse::codec::Row* parameter_row);
+    // respond with the schema, then send the rows by the stream of controller
+    // in chunks as they are produced
+    void ProcessStreamQuery(brpc::Controller* controller, const openmldb::api::QueryRequest* request,
+                            ::openmldb::api::QueryResponse* response, Closure* done);
     void ProcessBatchRequestQuery(RpcController* controller, const openmldb::api::SQLBatchRequestQueryRequest* request,
                                   openmldb::api::SQLBatchRequestQueryResponse* response,
                                   butil::IOBuf& buf);  // NOLINT
@@ -392,22 +422,60 @@ class TabletImpl : public ::openmldb::api::TabletServer {
 
  private:
     void RunRequestQuery(RpcController* controller, const openmldb::api::QueryRequest& request,
-                         ::hybridse::vm::RequestRunSession& session,                  // NOLINT
-                         openmldb::api::QueryResponse& response, butil::IOBuf& buf);  // NOLINT
+                         ::hybridse::vm::RequestRunSession& session,                 // NOLINT
+                         openmldb::api::QueryResponse& response, butil::IOBuf& buf,  // NOLINT
+                         ResultCache* result_cache = nullptr);
 
     void CreateProcedure(const std::shared_ptr<hybridse::sdk::ProcedureInfo>& sp_info);
 
+    // return null if the result cache is not enabled by the procedure
+    std::shared_ptr<ResultCache> NewResultCache(const std::shared_ptr<hybridse::sdk::ProcedureInfo>& sp_info);
+
+    // get the binlog offset and record count of the partitions, (tid << 32) | pid, a request reads. Return
+    // false if any of them is not a local leader or is updated by pre-aggr, then the result is not cached
+    bool GetResultCacheVersion(const std::vector<uint64_t>& partitions, std::vector<uint64_t>* version);
+
+    // rebuild cache_partitions_ after tables_, replicators_ or aggregators_ is changed, with spin_mutex_ held
+    void RefreshCachePartitionsUnLock();
+
+    // get the max count of binlog entries the local follower partitions of the table lag behind
+    // their leaders, UINT64_MAX if any follower has not heard from its leader recently. Only
+    // the partition read_pid is checked if it is not negative
+    uint64_t GetReadLag(const std::string& db, const std::string& table_name, int64_t read_pid);
+    // the max lag of the partitions in (tid << 32) | pid, the ones not on this tablet are skipped
+    uint64_t GetReadLag(const std::vector<uint64_t>& partitions);
+    uint64_t GetReadLag(uint32_t tid, uint32_t pid);
+    // set kReplicaLagTooLarge to response and return false if lag exceeds max_read_lag
+    static bool CheckReadLag(uint64_t lag, uint64_t max_read_lag, ::openmldb::api::QueryResponse* response);
+
+    // the stats of the sql compiling cache of engine_, exported to bvar
+    static double GetSqlCacheHitRate(void* arg);
+    static double GetSqlCompileLatency(void* arg);
+    static int64_t GetSqlCompileMaxLatency(void* arg);
+    static int64_t GetSqlCompileDedupCnt(void* arg);
+    static int64_t GetSqlNormalizedCnt(void* arg);
+
     Tables tables_;
     std::mutex mu_;
     SpinMutex spin_mutex_;
-    ThreadPool gc_pool_;
+    ::openmldb::base::WorkStealingPool gc_pool_;
     Replicators replicators_;
     Snapshots snapshots_;
+    // base table (tid << 32 | pid) -> aggregators of its pre-aggr tables
+    std::map<uint64_t, std::shared_ptr<Aggregators>> aggregators_;
+    struct CachePartition {
+        std::shared_ptr<Table> table;
+        std::shared_ptr<LogReplicator> replicator;
+        bool has_aggr;
+    };
+    // (tid << 32 | pid) -> the partition the result cache reads the version of. It is copied on write
+    // under spin_mutex_ and read by atomic_load, so a request does not take spin_mutex_
+    std::shared_ptr<std::map<uint64_t, CachePartition>> cache_partitions_;
     ZkClient* zk_client_;
     ThreadPool keep_alive_pool_;
-    ThreadPool task_pool_;
+    ::openmldb::base::WorkStealingPool task_pool_;
     ThreadPool io_pool_;
-    ThreadPool snapshot_pool_;
+    ::openmldb::base::WorkStealingPool snapshot_pool_;
     std::map<uint64_t, std::list<std::shared_ptr<::openmldb::api::TaskInfo>>> task_map_;
     std::set<std::string> sync_snapshot_set_;
     std::map<std::string, std::shared_ptr<FileReceiver>> file_receiver_map_;
@@ -420,6 +488,8 @@ class TabletImpl : public ::openmldb::api::TabletServer {
     std::shared_ptr<::openmldb::catalog::TabletCatalog> catalog_;
     // thread safe
     std::unique_ptr<::hybridse::vm::Engine> engine_;
+    // created with engine_ and destroyed before it
+    std::vector<std::unique_ptr<bvar::Variable>> engine_stats_;
     std::shared_ptr<::hybridse::vm::LocalTablet> local_tablet_;
     std::string zk_cluster_;
     std::string zk_path_;
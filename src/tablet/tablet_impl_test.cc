@@ -5714,6 +5714,79 @@ TEST_F(TabletImplTest, AddIndex) {
     ASSERT_EQ(1, (signed)srp.count());
 }
 
+TEST_F(TabletImplTest, PutBatch) {
+    TabletImpl tablet;
+    tablet.Init("");
+    MockClosure closure;
+    uint32_t id = counter++;
+    {
+        ::openmldb::api::CreateTableRequest request;
+        ::openmldb::api::TableMeta* table_meta = request.mutable_table_meta();
+        table_meta->set_name("t0");
+        table_meta->set_tid(id);
+        table_meta->set_pid(0);
+        table_meta->set_mode(::openmldb::api::TableMode::kTableLeader);
+        AddDefaultSchema(0, 0, ::openmldb::type::TTLType::kLatestTime, table_meta);
+        ::openmldb::api::CreateTableResponse response;
+        tablet.CreateTable(NULL, &request, &response, &closure);
+        ASSERT_EQ(0, response.code());
+    }
+    {
+        ::openmldb::api::PutBatchRequest request;
+        request.set_tid(id);
+        request.set_pid(0);
+        for (int i = 0; i < 10; i++) {
+            auto row = request.add_rows();
+            PackDefaultDimension("key" + std::to_string(i % 2), row);
+            row->set_time(i + 1);
+            row->set_value(::openmldb::test::EncodeKV("key" + std::to_string(i % 2), std::to_string(i)));
+        }
+        // invalid index
+        auto row = request.add_rows();
+        ::openmldb::test::SetDimension(3, "key0", row->add_dimensions());
+        row->set_time(100);
+        row->set_value(::openmldb::test::EncodeKV("key0", "value"));
+        ::openmldb::api::PutBatchResponse response;
+        tablet.PutBatch(NULL, &request, &response, &closure);
+        ASSERT_EQ(0, response.code());
+        ASSERT_EQ(11, response.row_code_size());
+        for (int i = 0; i < 10; i++) {
+            ASSERT_EQ(0, response.row_code(i));
+        }
+        ASSERT_EQ(::openmldb::base::ReturnCode::kInvalidDimensionParameter, response.row_code(10));
+    }
+    {
+        ::openmldb::api::CountRequest request;
+        request.set_tid(id);
+        request.set_pid(0);
+        request.set_key("key0");
+        ::openmldb::api::CountResponse response;
+        tablet.Count(NULL, &request, &response, &closure);
+        ASSERT_EQ(0, response.code());
+        ASSERT_EQ(5u, response.count());
+    }
+    {
+        ::openmldb::api::GetTableStatusRequest request;
+        ::openmldb::api::GetTableStatusResponse response;
+        tablet.GetTableStatus(NULL, &request, &response, &closure);
+        ASSERT_EQ(0, response.code());
+        for (const auto& ts : response.all_table_status()) {
+            if (ts.tid() == id) {
+                ASSERT_EQ(10u, ts.offset());
+            }
+        }
+    }
+    // table not exist
+    {
+        ::openmldb::api::PutBatchRequest request;
+        request.set_tid(id + 1);
+        request.set_pid(0);
+        ::openmldb::api::PutBatchResponse response;
+        tablet.PutBatch(NULL, &request, &response, &closure);
+        ASSERT_EQ(::openmldb::base::ReturnCode::kTableIsNotExist, response.code());
+    }
+}
+
 }  // namespace tablet
 }  // namespace openmldb
 